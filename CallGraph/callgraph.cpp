@@ -24,6 +24,7 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include "callgraph.h"
+#include "globals.h"
 #include "macromanager.h"
 #include "string.h"
 #include "toolbaricons.h"
@@ -42,8 +43,10 @@
 #include <wx/txtstrm.h>
 #include <wx/wfstream.h>
 
+#include "asyncprocess.h"
 #include "file_logger.h"
 #include "fileutils.h"
+#include "processreaderthread.h"
 #include <wx/msgdlg.h>
 
 /*!
@@ -101,6 +104,10 @@ CL_PLUGIN_API int GetPluginInterfaceVersion() { return PLUGIN_INTERFACE_VERSION;
 
 CallGraph::CallGraph(IManager* manager)
     : IPlugin(manager)
+    , m_gprofProcess(NULL)
+    , m_dotProcess(NULL)
+    , m_parser(NULL)
+    , m_suggestedThreshold(-1)
 {
     // will be created on-demand
     m_LogFile = nil;
@@ -115,6 +122,9 @@ CallGraph::CallGraph(IManager* manager)
 
     m_mgr->GetTheApp()->Connect(XRCID("cg_show_callgraph"), wxEVT_COMMAND_TOOL_CLICKED,
                                 wxCommandEventHandler(CallGraph::OnShowCallGraph), NULL, this);
+
+    Bind(wxEVT_ASYNC_PROCESS_OUTPUT, &CallGraph::OnProcessOutput, this);
+    Bind(wxEVT_ASYNC_PROCESS_TERMINATED, &CallGraph::OnProcessTerminated, this);
 }
 
 //---- DTOR -------------------------------------------------------------------
@@ -129,6 +139,10 @@ CallGraph::~CallGraph()
     m_mgr->GetTheApp()->Disconnect(XRCID("cg_show_callgraph"), wxEVT_COMMAND_TOOL_CLICKED,
                                    wxCommandEventHandler(CallGraph::OnShowCallGraph), NULL, this);
 
+    Unbind(wxEVT_ASYNC_PROCESS_OUTPUT, &CallGraph::OnProcessOutput, this);
+    Unbind(wxEVT_ASYNC_PROCESS_TERMINATED, &CallGraph::OnProcessTerminated, this);
+
+    DoResetState();
     wxDELETE(m_LogFile);
 }
 
@@ -207,7 +221,9 @@ void CallGraph::HookPopupMenu(wxMenu* menu, MenuType type)
 
 void CallGraph::UnPlug()
 {
-    // TODO:: perform the unplug action for this plugin
+    if(m_gprofProcess) { m_gprofProcess->Detach(); }
+    if(m_dotProcess) { m_dotProcess->Detach(); }
+    DoResetState();
 }
 
 //---- About ------------------------------------------------------------------
@@ -339,8 +355,11 @@ void CallGraph::OnShowCallGraph(wxCommandEvent& event)
 
     config_tool->ReadObject(wxT("CallGraph"), &confData);
 
-    if(!wxFileExists(GetGprofPath()) || !wxFileExists(GetDotPath()))
-        return MessageBox(_T("Failed to locate required tools (gprof, dot). Please check the plugin settings."),
+    if(m_gprofProcess || m_dotProcess)
+        return MessageBox(_("A call graph is already being created, please wait..."), wxICON_INFORMATION);
+
+    if(!wxFileExists(GetDotPath()))
+        return MessageBox(_T("Failed to locate required tool (dot). Please check the plugin settings."),
                           wxICON_ERROR);
 
     clCxxWorkspace* ws = m_mgr->GetWorkspace();
@@ -389,74 +408,116 @@ void CallGraph::OnShowCallGraph(wxCommandEvent& event)
     }
     if(!cfn.IsFileExecutable()) return MessageBox("bin/exe isn't executable", wxICON_ERROR);
 
-    // check 'gmon.out' file exists
+    // check 'gmon.out' (or callgrind output) file exists
     wxFileName gmon_cfn(cfn.GetPath() + wxFileName::GetPathSeparator() + GMON_FILENAME_OUT);
     gmon_cfn.Normalize();
 
     wxString gmonfn = gmon_cfn.GetFullPath();
     if(!gmon_cfn.Exists()) {
-        gmonfn = wxFileSelector("Please select the gprof file", gmon_cfn.GetPath(), "gmon", "out");
+        gmonfn = wxFileSelector("Please select the gprof or callgrind file", gmon_cfn.GetPath(), "gmon", "out",
+                                "gprof files (gmon*.out)|gmon*.out|callgrind files (callgrind.out*)|callgrind.out*|"
+                                "All files|*");
         if(gmonfn.IsEmpty()) return MessageBox("selected gprof was canceled", wxICON_ERROR);
 
         gmon_cfn.Assign(gmonfn, wxPATH_NATIVE);
     }
 
+    DoResetState();
+    m_parser = new GprofParser();
+    m_basePath = base_path;
+
+    if(GprofParser::IsCallgrindFile(gmonfn)) {
+        // callgrind files are imported directly, no external tool is needed
+        wxFFileInputStream callgrind_is(gmonfn);
+        if(!callgrind_is.IsOk()) {
+            DoResetState();
+            return MessageBox(_("Failed to open the callgrind file, aborting"), wxICON_ERROR);
+        }
+        m_parser->CallgrindParserStream(&callgrind_is);
+        DoRenderCallGraph();
+        return;
+    }
+
+    if(!wxFileExists(GetGprofPath())) {
+        DoResetState();
+        return MessageBox(_T("Failed to locate required tool (gprof). Please check the plugin settings."),
+                          wxICON_ERROR);
+    }
+
     wxString bin, arg1, arg2;
 
     bin = GetGprofPath();
     arg1 = bin_fpath;
     arg2 = gmonfn;
 
-    wxString cmdgprof = wxString::Format("%s %s %s", bin, arg1, arg2);
-
-    // myLog("about to wxExecute(\"%s\")", cmdgprof);
-
-    wxProcess* proc = new wxProcess(wxPROCESS_REDIRECT);
+    wxString cmdgprof;
+    cmdgprof << ::WrapWithQuotes(bin) << " " << ::WrapWithQuotes(arg1) << " " << ::WrapWithQuotes(arg2);
 
-    // wxStopWatch	sw;
-
-    const int err = ::wxExecute(cmdgprof, wxEXEC_SYNC, proc);
-    // on sync returns 0 (success), -1 (failure / "couldn't be started")
-
-    // myLog("wxExecute() returned err %d, had pid %d", err, (int)proc->GetPid());
-
-    wxInputStream* process_is = proc->GetInputStream();
-    if(!process_is || !process_is->CanRead())
-        return MessageBox(_("wxProcess::GetInputStream() can't be opened, aborting"), wxICON_ERROR);
+    // gprof output is collected in the background and parsed once the process terminates
+    m_gprofProcess = ::CreateAsyncProcess(this, cmdgprof, IProcessCreateDefault | IProcessCreateWithHiddenConsole,
+                                          cfn.GetPath());
+    if(!m_gprofProcess) {
+        DoResetState();
+        return MessageBox(_("Failed to execute gprof, aborting"), wxICON_ERROR);
+    }
+}
 
-    // start parsing and writing to dot language file
-    GprofParser pgp;
+//---- Asynchronous gprof / dot processes -------------------------------------
 
-    pgp.GprofParserStream(process_is);
+void CallGraph::OnProcessOutput(clProcessEvent& event)
+{
+    if(event.GetProcess() == m_gprofProcess) { m_gprofOutput << event.GetOutput(); }
+}
 
-    // myLog("gprof done (read %d lines)", (int) pgp.lines.GetCount());
+void CallGraph::OnProcessTerminated(clProcessEvent& event)
+{
+    IProcess* process = event.GetProcess();
+    if(process == m_gprofProcess) {
+        m_gprofOutput << event.GetOutput();
+        wxDELETE(m_gprofProcess);
+        event.SetProcess(NULL);
+
+        // start parsing and writing to dot language file. The output was decoded by the process already (whatever its
+        // encoding), so it is parsed as it is
+        if(m_parser) { m_parser->GprofParserString(m_gprofOutput); }
+        m_gprofOutput.clear();
+        DoRenderCallGraph();
+
+    } else if(process == m_dotProcess) {
+        wxDELETE(m_dotProcess);
+        event.SetProcess(NULL);
+        DoShowCallGraphPanel();
+    }
+}
 
-    delete proc;
+void CallGraph::DoRenderCallGraph()
+{
+    if(!m_parser) return;
 
     ConfCallGraph conf;
 
-    config_tool->ReadObject(wxT("CallGraph"), &conf);
+    m_mgr->GetConfigTool()->ReadObject(wxT("CallGraph"), &conf);
 
     DotWriter dotWriter;
 
     // DotWriter
-    dotWriter.SetLineParser(&(pgp.lines));
+    dotWriter.SetLineParser(&(m_parser->lines));
 
-    int suggestedThreshold = pgp.GetSuggestedNodeThreshold();
+    m_suggestedThreshold = m_parser->GetSuggestedNodeThreshold();
 
-    if(suggestedThreshold <= conf.GetTresholdNode()) {
-        suggestedThreshold = conf.GetTresholdNode();
+    if(m_suggestedThreshold <= conf.GetTresholdNode()) {
+        m_suggestedThreshold = conf.GetTresholdNode();
 
         dotWriter.SetDotWriterFromDialogSettings(m_mgr);
 
     } else {
-        dotWriter.SetDotWriterFromDetails(conf.GetColorsNode(), conf.GetColorsEdge(), suggestedThreshold,
+        dotWriter.SetDotWriterFromDetails(conf.GetColorsNode(), conf.GetColorsEdge(), m_suggestedThreshold,
                                           conf.GetTresholdEdge(), conf.GetHideParams(), conf.GetStripParams(),
                                           conf.GetHideNamespaces());
 
         wxString suggest_msg = wxString::Format(_("The CallGraph plugin has suggested node threshold %d to speed-up "
                                                   "the call graph creation. You can alter it on the call graph panel."),
-                                                suggestedThreshold);
+                                                m_suggestedThreshold);
 
         MessageBox(suggest_msg, wxICON_INFORMATION);
     }
@@ -464,7 +525,7 @@ void CallGraph::OnShowCallGraph(wxCommandEvent& event)
     dotWriter.WriteToDotLanguage();
 
     // build output dir
-    cfn.Assign(base_path, "");
+    wxFileName cfn(m_basePath, "");
     cfn.AppendDir(CALLGRAPH_DIR);
     cfn.Normalize();
 
@@ -476,35 +537,56 @@ void CallGraph::OnShowCallGraph(wxCommandEvent& event)
     dotWriter.SendToDotAppOutputDirectory(dot_fn);
 
     cfn.SetFullName(DOT_FILENAME_PNG);
-    wxString output_png_fn = cfn.GetFullPath();
+    m_outputPngFile = cfn.GetFullPath();
 
     // delete any existing PNG
-    if(wxFileExists(output_png_fn)) clRemoveFile(output_png_fn);
+    if(wxFileExists(m_outputPngFile)) clRemoveFile(m_outputPngFile);
 
+    wxString dot_path = GetDotPath();
+    wxString png_fn = m_outputPngFile;
     wxString cmddot_ln;
 
-    cmddot_ln << GetDotPath() << " -Tpng -o" << output_png_fn << " " << dot_fn;
-
-    // myLog("wxExecute(\"%s\")", cmddot_ln);
+    cmddot_ln << ::WrapWithQuotes(dot_path) << " -Tpng -o" << ::WrapWithQuotes(png_fn) << " "
+              << ::WrapWithQuotes(dot_fn);
 
-    wxExecute(cmddot_ln, wxEXEC_SYNC | wxEXEC_HIDE_CONSOLE);
+    m_dotProcess = ::CreateAsyncProcess(this, cmddot_ln, IProcessCreateDefault | IProcessCreateWithHiddenConsole);
+    if(!m_dotProcess) {
+        DoResetState();
+        MessageBox(_("Failed to execute dot, aborting"), wxICON_ERROR);
+    }
+}
 
-    // myLog("dot done");
+void CallGraph::DoShowCallGraphPanel()
+{
+    if(!m_parser) return;
 
-    if(!wxFileExists(output_png_fn))
+    if(!wxFileExists(m_outputPngFile)) {
+        DoResetState();
         return MessageBox(_("Failed to open file CallGraph.png. Please check the project settings, rebuild the project "
                             "and try again."),
                           wxICON_INFORMATION);
+    }
 
     // show image and create table in the editor tab page
-    uicallgraphpanel* panel = new uicallgraphpanel(m_mgr->GetEditorPaneNotebook(), m_mgr, output_png_fn, base_path,
-                                                   suggestedThreshold, &(pgp.lines));
+    uicallgraphpanel* panel = new uicallgraphpanel(m_mgr->GetEditorPaneNotebook(), m_mgr, m_outputPngFile, m_basePath,
+                                                   m_suggestedThreshold, &(m_parser->lines));
 
     wxString tstamp = wxDateTime::Now().Format(wxT(" %Y-%m-%d %H:%M:%S"));
 
-    wxString title = wxT("Call graph for \"") + output_png_fn + wxT("\" " + tstamp);
+    wxString title = wxT("Call graph for \"") + m_outputPngFile + wxT("\" " + tstamp);
 
     m_mgr->AddEditorPage(panel, title);
+    DoResetState();
+}
+
+void CallGraph::DoResetState()
+{
+    wxDELETE(m_gprofProcess);
+    wxDELETE(m_dotProcess);
+    wxDELETE(m_parser);
+    m_gprofOutput.clear();
+    m_outputPngFile.clear();
+    m_suggestedThreshold = -1;
 }
 
 //---- Show Settings Dialog ---------------------------------------------------
@@ -45,10 +45,12 @@
 #include "gprofparser.h"
 #include "dotwriter.h"
 #include "static.h"
+#include "cl_command_event.h"
 
 // forward references
 class wxFileOutputStream;
 class wxTextOutputStream;
+class IProcess;
 
 /**
  * @class CallGraph
@@ -123,6 +125,27 @@ protected:
      */
     void OnSettings(wxCommandEvent& event);
 
+    /**
+     * @brief Collect the output of the gprof process.
+     */
+    void OnProcessOutput(clProcessEvent& event);
+    /**
+     * @brief gprof or dot process terminated: continue with the next step of the call graph creation.
+     */
+    void OnProcessTerminated(clProcessEvent& event);
+    /**
+     * @brief Write the parsed profile in the dot language and start the (asynchronous) rendering of the PNG.
+     */
+    void DoRenderCallGraph();
+    /**
+     * @brief Show the rendered call graph in a new editor tab.
+     */
+    void DoShowCallGraphPanel();
+    /**
+     * @brief Release the state of the current call graph creation.
+     */
+    void DoResetState();
+
     /**
      * @brief Create custom plugin's popup menu.
      * @return Plugin's popup menu
@@ -141,6 +164,14 @@ protected:
      */
     ConfCallGraph confData; // object confData type ConfCallGraph with stored configuration data
 
+    IProcess* m_gprofProcess;  // running gprof process
+    IProcess* m_dotProcess;    // running dot process
+    wxString m_gprofOutput;    // collected gprof output
+    GprofParser* m_parser;     // parsed profile of the call graph being created
+    wxString m_basePath;       // workspace path
+    wxString m_outputPngFile;  // rendered call graph
+    int m_suggestedThreshold;
+
     // wxString        m_ProfiledBinFullName;
 };
 
@@ -24,22 +24,278 @@
 //////////////////////////////////////////////////////////////////////////////
 
 #include "gprofparser.h"
-#include <wx/intl.h>
-#include <wx/regex.h>
-#include <wx/strconv.h>
+#include "static.h"
+#include <wx/filename.h>
+#include <wx/wfstream.h>
+#include <algorithm>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
 
 int cmpint(int* a, int* b) { return *b - *a; }
 
+namespace
+{
+// The profiles are parsed directly from the raw bytes (or, for the gprof output collected from the process, from
+// the wide chars): no regular expressions, no per-line allocations and no locale dependent number conversion
+template <typename CharT> inline bool IsBlank(CharT ch) { return ch == ' ' || ch == '\t' || ch == '\r'; }
+template <typename CharT> inline bool IsDigit(CharT ch) { return ch >= '0' && ch <= '9'; }
+
+template <typename CharT> inline void SkipBlanks(const CharT*& p, const CharT* end)
+{
+	while(p < end && IsBlank(*p)) ++p;
+}
+
+template <typename CharT> inline const CharT* TrimRight(const CharT* begin, const CharT* end)
+{
+	while(end > begin && IsBlank(*(end - 1))) --end;
+	return end;
+}
+
+/**
+ * @brief return true if [begin, end) starts with the ASCII string 'prefix'
+ */
+template <typename CharT>
+bool StartsWithAscii(const CharT* begin, const CharT* end, const char* prefix, size_t prefixLen)
+{
+	if((size_t)(end - begin) < prefixLen) return false;
+	for(size_t i = 0; i < prefixLen; ++i) {
+		if(begin[i] != (CharT)(unsigned char)prefix[i]) return false;
+	}
+	return true;
+}
+
+template <typename CharT> bool ReadInt(const CharT*& p, const CharT* end, long long& value)
+{
+	const CharT* start = p;
+	bool neg = false;
+	if(p < end && (*p == '-' || *p == '+')) {
+		neg = (*p == '-');
+		++p;
+	}
+	long long v = 0;
+	const char* digits = p;
+	while(p < end && IsDigit(*p)) {
+		v = v * 10 + (*p - '0');
+		++p;
+	}
+	if(p == digits) {
+		p = start;
+		return false;
+	}
+	value = neg ? -v : v;
+	return true;
+}
+
+template <typename CharT> bool ReadFloat(const CharT*& p, const CharT* end, float& value)
+{
+	const CharT* start = p;
+	long long ip = 0;
+	bool neg = (p < end && *p == '-');
+	if(neg) ++p;
+	bool hasDigits = false;
+	while(p < end && IsDigit(*p)) {
+		ip = ip * 10 + (*p - '0');
+		++p;
+		hasDigits = true;
+	}
+	double v = (double)ip;
+	if(p < end && *p == '.') {
+		++p;
+		double scale = 0.1;
+		while(p < end && IsDigit(*p)) {
+			v += (*p - '0') * scale;
+			scale *= 0.1;
+			++p;
+			hasDigits = true;
+		}
+	}
+	if(!hasDigits) {
+		p = start;
+		return false;
+	}
+	value = (float)(neg ? -v : v);
+	return true;
+}
+
+wxString MakeString(const char* begin, const char* end)
+{
+	if(begin >= end) return wxEmptyString;
+	wxString str(begin, wxConvUTF8, end - begin);
+	if(str.IsEmpty()) { str = wxString(begin, wxConvISO8859_1, end - begin); }
+	return str;
+}
+
+wxString MakeString(const wxChar* begin, const wxChar* end)
+{
+	if(begin >= end) return wxEmptyString;
+	return wxString(begin, end - begin);
+}
+
+/**
+ * @brief numeric column of the gprof call graph: plain number, "a/b" (calls/total) or "a+b" (calls+recursive)
+ */
+struct GprofField {
+	float value;
+	int first;
+	int second;
+	char sep;
+	bool integer;
+};
+
+template <typename CharT> bool ReadGprofField(const CharT*& p, const CharT* end, GprofField& field)
+{
+	const CharT* start = p;
+	if(!ReadFloat(p, end, field.value)) return false;
+	field.integer = (std::find(start, p, (CharT)'.') == p);
+	field.first = (int)field.value;
+	field.second = -1;
+	field.sep = 0;
+	if(field.integer && p < end && (*p == '/' || *p == '+')) {
+		const CharT* sep = p;
+		long long second = 0;
+		++p;
+		if(ReadInt(p, end, second)) {
+			field.sep = (char)*sep;
+			field.second = (int)second;
+		} else {
+			p = sep;
+		}
+	}
+	// a field must be followed by a blank (otherwise it is the start of a name)
+	if(p < end && !IsBlank(*p)) {
+		p = start;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @brief split the tail of a gprof row: "name <cycle N> [index]"
+ */
+template <typename CharT> void ReadGprofName(const CharT* p, const CharT* end, LineParser* line)
+{
+	end = TrimRight(p, end);
+	// trailing [index]
+	if(end > p && *(end - 1) == ']') {
+		const CharT* open = end - 1;
+		while(open > p && *open != '[') --open;
+		if(*open == '[') {
+			const CharT* num = open + 1;
+			long long id = 0;
+			if(ReadInt(num, end, id)) line->nameid = (int)id;
+			end = TrimRight(p, open);
+		}
+	}
+	// trailing <cycle N>
+	if(end > p && *(end - 1) == '>') {
+		const CharT* open = end - 1;
+		while(open > p && *open != '<') --open;
+		static const char cycle[] = "<cycle ";
+		const size_t cycleLen = sizeof(cycle) - 1;
+		if((size_t)(end - open) > cycleLen && StartsWithAscii(open, end, cycle, cycleLen)) {
+			const CharT* num = open + cycleLen;
+			long long id = 0;
+			if(ReadInt(num, end, id)) {
+				line->cycle = true;
+				line->cycleid = (int)id;
+				if(open == p) {
+					// <cycle N as a whole>
+					line->name = wxT("whole");
+					return;
+				}
+				end = TrimRight(p, open);
+			}
+		}
+	}
+	line->name = MakeString(p, end);
+}
+
+struct CallgrindCall {
+	int callee;
+	long long calls;
+	unsigned long long cost;
+};
+
+struct CallgrindFunction {
+	std::string name;
+	unsigned long long self;
+	unsigned long long inclusive;
+	long long called;
+	std::vector<CallgrindCall> callees;
+	int index;
+	CallgrindFunction()
+		: self(0)
+		, inclusive(0)
+		, called(0)
+		, index(-1)
+	{
+	}
+};
+
+bool StartsWith(const char* begin, const char* end, const char* prefix, size_t prefixLen)
+{
+	return (size_t)(end - begin) >= prefixLen && memcmp(begin, prefix, prefixLen) == 0;
+}
+
+/**
+ * @brief resolve the (possibly compressed) function name "(id) name" / "(id)" / "name"
+ */
+int ResolveCallgrindFunction(const char* p, const char* end, std::vector<CallgrindFunction>& functions,
+							 std::unordered_map<std::string, int>& byName, std::unordered_map<long long, int>& byId)
+{
+	SkipBlanks(p, end);
+	long long id = -1;
+	if(p < end && *p == '(') {
+		const char* q = p + 1;
+		if(ReadInt(q, end, id) && q < end && *q == ')') {
+			p = q + 1;
+			SkipBlanks(p, end);
+		} else {
+			id = -1;
+		}
+	}
+	end = TrimRight(p, end);
+	if(id != -1 && p == end) {
+		std::unordered_map<long long, int>::iterator iter = byId.find(id);
+		if(iter != byId.end()) return iter->second;
+	}
+
+	std::string name(p, end);
+	int index;
+	std::unordered_map<std::string, int>::iterator iter = byName.find(name);
+	if(iter == byName.end()) {
+		index = (int)functions.size();
+		functions.push_back(CallgrindFunction());
+		functions.back().name.swap(name);
+		byName.insert(std::make_pair(functions.back().name, index));
+	} else {
+		index = iter->second;
+	}
+	if(id != -1) byId[id] = index;
+	return index;
+}
+
+bool CallgrindSort(const CallgrindFunction* a, const CallgrindFunction* b) { return a->inclusive > b->inclusive; }
+
+bool ReadStreamContent(wxInputStream* input, std::vector<char>& buffer)
+{
+	if(!input) return false;
+	char chunk[64 * 1024];
+	while(!input->Eof()) {
+		input->Read(chunk, sizeof(chunk));
+		size_t count = input->LastRead();
+		if(count == 0) break;
+		buffer.insert(buffer.end(), chunk, chunk + count);
+	}
+	return true;
+}
+}
+
 GprofParser::GprofParser()
 {
 	lineheader = false;
 	primaryline = false;
-	nameLen = 0;
-	nameandid = NULL;
-	isdot = false;
-	iscycle = false;
-	islom = false;
-	isplus = false;
 	isspontaneous = false;
 	lines.DeleteContents(true);
 	lines.Clear();
@@ -51,226 +307,326 @@ GprofParser::~GprofParser()
 	lines.Clear();
 };
 
+void GprofParser::AddLine(LineParser* line)
+{
+	lines.Append( line );
+	calls[ wxRound(line->time) ] = calls[ wxRound(line->time) ] + 1;
+}
+
 void	GprofParser::GprofParserStream(wxInputStream *gprof_output)
 {
-	wxRegEx re;
-	readlinetext = wxT("");
-	readlinetexttemp = wxT("");
-	wxCSConv conv( wxT("ISO-8859-1") );
-	wxTextInputStream text(*gprof_output);//, wxT(" \t"), conv);
-	//wxFileOutputStream out( wxT("DEBUG.TXT") );
-	//wxTextOutputStream tout( out );
+	std::vector<char> buffer;
+	if(!ReadStreamContent(gprof_output, buffer) || buffer.empty()) return;
+	GprofParserBuffer(&buffer[0], buffer.size());
+}
+
+void GprofParser::GprofParserBuffer(const char* buffer, size_t len) { DoParseGprof(buffer, len); }
+
+void GprofParser::GprofParserString(const wxString& output) { DoParseGprof(output.wc_str(), output.length()); }
+
+template <typename CharT> void GprofParser::DoParseGprof(const CharT* buffer, size_t len)
+{
+	static const char header[] = "index % time    self  children    called     name";
+	const size_t headerLen = sizeof(header) - 1;
 
+	lineheader = false;
+	primaryline = false;
 	isspontaneous = false;
 	calls.clear();
 
-	while(!gprof_output->Eof()) {
-		readlinetext = text.ReadLine();
-		//tout.WriteString( readlinetext + wxT("\n") );
-		nameLen = readlinetext.Len();
-
-		if(readlinetext != wxT("")) {
-			if(readlinetext == wxT("index % time    self  children    called     name")) {
-				lineheader = true;
-			} else if (readlinetext[0] == wxT('-')) {
-				primaryline = false;
-				continue;
-			} else if (readlinetext.Contains(wxT("<spontaneous>"))) {
-				isspontaneous = true;
-				continue;
-			} else if (lineheader) {
-				delete [] nameandid;
-				nameandid = new char[nameLen + 1]; // dynam array for pointer nameandid
-				memset(nameandid, 0, nameLen + 1);
-
-				LineParser *line = new LineParser();
-
-				//inicializace struktury
-				line->called0 = -1;
-				line->called1 = -1;
-				line->child = false;
-				line->children = -1;
-				line->cycle = false;
-				line->cycleid = -1;
-				line->index = -1;
-				line->name = wxT("<undefined>");
-				line->nameid = -1;
-				line->parents = false;
-				line->pline = false;
-				line->recursive = false;
-				line->self = -1;
-				line->time = -1;
-
-				if(re.Compile(wxT("[ ]{2,}")) && re.Matches( readlinetext )) {
-					re.Replace(&readlinetext, wxT(" "));
-				}
+	const CharT* p = buffer;
+	const CharT* end = buffer + len;
+	while(p < end) {
+		const CharT* eol = std::find(p, end, (CharT)'\n');
+		const CharT* lineEnd = TrimRight(p, eol);
+
+		if(p == lineEnd) {
+			// the call graph section ends with an empty line
+			if(lineheader) break;
 
-				if (readlinetext.Contains(wxT("."))) isdot = true;
-				else isdot = false;
+		} else if(!lineheader) {
+			if((size_t)(lineEnd - p) == headerLen && StartsWithAscii(p, lineEnd, header, headerLen)) lineheader = true;
 
-				if (readlinetext.Contains(wxT("cycle"))) iscycle = true;
-				else iscycle = false;
+		} else {
+			ParseGprofLine(p, lineEnd);
+		}
+		p = eol + 1;
+	}
+}
 
-				//if (readlinetext.Contains(wxT("/"))) islom = true;
-				if(re.Compile( wxT("[0-9]+/[0-9]+"), wxRE_ADVANCED) && re.Matches( readlinetext)) islom = true;
-				else islom = false;
+template <typename CharT> void GprofParser::ParseGprofLine(const CharT* p, const CharT* end)
+{
+	if(*p == '-') {
+		primaryline = false;
+		return;
+	}
+
+	static const char spontaneous[] = "<spontaneous>";
+	const size_t spontaneousLen = sizeof(spontaneous) - 1;
+	const CharT* q = p;
+	SkipBlanks(q, end);
+	if((size_t)(end - q) == spontaneousLen && StartsWithAscii(q, end, spontaneous, spontaneousLen)) {
+		isspontaneous = true;
+		return;
+	}
+
+	LineParser *line = new LineParser();
+	line->called0 = -1;
+	line->called1 = -1;
+	line->child = false;
+	line->children = -1;
+	line->cycle = false;
+	line->cycleid = -1;
+	line->index = -1;
+	line->name = wxT("<undefined>");
+	line->nameid = -1;
+	line->parents = false;
+	line->pline = false;
+	line->recursive = false;
+	line->self = -1;
+	line->time = -1;
+
+	if(*q == '[') {
+		// primary line: [index] %time self children [called[+self]] name [index]
+		primaryline = true;
+		++q;
+		long long index = -1;
+		ReadInt(q, end, index);
+		line->index = (int)index;
+		if(q < end && *q == ']') ++q;
+
+		GprofField fields[4];
+		int count = 0;
+		SkipBlanks(q, end);
+		while(count < 4 && ReadGprofField(q, end, fields[count])) {
+			++count;
+			SkipBlanks(q, end);
+		}
+
+		if(count > 0) line->time = fields[0].value;
+		if(count > 1) line->self = fields[1].value;
+		if(count > 2) line->children = fields[2].value;
+		if(count > 3) {
+			line->called0 = fields[3].first;
+			if(fields[3].sep == '+') {
+				line->called1 = fields[3].second;
+				line->recursive = true;
+			}
+		}
+		ReadGprofName(q, end, line);
+		line->parents = false;
+		line->pline = true;
+		line->child = false;
+		isspontaneous = false;
+
+	} else {
+		// parents and children: [self children] called[/total] name [index]
+		GprofField fields[3];
+		int count = 0;
+		while(count < 3 && ReadGprofField(q, end, fields[count])) {
+			++count;
+			SkipBlanks(q, end);
+		}
 
-				//if (readlinetext.Contains(wxT("+"))) isplus = true;
-				if(re.Compile( wxT("([0-9]+)\\+([0-9]+)"), wxRE_ADVANCED) && re.Matches( readlinetext)) { 
-					isplus = true;
-					//readlinetext.Replace( wxT("+"), wxT(" ") );
-					re.Replace(&readlinetext, wxT("\\1 \\2"));
+		bool hasTotal = false;
+		if(count == 1) {
+			line->called0 = fields[0].first;
+		} else if(count >= 2) {
+			line->self = fields[0].value;
+			line->children = fields[1].value;
+			if(count == 3) {
+				line->called0 = fields[2].first;
+				if(fields[2].sep == '/') {
+					line->called1 = fields[2].second;
+					hasTotal = true;
 				}
-				else isplus = false;
-
-				wxString dot = wxLocale::GetInfo(wxLOCALE_DECIMAL_POINT, wxLOCALE_CAT_NUMBER);
-				readlinetext.Replace( wxT("."), dot );
-
-				if ((readlinetext[0] == '[') && (readlinetext[(readlinetext.length()) - 1] == ']')) {
-					primaryline = true;
-					//
-					if(iscycle && isplus) { // [3]     91.71    1.77        0.00    1+5    <cycle 1 as a whole> [3]
-						//warning
-						sscanf((const char*)readlinetext.mb_str(conv),"[%d] %f %f %f %d %d <cycle %d as a whole> [%d]",&line->index,&line->time,&line->self,&line->children,&line->called0,&line->called1,&line->cycleid,&line->nameid);
-						line->name = wxT("whole");
-						line->parents = false;
-						line->pline = true;
-						line->child = false;
-						line->cycle = true;
-						line->recursive = true;
-					} else if(iscycle) { //  [5]     38.86    0.75        0    1      a <cycle 1> [5]
-						sscanf((const char*)readlinetext.mb_str(conv),"[%d] %f %f %f %d %[^\n]s",&line->index,&line->time,&line->self,&line->children,&line->called0,nameandid);
-
-						wxString readlinesubtext(nameandid, conv); // musi byt kodovani ?
-						line->name = readlinesubtext.BeforeFirst(wxT('<'));
-						wxSscanf(readlinesubtext.AfterFirst(wxT('<')).BeforeFirst(wxT('>')),wxT("cycle %d"), &line->cycleid);
-						//line->cycleid = readlinesubtext.AfterFirst('<').BeforeFirst('>');
-						wxSscanf(readlinesubtext.AfterFirst(wxT('[')).BeforeFirst(wxT(']')),wxT("%d"),&line->nameid);
-
-						line->parents = false;
-						line->pline = true;
-						line->child = false;
-						line->cycle = true;
-						line->recursive = false;
-					} else if(isplus) { //[4]      3.7    0.00    0.01       1+6       quicksort(int*, int, int) [4]
-						sscanf((const char*)readlinetext.mb_str(conv),"[%d] %f %f %f %d %d %[^\n]s",&line->index,&line->time,&line->self,&line->children,&line->called0,&line->called1,nameandid);
-						//
-						wxString readlinesubtext(nameandid, conv);
-						//
-						line->name = readlinesubtext.BeforeFirst(wxT('['));
-						//
-						wxSscanf(readlinesubtext.AfterFirst(wxT('[')).BeforeFirst(wxT(']')),wxT("%d"),&line->nameid);
-						line->parents = false;
-						line->pline = true;
-						line->child = false;
-						line->cycle = false;
-						line->recursive = true;
-					} else if (isspontaneous) { // || !readlinetext.Contains(wxT('('))) // [3]    100.0    0.00    0.03       %d - neni        main [3]
-						//special case (probably appears after 'spontaneous'
-						sscanf((const char*)readlinetext.mb_str(conv),"[%d] %f %f %f %[^\n]s",&line->index,&line->time,&line->self,&line->children,nameandid);
-						//
-						wxString readlinesubtext(nameandid, conv); // musi byt kodovani ?
-						line->name = readlinesubtext.BeforeFirst(wxT('['));
-						//
-						wxSscanf(readlinesubtext.AfterFirst(wxT('[')).BeforeFirst(wxT(']')),wxT("%d"),&line->nameid);
-						line->parents = false;
-						line->pline = true;
-						line->child = false;
-						line->cycle = false;
-						line->recursive = false;
-
-						isspontaneous = false;
-					} else { //[2]    100.00    0.16     1.77    1      main [2]
-						sscanf((const char*)readlinetext.mb_str(conv),"[%d] %f %f %f %d %[^\n]s",&line->index,&line->time,&line->self,&line->children,&line->called0,nameandid);
-						//
-						wxString readlinesubtext(nameandid, conv); // musi byt kodovani ?
-						line->name = readlinesubtext.BeforeFirst(wxT('['));
-						//
-						wxSscanf(readlinesubtext.AfterFirst(wxT('[')).BeforeFirst(wxT(']')),wxT("%d"),&line->nameid);
-						line->parents = false;
-						line->pline = true;
-						line->child = false;
-						line->cycle = false;
-						line->recursive = false;
+			}
+		}
+		ReadGprofName(q, end, line);
+		// "15 faktorial(int) [8]" is a recursive call
+		line->recursive = (count == 1) && !hasTotal && !line->cycle;
+
+		if(primaryline) {
+			line->parents = false;
+			line->pline = false;
+			line->child = true;
+		} else {
+			line->parents = true;
+			line->pline = false;
+			line->child = false;
+		}
+	}
 
-					}
-				} else { //parents and childern
-					if(iscycle && !islom) { //3          a <cycle 1> [5]
-						// warning
-						sscanf((const char*)readlinetext.mb_str(conv),"%d %[^\n]s",&line->called0,nameandid);
-						wxString readlinesubtext(nameandid, conv);
-						line->name = readlinesubtext.BeforeFirst(wxT('<'));
-						wxSscanf(readlinesubtext.AfterFirst(wxT('<')).BeforeFirst(wxT('>')),wxT("cycle %d"), &line->cycleid);
-						//line->cycleid = readlinesubtext.AfterFirst('<').BeforeFirst('>');
-						wxSscanf(readlinesubtext.AfterFirst(wxT('[')).BeforeFirst(wxT(']')),wxT("%d"),&line->nameid);
-
-						line->cycle = true;
-						line->recursive = false;
-
-					} else if(!iscycle && islom) { // 0        0    6/6        c [6]
-						sscanf((const char*)readlinetext.mb_str(conv),"%f %f %d/%d %[^\n]s",&line->self,&line->children,&line->called0,&line->called1,nameandid);
-						wxString readlinesubtext(nameandid, conv);
-						line->name = (wxString)readlinesubtext.BeforeFirst(wxT('['));
-						wxSscanf(readlinesubtext.AfterFirst(wxT('[')).BeforeFirst(wxT(']')),wxT("%d"),&line->nameid);
-
-						line->cycle = false;
-						line->recursive = false;
-						//
-					} else if(iscycle && islom) { //1.77        0    1/1        a <cycle 1> [5]
-						sscanf((const char*)readlinetext.mb_str(conv),"%f %f %d/%d %[^\n]s",&line->self,&line->children,&line->called0,&line->called1,nameandid);
-						wxString readlinesubtext(nameandid, conv); // musi byt kodovani ?
-						line->name = readlinesubtext.BeforeFirst(wxT('<'));
-						wxSscanf(readlinesubtext.AfterFirst(wxT('<')).BeforeFirst(wxT('>')),wxT("cycle %d"), &line->cycleid);
-						//line->cycleid = readlinesubtext.AfterFirst('<').BeforeFirst('>');
-						wxSscanf(readlinesubtext.AfterFirst(wxT('[')).BeforeFirst(wxT(']')),wxT("%d"),&line->nameid);
-
-						line->cycle = true;
-						line->recursive = false;
-
-					} else if(!iscycle && !islom && !isdot) { //15             faktorial(int) [8]
-						sscanf((const char*)readlinetext.mb_str(conv),"%d %[^\n]s",&line->called0,nameandid);
-						wxString readlinesubtext(nameandid, conv); // musi byt kodovani ?
-						line->name = readlinesubtext.BeforeFirst(wxT('['));
-						wxSscanf(readlinesubtext.AfterFirst(wxT('[')).BeforeFirst(wxT(']')),wxT("%d"),&line->nameid);
-
-						line->cycle = false;
-						line->recursive = true;
+	AddLine(line);
+}
 
+void GprofParser::CallgrindParserStream(wxInputStream* callgrind_output)
+{
+	std::vector<char> buffer;
+	if(!ReadStreamContent(callgrind_output, buffer) || buffer.empty()) return;
+	CallgrindParserBuffer(&buffer[0], buffer.size());
+}
+
+void GprofParser::CallgrindParserBuffer(const char* buffer, size_t len)
+{
+	std::vector<CallgrindFunction> functions;
+	std::unordered_map<std::string, int> byName;
+	std::unordered_map<long long, int> byId;
+
+	calls.clear();
+
+	unsigned long long total = 0;
+	int positions = 1;
+	int current = -1;
+	int callee = -1;
+	long long pendingCalls = -1;
+
+	const char* p = buffer;
+	const char* end = buffer + len;
+	while(p < end) {
+		const char* eol = (const char*)memchr(p, '\n', end - p);
+		if(!eol) eol = end;
+		const char* lineEnd = TrimRight(p, eol);
+		const char ch = (p < lineEnd) ? *p : 0;
+
+		if(IsDigit(ch) || ch == '+' || ch == '-' || ch == '*') {
+			// cost line: <positions> <first event cost> ...
+			const char* q = p;
+			for(int i = 0; i < positions && q < lineEnd; ++i) {
+				while(q < lineEnd && !IsBlank(*q)) ++q;
+				SkipBlanks(q, lineEnd);
+			}
+			long long cost = 0;
+			ReadInt(q, lineEnd, cost);
+
+			if(current != -1) {
+				if(pendingCalls != -1) {
+					// inclusive cost of the call preceded by "calls="
+					if(callee != -1) {
+						CallgrindFunction& caller = functions[current];
+						if(callee != current) {
+							CallgrindCall call;
+							call.callee = callee;
+							call.calls = pendingCalls;
+							call.cost = (unsigned long long)cost;
+							caller.callees.push_back(call);
+							caller.inclusive += (unsigned long long)cost;
+						}
+						functions[callee].called += pendingCalls;
 					}
-					/*else if(!iscycle && !islom)
-					{
-						sscanf((const char*)readlinetext.mb_str(conv),"%f %f %d %[^\n]s",&line->self,&line->childern,&line->called0,nameandid);
-						//
-						wxString readlinesubtext(nameandid, conv); // musi byt kodovani ?
-						line->name = readlinesubtext.BeforeFirst('[');
-						//
-						wxSscanf(readlinesubtext.AfterFirst('[').BeforeFirst(']'),"%d",&line->nameid);
-
-						line->cycle = false;
-						line->recursive = false;
-						//
-					}*/
-
-					if (primaryline) {
-						line->parents = false;
-						line->pline = false;
-						line->child = true;
-					} else {
-						line->parents = true;
-						line->pline = false;
-						line->child = false;
-					}
+					pendingCalls = -1;
+				} else {
+					functions[current].self += (unsigned long long)cost;
+					functions[current].inclusive += (unsigned long long)cost;
 				}
-				
-				lines.Append( line );
-				calls[ wxRound(line->time) ] = calls[ wxRound(line->time) ] + 1;
 			}
-		} else if (lineheader) {
-			break;
+
+		} else if(StartsWith(p, lineEnd, "fn=", 3)) {
+			current = ResolveCallgrindFunction(p + 3, lineEnd, functions, byName, byId);
+			pendingCalls = -1;
+
+		} else if(StartsWith(p, lineEnd, "cfn=", 4)) {
+			callee = ResolveCallgrindFunction(p + 4, lineEnd, functions, byName, byId);
+
+		} else if(StartsWith(p, lineEnd, "calls=", 6)) {
+			const char* q = p + 6;
+			pendingCalls = 0;
+			ReadInt(q, lineEnd, pendingCalls);
+
+		} else if(StartsWith(p, lineEnd, "positions:", 10)) {
+			// "positions: instr line" -> 2 position columns
+			positions = 0;
+			const char* q = p + 10;
+			while(q < lineEnd) {
+				SkipBlanks(q, lineEnd);
+				if(q == lineEnd) break;
+				++positions;
+				while(q < lineEnd && !IsBlank(*q)) ++q;
+			}
+			if(positions == 0) positions = 1;
+
+		} else if(StartsWith(p, lineEnd, "summary:", 8) || StartsWith(p, lineEnd, "totals:", 7)) {
+			const char* q = (*p == 's') ? p + 8 : p + 7;
+			SkipBlanks(q, lineEnd);
+			long long value = 0;
+			if(ReadInt(q, lineEnd, value)) total = (unsigned long long)value;
 		}
+		p = eol + 1;
 	}
 
-	delete [] nameandid;
+	if(functions.empty()) return;
+
+	if(total == 0) {
+		for(size_t i = 0; i < functions.size(); ++i) total += functions[i].self;
+	}
+	if(total == 0) total = 1;
+
+	// keep the hot paths only: the pruned functions (and the calls to them) are not converted to lines
+	std::vector<CallgrindFunction*> hot;
+	for(size_t i = 0; i < functions.size(); ++i) {
+		double percent = (double)functions[i].inclusive * 100.0 / (double)total;
+		if(percent >= CALLGRIND_MIN_INCLUSIVE_PERCENT) hot.push_back(&functions[i]);
+	}
+	std::sort(hot.begin(), hot.end(), CallgrindSort);
+	for(size_t i = 0; i < hot.size(); ++i) hot[i]->index = (int)i + 1;
+
+	for(size_t i = 0; i < hot.size(); ++i) {
+		const CallgrindFunction& func = *hot[i];
+
+		LineParser* line = new LineParser();
+		line->index = func.index;
+		line->nameid = func.index;
+		line->name = MakeString(func.name.c_str(), func.name.c_str() + func.name.length());
+		line->time = (float)((double)func.inclusive * 100.0 / (double)total);
+		line->self = (float)((double)func.self * 100.0 / (double)total);
+		line->children = line->time - line->self;
+		line->called0 = func.called ? (int)func.called : -1;
+		line->called1 = -1;
+		line->parents = false;
+		line->pline = true;
+		line->child = false;
+		line->cycle = false;
+		line->cycleid = -1;
+		line->recursive = false;
+		AddLine(line);
+
+		for(size_t j = 0; j < func.callees.size(); ++j) {
+			const CallgrindCall& call = func.callees[j];
+			const CallgrindFunction& target = functions[call.callee];
+			if(target.index == -1) continue;
+
+			LineParser* child = new LineParser();
+			child->index = -1;
+			child->nameid = target.index;
+			child->name = MakeString(target.name.c_str(), target.name.c_str() + target.name.length());
+			child->time = -1;
+			child->self = (float)((double)call.cost * 100.0 / (double)total);
+			child->children = 0;
+			child->called0 = (int)call.calls;
+			child->called1 = target.called ? (int)target.called : -1;
+			child->parents = false;
+			child->pline = false;
+			child->child = true;
+			child->cycle = false;
+			child->cycleid = -1;
+			child->recursive = false;
+			AddLine(child);
+		}
+	}
+}
+
+bool GprofParser::IsCallgrindFile(const wxString& filename)
+{
+	wxFileName fn(filename);
+	if(fn.GetFullName().StartsWith(CALLGRIND_FILENAME_OUT)) return true;
+
+	wxFFileInputStream input(filename);
+	if(!input.IsOk()) return false;
+
+	char head[256];
+	input.Read(head, sizeof(head) - 1);
+	head[input.LastRead()] = 0;
+	return strstr(head, "# callgrind format") || strstr(head, "events:");
 }
 
 int GprofParser::GetSuggestedNodeThreshold()
@@ -36,7 +36,6 @@
 #include <wx/wx.h>
 #include <wx/string.h> 
 #include <wx/stream.h>
-#include <wx/txtstrm.h>
 #include <wx/hashmap.h>
 
 #include "lineparser.h"
@@ -45,26 +44,32 @@ WX_DECLARE_HASH_MAP(int, int, wxIntegerHash, wxIntegerEqual, OccurenceMap);
 
 /**
  * @class GprofParser
- * @brief Class define structure for parser to read stream of data from gprof tool.
+ * @brief Class define structure for parser to read profiling data (gprof call graph or callgrind output files).
+ * Both formats are read with a single pass over a raw byte buffer and converted to the same collection of lines.
  */
 class GprofParser
 {
 private:
-	wxString readlinetext;
-	wxString readlinetexttemp;
 	bool lineheader;
 	bool primaryline;
-	int nameLen;
-	char *nameandid;
-	bool isdot;
-	bool iscycle;
-	bool islom;
-	bool isplus;	
 	bool isspontaneous;	
 	
 	OccurenceMap calls;
 	wxArrayInt sortedCalls;
 	
+	/**
+	 * @brief Parse the gprof call graph section, from raw bytes or from wide chars.
+	 */
+	template <typename CharT> void DoParseGprof(const CharT* buffer, size_t len);
+	/**
+	 * @brief Parse a single row of the gprof call graph section (the row is not NULL terminated).
+	 */
+	template <typename CharT> void ParseGprofLine(const CharT* begin, const CharT* end);
+	/**
+	 * @brief Append line to the collection and update the statistics used for the threshold suggestion.
+	 */
+	void AddLine(LineParser* line);
+	
 public:
 	/**
 	 * @brief Defautl constructor.
@@ -83,6 +88,34 @@ public:
 	 * @param m_pInputStream pointer of type wxInputStream. 
 	 */
 	void GprofParserStream(wxInputStream *m_pInputStream);
+	/**
+	 * @brief Parse the gprof output from memory.
+	 * @param buffer raw gprof output
+	 * @param len buffer length in bytes
+	 */
+	void GprofParserBuffer(const char* buffer, size_t len);
+	/**
+	 * @brief Parse the gprof output collected from the gprof process, as is (it is already decoded).
+	 * @param output gprof output
+	 */
+	void GprofParserString(const wxString& output);
+	/**
+	 * @brief Function is reading callgrind output file (valgrind --tool=callgrind) and converts the call graph
+	 * with its inclusive and exclusive costs into collection of objects lines. Functions with inclusive cost lower
+	 * than CALLGRIND_MIN_INCLUSIVE_PERCENT are pruned so only the hot paths are kept.
+	 * @param m_pInputStream pointer of type wxInputStream. 
+	 */
+	void CallgrindParserStream(wxInputStream *m_pInputStream);
+	/**
+	 * @brief Parse the callgrind output from memory.
+	 * @param buffer raw callgrind file content
+	 * @param len buffer length in bytes
+	 */
+	void CallgrindParserBuffer(const char* buffer, size_t len);
+	/**
+	 * @brief Return true if the given file looks like a callgrind output file.
+	 */
+	static bool IsCallgrindFile(const wxString& filename);
 	/**
 	 * @brief Suggest call diagram's node threshold so no more than 100 items should be displayed at once.
 	 */
@@ -42,6 +42,10 @@ const wxString	GMON_FILENAME_OUT = "gmon.out";
 const wxString	DOT_FILENAME_PNG = "dot.png";
 const wxString	DOT_FILENAME_TXT = "dot.txt";
 const wxString	CALLGRAPH_DIR = "CallGraph";
+const wxString	CALLGRIND_FILENAME_OUT = "callgrind.out";
+
+// functions with lower inclusive cost are dropped while importing callgrind profiles
+const double	CALLGRIND_MIN_INCLUSIVE_PERCENT = 0.1;
 
 	#ifdef __WXMSW__
 		const wxString	GPROF_FILENAME_EXE = "gprof.exe";
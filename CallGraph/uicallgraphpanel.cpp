@@ -23,8 +23,11 @@
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
 
+#include "asyncprocess.h"
 #include "callgraph.h"
 #include "fileutils.h"
+#include "globals.h"
+#include "processreaderthread.h"
 #include "uicallgraphpanel.h"
 #include "workspace.h"
 #include <wx/bitmap.h>
@@ -41,6 +44,7 @@ uicallgraphpanel::uicallgraphpanel(wxWindow* parent, IManager* mgr, const wxStri
     m_pathimage = imagepath;
     m_pathproject = projectpath;
     m_scale = 1;
+    m_dotProcess = NULL;
 
     m_scrolledWindow->SetBackgroundColour(wxColour(255, 255, 255));
     m_scrolledWindow->SetBackgroundStyle(wxBG_STYLE_PAINT);
@@ -62,9 +66,19 @@ uicallgraphpanel::uicallgraphpanel(wxWindow* parent, IManager* mgr, const wxStri
     m_checkBoxHP->SetValue(confData.GetHideParams());
     m_checkBoxHN->SetValue(confData.GetHideNamespaces());
     m_grid->Update();
+
+    Bind(wxEVT_ASYNC_PROCESS_TERMINATED, &uicallgraphpanel::OnDotProcessTerminated, this);
 }
 
-uicallgraphpanel::~uicallgraphpanel() { m_lines.Clear(); }
+uicallgraphpanel::~uicallgraphpanel()
+{
+    Unbind(wxEVT_ASYNC_PROCESS_TERMINATED, &uicallgraphpanel::OnDotProcessTerminated, this);
+    if(m_dotProcess) {
+        m_dotProcess->Detach();
+        wxDELETE(m_dotProcess);
+    }
+    m_lines.Clear();
+}
 
 void uicallgraphpanel::OnPaint(wxPaintEvent& event)
 {
@@ -151,16 +165,25 @@ void uicallgraphpanel::OnRefreshClick(wxCommandEvent& event)
     wxString dot_fn = cfn.GetFullPath();
 
     bool ok = dw.SendToDotAppOutputDirectory(dot_fn);
-    if(ok) { // delete any existing PNG
+    if(ok) {
+        // a previous rendering is still running, its output is obsolete
+        if(m_dotProcess) {
+            m_dotProcess->Detach();
+            wxDELETE(m_dotProcess);
+        }
+
+        // delete any existing PNG
         if(wxFileExists(m_pathimage)) { clRemoveFile(m_pathimage); }
 
+        wxString dot_path = confData.GetDotPath();
+        wxString png_fn = m_pathimage;
         wxString cmddot_ln;
 
-        cmddot_ln << confData.GetDotPath() << " -Tpng -o" << m_pathimage << " " << dot_fn;
-
-        wxExecute(cmddot_ln, wxEXEC_SYNC | wxEXEC_HIDE_CONSOLE);
+        cmddot_ln << ::WrapWithQuotes(dot_path) << " -Tpng -o" << ::WrapWithQuotes(png_fn) << " "
+                  << ::WrapWithQuotes(dot_fn);
 
-        if(m_bmpOrig.LoadFile(m_pathimage, wxBITMAP_TYPE_PNG)) UpdateImage();
+        // the image is reloaded once dot terminates
+        m_dotProcess = ::CreateAsyncProcess(this, cmddot_ln, IProcessCreateDefault | IProcessCreateWithHiddenConsole);
 
     } else
         wxMessageBox(_("CallGraph failed to save file with DOT language, please build the project again."),
@@ -170,6 +193,16 @@ void uicallgraphpanel::OnRefreshClick(wxCommandEvent& event)
     CreateAndInserDataToTable(m_spinNT->GetValue());
 }
 
+void uicallgraphpanel::OnDotProcessTerminated(clProcessEvent& event)
+{
+    if(event.GetProcess() != m_dotProcess) return;
+
+    wxDELETE(m_dotProcess);
+    event.SetProcess(NULL);
+
+    if(m_bmpOrig.LoadFile(m_pathimage, wxBITMAP_TYPE_PNG)) UpdateImage();
+}
+
 void uicallgraphpanel::UpdateImage()
 {
     wxBusyCursor busy;
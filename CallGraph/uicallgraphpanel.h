@@ -40,6 +40,9 @@
 #include "confcallgraph.h"
 #include "plugin.h"
 #include "uicallgraph.h" // Base class: uicallgraph
+#include "cl_command_event.h"
+
+class IProcess;
 
 
 class uicallgraphpanel : public uicallgraph
@@ -63,6 +66,8 @@ protected:
 	virtual void OnZoomOut(wxCommandEvent& event);
 	virtual void OnZoomOriginal(wxCommandEvent& event);
 
+	void OnDotProcessTerminated(clProcessEvent& event);
+
 	int CreateAndInserDataToTable(int nodethr);	// returns min_threshold
 	void UpdateImage();
 
@@ -76,6 +81,7 @@ protected:
 	wxPoint m_viewPortOrigin;
 	wxPoint m_startigPoint;
 	float m_scale;
+	IProcess* m_dotProcess; // dot is rendering the call graph in the background
 };
 
 #endif // UICALLGRAPHPANEL_H
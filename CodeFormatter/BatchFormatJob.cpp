@@ -0,0 +1,232 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 Eran Ifrah
+// file name            : BatchFormatJob.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "BatchFormatJob.h"
+#include "astyle_main.h"
+#include "fileutils.h"
+#include <functional>
+#include <sstream>
+#include <vector>
+#include <wx/dir.h>
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+wxDEFINE_EVENT(wxEVT_BATCH_FORMAT_FILE_DONE, clCommandEvent);
+wxDEFINE_EVENT(wxEVT_BATCH_FORMAT_SCAN_DONE, clCommandEvent);
+
+//------------------------------------------------------------------------
+// BatchFormatCache
+//------------------------------------------------------------------------
+
+BatchFormatCache::BatchFormatCache()
+    : m_optionsHash(0)
+{
+}
+
+BatchFormatCache::~BatchFormatCache() {}
+
+void BatchFormatCache::SetOptionsHash(size_t optionsHash)
+{
+    wxMutexLocker locker(m_mutex);
+    if(m_optionsHash != optionsHash) {
+        m_hashes.clear();
+        m_optionsHash = optionsHash;
+    }
+}
+
+bool BatchFormatCache::IsUpToDate(const wxString& filename, size_t hash)
+{
+    wxMutexLocker locker(m_mutex);
+    std::map<wxString, size_t>::const_iterator iter = m_hashes.find(filename);
+    return iter != m_hashes.end() && iter->second == hash;
+}
+
+void BatchFormatCache::Update(const wxString& filename, size_t hash)
+{
+    wxMutexLocker locker(m_mutex);
+    m_hashes[filename] = hash;
+}
+
+size_t BatchFormatCache::Hash(const std::string& buffer) { return std::hash<std::string>()(buffer); }
+
+//------------------------------------------------------------------------
+// BatchFormatJob
+//------------------------------------------------------------------------
+
+BatchFormatJob::BatchFormatJob(wxEvtHandler* parent, const wxArrayString& files, const wxString& options,
+                               const wxString& eol, BatchFormatCache* cache)
+    : Job(parent)
+    , m_cache(cache)
+{
+    // deep copy: the job is processed by a worker thread
+    m_files.reserve(files.size());
+    for(size_t i = 0; i < files.size(); ++i) {
+        m_files.Add(files.Item(i).c_str());
+    }
+    m_options = options.mb_str(wxConvUTF8).data();
+    m_eol = eol.mb_str(wxConvUTF8).data();
+}
+
+BatchFormatJob::~BatchFormatJob() {}
+
+bool BatchFormatJob::ReadFile(const wxString& filename, std::string& content) const
+{
+    wxFFile fp(filename, "rb");
+    if(!fp.IsOpened()) { return false; }
+
+    wxFileOffset len = fp.Length();
+    if(len < 0) { return false; }
+
+    content.resize((size_t)len);
+    if(len && fp.Read(&content[0], content.size()) != content.size()) { return false; }
+    return true;
+}
+
+bool BatchFormatJob::WriteFile(const wxString& filename, const std::string& content) const
+{
+    // write the new content next to the file and then replace it, so the file is never left half written
+    wxString tmpfile = filename + ".codeformatter.tmp";
+    {
+        wxFFile fp(tmpfile, "wb");
+        if(!fp.IsOpened()) { return false; }
+        if(fp.Write(content.c_str(), content.length()) != content.length() || !fp.Close()) {
+            FileUtils::RemoveFile(tmpfile, "BatchFormatJob::WriteFile");
+            return false;
+        }
+    }
+
+    mode_t perm;
+    if(FileUtils::GetFilePermissions(filename, perm)) { FileUtils::SetFilePermissions(tmpfile, perm); }
+
+    if(!::wxRenameFile(tmpfile, filename, true)) {
+        FileUtils::RemoveFile(tmpfile, "BatchFormatJob::WriteFile");
+        return false;
+    }
+    return true;
+}
+
+void BatchFormatJob::NotifyFileDone(const wxString& filename, eStatus status)
+{
+    if(!m_parent) { return; }
+    clCommandEvent event(wxEVT_BATCH_FORMAT_FILE_DONE);
+    event.SetFileName(filename.c_str());
+    event.SetInt(status);
+    m_parent->AddPendingEvent(event);
+}
+
+void BatchFormatJob::Process(wxThread* thread)
+{
+    // one formatter per job, the options are parsed once and reused for all the files
+    astyle::ASFormatter formatter;
+    astyle::ASOptions options(formatter);
+
+    std::vector<std::string> optionsVector;
+    std::istringstream opt(m_options);
+    options.importOptions(opt, optionsVector);
+    options.parseOptions(optionsVector, "Invalid Artistic Style options:");
+
+    for(size_t i = 0; i < m_files.size(); ++i) {
+        if(thread && thread->TestDestroy()) { break; }
+
+        const wxString& filename = m_files.Item(i);
+        std::string content;
+        if(!ReadFile(filename, content)) {
+            NotifyFileDone(filename, kFailed);
+            continue;
+        }
+
+        if(m_cache && m_cache->IsUpToDate(filename, BatchFormatCache::Hash(content))) {
+            NotifyFileDone(filename, kUpToDate);
+            continue;
+        }
+
+        std::istringstream in(content);
+        astyle::ASStreamIterator<std::istringstream> streamIterator(&in);
+        std::ostringstream out;
+        formatter.init(&streamIterator);
+
+        while(formatter.hasMoreLines()) {
+            out << formatter.nextLine();
+            if(formatter.hasMoreLines()) {
+                out << streamIterator.getOutputEOL();
+            } else if(formatter.getIsLineReady()) {
+                // missing closing brace with break-blocks
+                out << streamIterator.getOutputEOL();
+                out << formatter.nextLine();
+            }
+        }
+
+        // Same as CodeFormatter::DoFormatWithAstyle: trim the output and terminate it with the configured EOL
+        std::string output = out.str();
+        size_t last = output.find_last_not_of(" \t\r\n");
+        if(last == std::string::npos) {
+            // nothing to format
+            NotifyFileDone(filename, kUnchanged);
+            continue;
+        }
+        output.erase(last + 1);
+        output.append(m_eol);
+
+        if(output == content) {
+            if(m_cache) { m_cache->Update(filename, BatchFormatCache::Hash(output)); }
+            NotifyFileDone(filename, kUnchanged);
+
+        } else if(WriteFile(filename, output)) {
+            if(m_cache) { m_cache->Update(filename, BatchFormatCache::Hash(output)); }
+            NotifyFileDone(filename, kFormatted);
+
+        } else {
+            NotifyFileDone(filename, kFailed);
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+// BatchFormatScanJob
+//------------------------------------------------------------------------
+
+BatchFormatScanJob::BatchFormatScanJob(wxEvtHandler* parent, const wxString& folder)
+    : Job(parent)
+    , m_folder(folder.c_str())
+{
+}
+
+BatchFormatScanJob::~BatchFormatScanJob() {}
+
+void BatchFormatScanJob::Process(wxThread* thread)
+{
+    wxUnusedVar(thread);
+
+    wxArrayString files;
+    if(wxDir::Exists(m_folder)) { wxDir::GetAllFiles(m_folder, &files); }
+
+    if(m_parent) {
+        clCommandEvent event(wxEVT_BATCH_FORMAT_SCAN_DONE);
+        event.SetFileName(m_folder);
+        event.SetStrings(files);
+        m_parent->AddPendingEvent(event);
+    }
+}
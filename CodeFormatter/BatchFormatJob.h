@@ -0,0 +1,136 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2014 Eran Ifrah
+// file name            : BatchFormatJob.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef BATCHFORMATJOB_H
+#define BATCHFORMATJOB_H
+
+#include "cl_command_event.h"
+#include "job.h"
+#include <map>
+#include <string>
+#include <wx/arrstr.h>
+#include <wx/thread.h>
+
+// Sent to the job's parent for every file processed by the batch formatter
+// clCommandEvent::GetFileName() holds the file, GetInt() holds a BatchFormatJob::eStatus value
+wxDECLARE_EVENT(wxEVT_BATCH_FORMAT_FILE_DONE, clCommandEvent);
+
+// Sent to the job's parent when a folder scan completes. clCommandEvent::GetStrings() holds the files found
+wxDECLARE_EVENT(wxEVT_BATCH_FORMAT_SCAN_DONE, clCommandEvent);
+
+/**
+ * @class BatchFormatCache
+ * @brief keeps the hash of the last formatted output per file. A file whose content still has this hash
+ * was already formatted with the same options and can be skipped. Shared by all the batch format workers
+ */
+class BatchFormatCache
+{
+    std::map<wxString, size_t> m_hashes;
+    size_t m_optionsHash;
+    wxMutex m_mutex;
+
+public:
+    BatchFormatCache();
+    virtual ~BatchFormatCache();
+
+    /**
+     * @brief set the formatting options hash. If the options changed, all the cached entries are dropped
+     */
+    void SetOptionsHash(size_t optionsHash);
+
+    /**
+     * @brief return true if 'hash' is the hash of the last formatted output of 'filename'
+     */
+    bool IsUpToDate(const wxString& filename, size_t hash);
+
+    /**
+     * @brief remember the hash of the formatted output of 'filename'
+     */
+    void Update(const wxString& filename, size_t hash);
+
+    /**
+     * @brief compute the hash of a buffer
+     */
+    static size_t Hash(const std::string& buffer);
+};
+
+/**
+ * @class BatchFormatJob
+ * @brief formats a list of files with AStyle in-process. Each job owns a single ASFormatter instance which is reused
+ * for all of its files. Files are written (atomically) only if the formatted output differs from the content on the
+ * disk
+ */
+class BatchFormatJob : public Job
+{
+public:
+    enum eStatus {
+        kFormatted = 0, // file was formatted and written
+        kUnchanged,     // file was formatted, the output is identical to the input
+        kUpToDate,      // file content matches the last formatted output, formatting skipped
+        kFailed,        // could not read/write the file
+    };
+
+protected:
+    wxArrayString m_files;
+    std::string m_options;
+    std::string m_eol;
+    BatchFormatCache* m_cache;
+
+protected:
+    bool ReadFile(const wxString& filename, std::string& content) const;
+    bool WriteFile(const wxString& filename, const std::string& content) const;
+    void NotifyFileDone(const wxString& filename, eStatus status);
+
+public:
+    /**
+     * @param parent the event handler receiving the wxEVT_BATCH_FORMAT_FILE_DONE events
+     * @param files files to format
+     * @param options AStyle options string
+     * @param eol the EOL appended to the formatted output
+     * @param cache the shared formatted-output cache
+     */
+    BatchFormatJob(wxEvtHandler* parent, const wxArrayString& files, const wxString& options, const wxString& eol,
+                   BatchFormatCache* cache);
+    virtual ~BatchFormatJob();
+
+    virtual void Process(wxThread* thread);
+};
+
+/**
+ * @class BatchFormatScanJob
+ * @brief collect the files of a folder in the background
+ */
+class BatchFormatScanJob : public Job
+{
+    wxString m_folder;
+
+public:
+    BatchFormatScanJob(wxEvtHandler* parent, const wxString& folder);
+    virtual ~BatchFormatScanJob();
+
+    virtual void Process(wxThread* thread);
+};
+
+#endif // BATCHFORMATJOB_H
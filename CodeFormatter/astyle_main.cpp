@@ -3734,6 +3734,13 @@ size_t ASEncoding::utf16ToUtf8(char* utf16In, size_t inLen, bool isBigEndian,
 
 //----------------------------------------------------------------------------
 
+#ifdef ASTYLE_LIB
+// used by the CodeFormatter batch formatter which drives ASFormatter directly
+template class ASStreamIterator<istringstream>;
+#endif
+
+//----------------------------------------------------------------------------
+
 }   // namespace astyle
 
 //----------------------------------------------------------------------------
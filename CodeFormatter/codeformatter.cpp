@@ -35,6 +35,7 @@
 #include "fileutils.h"
 #include "formatoptions.h"
 #include "globals.h"
+#include "jobqueue.h"
 #include "json_node.h"
 #include "macros.h"
 #include "phpoptions.h"
@@ -98,6 +99,12 @@ CL_PLUGIN_API int GetPluginInterfaceVersion() { return PLUGIN_INTERFACE_VERSION;
 
 CodeFormatter::CodeFormatter(IManager* manager)
     : IPlugin(manager)
+    , m_batchQueue(NULL)
+    , m_batchWorkers(0)
+    , m_batchTotal(0)
+    , m_batchProcessed(0)
+    , m_batchFormatted(0)
+    , m_batchFailed(0)
 {
     m_longName = _("Source Code Formatter");
     m_shortName = _("Source Code Formatter");
@@ -114,6 +121,8 @@ CodeFormatter::CodeFormatter(IManager* manager)
     EventNotifier::Get()->Bind(wxEVT_BEFORE_EDITOR_SAVE, clCommandEventHandler(CodeFormatter::OnBeforeFileSave), this);
     EventNotifier::Get()->Bind(wxEVT_PHP_SETTINGS_CHANGED, &CodeFormatter::OnPhpSettingsChanged, this);
     EventNotifier::Get()->Bind(wxEVT_CONTEXT_MENU_FOLDER, &CodeFormatter::OnContextMenu, this);
+    Bind(wxEVT_BATCH_FORMAT_FILE_DONE, &CodeFormatter::OnBatchFormatFileDone, this);
+    Bind(wxEVT_BATCH_FORMAT_SCAN_DONE, &CodeFormatter::OnBatchFormatScanDone, this);
 
     m_optionsPhp.Load();
     if(!m_mgr->GetConfigTool()->ReadObject("FormatterOptions", &m_options)) { m_options.AutodetectSettings(); }
@@ -449,7 +458,7 @@ void CodeFormatter::DoFormatWithClang(wxString& content, const wxFileName& fileN
     if(selStart != wxNOT_FOUND) { content = content.Mid(selStart, content.length() - tailLength - selStart); }
 }
 
-void CodeFormatter::DoFormatWithAstyle(wxString& content, const bool& appendEOL)
+wxString CodeFormatter::DoGetAstyleOptions()
 {
     wxString options = m_options.AstyleOptionsAsString();
 
@@ -458,6 +467,12 @@ void CodeFormatter::DoFormatWithAstyle(wxString& content, const bool& appendEOL)
     int tabWidth = m_mgr->GetEditorSettings()->GetTabWidth();
     int indentWidth = m_mgr->GetEditorSettings()->GetIndentWidth();
     options << (useTabs && tabWidth == indentWidth ? wxT(" -t") : wxT(" -s")) << indentWidth;
+    return options;
+}
+
+void CodeFormatter::DoFormatWithAstyle(wxString& content, const bool& appendEOL)
+{
+    wxString options = DoGetAstyleOptions();
 
     char* textOut = AStyleMain(_C(content), _C(options), ASErrorHandler, ASMemoryAlloc);
     content.clear();
@@ -590,6 +605,14 @@ void CodeFormatter::UnPlug()
                                  this);
     EventNotifier::Get()->Unbind(wxEVT_PHP_SETTINGS_CHANGED, &CodeFormatter::OnPhpSettingsChanged, this);
     EventNotifier::Get()->Unbind(wxEVT_CONTEXT_MENU_FOLDER, &CodeFormatter::OnContextMenu, this);
+
+    // Stop the batch formatter before we stop receiving its events
+    if(m_batchQueue) {
+        m_batchQueue->Stop();
+        wxDELETE(m_batchQueue);
+    }
+    Unbind(wxEVT_BATCH_FORMAT_FILE_DONE, &CodeFormatter::OnBatchFormatFileDone, this);
+    Unbind(wxEVT_BATCH_FORMAT_SCAN_DONE, &CodeFormatter::OnBatchFormatScanDone, this);
 }
 
 IManager* CodeFormatter::GetManager() { return m_mgr; }
@@ -646,9 +669,16 @@ void CodeFormatter::OnFormatFiles(wxCommandEvent& event)
 {
     wxUnusedVar(event);
 
-    wxArrayString files;
-    wxDir::GetAllFiles(m_selectedFolder, &files);
+    // Collect the files in the background, see OnBatchFormatScanDone
+    m_mgr->SetStatusMessage(_("Scanning folder for files to format..."), 0);
+    GetBatchQueue()->PushJob(new BatchFormatScanJob(this, m_selectedFolder));
+}
+
+void CodeFormatter::OnBatchFormatScanDone(clCommandEvent& event)
+{
+    m_mgr->SetStatusMessage(wxEmptyString, 0);
 
+    const wxArrayString& files = event.GetStrings();
     if(files.IsEmpty()) return;
 
     std::vector<wxFileName> filesToFormat;
@@ -693,25 +723,118 @@ void CodeFormatter::BatchFormat(const std::vector<wxFileName>& files)
         return;
     }
 
+    if(m_batchTotal) {
+        ::wxMessageBox(_("Source code formatting is already in progress"), _("Source Code Formatter"),
+                       wxOK | wxICON_WARNING | wxCENTER);
+        return;
+    }
+
     wxString msg;
     msg << _("You are about to beautify ") << files.size() << _(" files\nContinue?");
     if(wxYES != ::wxMessageBox(msg, _("Source Code Formatter"), wxYES_NO | wxCANCEL | wxCENTER)) { return; }
 
-    wxProgressDialog dlg(_("Source Code Formatter"), _("Formatting files..."), (int)files.size(),
+    // AStyle runs in-process and can be executed in the background, the other engines
+    // (external tools, PHP and XML formatters) are processed here
+    std::vector<wxFileName> astyleFiles;
+    std::vector<wxFileName> otherFiles;
+    for(size_t i = 0; i < files.size(); ++i) {
+        if(FindFormatter(files.at(i).GetFullPath()) == kFormatEngineAStyle) {
+            astyleFiles.push_back(files.at(i));
+        } else {
+            otherFiles.push_back(files.at(i));
+        }
+    }
+
+    if(!astyleFiles.empty()) { DoBatchFormatWithAstyle(astyleFiles); }
+    if(otherFiles.empty()) { return; }
+
+    wxProgressDialog dlg(_("Source Code Formatter"), _("Formatting files..."), (int)otherFiles.size(),
                          m_mgr->GetTheApp()->GetTopWindow());
 
-    for(size_t i = 0; i < files.size(); ++i) {
+    for(size_t i = 0; i < otherFiles.size(); ++i) {
         wxString msg;
-        msg << "[ " << i << " / " << files.size() << " ] " << files.at(i).GetFullName();
+        msg << "[ " << i << " / " << otherFiles.size() << " ] " << otherFiles.at(i).GetFullName();
         dlg.Update(i, msg);
 
-        FormatterEngine engine = FindFormatter(files.at(i).GetFullPath());
-        DoFormatFile(files.at(i).GetFullPath(), engine);
+        FormatterEngine engine = FindFormatter(otherFiles.at(i).GetFullPath());
+        DoFormatFile(otherFiles.at(i).GetFullPath(), engine);
     }
 
     EventNotifier::Get()->PostReloadExternallyModifiedEvent(false);
 }
 
+JobQueue* CodeFormatter::GetBatchQueue()
+{
+    if(!m_batchQueue) {
+        int cpus = wxThread::GetCPUCount();
+        m_batchWorkers = cpus > 0 ? (size_t)cpus : 1;
+        m_batchQueue = new JobQueue();
+        m_batchQueue->Start(m_batchWorkers);
+    }
+    return m_batchQueue;
+}
+
+void CodeFormatter::DoBatchFormatWithAstyle(const std::vector<wxFileName>& files)
+{
+    JobQueue* queue = GetBatchQueue();
+
+    // Files still matching their last formatted output are skipped, unless the options were modified since
+    wxString options = DoGetAstyleOptions();
+    wxString eol = DoGetGlobalEOLString();
+    wxString optionsKey = options + eol;
+    m_batchCache.SetOptionsHash(BatchFormatCache::Hash(optionsKey.mb_str(wxConvUTF8).data()));
+
+    // One job per worker, each job owns its own formatter
+    std::vector<wxArrayString> chunks(m_batchWorkers);
+    for(size_t i = 0; i < files.size(); ++i) {
+        chunks[i % m_batchWorkers].Add(files.at(i).GetFullPath());
+    }
+
+    m_batchTotal = files.size();
+    m_batchProcessed = 0;
+    m_batchFormatted = 0;
+    m_batchFailed = 0;
+
+    for(size_t i = 0; i < chunks.size(); ++i) {
+        if(chunks[i].IsEmpty()) { continue; }
+        queue->PushJob(new BatchFormatJob(this, chunks[i], options, eol, &m_batchCache));
+    }
+    m_mgr->SetStatusMessage(_("Formatting files..."), 0);
+}
+
+void CodeFormatter::OnBatchFormatFileDone(clCommandEvent& event)
+{
+    if(m_batchTotal == 0) { return; }
+
+    ++m_batchProcessed;
+    switch(event.GetInt()) {
+    case BatchFormatJob::kFormatted:
+        ++m_batchFormatted;
+        break;
+    case BatchFormatJob::kFailed:
+        ++m_batchFailed;
+        clWARNING() << "CodeFormatter: Failed to format file:" << event.GetFileName() << clEndl;
+        break;
+    default:
+        break;
+    }
+
+    if(m_batchProcessed < m_batchTotal) {
+        wxString msg;
+        msg << _("Formatting files: [ ") << m_batchProcessed << " / " << m_batchTotal << " ]";
+        m_mgr->SetStatusMessage(msg, 0);
+        return;
+    }
+
+    wxString msg;
+    msg << _("Formatting completed: ") << m_batchFormatted << _(" files modified");
+    if(m_batchFailed) { msg << ", " << m_batchFailed << _(" errors"); }
+    m_mgr->SetStatusMessage(msg, 3);
+    m_batchTotal = 0;
+
+    if(m_batchFormatted) { EventNotifier::Get()->PostReloadExternallyModifiedEvent(false); }
+}
+
 void CodeFormatter::OnBeforeFileSave(clCommandEvent& e)
 {
     e.Skip();
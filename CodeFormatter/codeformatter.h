@@ -25,6 +25,7 @@
 #ifndef CODEFORMATTER_H
 #define CODEFORMATTER_H
 
+#include "BatchFormatJob.h"
 #include "cl_command_event.h"
 #include "fileextmanager.h"
 #include "formatoptions.h"
@@ -40,11 +41,21 @@ enum FormatterEngine {
     kFormatEngineWxXmlDocument,
 };
 
+class JobQueue;
 class CodeFormatter : public IPlugin
 {
     FormatOptions m_options;
     PhpOptions m_optionsPhp;
 
+    // Background batch formatting
+    JobQueue* m_batchQueue;
+    size_t m_batchWorkers;
+    BatchFormatCache m_batchCache;
+    size_t m_batchTotal;
+    size_t m_batchProcessed;
+    size_t m_batchFormatted;
+    size_t m_batchFailed;
+
 protected:
     wxString m_selectedFolder;
 
@@ -83,15 +94,24 @@ private:
         const int& selStart = wxNOT_FOUND,
         const int& selEnd = wxNOT_FOUND);
     void DoFormatWithAstyle(wxString& content, const bool& appendEOL = true);
+    wxString DoGetAstyleOptions();
     void DoFormatWithWxXmlDocument(const wxFileName& fileName);
 
     void OnPhpSettingsChanged(clCommandEvent& event);
 
+    JobQueue* GetBatchQueue();
+    /**
+     * @brief format the files using AStyle on the batch queue workers, the files are processed in the background
+     */
+    void DoBatchFormatWithAstyle(const std::vector<wxFileName>& files);
+    void OnBatchFormatFileDone(clCommandEvent& event);
+    void OnBatchFormatScanDone(clCommandEvent& event);
+
 public:
     wxString RunCommand(const wxString& command);
 
     /**
-     * @brief format list of files
+     * @brief format list of files. Files formatted by AStyle are processed in the background
      */
     void BatchFormat(const std::vector<wxFileName>& files);
     void OnContextMenu(clContextMenuEvent& event);
@@ -1,4 +1,5 @@
 #include "CxxPreProcessor.h"
+#include "CxxPreProcessorIncludeCache.h"
 #include <wx/regex.h>
 #include "file_logger.h"
 
@@ -48,10 +49,6 @@ CxxPreProcessor::ExpandInclude(const wxFileName& currentFile, const wxString& in
     includeName.Replace("<", "");
     includeName.Replace(">", "");
 
-    // Try the current file's directory first
-    wxArrayString paths = m_includePaths;
-    paths.Insert(currentFile.GetPath(), 0);
-
     if(m_noSuchFiles.count(includeStatement)) {
         // wxPrintf("No such file hit\n");
         return false;
@@ -65,6 +62,26 @@ CxxPreProcessor::ExpandInclude(const wxFileName& currentFile, const wxString& in
         return false;
     }
 
+    // Other preprocessor runs (on any thread) may have resolved this include already
+    wxString includingDir = currentFile.GetPath();
+    if(m_includePathsHash.IsEmpty()) {
+        m_includePathsHash = CxxPreProcessorIncludeCache::GetIncludePathsHash(m_includePaths);
+    }
+    wxString resolved;
+    if(CxxPreProcessorIncludeCache::Get().Find(m_includePathsHash, includingDir, includeStatement, resolved)) {
+        m_fileMapping.insert(std::make_pair(includeStatement, resolved));
+        if(resolved.IsEmpty()) {
+            m_noSuchFiles.insert(includeStatement);
+            return false;
+        }
+        outFile = wxFileName(resolved);
+        return true;
+    }
+
+    // Try the current file's directory first
+    wxArrayString paths = m_includePaths;
+    paths.Insert(includingDir, 0);
+
     for(size_t i = 0; i < paths.GetCount(); ++i) {
         wxString tmpfile;
         tmpfile << paths.Item(i) << "/" << includeName;
@@ -79,6 +96,7 @@ CxxPreProcessor::ExpandInclude(const wxFileName& currentFile, const wxString& in
                 fixedFileName.Normalize(wxPATH_NORM_DOTS);
                 tmpfile = fixedFileName.GetFullPath();
                 m_fileMapping.insert(std::make_pair(includeStatement, tmpfile));
+                CxxPreProcessorIncludeCache::Get().Insert(m_includePathsHash, includingDir, includeStatement, tmpfile);
                 outFile = fixedFileName;
                 return true;
             } else {
@@ -90,10 +108,15 @@ CxxPreProcessor::ExpandInclude(const wxFileName& currentFile, const wxString& in
     // remember that we could not locate this include statement
     m_noSuchFiles.insert(includeStatement);
     m_fileMapping.insert(std::make_pair(includeStatement, wxString()));
+    CxxPreProcessorIncludeCache::Get().Insert(m_includePathsHash, includingDir, includeStatement, wxEmptyString);
     return false;
 }
 
-void CxxPreProcessor::AddIncludePath(const wxString& path) { m_includePaths.Add(path); }
+void CxxPreProcessor::AddIncludePath(const wxString& path)
+{
+    m_includePaths.Add(path);
+    m_includePathsHash.Clear();
+}
 
 void CxxPreProcessor::AddDefinition(const wxString& def)
 {
@@ -135,6 +158,7 @@ wxString CxxPreProcessor::GetGxxCommand(const wxString& gxx, const wxString& fil
 void CxxPreProcessor::SetIncludePaths(const wxArrayString& includePaths)
 {
     m_includePaths.Clear();
+    m_includePathsHash.Clear();
     for(size_t i = 0; i < includePaths.GetCount(); ++i) {
         wxString path = includePaths.Item(i);
         path.Trim().Trim(false);
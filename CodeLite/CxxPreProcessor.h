@@ -36,6 +36,7 @@ class WXDLLIMPEXP_CL CxxPreProcessor
 {
     CxxPreProcessorToken::Map_t m_tokens;
     wxArrayString m_includePaths;
+    wxString m_includePathsHash;
     std::set<wxString> m_noSuchFiles;
     std::map<wxString, wxString> m_fileMapping;
     size_t m_options;
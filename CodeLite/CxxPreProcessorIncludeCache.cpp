@@ -0,0 +1,128 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2018 Eran Ifrah
+// File name            : CxxPreProcessorIncludeCache.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "CxxPreProcessorIncludeCache.h"
+#include "cl_config.h"
+#include "file_logger.h"
+
+// The number of seconds an include that could not be resolved is remembered
+#define INCLUDE_CACHE_MISSING_TTL 30
+
+CxxPreProcessorIncludeCache::CxxPreProcessorIncludeCache()
+    : m_missingCount(0)
+    , m_hits(0)
+    , m_misses(0)
+    , m_missingCleared(time(NULL))
+{
+    m_maxEntries = wxMax(1000, clConfig::Get().Read(kConfigCxxIncludeCacheMaxEntries, 50000));
+}
+
+CxxPreProcessorIncludeCache::~CxxPreProcessorIncludeCache() {}
+
+CxxPreProcessorIncludeCache& CxxPreProcessorIncludeCache::Get()
+{
+    static CxxPreProcessorIncludeCache cache;
+    return cache;
+}
+
+wxString CxxPreProcessorIncludeCache::GetIncludePathsHash(const wxArrayString& includePaths)
+{
+    wxString paths;
+    for(size_t i = 0; i < includePaths.GetCount(); ++i) {
+        paths << includePaths.Item(i) << ";";
+    }
+    return wxString::Format("%lx", (unsigned long)std::hash<wxString>()(paths));
+}
+
+bool CxxPreProcessorIncludeCache::Find(const wxString& pathsHash, const wxString& includingDir,
+                                       const wxString& includeStatement, wxString& resolved)
+{
+    wxString key;
+    key << pathsHash << "|" << includingDir << "|" << includeStatement;
+
+    wxMutexLocker locker(m_mutex);
+    if(m_missingCount && (time(NULL) - m_missingCleared) >= INCLUDE_CACHE_MISSING_TTL) {
+        // The missing files may have been created since
+        DoClearMissing();
+    }
+
+    Map_t::const_iterator iter = m_entries.find(key);
+    if(iter == m_entries.end()) {
+        ++m_misses;
+        return false;
+    }
+    ++m_hits;
+    // Deep copy: the entry is shared between threads
+    resolved = iter->second.c_str();
+    return true;
+}
+
+void CxxPreProcessorIncludeCache::Insert(const wxString& pathsHash, const wxString& includingDir,
+                                         const wxString& includeStatement, const wxString& resolved)
+{
+    wxString key;
+    key << pathsHash << "|" << includingDir << "|" << includeStatement;
+
+    wxMutexLocker locker(m_mutex);
+    if(m_entries.size() >= m_maxEntries) {
+        // Start over, the entries that are still needed will be added back quickly
+        CL_DEBUG("Include cache is full (%u entries, hits: %u, misses: %u), clearing it", (unsigned)m_entries.size(),
+                 (unsigned)m_hits, (unsigned)m_misses);
+        m_entries.clear();
+        m_missingCount = 0;
+    }
+
+    std::pair<Map_t::iterator, bool> res = m_entries.insert(std::make_pair(key, wxString(resolved.c_str())));
+    if(res.second && resolved.IsEmpty()) { ++m_missingCount; }
+}
+
+void CxxPreProcessorIncludeCache::Clear()
+{
+    wxMutexLocker locker(m_mutex);
+    m_entries.clear();
+    m_missingCount = 0;
+}
+
+void CxxPreProcessorIncludeCache::ClearMissing()
+{
+    wxMutexLocker locker(m_mutex);
+    DoClearMissing();
+}
+
+void CxxPreProcessorIncludeCache::DoClearMissing()
+{
+    m_missingCleared = time(NULL);
+    if(m_missingCount == 0) { return; }
+
+    Map_t::iterator iter = m_entries.begin();
+    while(iter != m_entries.end()) {
+        if(iter->second.IsEmpty()) {
+            iter = m_entries.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+    m_missingCount = 0;
+}
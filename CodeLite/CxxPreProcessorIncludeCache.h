@@ -0,0 +1,97 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2018 Eran Ifrah
+// File name            : CxxPreProcessorIncludeCache.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef CXXPREPROCESSORINCLUDECACHE_H
+#define CXXPREPROCESSORINCLUDECACHE_H
+
+#include "codelite_exports.h"
+#include "wxStringHash.h"
+#include <unordered_map>
+#include <wx/arrstr.h>
+#include <wx/string.h>
+#include <wx/thread.h>
+
+/**
+ * @class CxxPreProcessorIncludeCache
+ * @brief a process wide cache of resolved include statements, shared by all the CxxPreProcessor instances
+ * (and threads). An entry is keyed by the include paths, the including directory and the include statement.
+ * Failures to resolve an include are cached as well (as an empty path). The cache must be invalidated
+ * whenever files are created, deleted or renamed. Since files can also be created outside of the editor
+ * (generated headers, build output...), the failures are dropped every 30 seconds anyway
+ */
+class WXDLLIMPEXP_CL CxxPreProcessorIncludeCache
+{
+    typedef std::unordered_map<wxString, wxString> Map_t;
+    Map_t m_entries;
+    size_t m_missingCount;
+    size_t m_maxEntries;
+    size_t m_hits;
+    size_t m_misses;
+    time_t m_missingCleared;
+    wxMutex m_mutex;
+
+private:
+    void DoClearMissing();
+
+private:
+    CxxPreProcessorIncludeCache();
+    virtual ~CxxPreProcessorIncludeCache();
+
+public:
+    static CxxPreProcessorIncludeCache& Get();
+
+    /**
+     * @brief return a hash for a list of include paths, to be used with Find/Insert
+     */
+    static wxString GetIncludePathsHash(const wxArrayString& includePaths);
+
+    /**
+     * @brief find a cached resolution for an include statement
+     * @param resolved [output] the full path of the include file. Empty if the include could not be resolved
+     * @return true if the statement is in the cache
+     */
+    bool Find(const wxString& pathsHash, const wxString& includingDir, const wxString& includeStatement,
+              wxString& resolved);
+
+    /**
+     * @brief cache the resolution of an include statement. Pass an empty 'resolved' for includes that
+     * could not be resolved
+     */
+    void Insert(const wxString& pathsHash, const wxString& includingDir, const wxString& includeStatement,
+                const wxString& resolved);
+
+    /**
+     * @brief drop all the entries
+     */
+    void Clear();
+
+    /**
+     * @brief drop the includes that could not be resolved. Call this when a file is added, a new file
+     * may resolve one of them
+     */
+    void ClearMissing();
+};
+
+#endif // CXXPREPROCESSORINCLUDECACHE_H
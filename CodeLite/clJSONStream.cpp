@@ -0,0 +1,495 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2018 Eran Ifrah
+// File name            : clJSONStream.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "clJSONStream.h"
+#include <stdlib.h>
+#include <string.h>
+
+namespace
+{
+// The reader and the writer work on chunks of this size
+const size_t CHUNK_SIZE = 64 * 1024;
+
+bool HexValue(char ch, unsigned int& value)
+{
+    if(ch >= '0' && ch <= '9') {
+        value = ch - '0';
+    } else if(ch >= 'a' && ch <= 'f') {
+        value = ch - 'a' + 10;
+    } else if(ch >= 'A' && ch <= 'F') {
+        value = ch - 'A' + 10;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void AppendUTF8(std::string& str, unsigned int cp)
+{
+    if(cp < 0x80) {
+        str += (char)cp;
+    } else if(cp < 0x800) {
+        str += (char)(0xC0 | (cp >> 6));
+        str += (char)(0x80 | (cp & 0x3F));
+    } else if(cp < 0x10000) {
+        str += (char)(0xE0 | (cp >> 12));
+        str += (char)(0x80 | ((cp >> 6) & 0x3F));
+        str += (char)(0x80 | (cp & 0x3F));
+    } else {
+        str += (char)(0xF0 | (cp >> 18));
+        str += (char)(0x80 | ((cp >> 12) & 0x3F));
+        str += (char)(0x80 | ((cp >> 6) & 0x3F));
+        str += (char)(0x80 | (cp & 0x3F));
+    }
+}
+} // namespace
+
+//===------------------------------------------------------------
+// clJSONStreamReader
+//===------------------------------------------------------------
+
+bool clJSONStreamReader::StringView::operator==(const char* str) const
+{
+    size_t len = strlen(str);
+    return len == m_length && memcmp(m_data, str, len) == 0;
+}
+
+clJSONStreamReader::clJSONStreamReader(const wxFileName& filename)
+    : m_data(NULL)
+    , m_pos(0)
+    , m_end(0)
+    , m_eof(false)
+    , m_ok(false)
+    , m_expectKey(false)
+    , m_token(kEOF)
+{
+    if(m_fp.Open(filename.GetFullPath(), "rb")) {
+        m_chunk.resize(CHUNK_SIZE);
+        m_ok = true;
+    }
+}
+
+clJSONStreamReader::clJSONStreamReader(const char* data, size_t length)
+    : m_data(data)
+    , m_pos(0)
+    , m_end(length)
+    , m_eof(true)
+    , m_ok(data != NULL)
+    , m_expectKey(false)
+    , m_token(kEOF)
+{
+}
+
+clJSONStreamReader::~clJSONStreamReader() {}
+
+bool clJSONStreamReader::Fill()
+{
+    if(m_eof || !m_fp.IsOpened()) { return false; }
+    size_t count = m_fp.Read(&m_chunk[0], m_chunk.size());
+    if(count == 0) {
+        m_eof = true;
+        return false;
+    }
+    m_data = &m_chunk[0];
+    m_pos = 0;
+    m_end = count;
+    return true;
+}
+
+clJSONStreamReader::eToken clJSONStreamReader::SetToken(eToken token)
+{
+    if(token == kError) { m_ok = false; }
+    m_token = token;
+    return m_token;
+}
+
+void clJSONStreamReader::ValueCompleted() { m_expectKey = !m_containers.empty() && m_containers.back() == '{'; }
+
+bool clJSONStreamReader::ReadUnicodeEscape()
+{
+    unsigned int cp = 0;
+    for(int i = 0; i < 4; ++i) {
+        char ch;
+        unsigned int digit;
+        if(!Get(ch) || !HexValue(ch, digit)) { return false; }
+        cp = (cp << 4) | digit;
+    }
+
+    if(cp >= 0xD800 && cp <= 0xDBFF) {
+        // A surrogate pair: the low surrogate must follow
+        char backslash, u;
+        if(!Get(backslash) || !Get(u) || backslash != '\\' || u != 'u') { return false; }
+        unsigned int low = 0;
+        for(int i = 0; i < 4; ++i) {
+            char ch;
+            unsigned int digit;
+            if(!Get(ch) || !HexValue(ch, digit)) { return false; }
+            low = (low << 4) | digit;
+        }
+        if(low < 0xDC00 || low > 0xDFFF) { return false; }
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+    }
+    AppendUTF8(m_value, cp);
+    return true;
+}
+
+bool clJSONStreamReader::ReadString()
+{
+    m_value.clear();
+    while(true) {
+        // Copy the plain characters in one go
+        size_t start = m_pos;
+        while(m_pos < m_end && m_data[m_pos] != '"' && m_data[m_pos] != '\\') {
+            ++m_pos;
+        }
+        m_value.append(m_data + start, m_pos - start);
+        if(m_pos == m_end) {
+            if(!Fill()) { return false; }
+            continue;
+        }
+
+        char ch = m_data[m_pos++];
+        if(ch == '"') { return true; }
+
+        // An escape sequence
+        char esc;
+        if(!Get(esc)) { return false; }
+        switch(esc) {
+        case '"':
+        case '\\':
+        case '/':
+            m_value += esc;
+            break;
+        case 'b':
+            m_value += '\b';
+            break;
+        case 'f':
+            m_value += '\f';
+            break;
+        case 'n':
+            m_value += '\n';
+            break;
+        case 'r':
+            m_value += '\r';
+            break;
+        case 't':
+            m_value += '\t';
+            break;
+        case 'u':
+            if(!ReadUnicodeEscape()) { return false; }
+            break;
+        default:
+            return false;
+        }
+    }
+}
+
+bool clJSONStreamReader::ReadNumber()
+{
+    m_value.clear();
+    while(true) {
+        while(m_pos < m_end) {
+            char ch = m_data[m_pos];
+            if((ch >= '0' && ch <= '9') || ch == '-' || ch == '+' || ch == '.' || ch == 'e' || ch == 'E') {
+                m_value += ch;
+                ++m_pos;
+            } else {
+                return !m_value.empty();
+            }
+        }
+        // A number may end the document
+        if(!Fill()) { return !m_value.empty(); }
+    }
+}
+
+bool clJSONStreamReader::ReadLiteral(const char* literal)
+{
+    for(const char* p = literal; *p; ++p) {
+        char ch;
+        if(!Get(ch) || ch != *p) { return false; }
+    }
+    return true;
+}
+
+clJSONStreamReader::eToken clJSONStreamReader::Next()
+{
+    if(!m_ok) { return SetToken(kError); }
+    if(!SkipWhitespace()) {
+        // Running out of input is only valid once all the containers are closed
+        return SetToken(m_containers.empty() ? kEOF : kError);
+    }
+
+    char ch = m_data[m_pos];
+    if(m_expectKey && ch != '"' && ch != '}') { return SetToken(kError); }
+
+    switch(ch) {
+    case '{':
+        ++m_pos;
+        m_containers.push_back('{');
+        m_expectKey = true;
+        return SetToken(kObjectStart);
+    case '[':
+        ++m_pos;
+        m_containers.push_back('[');
+        m_expectKey = false;
+        return SetToken(kArrayStart);
+    case '}':
+    case ']': {
+        char open = (ch == '}') ? '{' : '[';
+        if(m_containers.empty() || m_containers.back() != open) { return SetToken(kError); }
+        ++m_pos;
+        m_containers.pop_back();
+        ValueCompleted();
+        return SetToken(ch == '}' ? kObjectEnd : kArrayEnd);
+    }
+    case '"':
+        ++m_pos;
+        if(!ReadString()) { return SetToken(kError); }
+        if(m_expectKey) {
+            m_expectKey = false;
+            return SetToken(kKey);
+        }
+        ValueCompleted();
+        return SetToken(kString);
+    case 't':
+        if(!ReadLiteral("true")) { return SetToken(kError); }
+        ValueCompleted();
+        return SetToken(kTrue);
+    case 'f':
+        if(!ReadLiteral("false")) { return SetToken(kError); }
+        ValueCompleted();
+        return SetToken(kFalse);
+    case 'n':
+        if(!ReadLiteral("null")) { return SetToken(kError); }
+        ValueCompleted();
+        return SetToken(kNull);
+    default:
+        if(ch != '-' && (ch < '0' || ch > '9')) { return SetToken(kError); }
+        if(!ReadNumber()) { return SetToken(kError); }
+        ValueCompleted();
+        return SetToken(kNumber);
+    }
+}
+
+bool clJSONStreamReader::SkipValue()
+{
+    if(m_token != kObjectStart && m_token != kArrayStart) { return m_ok; }
+
+    // Read until the container that was just opened is closed
+    size_t depth = m_containers.size();
+    while(m_containers.size() >= depth) {
+        eToken token = Next();
+        if(token == kError || token == kEOF) { return false; }
+    }
+    return true;
+}
+
+double clJSONStreamReader::GetDouble(double defaultValue) const
+{
+    double d;
+    if(m_token != kNumber || !wxString(m_value.c_str(), wxConvUTF8).ToCDouble(&d)) { return defaultValue; }
+    return d;
+}
+
+long clJSONStreamReader::GetLong(long defaultValue) const
+{
+    if(m_token != kNumber) { return defaultValue; }
+    char* end = NULL;
+    long l = strtol(m_value.c_str(), &end, 10);
+    return (end == m_value.c_str()) ? defaultValue : l;
+}
+
+//===------------------------------------------------------------
+// clJSONStreamWriter
+//===------------------------------------------------------------
+
+clJSONStreamWriter::clJSONStreamWriter(const wxFileName& filename)
+    : m_afterKey(false)
+    , m_ok(false)
+{
+    m_ok = m_fp.Open(filename.GetFullPath(), "w+b");
+    m_buffer.reserve(CHUNK_SIZE + 1024);
+}
+
+clJSONStreamWriter::~clJSONStreamWriter() { Close(); }
+
+bool clJSONStreamWriter::Flush()
+{
+    if(!m_ok) { return false; }
+    if(!m_buffer.empty()) {
+        if(m_fp.Write(m_buffer.data(), m_buffer.length()) != m_buffer.length()) { m_ok = false; }
+        m_buffer.clear();
+    }
+    return m_ok;
+}
+
+void clJSONStreamWriter::FlushIfNeeded()
+{
+    if(m_buffer.length() >= CHUNK_SIZE) { Flush(); }
+}
+
+bool clJSONStreamWriter::Close()
+{
+    if(!m_fp.IsOpened()) { return m_ok; }
+    Flush();
+    if(!m_fp.Close()) { m_ok = false; }
+    return m_ok;
+}
+
+void clJSONStreamWriter::BeforeValue()
+{
+    if(m_afterKey) {
+        m_afterKey = false;
+        return;
+    }
+    if(m_hasElements.empty()) { return; }
+    if(m_hasElements.back()) { m_buffer += ','; }
+    m_hasElements.back() = true;
+    // Place each of the top level elements on its own line
+    if(m_hasElements.size() == 1) { m_buffer += '\n'; }
+}
+
+void clJSONStreamWriter::WriteEscaped(const char* str, size_t length)
+{
+    static const char* hex = "0123456789abcdef";
+    m_buffer += '"';
+    for(size_t i = 0; i < length; ++i) {
+        unsigned char ch = (unsigned char)str[i];
+        switch(ch) {
+        case '"':
+            m_buffer += "\\\"";
+            break;
+        case '\\':
+            m_buffer += "\\\\";
+            break;
+        case '\n':
+            m_buffer += "\\n";
+            break;
+        case '\r':
+            m_buffer += "\\r";
+            break;
+        case '\t':
+            m_buffer += "\\t";
+            break;
+        default:
+            if(ch < 0x20) {
+                m_buffer += "\\u00";
+                m_buffer += hex[ch >> 4];
+                m_buffer += hex[ch & 0xF];
+            } else {
+                m_buffer += (char)ch;
+            }
+            break;
+        }
+    }
+    m_buffer += '"';
+}
+
+clJSONStreamWriter& clJSONStreamWriter::StartObject()
+{
+    BeforeValue();
+    m_buffer += '{';
+    m_hasElements.push_back(false);
+    return *this;
+}
+
+clJSONStreamWriter& clJSONStreamWriter::EndObject()
+{
+    if(m_hasElements.empty()) { return *this; }
+    bool topLevel = (m_hasElements.size() == 1) && m_hasElements.back();
+    m_hasElements.pop_back();
+    if(topLevel) { m_buffer += '\n'; }
+    m_buffer += '}';
+    FlushIfNeeded();
+    return *this;
+}
+
+clJSONStreamWriter& clJSONStreamWriter::StartArray()
+{
+    BeforeValue();
+    m_buffer += '[';
+    m_hasElements.push_back(false);
+    return *this;
+}
+
+clJSONStreamWriter& clJSONStreamWriter::EndArray()
+{
+    if(m_hasElements.empty()) { return *this; }
+    bool topLevel = (m_hasElements.size() == 1) && m_hasElements.back();
+    m_hasElements.pop_back();
+    if(topLevel) { m_buffer += '\n'; }
+    m_buffer += ']';
+    FlushIfNeeded();
+    return *this;
+}
+
+clJSONStreamWriter& clJSONStreamWriter::Key(const wxString& key)
+{
+    BeforeValue();
+    const wxScopedCharBuffer cb = key.utf8_str();
+    WriteEscaped(cb.data(), cb.length());
+    m_buffer += ':';
+    m_afterKey = true;
+    return *this;
+}
+
+clJSONStreamWriter& clJSONStreamWriter::WriteString(const wxString& value)
+{
+    BeforeValue();
+    const wxScopedCharBuffer cb = value.utf8_str();
+    WriteEscaped(cb.data(), cb.length());
+    FlushIfNeeded();
+    return *this;
+}
+
+clJSONStreamWriter& clJSONStreamWriter::WriteNumber(long value)
+{
+    BeforeValue();
+    m_buffer += wxString::Format("%ld", value).ToStdString();
+    FlushIfNeeded();
+    return *this;
+}
+
+clJSONStreamWriter& clJSONStreamWriter::WriteNumber(double value)
+{
+    BeforeValue();
+    m_buffer += wxString::FromCDouble(value).ToStdString();
+    FlushIfNeeded();
+    return *this;
+}
+
+clJSONStreamWriter& clJSONStreamWriter::WriteBool(bool value)
+{
+    BeforeValue();
+    m_buffer += value ? "true" : "false";
+    return *this;
+}
+
+clJSONStreamWriter& clJSONStreamWriter::WriteNull()
+{
+    BeforeValue();
+    m_buffer += "null";
+    return *this;
+}
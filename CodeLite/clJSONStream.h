@@ -0,0 +1,240 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2018 Eran Ifrah
+// File name            : clJSONStream.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef CLJSONSTREAM_H
+#define CLJSONSTREAM_H
+
+#include "codelite_exports.h"
+#include <string>
+#include <vector>
+#include <wx/ffile.h>
+#include <wx/filename.h>
+#include <wx/string.h>
+
+/**
+ * @class clJSONStreamReader
+ * @brief a pull parser for JSON documents. Unlike JSONRoot, the document is never loaded as a whole:
+ * the file is read in fixed size chunks and only the current token is kept in memory.
+ * Typical usage:
+ *
+ * clJSONStreamReader reader(fn);
+ * if(reader.Next() == clJSONStreamReader::kArrayStart) {
+ *     while(reader.Next() == clJSONStreamReader::kObjectStart) {
+ *         while(reader.Next() == clJSONStreamReader::kKey) {
+ *             if(reader.GetValue() == "name" && reader.Next() == clJSONStreamReader::kString) {
+ *                 ...
+ *             } else {
+ *                 reader.Next();
+ *                 reader.SkipValue();
+ *             }
+ *         }
+ *     }
+ * }
+ */
+class WXDLLIMPEXP_CL clJSONStreamReader
+{
+public:
+    enum eToken {
+        kError = -1,
+        kEOF = 0,
+        kObjectStart,
+        kObjectEnd,
+        kArrayStart,
+        kArrayEnd,
+        kKey,
+        kString,
+        kNumber,
+        kTrue,
+        kFalse,
+        kNull,
+    };
+
+    /**
+     * @brief a view into the reader's UTF-8 buffer. It is valid until the next call to Next()
+     */
+    struct WXDLLIMPEXP_CL StringView {
+        const char* m_data;
+        size_t m_length;
+
+        StringView(const char* data, size_t length)
+            : m_data(data)
+            , m_length(length)
+        {
+        }
+        bool operator==(const char* str) const;
+        bool operator!=(const char* str) const { return !(*this == str); }
+        wxString ToString() const { return wxString::FromUTF8(m_data, m_length); }
+    };
+
+protected:
+    wxFFile m_fp;
+    std::vector<char> m_chunk;
+    const char* m_data;
+    size_t m_pos;
+    size_t m_end;
+    bool m_eof;
+    bool m_ok;
+
+    // The value of the current kKey, kString or kNumber token (unescaped)
+    std::string m_value;
+    // The open containers: '{' or '['
+    std::vector<char> m_containers;
+    bool m_expectKey;
+    eToken m_token;
+
+protected:
+    bool Fill();
+    inline bool SkipWhitespace()
+    {
+        while(true) {
+            while(m_pos < m_end) {
+                char ch = m_data[m_pos];
+                if(ch == ' ' || ch == '\n' || ch == '\r' || ch == '\t' || ch == ',' || ch == ':') {
+                    ++m_pos;
+                } else {
+                    return true;
+                }
+            }
+            if(!Fill()) { return false; }
+        }
+    }
+    inline bool Get(char& ch)
+    {
+        if(m_pos == m_end && !Fill()) { return false; }
+        ch = m_data[m_pos++];
+        return true;
+    }
+    bool ReadString();
+    bool ReadUnicodeEscape();
+    bool ReadNumber();
+    bool ReadLiteral(const char* literal);
+    eToken SetToken(eToken token);
+    void ValueCompleted();
+
+private:
+    clJSONStreamReader(const clJSONStreamReader&);
+    clJSONStreamReader& operator=(const clJSONStreamReader&);
+
+public:
+    /**
+     * @brief read the document from a file
+     */
+    clJSONStreamReader(const wxFileName& filename);
+    /**
+     * @brief read the document from a UTF-8 buffer. The buffer must outlive the reader
+     */
+    clJSONStreamReader(const char* data, size_t length);
+    virtual ~clJSONStreamReader();
+
+    bool IsOk() const { return m_ok; }
+
+    /**
+     * @brief advance to the next token. ',' and ':' are treated as separators
+     */
+    eToken Next();
+
+    /**
+     * @brief skip the value that starts with the current token. If the current token opens an object or
+     * an array, the reader moves to its matching end token. Scalar values are already consumed
+     */
+    bool SkipValue();
+
+    /**
+     * @brief the current token
+     */
+    eToken GetToken() const { return m_token; }
+
+    /**
+     * @brief return the raw value of the current kKey, kString or kNumber token
+     */
+    StringView GetValue() const { return StringView(m_value.c_str(), m_value.length()); }
+    wxString GetString() const { return wxString::FromUTF8(m_value.c_str(), m_value.length()); }
+    double GetDouble(double defaultValue = 0.0) const;
+    long GetLong(long defaultValue = 0) const;
+
+    /**
+     * @brief the nesting level of the current token
+     */
+    size_t GetDepth() const { return m_containers.size(); }
+};
+
+/**
+ * @class clJSONStreamWriter
+ * @brief write a JSON document token by token into a file. The output is buffered and written in chunks,
+ * so the document is never held in memory as a whole
+ */
+class WXDLLIMPEXP_CL clJSONStreamWriter
+{
+protected:
+    wxFFile m_fp;
+    std::string m_buffer;
+    // For each open container: does it already have an element?
+    std::vector<bool> m_hasElements;
+    bool m_afterKey;
+    bool m_ok;
+
+protected:
+    void BeforeValue();
+    void WriteEscaped(const char* str, size_t length);
+    void FlushIfNeeded();
+    bool Flush();
+
+private:
+    clJSONStreamWriter(const clJSONStreamWriter&);
+    clJSONStreamWriter& operator=(const clJSONStreamWriter&);
+
+public:
+    clJSONStreamWriter(const wxFileName& filename);
+    virtual ~clJSONStreamWriter();
+
+    bool IsOk() const { return m_ok; }
+
+    clJSONStreamWriter& StartObject();
+    clJSONStreamWriter& EndObject();
+    clJSONStreamWriter& StartArray();
+    clJSONStreamWriter& EndArray();
+    clJSONStreamWriter& Key(const wxString& key);
+    clJSONStreamWriter& WriteString(const wxString& value);
+    clJSONStreamWriter& WriteNumber(long value);
+    clJSONStreamWriter& WriteNumber(double value);
+    clJSONStreamWriter& WriteBool(bool value);
+    clJSONStreamWriter& WriteNull();
+
+    /**
+     * @brief write a "key": "value" pair
+     */
+    clJSONStreamWriter& WriteProperty(const wxString& key, const wxString& value)
+    {
+        return Key(key).WriteString(value);
+    }
+
+    /**
+     * @brief flush the remaining output and close the file
+     * @return true if the whole document was written successfully
+     */
+    bool Close();
+};
+
+#endif // CLJSONSTREAM_H
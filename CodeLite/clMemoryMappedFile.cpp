@@ -0,0 +1,111 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2018 Eran Ifrah
+// File name            : clMemoryMappedFile.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "clMemoryMappedFile.h"
+#include "file_logger.h"
+
+#ifdef __WXMSW__
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+clMemoryMappedFile::clMemoryMappedFile(const wxString& filename)
+    : m_data(NULL)
+    , m_size(0)
+#ifdef __WXMSW__
+    , m_file(INVALID_HANDLE_VALUE)
+    , m_mapping(NULL)
+#else
+    , m_fd(-1)
+#endif
+{
+#ifdef __WXMSW__
+    m_file = ::CreateFileW(filename.wc_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(m_file == INVALID_HANDLE_VALUE) { return; }
+
+    LARGE_INTEGER size;
+    if(!::GetFileSizeEx(m_file, &size) || size.QuadPart == 0 || (ULONGLONG)size.QuadPart > (size_t)-1) {
+        Close();
+        return;
+    }
+
+    m_mapping = ::CreateFileMappingW(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(!m_mapping) {
+        Close();
+        return;
+    }
+
+    m_data = (const char*)::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if(!m_data) {
+        Close();
+        return;
+    }
+    m_size = (size_t)size.QuadPart;
+#else
+    m_fd = ::open(filename.fn_str(), O_RDONLY);
+    if(m_fd < 0) { return; }
+
+    struct stat st;
+    if(::fstat(m_fd, &st) != 0 || st.st_size <= 0 || (unsigned long long)st.st_size > (size_t)-1) {
+        Close();
+        return;
+    }
+
+    void* addr = ::mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if(addr == MAP_FAILED) {
+        clWARNING() << "Failed to map file:" << filename << clEndl;
+        Close();
+        return;
+    }
+    // We read the view once, from start to end
+    ::madvise(addr, (size_t)st.st_size, MADV_SEQUENTIAL);
+    m_data = (const char*)addr;
+    m_size = (size_t)st.st_size;
+#endif
+}
+
+clMemoryMappedFile::~clMemoryMappedFile() { Close(); }
+
+void clMemoryMappedFile::Close()
+{
+#ifdef __WXMSW__
+    if(m_data) { ::UnmapViewOfFile(m_data); }
+    if(m_mapping) { ::CloseHandle(m_mapping); }
+    if(m_file != INVALID_HANDLE_VALUE) { ::CloseHandle(m_file); }
+    m_mapping = NULL;
+    m_file = INVALID_HANDLE_VALUE;
+#else
+    if(m_data) { ::munmap((void*)m_data, m_size); }
+    if(m_fd >= 0) { ::close(m_fd); }
+    m_fd = -1;
+#endif
+    m_data = NULL;
+    m_size = 0;
+}
@@ -0,0 +1,65 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2018 Eran Ifrah
+// File name            : clMemoryMappedFile.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef CLMEMORYMAPPEDFILE_H
+#define CLMEMORYMAPPEDFILE_H
+
+#include "codelite_exports.h"
+#include <wx/string.h>
+
+/**
+ * @class clMemoryMappedFile
+ * @brief a read-only view of a file mapped into memory. The mapping is released in the destructor
+ */
+class WXDLLIMPEXP_CL clMemoryMappedFile
+{
+    const char* m_data;
+    size_t m_size;
+#ifdef __WXMSW__
+    void* m_file;
+    void* m_mapping;
+#else
+    int m_fd;
+#endif
+
+    void Close();
+
+private:
+    clMemoryMappedFile(const clMemoryMappedFile&);
+    clMemoryMappedFile& operator=(const clMemoryMappedFile&);
+
+public:
+    clMemoryMappedFile(const wxString& filename);
+    virtual ~clMemoryMappedFile();
+
+    /**
+     * @brief return true if the file was mapped successfully. An empty file is never mapped
+     */
+    bool IsOk() const { return m_data != NULL; }
+    const char* GetData() const { return m_data; }
+    size_t GetSize() const { return m_size; }
+};
+
+#endif // CLMEMORYMAPPEDFILE_H
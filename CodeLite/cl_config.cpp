@@ -26,6 +26,7 @@
 #include "cl_config.h"
 #include <wx/stdpaths.h>
 #include <wx/filefn.h>
+#include <wx/ffile.h>
 #include <wx/log.h>
 #include <algorithm>
 #include "cl_standard_paths.h"
@@ -42,7 +43,63 @@
         parent.append(arr);                                  \
     }
 
-clConfig::clConfig(const wxString& filename)
+// The minimum time between 2 writes of the same configuration file
+#define CONFIG_FLUSH_INTERVAL_MS 1000
+
+class clConfigFlusher : public wxThread
+{
+    clConfig* m_config;
+    wxSemaphore m_stop;
+
+public:
+    clConfigFlusher(clConfig* config)
+        : wxThread(wxTHREAD_JOINABLE)
+        , m_config(config)
+    {
+    }
+    virtual ~clConfigFlusher() {}
+
+    void Stop()
+    {
+        m_stop.Post();
+        Wait();
+    }
+
+protected:
+    void* Entry()
+    {
+        // All the changes made since the last write are written as a single snapshot
+        while(m_stop.WaitTimeout(CONFIG_FLUSH_INTERVAL_MS) == wxSEMA_TIMEOUT) {
+            m_config->Flush();
+        }
+        return NULL;
+    }
+};
+
+namespace
+{
+// Write the content to a temporary file and rename it, so the file is never left half written
+bool WriteFileAtomically(const wxFileName& fn, const wxString& content)
+{
+    wxString tmpFile = fn.GetFullPath() + ".tmp";
+    {
+        wxFFile fp(tmpFile, wxT("w+b"));
+        if(!fp.IsOpened() || !fp.Write(content, wxConvUTF8)) { return false; }
+        fp.Close();
+    }
+    wxLogNull noLog;
+    if(!::wxRenameFile(tmpFile, fn.GetFullPath(), true)) {
+        ::wxRemoveFile(tmpFile);
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+clConfig::clConfig(const wxString& filename, bool writeBehind)
+    : m_dirty(false)
+    , m_flusher(NULL)
+    , m_writeBehind(writeBehind)
 {
     if(wxFileName(filename).IsAbsolute()) {
         m_filename = filename;
@@ -79,16 +136,21 @@ clConfig::clConfig(const wxString& filename)
     }
 }
 
-clConfig::~clConfig() { wxDELETE(m_root); }
+clConfig::~clConfig()
+{
+    Flush(true);
+    wxDELETE(m_root);
+}
 
 clConfig& clConfig::Get()
 {
-    static clConfig config;
+    static clConfig config("codelite.conf", true);
     return config;
 }
 
 bool clConfig::GetOutputTabOrder(wxArrayString& tabs, int& selected)
 {
+    wxCriticalSectionLocker locker(m_cs);
     if(m_root->toElement().hasNamedObject("outputTabOrder")) {
         JSONElement element = m_root->toElement().namedObject("outputTabOrder");
         tabs = element.namedObject("tabs").toArrayString();
@@ -100,18 +162,22 @@ bool clConfig::GetOutputTabOrder(wxArrayString& tabs, int& selected)
 
 void clConfig::SetOutputTabOrder(const wxArrayString& tabs, int selected)
 {
-    DoDeleteProperty("outputTabOrder");
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        DoDeleteProperty("outputTabOrder");
 
-    // first time
-    JSONElement e = JSONElement::createObject("outputTabOrder");
-    e.addProperty("tabs", tabs);
-    e.addProperty("selected", selected);
-    m_root->toElement().append(e);
-    m_root->save(m_filename);
+        // first time
+        JSONElement e = JSONElement::createObject("outputTabOrder");
+        e.addProperty("tabs", tabs);
+        e.addProperty("selected", selected);
+        m_root->toElement().append(e);
+    }
+    Save();
 }
 
 bool clConfig::GetWorkspaceTabOrder(wxArrayString& tabs, int& selected)
 {
+    wxCriticalSectionLocker locker(m_cs);
     if(m_root->toElement().hasNamedObject("workspaceTabOrder")) {
         JSONElement element = m_root->toElement().namedObject("workspaceTabOrder");
         tabs = element.namedObject("tabs").toArrayString();
@@ -123,15 +189,17 @@ bool clConfig::GetWorkspaceTabOrder(wxArrayString& tabs, int& selected)
 
 void clConfig::SetWorkspaceTabOrder(const wxArrayString& tabs, int selected)
 {
-    DoDeleteProperty("workspaceTabOrder");
-
-    // first time
-    JSONElement e = JSONElement::createObject("workspaceTabOrder");
-    e.addProperty("tabs", tabs);
-    e.addProperty("selected", selected);
-    m_root->toElement().append(e);
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        DoDeleteProperty("workspaceTabOrder");
 
-    m_root->save(m_filename);
+        // first time
+        JSONElement e = JSONElement::createObject("workspaceTabOrder");
+        e.addProperty("tabs", tabs);
+        e.addProperty("selected", selected);
+        m_root->toElement().append(e);
+    }
+    Save();
 }
 
 void clConfig::DoDeleteProperty(const wxString& property)
@@ -143,6 +211,7 @@ void clConfig::DoDeleteProperty(const wxString& property)
 
 bool clConfig::ReadItem(clConfigItem* item, const wxString& differentName)
 {
+    wxCriticalSectionLocker locker(m_cs);
     wxString nameToUse = differentName.IsEmpty() ? item->GetName() : differentName;
     if(m_root->toElement().hasNamedObject(nameToUse)) {
         item->FromJSON(m_root->toElement().namedObject(nameToUse));
@@ -153,16 +222,23 @@ bool clConfig::ReadItem(clConfigItem* item, const wxString& differentName)
 
 void clConfig::WriteItem(const clConfigItem* item, const wxString& differentName)
 {
-    wxString nameToUse = differentName.IsEmpty() ? item->GetName() : differentName;
-    DoDeleteProperty(nameToUse);
-    m_root->toElement().append(item->ToJSON());
-    m_root->save(m_filename);
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        wxString nameToUse = differentName.IsEmpty() ? item->GetName() : differentName;
+        DoDeleteProperty(nameToUse);
+        m_root->toElement().append(item->ToJSON());
+    }
+    Save();
 }
 
 void clConfig::Reload()
 {
     if(m_filename.FileExists() == false) return;
 
+    // Don't lose the changes that were not written yet
+    Flush();
+
+    wxCriticalSectionLocker locker(m_cs);
     delete m_root;
     m_root = new JSONRoot(m_filename);
 }
@@ -193,12 +269,68 @@ wxStringMap_t clConfig::MergeStringMaps(
 
 void clConfig::Save()
 {
-    if(m_root) m_root->save(m_filename);
+    bool flushNow = false;
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        if(!m_root) return;
+        m_dirty = true;
+
+        // The background writer is started on the first change
+        if(m_writeBehind && !m_flusher) {
+            m_flusher = new clConfigFlusher(this);
+            if(m_flusher->Create() != wxTHREAD_NO_ERROR || m_flusher->Run() != wxTHREAD_NO_ERROR) {
+                wxDELETE(m_flusher);
+                m_writeBehind = false;
+            }
+        }
+        flushNow = !m_writeBehind;
+    }
+
+    if(flushNow) { Flush(); }
+}
+
+void clConfig::Flush(bool shutdown)
+{
+    if(shutdown) {
+        clConfigFlusher* flusher = NULL;
+        {
+            wxCriticalSectionLocker locker(m_cs);
+            m_writeBehind = false;
+            flusher = m_flusher;
+            m_flusher = NULL;
+        }
+        if(flusher) {
+            flusher->Stop();
+            delete flusher;
+        }
+    }
+
+    // Holding m_flushCs makes sure that an older snapshot never overwrites a newer one
+    wxCriticalSectionLocker flushLocker(m_flushCs);
+    wxString content;
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        if(!m_dirty || !m_root) return;
+        content = m_root->toElement().format();
+        m_dirty = false;
+    }
+
+    if(!WriteFileAtomically(m_filename, content)) {
+        // Try again on the next flush
+        wxCriticalSectionLocker locker(m_cs);
+        m_dirty = true;
+    }
 }
 
 void clConfig::Save(const wxFileName& fn)
 {
-    if(m_root) m_root->save(fn);
+    wxString content;
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        if(!m_root) return;
+        content = m_root->toElement().format();
+    }
+    WriteFileAtomically(fn, content);
 }
 
 JSONElement clConfig::GetGeneralSetting()
@@ -212,17 +344,21 @@ JSONElement clConfig::GetGeneralSetting()
 
 void clConfig::Write(const wxString& name, bool value)
 {
-    JSONElement general = GetGeneralSetting();
-    if(general.hasNamedObject(name)) {
-        general.removeProperty(name);
-    }
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        JSONElement general = GetGeneralSetting();
+        if(general.hasNamedObject(name)) {
+            general.removeProperty(name);
+        }
 
-    general.addProperty(name, value);
+        general.addProperty(name, value);
+    }
     Save();
 }
 
 bool clConfig::Read(const wxString& name, bool defaultValue)
 {
+    wxCriticalSectionLocker locker(m_cs);
     JSONElement general = GetGeneralSetting();
     if(general.namedObject(name).isBool()) {
         return general.namedObject(name).toBool();
@@ -233,34 +369,42 @@ bool clConfig::Read(const wxString& name, bool defaultValue)
 
 void clConfig::Write(const wxString& name, int value)
 {
-    JSONElement general = GetGeneralSetting();
-    if(general.hasNamedObject(name)) {
-        general.removeProperty(name);
-    }
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        JSONElement general = GetGeneralSetting();
+        if(general.hasNamedObject(name)) {
+            general.removeProperty(name);
+        }
 
-    general.addProperty(name, value);
+        general.addProperty(name, value);
+    }
     Save();
 }
 
 int clConfig::Read(const wxString& name, int defaultValue)
 {
+    wxCriticalSectionLocker locker(m_cs);
     JSONElement general = GetGeneralSetting();
     return general.namedObject(name).toInt(defaultValue);
 }
 
 void clConfig::Write(const wxString& name, const wxString& value)
 {
-    JSONElement general = GetGeneralSetting();
-    if(general.hasNamedObject(name)) {
-        general.removeProperty(name);
-    }
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        JSONElement general = GetGeneralSetting();
+        if(general.hasNamedObject(name)) {
+            general.removeProperty(name);
+        }
 
-    general.addProperty(name, value);
+        general.addProperty(name, value);
+    }
     Save();
 }
 
 wxString clConfig::Read(const wxString& name, const wxString& defaultValue)
 {
+    wxCriticalSectionLocker locker(m_cs);
     JSONElement general = GetGeneralSetting();
     if(general.namedObject(name).isString()) {
         return general.namedObject(name).toString();
@@ -271,6 +415,7 @@ wxString clConfig::Read(const wxString& name, const wxString& defaultValue)
 
 int clConfig::GetAnnoyingDlgAnswer(const wxString& name, int defaultValue)
 {
+    wxCriticalSectionLocker locker(m_cs);
     if(m_root->toElement().hasNamedObject("AnnoyingDialogsAnswers")) {
 
         JSONElement element = m_root->toElement().namedObject("AnnoyingDialogsAnswers");
@@ -283,86 +428,99 @@ int clConfig::GetAnnoyingDlgAnswer(const wxString& name, int defaultValue)
 
 void clConfig::SetAnnoyingDlgAnswer(const wxString& name, int value)
 {
-    if(!m_root->toElement().hasNamedObject("AnnoyingDialogsAnswers")) {
-        JSONElement element = JSONElement::createObject("AnnoyingDialogsAnswers");
-        m_root->toElement().append(element);
-    }
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        if(!m_root->toElement().hasNamedObject("AnnoyingDialogsAnswers")) {
+            JSONElement element = JSONElement::createObject("AnnoyingDialogsAnswers");
+            m_root->toElement().append(element);
+        }
 
-    JSONElement element = m_root->toElement().namedObject("AnnoyingDialogsAnswers");
-    if(element.hasNamedObject(name)) {
-        element.removeProperty(name);
+        JSONElement element = m_root->toElement().namedObject("AnnoyingDialogsAnswers");
+        if(element.hasNamedObject(name)) {
+            element.removeProperty(name);
+        }
+        element.addProperty(name, value);
     }
-    element.addProperty(name, value);
     Save();
 }
 
 void clConfig::ClearAnnoyingDlgAnswers()
 {
-    DoDeleteProperty("AnnoyingDialogsAnswers");
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        DoDeleteProperty("AnnoyingDialogsAnswers");
+    }
     Save();
     Reload();
 }
 
 void clConfig::AddQuickFindReplaceItem(const wxString& str)
 {
-    ADD_OBJ_IF_NOT_EXISTS(m_root->toElement(), "QuickFindBar");
-
-    JSONElement quickFindBar = m_root->toElement().namedObject("QuickFindBar");
-    ADD_ARR_IF_NOT_EXISTS(quickFindBar, "ReplaceHistory");
-
-    JSONElement arr = quickFindBar.namedObject("ReplaceHistory");
-    wxArrayString items = arr.toArrayString();
-
-    // Update the array
-    int where = items.Index(str);
-    if(where != wxNOT_FOUND) {
-        items.RemoveAt(where);
-        items.Insert(str, 0);
-
-    } else {
-        // remove overflow items if needed
-        if(items.GetCount() > 20) {
-            // remove last item
-            items.RemoveAt(items.GetCount() - 1);
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        ADD_OBJ_IF_NOT_EXISTS(m_root->toElement(), "QuickFindBar");
+
+        JSONElement quickFindBar = m_root->toElement().namedObject("QuickFindBar");
+        ADD_ARR_IF_NOT_EXISTS(quickFindBar, "ReplaceHistory");
+
+        JSONElement arr = quickFindBar.namedObject("ReplaceHistory");
+        wxArrayString items = arr.toArrayString();
+
+        // Update the array
+        int where = items.Index(str);
+        if(where != wxNOT_FOUND) {
+            items.RemoveAt(where);
+            items.Insert(str, 0);
+
+        } else {
+            // remove overflow items if needed
+            if(items.GetCount() > 20) {
+                // remove last item
+                items.RemoveAt(items.GetCount() - 1);
+            }
+            items.Insert(str, 0);
         }
-        items.Insert(str, 0);
-    }
 
-    quickFindBar.removeProperty("ReplaceHistory");
-    quickFindBar.addProperty("ReplaceHistory", items);
+        quickFindBar.removeProperty("ReplaceHistory");
+        quickFindBar.addProperty("ReplaceHistory", items);
+    }
     Save();
 }
 
 void clConfig::AddQuickFindSearchItem(const wxString& str)
 {
-    ADD_OBJ_IF_NOT_EXISTS(m_root->toElement(), "QuickFindBar");
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        ADD_OBJ_IF_NOT_EXISTS(m_root->toElement(), "QuickFindBar");
 
-    JSONElement quickFindBar = m_root->toElement().namedObject("QuickFindBar");
-    ADD_ARR_IF_NOT_EXISTS(quickFindBar, "SearchHistory");
+        JSONElement quickFindBar = m_root->toElement().namedObject("QuickFindBar");
+        ADD_ARR_IF_NOT_EXISTS(quickFindBar, "SearchHistory");
 
-    JSONElement arr = quickFindBar.namedObject("SearchHistory");
-    wxArrayString items = arr.toArrayString();
+        JSONElement arr = quickFindBar.namedObject("SearchHistory");
+        wxArrayString items = arr.toArrayString();
 
-    // Update the array
-    int where = items.Index(str);
-    if(where != wxNOT_FOUND) {
-        items.RemoveAt(where);
-    }
-    items.Insert(str, 0);
+        // Update the array
+        int where = items.Index(str);
+        if(where != wxNOT_FOUND) {
+            items.RemoveAt(where);
+        }
+        items.Insert(str, 0);
 
-    // Reudce to size to max of 20
-    while(items.size() > 20) {
-        items.RemoveAt(items.size() - 1);
-    }
+        // Reudce to size to max of 20
+        while(items.size() > 20) {
+            items.RemoveAt(items.size() - 1);
+        }
 
-    // Update the array
-    quickFindBar.removeProperty("SearchHistory");
-    quickFindBar.addProperty("SearchHistory", items);
+        // Update the array
+        quickFindBar.removeProperty("SearchHistory");
+        quickFindBar.addProperty("SearchHistory", items);
+    }
     Save();
 }
 
 wxArrayString clConfig::GetQuickFindReplaceItems() const
 {
+    wxCriticalSectionLocker locker(m_cs);
     ADD_OBJ_IF_NOT_EXISTS(m_root->toElement(), "QuickFindBar");
     JSONElement quickFindBar = m_root->toElement().namedObject("QuickFindBar");
     ADD_ARR_IF_NOT_EXISTS(quickFindBar, "ReplaceHistory");
@@ -371,6 +529,7 @@ wxArrayString clConfig::GetQuickFindReplaceItems() const
 
 wxArrayString clConfig::GetQuickFindSearchItems() const
 {
+    wxCriticalSectionLocker locker(m_cs);
     ADD_OBJ_IF_NOT_EXISTS(m_root->toElement(), "QuickFindBar");
     JSONElement quickFindBar = m_root->toElement().namedObject("QuickFindBar");
     ADD_ARR_IF_NOT_EXISTS(quickFindBar, "SearchHistory");
@@ -379,6 +538,7 @@ wxArrayString clConfig::GetQuickFindSearchItems() const
 
 wxArrayString clConfig::Read(const wxString& name, const wxArrayString& defaultValue)
 {
+    wxCriticalSectionLocker locker(m_cs);
     JSONElement general = GetGeneralSetting();
     if(general.hasNamedObject(name)) {
         return general.namedObject(name).toArrayString();
@@ -388,12 +548,15 @@ wxArrayString clConfig::Read(const wxString& name, const wxArrayString& defaultV
 
 void clConfig::Write(const wxString& name, const wxArrayString& value)
 {
-    JSONElement general = GetGeneralSetting();
-    if(general.hasNamedObject(name)) {
-        general.removeProperty(name);
-    }
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        JSONElement general = GetGeneralSetting();
+        if(general.hasNamedObject(name)) {
+            general.removeProperty(name);
+        }
 
-    general.addProperty(name, value);
+        general.addProperty(name, value);
+    }
     Save();
 }
 
@@ -427,39 +590,46 @@ void clConfig::DoAddRecentItem(const wxString& propName, const wxString& filenam
     }
     recentItems.swap(existingFiles);
 
-    // Remove old node if exists
-    JSONElement e = m_root->toElement();
-    if(e.hasNamedObject(propName)) {
-        e.removeProperty(propName);
-    }
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        // Remove old node if exists
+        JSONElement e = m_root->toElement();
+        if(e.hasNamedObject(propName)) {
+            e.removeProperty(propName);
+        }
 
-    // append new property
-    e.addProperty(propName, recentItems);
+        // append new property
+        e.addProperty(propName, recentItems);
 
-    // update the cache
-    if(m_cacheRecentItems.count(propName)) {
-        m_cacheRecentItems.erase(propName);
-    }
+        // update the cache
+        if(m_cacheRecentItems.count(propName)) {
+            m_cacheRecentItems.erase(propName);
+        }
 
-    m_cacheRecentItems.insert(std::make_pair(propName, recentItems));
-    m_root->save(m_filename);
+        m_cacheRecentItems.insert(std::make_pair(propName, recentItems));
+    }
+    Save();
 }
 
 void clConfig::DoClearRecentItems(const wxString& propName)
 {
-    JSONElement e = m_root->toElement();
-    if(e.hasNamedObject(propName)) {
-        e.removeProperty(propName);
-    }
-    m_root->save(m_filename);
-    // update the cache
-    if(m_cacheRecentItems.count(propName)) {
-        m_cacheRecentItems.erase(propName);
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        JSONElement e = m_root->toElement();
+        if(e.hasNamedObject(propName)) {
+            e.removeProperty(propName);
+        }
+        // update the cache
+        if(m_cacheRecentItems.count(propName)) {
+            m_cacheRecentItems.erase(propName);
+        }
     }
+    Save();
 }
 
 wxArrayString clConfig::DoGetRecentItems(const wxString& propName) const
 {
+    wxCriticalSectionLocker locker(m_cs);
     wxArrayString recentItems;
 
     // Try the cache first
@@ -477,6 +647,7 @@ wxArrayString clConfig::DoGetRecentItems(const wxString& propName) const
 
 wxFont clConfig::Read(const wxString& name, const wxFont& defaultValue)
 {
+    wxCriticalSectionLocker locker(m_cs);
     JSONElement general = GetGeneralSetting();
     if(!general.hasNamedObject(name)) return defaultValue;
 
@@ -499,11 +670,14 @@ void clConfig::Write(const wxString& name, const wxFont& value)
     font.addProperty("bold", (value.GetWeight() == wxFONTWEIGHT_BOLD));
     font.addProperty("italic", (value.GetStyle() == wxFONTSTYLE_ITALIC));
 
-    JSONElement general = GetGeneralSetting();
-    if(general.hasNamedObject(name)) {
-        general.removeProperty(name);
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        JSONElement general = GetGeneralSetting();
+        if(general.hasNamedObject(name)) {
+            general.removeProperty(name);
+        }
+        general.append(font);
     }
-    general.append(font);
     Save();
 }
 
@@ -522,5 +696,4 @@ void clConfig::Write(const wxString& name, const wxColour& value)
 {
     wxString strValue = value.GetAsString(wxC2S_HTML_SYNTAX);
     Write(name, strValue);
-    Save();
 }
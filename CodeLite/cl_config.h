@@ -27,6 +27,7 @@
 #define CLCONFIG_H
 
 #include "codelite_exports.h"
+#include <wx/thread.h>
 #include "json_node.h"
 #include <map>
 
@@ -65,6 +66,11 @@ public:
 #define kConfigMaxItemsInFindReplaceDialog "MaxItemsInFindReplaceDialog"
 #define kConfigMaxOpenedTabs "MaxOpenedTabs"
 #define kConfigRestoreLastSession "RestoreLastSession"
+#define kConfigRestoreSessionLazily "RestoreSessionLazily"
+#define kConfigLargeFileSizeThreshold "LargeFileSizeThreshold"
+#define kConfigClangTUCacheMaxItems "ClangTUCacheMaxItems"
+#define kConfigClangTUCacheMemoryBudget "ClangTUCacheMemoryBudget" // MB
+#define kConfigCxxIncludeCacheMaxEntries "CxxIncludeCacheMaxEntries"
 #define kConfigFrameTitlePattern "FrameTitlePattern"
 #define kConfigStatusbarShowLine "StatusbarShowLine"
 #define kConfigStatusbarShowColumn "StatusbarShowColumn"
@@ -80,13 +86,26 @@ public:
 #define kConfigWorkspaceTabSashPosition "WorkspaceTabSashPosition"
 #define kConfigTabsPaneSortAlphabetically "TabsPaneSortAlphabetically"
 #define kConfigFileExplorerBookmarks "FileExplorerBookmarks"
-
+#define kConfigProjectSnapshots "ProjectSnapshots"
+
+class clConfigFlusher;
+/**
+ * @class clConfig
+ * @brief the configuration store. Changes of the global configuration are kept in memory and written to the disk
+ * by a background thread, at most once per second, as a single snapshot (written to a temporary file which is then
+ * renamed). The store can be accessed from any thread
+ */
 class WXDLLIMPEXP_CL clConfig
 {
 protected:
     wxFileName m_filename;
     JSONRoot* m_root;
     std::map<wxString, wxArrayString> m_cacheRecentItems;
+    mutable wxCriticalSection m_cs;
+    wxCriticalSection m_flushCs; // serializes the disk writes. Acquire it before m_cs
+    bool m_dirty;
+    clConfigFlusher* m_flusher;
+    bool m_writeBehind;
     
 protected:
     void DoDeleteProperty(const wxString& property);
@@ -99,7 +118,9 @@ protected:
 public:
     // We provide a global configuration
     // and the ability to allocate a private copy with a different file
-    clConfig(const wxString& filename = "codelite.conf");
+    // Only the global configuration uses the background writer ('writeBehind'): most of the private copies are
+    // short lived and write their changes immediately
+    clConfig(const wxString& filename = "codelite.conf", bool writeBehind = false);
     virtual ~clConfig();
     static clConfig& Get();
 
@@ -107,8 +128,13 @@ public:
     void Reload();
     // Save the content to a give file name
     void Save(const wxFileName& fn);
-    // Save the content the file passed on the construction
+    // Schedule a save of the content to the file passed on the construction
     void Save();
+    /**
+     * @brief write the pending changes to the disk now. Pass 'shutdown' as true when the application
+     * exits: the background writer is stopped and from this point on, changes are written immediately
+     */
+    void Flush(bool shutdown = false);
 
     // Utility functions
     //------------------------------
@@ -25,6 +25,8 @@
 
 #if USE_SFTP
 #include "cl_sftp.h"
+#include <deque>
+#include <vector>
 #include <wx/ffile.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -32,6 +34,11 @@
 #include <libssh/sftp.h>
 #include "cl_standard_paths.h"
 
+// Chunk sizes. 32K is the largest read size that all servers are required to support
+#define SFTP_READ_CHUNK_SIZE 32768
+#define SFTP_WRITE_CHUNK_SIZE 65536
+#define SFTP_MAX_PENDING_READS 16
+
 class SFTPDirCloser
 {
     sftp_dir m_dir;
@@ -44,6 +51,19 @@ public:
     ~SFTPDirCloser() { sftp_closedir(m_dir); }
 };
 
+class SFTPFileCloser
+{
+    sftp_file m_file;
+
+public:
+    SFTPFileCloser(sftp_file f)
+        : m_file(f)
+    {
+    }
+    ~SFTPFileCloser() { sftp_close(m_file); }
+    sftp_file Get() const { return m_file; }
+};
+
 clSFTP::clSFTP(clSSH::Ptr_t ssh)
     : m_ssh(ssh)
     , m_sftp(NULL)
@@ -98,19 +118,26 @@ void clSFTP::Write(const wxFileName& localFile,
                                      << ::strerror(errno));
     }
 
-    char buffer[4096];
-    wxMemoryBuffer memBuffer;
-    size_t nbytes(0);
-    while(!fp.Eof()) {
-        nbytes = fp.Read(buffer, sizeof(buffer));
-        if(nbytes == 0) break;
-        memBuffer.AppendData(buffer, nbytes);
+    // Stream the file: read a chunk from the disk and send it
+    wxString tmpRemoteFile = remotePath;
+    tmpRemoteFile << ".codelitesftp";
+    {
+        SFTPFileCloser file(DoOpenForWrite(tmpRemoteFile));
+        std::vector<char> buffer(SFTP_WRITE_CHUNK_SIZE);
+        while(true) {
+            size_t nbytes = fp.Read(buffer.data(), buffer.size());
+            if(nbytes == 0) {
+                if(fp.Error()) {
+                    throw clException(wxString() << "scp::Write error while reading file '"
+                                                 << localFile.GetFullPath() << "'");
+                }
+                break;
+            }
+            DoWriteChunk(file.Get(), buffer.data(), nbytes, tmpRemoteFile);
+        }
     }
     fp.Close();
-    Write(memBuffer, remotePath);
-    if(attributes && attributes->GetPermissions()) {
-        Chmod(remotePath, attributes->GetPermissions());
-    }
+    DoReplaceFile(tmpRemoteFile, remotePath, attributes);
 }
 
 void clSFTP::Write(const wxMemoryBuffer& fileContent,
@@ -121,36 +148,109 @@ void clSFTP::Write(const wxMemoryBuffer& fileContent,
         throw clException("SFTP is not initialized");
     }
 
-    int access_type = O_WRONLY | O_CREAT | O_TRUNC;
-    sftp_file file;
     wxString tmpRemoteFile = remotePath;
     tmpRemoteFile << ".codelitesftp";
+    {
+        SFTPFileCloser file(DoOpenForWrite(tmpRemoteFile));
+        const char* p = (const char*)fileContent.GetData();
+        size_t bytesLeft = fileContent.GetDataLen();
+        while(bytesLeft > 0) {
+            size_t chunkSize = wxMin(bytesLeft, (size_t)SFTP_WRITE_CHUNK_SIZE);
+            DoWriteChunk(file.Get(), p, chunkSize, tmpRemoteFile);
+            bytesLeft -= chunkSize;
+            p += chunkSize;
+        }
+    }
+    DoReplaceFile(tmpRemoteFile, remotePath, attributes);
+}
 
-    file = sftp_open(m_sftp, tmpRemoteFile.mb_str(wxConvUTF8).data(), access_type, 0644);
-    if(file == NULL) {
-        throw clException(wxString() << _("Can't open file: ") << tmpRemoteFile << ". "
+void clSFTP::WriteRanges(const wxFileName& localFile,
+                         const wxString& remotePath,
+                         const std::vector<std::pair<size_t, size_t> >& ranges,
+                         size_t newSize)
+{
+    if(!m_sftp) {
+        throw clException("SFTP is not initialized");
+    }
+
+    wxFFile fp(localFile.GetFullPath(), "rb");
+    if(!fp.IsOpened()) {
+        throw clException(wxString() << "scp::WriteRanges could not open file '" << localFile.GetFullPath() << "'. "
+                                     << ::strerror(errno));
+    }
+
+    {
+        sftp_file f = sftp_open(m_sftp, remotePath.mb_str(wxConvUTF8).data(), O_WRONLY, 0);
+        if(f == NULL) {
+            throw clException(wxString() << _("Can't open file: ") << remotePath << ". "
+                                         << ssh_get_error(m_ssh->GetSession()),
+                              sftp_get_error(m_sftp));
+        }
+        SFTPFileCloser file(f);
+
+        std::vector<char> buffer(SFTP_WRITE_CHUNK_SIZE);
+        for(size_t i = 0; i < ranges.size(); ++i) {
+            size_t offset = ranges[i].first;
+            size_t bytesLeft = ranges[i].second;
+            if(!fp.Seek(offset) || sftp_seek64(file.Get(), offset) < 0) {
+                throw clException(wxString() << "scp::WriteRanges failed to seek in file: " << remotePath);
+            }
+            while(bytesLeft > 0) {
+                size_t nbytes = fp.Read(buffer.data(), wxMin(bytesLeft, buffer.size()));
+                if(nbytes == 0) {
+                    throw clException(wxString() << "scp::WriteRanges error while reading file '"
+                                                 << localFile.GetFullPath() << "'");
+                }
+                DoWriteChunk(file.Get(), buffer.data(), nbytes, remotePath);
+                bytesLeft -= nbytes;
+            }
+        }
+    }
+
+    // Truncate (or extend) the file to its new size
+    struct sftp_attributes_struct attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.flags = SSH_FILEXFER_ATTR_SIZE;
+    attr.size = newSize;
+    if(sftp_setstat(m_sftp, remotePath.mb_str(wxConvUTF8).data(), &attr) < 0) {
+        throw clException(wxString() << _("Failed to set the size of file: ") << remotePath << ". "
                                      << ssh_get_error(m_ssh->GetSession()),
                           sftp_get_error(m_sftp));
     }
+}
 
-    char* p = (char*)fileContent.GetData();
-    const int maxChunkSize = 65536;
-    wxInt64 bytesLeft = fileContent.GetDataLen();
+SFTPFile_t clSFTP::DoOpenForWrite(const wxString& remotePath)
+{
+    if(!m_sftp) {
+        throw clException("SFTP is not initialized");
+    }
 
-    while(bytesLeft > 0) {
-        wxInt64 chunkSize = bytesLeft > maxChunkSize ? maxChunkSize : bytesLeft;
-        wxInt64 bytesWritten = sftp_write(file, p, chunkSize);
-        if(bytesWritten < 0) {
-            sftp_close(file);
-            throw clException(wxString() << _("Can't write data to file: ") << tmpRemoteFile << ". "
+    int access_type = O_WRONLY | O_CREAT | O_TRUNC;
+    sftp_file file = sftp_open(m_sftp, remotePath.mb_str(wxConvUTF8).data(), access_type, 0644);
+    if(file == NULL) {
+        throw clException(wxString() << _("Can't open file: ") << remotePath << ". "
+                                     << ssh_get_error(m_ssh->GetSession()),
+                          sftp_get_error(m_sftp));
+    }
+    return file;
+}
+
+void clSFTP::DoWriteChunk(SFTPFile_t file, const char* data, size_t len, const wxString& remotePath)
+{
+    while(len > 0) {
+        wxInt64 bytesWritten = sftp_write(file, data, len);
+        if(bytesWritten <= 0) {
+            throw clException(wxString() << _("Can't write data to file: ") << remotePath << ". "
                                          << ssh_get_error(m_ssh->GetSession()),
                               sftp_get_error(m_sftp));
         }
-        bytesLeft -= bytesWritten;
-        p += bytesWritten;
+        len -= bytesWritten;
+        data += bytesWritten;
     }
-    sftp_close(file);
+}
 
+void clSFTP::DoReplaceFile(const wxString& tmpRemoteFile, const wxString& remotePath, SFTPAttribute::Ptr_t attributes)
+{
     // Unlink the original file if it exists
     bool needUnlink = false;
     {
@@ -242,51 +342,125 @@ SFTPAttribute::List_t clSFTP::CdUp(size_t flags, const wxString& filter)
 }
 
 SFTPAttribute::Ptr_t clSFTP::Read(const wxString& remotePath, wxMemoryBuffer& buffer) 
+{
+    return DoRead(remotePath, [&](const char* data, size_t len) { buffer.AppendData(data, len); });
+}
+
+SFTPAttribute::Ptr_t clSFTP::Read(const wxString& remotePath, const wxFileName& localFile)
+{
+    // Download into a temporary file, so an error does not leave a truncated file behind
+    wxString tmpLocalFile = localFile.GetFullPath() + ".codelitesftp";
+    wxFFile fp(tmpLocalFile, "w+b");
+    if(!fp.IsOpened()) {
+        throw clException(wxString() << _("Could not open file: ") << tmpLocalFile << ". " << ::strerror(errno));
+    }
+
+    SFTPAttribute::Ptr_t fileAttr;
+    try {
+        fileAttr = DoRead(remotePath, [&](const char* data, size_t len) {
+            if(fp.Write(data, len) != len) {
+                throw clException(wxString() << _("Could not write file: ") << tmpLocalFile);
+            }
+        });
+        fp.Close();
+
+    } catch(clException&) {
+        fp.Close();
+        ::wxRemoveFile(tmpLocalFile);
+        throw;
+    }
+
+    if(!::wxRenameFile(tmpLocalFile, localFile.GetFullPath(), true)) {
+        ::wxRemoveFile(tmpLocalFile);
+        throw clException(wxString() << _("Could not rename file: ") << tmpLocalFile << " -> "
+                                     << localFile.GetFullPath());
+    }
+    return fileAttr;
+}
+
+SFTPAttribute::Ptr_t clSFTP::DoRead(const wxString& remotePath, const std::function<void(const char*, size_t)>& sink)
 {
     if(!m_sftp) {
         throw clException("SFTP is not initialized");
     }
 
-    sftp_file file = sftp_open(m_sftp, remotePath.mb_str(wxConvUTF8).data(), O_RDONLY, 0);
-    if(file == NULL) {
-        throw clException(wxString() << _("Failed to open remote file: ") << remotePath << ". "
+    SFTPAttribute::Ptr_t fileAttr = Stat(remotePath);
+    if(!fileAttr) {
+        throw clException(wxString() << _("Could not stat file:") << remotePath << ". "
                                      << ssh_get_error(m_ssh->GetSession()),
                           sftp_get_error(m_sftp));
     }
 
-    SFTPAttribute::Ptr_t fileAttr = Stat(remotePath);
-    if(!fileAttr) {
-        throw clException(wxString() << _("Could not stat file:") << remotePath << ". "
+    sftp_file f = sftp_open(m_sftp, remotePath.mb_str(wxConvUTF8).data(), O_RDONLY, 0);
+    if(f == NULL) {
+        throw clException(wxString() << _("Failed to open remote file: ") << remotePath << ". "
                                      << ssh_get_error(m_ssh->GetSession()),
                           sftp_get_error(m_sftp));
     }
+    SFTPFileCloser file(f);
+
     wxInt64 fileSize = fileAttr->GetSize();
     if(fileSize == 0) return fileAttr;
 
-    // Allocate buffer for the file content
-    char pBuffer[65536]; // buffer
-
-    // Read the entire file content
-    wxInt64 bytesLeft = fileSize;
+    // Keep several read requests in flight: over a high latency link, reading one chunk at a time
+    // makes the download time dominated by the round trips
+    std::deque<std::pair<int, uint32_t> > pending; // <request id, length>
+    std::vector<char> buffer(SFTP_READ_CHUNK_SIZE);
+    wxInt64 bytesRequested = 0;
     wxInt64 bytesRead = 0;
-    while(bytesLeft > 0) {
-        wxInt64 nbytes = sftp_read(file, pBuffer, sizeof(pBuffer));
+    while(bytesRead < fileSize) {
+        while(pending.size() < SFTP_MAX_PENDING_READS && bytesRequested < fileSize) {
+            uint32_t len = (uint32_t)wxMin((wxInt64)SFTP_READ_CHUNK_SIZE, fileSize - bytesRequested);
+            int id = sftp_async_read_begin(file.Get(), len);
+            if(id < 0) {
+                throw clException(wxString() << _("Could not read file:") << remotePath << ". "
+                                             << ssh_get_error(m_ssh->GetSession()),
+                                  sftp_get_error(m_sftp));
+            }
+            pending.push_back(std::make_pair(id, len));
+            bytesRequested += len;
+        }
+
+        std::pair<int, uint32_t> request = pending.front();
+        pending.pop_front();
+        int nbytes = sftp_async_read(file.Get(), buffer.data(), request.second, request.first);
+        // The requests are issued back to back, so a short read (other than at the end) would leave a hole
+        if(nbytes <= 0 || ((uint32_t)nbytes != request.second && !pending.empty())) {
+            throw clException(wxString() << _("Could not read file:") << remotePath << ". "
+                                         << ssh_get_error(m_ssh->GetSession()),
+                              sftp_get_error(m_sftp));
+        }
+        sink(buffer.data(), nbytes);
         bytesRead += nbytes;
-        bytesLeft -= nbytes;
-        buffer.AppendData(pBuffer, nbytes);
+        if(pending.empty() && bytesRequested >= fileSize) { break; }
     }
 
     if(bytesRead != fileSize) {
-        sftp_close(file);
-        buffer.Clear();
         throw clException(wxString() << _("Could not read file:") << remotePath << ". "
                                      << ssh_get_error(m_ssh->GetSession()),
                           sftp_get_error(m_sftp));
     }
-    sftp_close(file);
     return fileAttr;
 }
 
+void clSFTP::SetModificationTime(const wxString& remotePath, time_t modificationTime)
+{
+    if(!m_sftp) {
+        throw clException("SFTP is not initialized");
+    }
+
+    struct timeval times[2];
+    times[0].tv_sec = modificationTime; // access time
+    times[0].tv_usec = 0;
+    times[1].tv_sec = modificationTime; // modification time
+    times[1].tv_usec = 0;
+    if(sftp_utimes(m_sftp, remotePath.mb_str(wxConvUTF8).data(), times) != SSH_OK) {
+        throw clException(wxString() << _("Failed to set the modification time of file: ") << remotePath << ". "
+                                     << ssh_get_error(m_ssh->GetSession()),
+                          sftp_get_error(m_sftp));
+    }
+}
+
 void clSFTP::CreateDir(const wxString& dirname) 
 {
     if(!m_sftp) {
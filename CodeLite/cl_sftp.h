@@ -34,10 +34,14 @@
 #include "codelite_exports.h"
 #include "cl_sftp_attribute.h"
 #include <wx/buffer.h>
+#include <functional>
+#include <vector>
 
 // We do it this way to avoid exposing the include to <libssh/sftp.h> to files including this header
 struct sftp_session_struct;
 typedef struct sftp_session_struct* SFTPSession_t;
+struct sftp_file_struct;
+typedef struct sftp_file_struct* SFTPFile_t;
 
 class WXDLLIMPEXP_CL clSFTP
 {
@@ -47,6 +51,12 @@ class WXDLLIMPEXP_CL clSFTP
     wxString m_currentFolder;
     wxString m_account;
 
+protected:
+    SFTPFile_t DoOpenForWrite(const wxString& remotePath);
+    void DoWriteChunk(SFTPFile_t file, const char* data, size_t len, const wxString& remotePath);
+    void DoReplaceFile(const wxString& tmpRemoteFile, const wxString& remotePath, SFTPAttribute::Ptr_t attributes);
+    SFTPAttribute::Ptr_t DoRead(const wxString& remotePath, const std::function<void(const char*, size_t)>& sink);
+
 public:
     typedef wxSharedPtr<clSFTP> Ptr_t;
     enum {
@@ -83,7 +93,7 @@ public:
     void Close();
 
     /**
-     * @brief write the content of local file into a remote file
+     * @brief write the content of local file into a remote file. The file is streamed from the disk
      * @param localFile the local file
      * @param remotePath the remote path (abs path)
      */
@@ -98,12 +108,34 @@ public:
                const wxString& remotePath,
                SFTPAttribute::Ptr_t attributes = SFTPAttribute::Ptr_t(NULL)) ;
 
+    /**
+     * @brief update an existing remote file in place: write the given ranges (<offset, length>) of the
+     * local file into it and set its size to 'newSize'. Unlike Write(), this is not atomic: if it throws,
+     * the remote file may be partially updated and the caller should replace it using Write()
+     */
+    void WriteRanges(const wxFileName& localFile,
+                     const wxString& remotePath,
+                     const std::vector<std::pair<size_t, size_t> >& ranges,
+                     size_t newSize);
+
     /**
      * @brief read remote file and return its content
      * @return the file content + the file attributes
      */
     SFTPAttribute::Ptr_t Read(const wxString& remotePath, wxMemoryBuffer& buffer) ;
 
+    /**
+     * @brief download a remote file into a local file. The content is streamed to the disk, with several
+     * read requests in flight
+     * @return the remote file attributes
+     */
+    SFTPAttribute::Ptr_t Read(const wxString& remotePath, const wxFileName& localFile);
+
+    /**
+     * @brief set the modification (and access) time of a remote file
+     */
+    void SetModificationTime(const wxString& remotePath, time_t modificationTime);
+
     /**
      * @brief list the content of a folder
      * @param folder
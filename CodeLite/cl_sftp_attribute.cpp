@@ -31,6 +31,7 @@
 SFTPAttribute::SFTPAttribute(SFTPAttribute_t attr)
     : m_attributes(NULL)
     , m_permissions(0)
+    , m_modificationTime(0)
 {
     Assign(attr);
 }
@@ -57,6 +58,7 @@ void SFTPAttribute::DoClear()
     m_flags = 0;
     m_size = 0;
     m_permissions = 0;
+    m_modificationTime = 0;
 }
 
 void SFTPAttribute::DoConstruct()
@@ -67,6 +69,7 @@ void SFTPAttribute::DoConstruct()
     m_name = m_attributes->name;
     m_size = m_attributes->size;
     m_permissions = m_attributes->permissions;
+    m_modificationTime = m_attributes->mtime;
     m_flags = 0;
 
     switch ( m_attributes->type ) {
@@ -44,6 +44,7 @@ class WXDLLIMPEXP_CL SFTPAttribute : public wxClientData
     size_t m_size;
     SFTPAttribute_t m_attributes;
     size_t m_permissions;
+    time_t m_modificationTime;
 
 public:
     typedef SmartPtr<SFTPAttribute> Ptr_t;
@@ -86,6 +87,10 @@ public:
     bool IsSpecial() const { return m_flags & TYPE_SEPCIAL; }
     void SetPermissions(size_t permissions) { this->m_permissions = permissions; }
     size_t GetPermissions() const { return m_permissions; }
+    /**
+     * @brief the last modification time, in seconds since the epoch
+     */
+    time_t GetModificationTime() const { return m_modificationTime; }
 };
 #endif
 #endif // SFTPATTRIBUTE_H
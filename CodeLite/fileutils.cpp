@@ -492,6 +492,24 @@ size_t FileUtils::GetFileSize(const wxFileName& filename)
     return 0;
 }
 
+wxUint64 FileUtils::GetFileHash(const wxFileName& filename)
+{
+    wxLogNull noLog;
+    wxFFile fp(filename.GetFullPath(), "rb");
+    if(!fp.IsOpened()) { return 0; }
+
+    wxUint64 hash = wxULL(14695981039346656037);
+    char buffer[64 * 1024];
+    size_t count = 0;
+    while((count = fp.Read(buffer, sizeof(buffer))) > 0) {
+        for(size_t i = 0; i < count; ++i) {
+            hash ^= (unsigned char)buffer[i];
+            hash *= wxULL(1099511628211);
+        }
+    }
+    return hash;
+}
+
 wxString FileUtils::EscapeString(const wxString& str)
 {
     wxString modstr = str;
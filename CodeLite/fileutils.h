@@ -184,6 +184,12 @@ public:
      */
     static size_t GetFileSize(const wxFileName& filename);
 
+    /**
+     * @brief return a 64 bit hash (FNV-1a) of the file content, or 0 if the file could not be read.
+     * The file is read in chunks and never loaded as a whole
+     */
+    static wxUint64 GetFileHash(const wxFileName& filename);
+
     /**
      * @brief replace any unwanted characters with underscore
      * The chars that we replace are:
@@ -239,46 +239,11 @@ static void make_argv(const wxString& cmd)
     }
 }
 
-#define BUFF_STATE_NORMAL 0
-#define BUFF_STATE_IN_ESC 1
-
-static void RemoveTerminalColoring(char* buffer)
-{
-    char* saved_buff = buffer;
-    char tmpbuf[BUFF_SIZE + 1];
-    memset(tmpbuf, 0, sizeof(tmpbuf));
-
-    short state = BUFF_STATE_NORMAL;
-    size_t i(0);
-
-    while((*buffer) != 0) {
-        switch(state) {
-        case BUFF_STATE_NORMAL:
-            if(*buffer == 0x1B) { // found ESC char
-                state = BUFF_STATE_IN_ESC;
-
-            } else {
-                tmpbuf[i] = *buffer;
-                i++;
-            }
-            break;
-        case BUFF_STATE_IN_ESC:
-            if(*buffer == 'm') { // end of color sequence
-                state = BUFF_STATE_NORMAL;
-            }
-            break;
-        }
-        buffer++;
-    }
-    memset(saved_buff, 0, BUFF_SIZE);
-    memcpy(saved_buff, tmpbuf, strlen(tmpbuf));
-}
-
 UnixProcessImpl::UnixProcessImpl(wxEvtHandler* parent)
     : IProcess(parent)
     , m_readHandle(-1)
     , m_writeHandle(-1)
-    , m_thr(NULL)
+    , m_reading(false)
 {
 }
 
@@ -286,16 +251,12 @@ UnixProcessImpl::~UnixProcessImpl() { Cleanup(); }
 
 void UnixProcessImpl::Cleanup()
 {
+    // Stop reading before the handles are closed
+    Detach();
+
     close(GetReadHandle());
     close(GetWriteHandle());
 
-    if(m_thr) {
-        // Stop the reader thread
-        m_thr->Stop();
-        delete m_thr;
-    }
-    m_thr = NULL;
-
     if(GetPid() != wxNOT_FOUND) {
         wxKill(GetPid(), GetHardKill() ? wxSIGKILL : wxSIGTERM, NULL, wxKILL_CHILDREN);
         // The Zombie cleanup is done in app.cpp in ::ChildTerminatedSingalHandler() signal handler
@@ -328,19 +289,16 @@ bool UnixProcessImpl::Read(wxString& buff)
 
     } else if(rc > 0) {
         // there is something to read
-        char buffer[BUFF_SIZE + 1]; // our read buffer
-        memset(buffer, 0, sizeof(buffer));
+        char buffer[BUFF_SIZE]; // our read buffer
         int bytesRead = read(GetReadHandle(), buffer, sizeof(buffer));
         if(bytesRead > 0) {
-            buffer[BUFF_SIZE] = 0; // allways place a terminator
-
             // Remove coloring chars from the incomnig buffer
-            // colors are marked with ESC and terminates with lower case 'm'
-            RemoveTerminalColoring(buffer);
+            bool inEscape = false;
+            size_t len = UnixProcessReactor::RemoveTerminalColoring(buffer, bytesRead, inEscape);
 
-            wxString convBuff = wxString(buffer, wxConvUTF8);
+            wxString convBuff = wxString(buffer, wxConvUTF8, len);
             if(convBuff.IsEmpty()) {
-                convBuff = wxString::From8BitData(buffer);
+                convBuff = wxString::From8BitData(buffer, len);
             }
 
             buff = convBuff;
@@ -450,19 +408,17 @@ IProcess* UnixProcessImpl::Execute(
         proc->m_flags = flags; // Keep the creation flags
 
         if(!(proc->m_flags & IProcessCreateSync)) {
-            proc->StartReaderThread();
+            proc->StartReading();
         }
         return proc;
     }
 }
 
-void UnixProcessImpl::StartReaderThread()
+void UnixProcessImpl::StartReading()
 {
-    // Launch the 'Reader' thread
-    m_thr = new ProcessReaderThread();
-    m_thr->SetProcess(this);
-    m_thr->SetNotifyWindow(m_parent);
-    m_thr->Start();
+    // A single thread reads the output of all the processes
+    UnixProcessReactor::Get()->Register(this);
+    m_reading = true;
 }
 
 void UnixProcessImpl::Terminate()
@@ -485,12 +441,11 @@ bool UnixProcessImpl::WriteToConsole(const wxString& buff)
 
 void UnixProcessImpl::Detach()
 {
-    if(m_thr) {
-        // Stop the reader thread
-        m_thr->Stop();
-        delete m_thr;
+    if(m_reading) {
+        // No more output or termination notifications
+        UnixProcessReactor::Get()->Unregister(this);
+        m_reading = false;
     }
-    m_thr = NULL;
 }
 
 #endif //#if defined(__WXMAC )||defined(__WXGTK__)
@@ -30,17 +30,21 @@
 #include "asyncprocess.h"
 #include "processreaderthread.h"
 #include "codelite_exports.h"
+#include "unixprocess_reactor.h"
 
 class wxTerminal;
 class WXDLLIMPEXP_CL UnixProcessImpl : public IProcess
 {
     int                  m_readHandle;
     int                  m_writeHandle;
-    ProcessReaderThread *m_thr;
+    bool                 m_reading;
 
     friend class wxTerminal;
 private:
-    void StartReaderThread();
+    /**
+     * @brief hand the read handle to the UnixProcessReactor, which reports the output to the parent
+     */
+    void StartReading();
 
 public:
     UnixProcessImpl(wxEvtHandler *parent);
@@ -60,6 +64,9 @@ public:
     const int& GetWriteHandle() const {
         return m_writeHandle;
     }
+    wxEvtHandler* GetParent() const {
+        return m_parent;
+    }
 
 public:
     virtual void Cleanup();
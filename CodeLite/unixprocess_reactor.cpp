@@ -0,0 +1,505 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2017 Eran Ifrah
+// file name            : unixprocess_reactor.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "unixprocess_reactor.h"
+
+#if defined(__WXMAC__) || defined(__WXGTK__)
+#include "asyncprocess.h"
+#include "cl_command_event.h"
+#include "file_logger.h"
+#include "processreaderthread.h"
+#include "unixprocess_impl.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+// The size of a single read
+#define REACTOR_READ_SIZE (64 * 1024)
+// Deliver the output to the UI once this many bytes are waiting
+#define REACTOR_FLUSH_SIZE (64 * 1024)
+// ... or once the oldest waiting byte is that old (ms)
+#define REACTOR_FLUSH_INTERVAL 30
+// Stop reading from a process when the UI has that much output (chars) of it still waiting
+#define REACTOR_MAX_READY (4 * 1024 * 1024)
+// The wake up pipe is watched with this id, the channel ids start after it
+#define REACTOR_WAKE_ID 0
+
+namespace
+{
+// The length of the prefix of 'data' that does not end in the middle of a UTF-8 sequence
+size_t GetCompleteUTF8Length(const std::string& data)
+{
+    size_t len = data.length();
+    for(size_t back = 1; back <= 3 && back <= len; ++back) {
+        unsigned char ch = data[len - back];
+        if((ch & 0xC0) == 0x80) {
+            continue; // continuation byte
+        }
+        size_t seqLen = 1;
+        if((ch & 0xE0) == 0xC0) {
+            seqLen = 2;
+        } else if((ch & 0xF0) == 0xE0) {
+            seqLen = 3;
+        } else if((ch & 0xF8) == 0xF0) {
+            seqLen = 4;
+        }
+        return (seqLen > back) ? (len - back) : len;
+    }
+    return len;
+}
+
+void SetFdFlags(int fd)
+{
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+} // namespace
+
+/**
+ * @class UnixProcessReactorThread
+ * @brief the thread that waits on all the process file descriptors
+ */
+class UnixProcessReactorThread : public wxThread
+{
+    UnixProcessReactor* m_reactor;
+
+public:
+    UnixProcessReactorThread(UnixProcessReactor* reactor)
+        : wxThread(wxTHREAD_JOINABLE)
+        , m_reactor(reactor)
+    {
+    }
+    virtual ~UnixProcessReactorThread() {}
+
+    /**
+     * @brief Delete() must not wait for the next output of some process
+     */
+    virtual void OnDelete() { m_reactor->DoWakeUp(); }
+
+    virtual void* Entry()
+    {
+        std::vector<char> buffer(REACTOR_READ_SIZE);
+        std::vector<wxUint64> ready;
+#ifdef __linux__
+        struct epoll_event events[64];
+#else
+        std::vector<struct pollfd> fds;
+        std::vector<wxUint64> ids;
+#endif
+        while(!TestDestroy()) {
+            int timeout = -1;
+            ready.clear();
+            {
+                wxMutexLocker locker(m_reactor->m_mutex);
+                timeout = m_reactor->DoGetTimeout();
+#ifndef __linux__
+                fds.clear();
+                ids.clear();
+                struct pollfd pfd;
+                pfd.fd = m_reactor->m_wakeFds[0];
+                pfd.events = POLLIN;
+                pfd.revents = 0;
+                fds.push_back(pfd);
+                ids.push_back(REACTOR_WAKE_ID);
+                UnixProcessReactor::ChannelMap_t::iterator iter = m_reactor->m_channels.begin();
+                for(; iter != m_reactor->m_channels.end(); ++iter) {
+                    if(iter->second->m_paused || iter->second->m_eof) {
+                        continue;
+                    }
+                    pfd.fd = iter->second->m_fd;
+                    fds.push_back(pfd);
+                    ids.push_back(iter->first);
+                }
+#endif
+            }
+
+#ifdef __linux__
+            int count = ::epoll_wait(m_reactor->m_poller, events, sizeof(events) / sizeof(events[0]), timeout);
+            for(int i = 0; i < count; ++i) {
+                ready.push_back(events[i].data.u64);
+            }
+#else
+            int count = ::poll(&fds[0], fds.size(), timeout);
+            for(size_t i = 0; count > 0 && i < fds.size(); ++i) {
+                if(fds[i].revents) {
+                    ready.push_back(ids[i]);
+                }
+            }
+#endif
+            if(count < 0 && errno != EINTR) {
+                clERROR() << "Process reactor: wait error:" << strerror(errno) << clEndl;
+                wxThread::Sleep(10);
+            }
+
+            for(size_t i = 0; i < ready.size(); ++i) {
+                if(ready[i] == REACTOR_WAKE_ID) {
+                    // drain the wake up pipe
+                    char dummy[64];
+                    while(::read(m_reactor->m_wakeFds[0], dummy, sizeof(dummy)) > 0) {
+                    }
+                } else {
+                    m_reactor->DoRead(ready[i], &buffer[0], buffer.size());
+                }
+            }
+
+            // Deliver the output that waited long enough
+            wxMutexLocker locker(m_reactor->m_mutex);
+            long now = m_reactor->m_clock.Time();
+            UnixProcessReactor::ChannelMap_t::iterator iter = m_reactor->m_channels.begin();
+            for(; iter != m_reactor->m_channels.end(); ++iter) {
+                UnixProcessReactor::Channel* channel = iter->second;
+                if(!channel->m_pending.empty() && (now - channel->m_pendingSince) >= REACTOR_FLUSH_INTERVAL) {
+                    m_reactor->DoFlush(channel, false);
+                }
+            }
+        }
+        return NULL;
+    }
+};
+
+UnixProcessReactor::UnixProcessReactor()
+    : m_nextId(REACTOR_WAKE_ID + 1)
+    , m_tickPending(false)
+    , m_poller(-1)
+    , m_thread(NULL)
+{
+    m_wakeFds[0] = m_wakeFds[1] = -1;
+    if(::pipe(m_wakeFds) == 0) {
+        SetFdFlags(m_wakeFds[0]);
+        SetFdFlags(m_wakeFds[1]);
+    } else {
+        clERROR() << "Process reactor: failed to create the wake up pipe:" << strerror(errno) << clEndl;
+    }
+
+#ifdef __linux__
+    m_poller = ::epoll_create(64);
+    if(m_poller != -1) {
+        ::fcntl(m_poller, F_SETFD, FD_CLOEXEC);
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.u64 = REACTOR_WAKE_ID;
+        ::epoll_ctl(m_poller, EPOLL_CTL_ADD, m_wakeFds[0], &ev);
+    } else {
+        clERROR() << "Process reactor: epoll_create error:" << strerror(errno) << clEndl;
+    }
+#endif
+}
+
+UnixProcessReactor::~UnixProcessReactor()
+{
+    DoStop();
+
+    ChannelMap_t::iterator iter = m_channels.begin();
+    for(; iter != m_channels.end(); ++iter) {
+        delete iter->second;
+    }
+    m_channels.clear();
+
+    if(m_poller != -1) {
+        ::close(m_poller);
+    }
+    ::close(m_wakeFds[0]);
+    ::close(m_wakeFds[1]);
+}
+
+UnixProcessReactor* UnixProcessReactor::Get()
+{
+    // Lives as long as the application, its (joinable) thread is stopped by Release()
+    static UnixProcessReactor* reactor = new UnixProcessReactor();
+    return reactor;
+}
+
+void UnixProcessReactor::Release() { Get()->DoStop(); }
+
+void UnixProcessReactor::DoStop()
+{
+    UnixProcessReactorThread* thread = NULL;
+    {
+        wxMutexLocker locker(m_mutex);
+        thread = m_thread;
+        m_thread = NULL;
+    }
+    // Not under the lock: the thread takes it on every iteration
+    if(thread) {
+        thread->Delete(NULL, wxTHREAD_WAIT_BLOCK);
+        wxDELETE(thread);
+    }
+}
+
+size_t UnixProcessReactor::RemoveTerminalColoring(char* buffer, size_t len, bool& inEscape)
+{
+    // colors are marked with ESC and terminate with lower case 'm'
+    size_t j = 0;
+    for(size_t i = 0; i < len; ++i) {
+        if(inEscape) {
+            if(buffer[i] == 'm') { // end of color sequence
+                inEscape = false;
+            }
+        } else if(buffer[i] == 0x1B) { // found ESC char
+            inEscape = true;
+        } else if(buffer[i] != 0) {
+            buffer[j++] = buffer[i];
+        }
+    }
+    return j;
+}
+
+void UnixProcessReactor::DoWakeUp()
+{
+    char ch = 'x';
+    if(::write(m_wakeFds[1], &ch, 1) < 0 && errno != EAGAIN) {
+        clWARNING() << "Process reactor: wake up error:" << strerror(errno) << clEndl;
+    }
+}
+
+int UnixProcessReactor::DoGetTimeout()
+{
+    // Wake up in time to deliver the oldest pending output
+    int timeout = -1;
+    long now = m_clock.Time();
+    ChannelMap_t::iterator iter = m_channels.begin();
+    for(; iter != m_channels.end(); ++iter) {
+        if(iter->second->m_pending.empty()) {
+            continue;
+        }
+        long left = iter->second->m_pendingSince + REACTOR_FLUSH_INTERVAL - now;
+        left = wxMax(left, 0L);
+        if(timeout == -1 || left < timeout) {
+            timeout = left;
+        }
+    }
+    return timeout;
+}
+
+void UnixProcessReactor::DoRead(wxUint64 id, char* buffer, size_t size)
+{
+    // The lock is held during the read: this is what makes Unregister() safe
+    wxMutexLocker locker(m_mutex);
+    ChannelMap_t::iterator iter = m_channels.find(id);
+    if(iter == m_channels.end() || iter->second->m_eof || iter->second->m_paused) {
+        return;
+    }
+
+    Channel* channel = iter->second;
+    ssize_t bytesRead = ::read(channel->m_fd, buffer, size);
+    if(bytesRead > 0) {
+        size_t len = RemoveTerminalColoring(buffer, bytesRead, channel->m_inEscape);
+        if(len) {
+            if(channel->m_pending.empty()) {
+                channel->m_pendingSince = m_clock.Time();
+            }
+            channel->m_pending.append(buffer, len);
+            if(channel->m_pending.length() >= REACTOR_FLUSH_SIZE) {
+                DoFlush(channel, false);
+            }
+        }
+
+    } else if(bytesRead == 0 || (errno != EINTR && errno != EAGAIN)) {
+        // Process terminated (on a pty this is usually EIO)
+        // the exit code will be set in the sigchld event handler
+        channel->m_eof = true;
+        DoUnwatch(channel);
+        DoFlush(channel, true);
+    }
+}
+
+void UnixProcessReactor::DoFlush(Channel* channel, bool force)
+{
+    if(!channel->m_pending.empty()) {
+        size_t len = force ? channel->m_pending.length() : GetCompleteUTF8Length(channel->m_pending);
+        if(len == 0) {
+            // Only the tail that was held back by the previous flush is left and nothing completed it since: this is
+            // not UTF-8 (e.g. a Latin-1 prompt), deliver it now instead of holding it forever
+            len = channel->m_pending.length();
+        }
+        if(len) {
+            wxString text(channel->m_pending.c_str(), wxConvUTF8, len);
+            if(text.IsEmpty()) {
+                text = wxString::From8BitData(channel->m_pending.c_str(), len);
+            }
+            channel->m_ready << text;
+            channel->m_pending.erase(0, len);
+        }
+        // A split sequence left alone in the buffer waits (at most one more interval) for the next read, the reactor
+        // must not spin on it
+        channel->m_pendingSince = m_clock.Time();
+    }
+
+    if(!channel->m_ready.IsEmpty() || channel->m_eof) {
+        if(!m_tickPending) {
+            m_tickPending = true;
+            CallAfter(&UnixProcessReactor::OnTick);
+        }
+        if(!channel->m_paused && !channel->m_eof && channel->m_ready.length() > REACTOR_MAX_READY) {
+            // Back pressure: leave the rest in the pipe until the UI catches up
+            channel->m_paused = true;
+            DoUnwatch(channel);
+        }
+    }
+}
+
+void UnixProcessReactor::DoWatch(wxUint64 id, Channel* channel)
+{
+#ifdef __linux__
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u64 = id;
+    if(::epoll_ctl(m_poller, EPOLL_CTL_ADD, channel->m_fd, &ev) < 0) {
+        clWARNING() << "Process reactor: failed to watch fd" << channel->m_fd << ":" << strerror(errno) << clEndl;
+    }
+#else
+    wxUnusedVar(id);
+    wxUnusedVar(channel);
+    DoWakeUp(); // the poll set is rebuilt on every iteration
+#endif
+}
+
+void UnixProcessReactor::DoUnwatch(Channel* channel)
+{
+#ifdef __linux__
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ::epoll_ctl(m_poller, EPOLL_CTL_DEL, channel->m_fd, &ev);
+#else
+    wxUnusedVar(channel);
+    DoWakeUp();
+#endif
+}
+
+void UnixProcessReactor::Register(UnixProcessImpl* process)
+{
+    wxMutexLocker locker(m_mutex);
+    Channel* channel = new Channel();
+    channel->m_process = process;
+    channel->m_fd = process->GetReadHandle();
+
+    wxUint64 id = m_nextId++;
+    m_channels.insert(std::make_pair(id, channel));
+    DoWatch(id, channel);
+
+    if(!m_thread) {
+        m_thread = new UnixProcessReactorThread(this);
+        m_thread->Create();
+        m_thread->Run();
+    }
+}
+
+void UnixProcessReactor::Unregister(UnixProcessImpl* process)
+{
+    wxMutexLocker locker(m_mutex);
+    ChannelMap_t::iterator iter = m_channels.begin();
+    for(; iter != m_channels.end(); ++iter) {
+        if(iter->second->m_process == process) {
+            if(!iter->second->m_paused && !iter->second->m_eof) {
+                DoUnwatch(iter->second);
+            }
+            delete iter->second;
+            m_channels.erase(iter);
+            break;
+        }
+    }
+}
+
+void UnixProcessReactor::OnTick()
+{
+    struct Delivery {
+        UnixProcessImpl* m_process;
+        wxString m_output;
+        bool m_terminated;
+    };
+
+    // Collect the output of all the processes, one batch per process
+    std::vector<Delivery> deliveries;
+    {
+        wxMutexLocker locker(m_mutex);
+        m_tickPending = false;
+        ChannelMap_t::iterator iter = m_channels.begin();
+        while(iter != m_channels.end()) {
+            Channel* channel = iter->second;
+            if(channel->m_ready.IsEmpty() && !channel->m_eof) {
+                ++iter;
+                continue;
+            }
+
+            deliveries.push_back(Delivery());
+            Delivery& d = deliveries.back();
+            d.m_process = channel->m_process;
+            d.m_output.swap(channel->m_ready);
+            d.m_terminated = channel->m_eof;
+
+            if(channel->m_eof) {
+                // Nothing more will come from this process
+                delete channel;
+                m_channels.erase(iter++);
+                continue;
+            }
+
+            if(channel->m_paused) {
+                // The UI caught up, resume reading
+                channel->m_paused = false;
+                DoWatch(iter->first, channel);
+            }
+            ++iter;
+        }
+    }
+
+    // Notify the owners, exactly like the reader thread used to
+    for(size_t i = 0; i < deliveries.size(); ++i) {
+        const Delivery& d = deliveries[i];
+        IProcessCallback* cb = d.m_process->GetCallback();
+        wxEvtHandler* parent = d.m_process->GetParent();
+        if(!d.m_output.IsEmpty()) {
+            if(cb) {
+                cb->CallAfter(&IProcessCallback::OnProcessOutput, d.m_output);
+            } else if(parent) {
+                clProcessEvent e(wxEVT_ASYNC_PROCESS_OUTPUT);
+                e.SetOutput(d.m_output);
+                e.SetProcess(d.m_process);
+                parent->AddPendingEvent(e);
+            }
+        }
+
+        if(d.m_terminated) {
+            if(cb) {
+                cb->CallAfter(&IProcessCallback::OnProcessTerminated);
+            } else if(parent) {
+                clProcessEvent e(wxEVT_ASYNC_PROCESS_TERMINATED);
+                e.SetProcess(d.m_process);
+                parent->AddPendingEvent(e);
+            }
+        }
+    }
+}
+
+#endif // defined(__WXMAC__) || defined(__WXGTK__)
@@ -0,0 +1,133 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2017 Eran Ifrah
+// file name            : unixprocess_reactor.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef UNIXPROCESS_REACTOR_H
+#define UNIXPROCESS_REACTOR_H
+
+#if defined(__WXMAC__) || defined(__WXGTK__)
+#include "codelite_exports.h"
+#include <map>
+#include <string>
+#include <vector>
+#include <wx/event.h>
+#include <wx/stopwatch.h>
+#include <wx/string.h>
+#include <wx/thread.h>
+
+class UnixProcessImpl;
+class UnixProcessReactorThread;
+
+/**
+ * @class UnixProcessReactor
+ * @brief reads the output of all the asynchronous processes from a single thread.
+ * The output of each process is coalesced and delivered to its owner (as wxEVT_ASYNC_PROCESS_OUTPUT or via its
+ * IProcessCallback) at most once per UI tick. When the UI does not keep up, the reactor stops reading from the process
+ * which then blocks on its writes
+ */
+class WXDLLIMPEXP_CL UnixProcessReactor : public wxEvtHandler
+{
+    friend class UnixProcessReactorThread;
+
+    struct Channel {
+        UnixProcessImpl* m_process;
+        int m_fd;
+        std::string m_pending; // output that was read but not flushed yet
+        long m_pendingSince;   // when the first pending byte was read
+        bool m_inEscape;       // in the middle of a terminal colour sequence
+        wxString m_ready;      // flushed output, waiting for the UI
+        bool m_paused;         // the UI is behind, we stopped reading
+        bool m_eof;            // the process closed its end
+        Channel()
+            : m_process(NULL)
+            , m_fd(-1)
+            , m_pendingSince(0)
+            , m_inEscape(false)
+            , m_paused(false)
+            , m_eof(false)
+        {
+        }
+    };
+
+    typedef std::map<wxUint64, Channel*> ChannelMap_t;
+
+    wxMutex m_mutex;
+    ChannelMap_t m_channels;
+    wxUint64 m_nextId;
+    bool m_tickPending;
+    int m_poller;
+    int m_wakeFds[2];
+    wxStopWatch m_clock;
+    UnixProcessReactorThread* m_thread;
+
+protected:
+    UnixProcessReactor();
+    virtual ~UnixProcessReactor();
+
+    void DoStop();
+
+    // Reactor thread side
+    void DoWakeUp();
+    int DoGetTimeout();
+    void DoRead(wxUint64 id, char* buffer, size_t size);
+    /**
+     * @brief move the pending output to the UI. Unless 'force' is set (end of output), an incomplete UTF-8
+     * sequence at the end stays pending until the rest of it is read or until the next flush
+     */
+    void DoFlush(Channel* channel, bool force);
+    void DoWatch(wxUint64 id, Channel* channel);
+    void DoUnwatch(Channel* channel);
+
+    // UI side
+    void OnTick();
+
+public:
+    static UnixProcessReactor* Get();
+    /**
+     * @brief stop and join the reactor thread. Call this on exit, while wxWidgets is still alive
+     */
+    static void Release();
+
+    /**
+     * @brief remove the terminal colour sequences (ESC ... m) from a buffer, in place
+     * @param inEscape the state between consecutive buffers of the same stream
+     * @return the new length of the buffer
+     */
+    static size_t RemoveTerminalColoring(char* buffer, size_t len, bool& inEscape);
+
+    /**
+     * @brief start reading the output of a process. Its owner is notified
+     * exactly like it was by the old per process reader thread
+     */
+    void Register(UnixProcessImpl* process);
+
+    /**
+     * @brief stop reading the output of a process. When this function returns, the reactor no longer uses the process
+     * or its file descriptor and no further output or termination is delivered for it
+     */
+    void Unregister(UnixProcessImpl* process);
+};
+
+#endif // defined(__WXMAC__) || defined(__WXGTK__)
+#endif // UNIXPROCESS_REACTOR_H
@@ -32,6 +32,7 @@
 #include "file_logger.h"
 #include "macros.h"
 #include "wx/menu.h"
+#include <wx/dirdlg.h>
 #include <wx/ffile.h>
 #include <wx/xrc/xmlres.h>
 
@@ -69,6 +70,8 @@ CodeLiteDiff::CodeLiteDiff(IManager* manager)
     clKeyboardManager::Get()->AddGlobalAccelerator("diff_new_comparison", "Ctrl-Shift-C",
                                                    "Plugins::Diff Tool::New File Comparison");
     wxTheApp->Bind(wxEVT_COMMAND_MENU_SELECTED, &CodeLiteDiff::OnNewDiff, this, XRCID("diff_new_comparison"));
+    wxTheApp->Bind(wxEVT_COMMAND_MENU_SELECTED, &CodeLiteDiff::OnNewFoldersDiff, this,
+                   XRCID("diff_new_folders_comparison"));
 }
 
 CodeLiteDiff::~CodeLiteDiff() {}
@@ -84,11 +87,14 @@ void CodeLiteDiff::CreatePluginMenu(wxMenu* pluginsMenu)
 {
     wxMenu* menu = new wxMenu;
     menu->Append(XRCID("diff_new_comparison"), _("New Diff.."), _("Start new diff"));
+    menu->Append(XRCID("diff_new_folders_comparison"), _("New Folders Diff.."), _("Compare two folders"));
     pluginsMenu->Append(wxID_ANY, _("Diff Tool"), menu);
 }
 
 void CodeLiteDiff::UnPlug()
 {
+    wxTheApp->Unbind(wxEVT_COMMAND_MENU_SELECTED, &CodeLiteDiff::OnNewFoldersDiff, this,
+                     XRCID("diff_new_folders_comparison"));
     wxTheApp->Unbind(wxEVT_COMMAND_MENU_SELECTED, &CodeLiteDiff::OnNewDiff, this, XRCID("diff_new_comparison"));
     EventNotifier::Get()->Unbind(wxEVT_CONTEXT_MENU_TAB_LABEL, &CodeLiteDiff::OnTabContextMenu, this);
     Unbind(wxEVT_MENU, &CodeLiteDiff::OnDiff, this, XRCID("diff_compare_with"));
@@ -100,6 +106,20 @@ void CodeLiteDiff::OnNewDiff(wxCommandEvent& e)
     diff->Show();
 }
 
+void CodeLiteDiff::OnNewFoldersDiff(wxCommandEvent& e)
+{
+    wxString leftFolder = ::wxDirSelector(_("Select the left folder"), "", wxDD_DEFAULT_STYLE | wxDD_DIR_MUST_EXIST,
+                                          wxDefaultPosition, EventNotifier::Get()->TopFrame());
+    if(leftFolder.IsEmpty()) { return; }
+
+    wxString rightFolder = ::wxDirSelector(_("Select the right folder"), "", wxDD_DEFAULT_STYLE | wxDD_DIR_MUST_EXIST,
+                                           wxDefaultPosition, EventNotifier::Get()->TopFrame());
+    if(rightFolder.IsEmpty()) { return; }
+
+    clDiffFrame* diff = new clDiffFrame(EventNotifier::Get()->TopFrame(), leftFolder, rightFolder);
+    diff->Show();
+}
+
 void CodeLiteDiff::OnTabContextMenu(clContextMenuEvent& event)
 {
     event.Skip();
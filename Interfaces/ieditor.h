@@ -522,6 +522,13 @@ public:
      * @return number of bookmarks found
      */
     virtual size_t GetFindMarkers(std::vector<std::pair<int, wxString> >& bookmarksVector) = 0;
+
+    /**
+     * @brief clear the user indicators from the given range
+     * @param startPos start of the range
+     * @param len range's length
+     */
+    virtual void ClearUserIndicator(int startPos, int len) = 0;
 };
 
 #endif // IEDITOR_H
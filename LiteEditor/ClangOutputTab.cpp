@@ -105,7 +105,8 @@ void ClangOutputTab::OnClearCache(wxCommandEvent& event)
 {
     wxUnusedVar(event);
 #if HAS_LIBCLANG
-    ClangCodeCompletion::Instance()->ClearCache();
+    // An explicit request: drop the translation units saved on disk as well
+    ClangCodeCompletion::Instance()->ClearCache(true);
 #endif
 }
 
@@ -44,6 +44,7 @@
 #include "globals.h"
 #include "frame.h"
 #include "asyncprocess.h" // IProcess
+#include "unixprocess_reactor.h"
 #include "new_build_tab.h"
 #include "cl_config.h"
 #include "globals.h"
@@ -753,6 +754,11 @@ int CodeLiteApp::OnExit()
     CL_DEBUG(wxT("Bye"));
     EditorConfigST::Free();
     ConfFileLocator::Release();
+#if defined(__WXMAC__) || defined(__WXGTK__)
+    UnixProcessReactor::Release();
+#endif
+    // Write any pending configuration changes and stop the background writer while wx is still alive
+    clConfig::Get().Flush(true);
     return 0;
 }
 
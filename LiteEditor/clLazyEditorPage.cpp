@@ -0,0 +1,37 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2017 Eran Ifrah
+// File name            : clLazyEditorPage.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "clLazyEditorPage.h"
+#include "drawingutils.h"
+
+clLazyEditorPage::clLazyEditorPage(wxWindow* parent, const TabInfo& tabInfo)
+    : wxPanel(parent)
+    , m_tabInfo(tabInfo)
+{
+    // Avoid a flash of a different colour until the editor replaces us
+    SetBackgroundColour(DrawingUtils::GetPanelBgColour());
+}
+
+clLazyEditorPage::~clLazyEditorPage() {}
@@ -0,0 +1,52 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2017 Eran Ifrah
+// File name            : clLazyEditorPage.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef CLLAZYEDITORPAGE_H
+#define CLLAZYEDITORPAGE_H
+
+#include "serialized_object.h"
+#include <wx/panel.h>
+
+/**
+ * @class clLazyEditorPage
+ * @brief a light weight page that stands for an editor restored from the session.
+ * The file is loaded into a real editor (see MainBook) when the tab is first selected
+ */
+class clLazyEditorPage : public wxPanel
+{
+    TabInfo m_tabInfo;
+
+public:
+    clLazyEditorPage(wxWindow* parent, const TabInfo& tabInfo);
+    virtual ~clLazyEditorPage();
+
+    /**
+     * @brief the state of the editor (caret, first visible line, bookmarks and folds) as stored in the session
+     */
+    const TabInfo& GetTabInfo() const { return m_tabInfo; }
+    wxString GetFileName() const { return m_tabInfo.GetFileName(); }
+};
+
+#endif // CLLAZYEDITORPAGE_H
@@ -33,6 +33,8 @@
 #include "clPrintout.h"
 #include "clSTCLineKeeper.h"
 #include "cl_command_event.h"
+#include "clMemoryMappedFile.h"
+#include "cl_config.h"
 #include "cl_editor.h"
 #include "cl_editor_tip_window.h"
 #include "clang_code_completion.h"
@@ -72,6 +74,7 @@
 #include "stringhighlighterjob.h"
 #include "stringsearcher.h"
 #include "wxCodeCompletionBoxManager.h"
+#include <climits>
 #include <wx/dataobj.h>
 #include <wx/dcmemory.h>
 #include <wx/log.h>
@@ -328,6 +331,8 @@ LEditor::LEditor(wxWindow* parent)
     , m_autoAddNormalBraces(false)
     , m_autoAdjustHScrollbarWidth(true)
     , m_reloadingFile(false)
+    , m_largeFile(false)
+    , m_searchEngine(this)
     , m_functionTip(NULL)
     , m_calltip(NULL)
     , m_lastCharEntered(0)
@@ -442,7 +447,9 @@ void LEditor::SetSyntaxHighlight(const wxString& lexerName)
 void LEditor::SetSyntaxHighlight(bool bUpdateColors)
 {
     ClearDocumentStyle();
-    m_context = ContextManager::Get()->NewContextByFileName(this, m_fileName);
+    // Large files are always displayed as plain text
+    m_context = m_largeFile ? ContextManager::Get()->NewContext(this, wxT("text"))
+                            : ContextManager::Get()->NewContextByFileName(this, m_fileName);
 
     SetProperties();
 
@@ -849,6 +856,17 @@ void LEditor::SetProperties()
     CmdKeyAssign(wxSTC_KEY_LEFT, wxSTC_KEYMOD_META, wxSTC_CMD_WORDPARTLEFT);
     CmdKeyAssign(wxSTC_KEY_RIGHT, wxSTC_KEYMOD_META, wxSTC_CMD_WORDPARTRIGHT);
 #endif
+
+    if(m_largeFile) {
+        // Large file mode: no folding and no wrapping (wrapping requires measuring every line of the file)
+        // Layout is cached for the visible page only. The change tracker is hidden too: clearing it on save
+        // visits every line of the file
+        SetProperty(wxT("fold"), wxT("0"));
+        SetMarginWidth(FOLD_MARGIN_ID, 0);
+        SetMarginWidth(EDIT_TRACKER_MARGIN_ID, 0);
+        SetWrapMode(wxSTC_WRAP_NONE);
+        SetLayoutCache(wxSTC_CACHE_PAGE);
+    }
 }
 
 void LEditor::OnSavePoint(wxStyledTextEvent& event)
@@ -2205,7 +2223,14 @@ bool LEditor::FindAndSelect(const FindReplaceData& data)
     int pos(0);
     int match_len(0);
 
-    if(StringFindReplacer::Search(GetText().wc_str(), offset, findWhat.wc_str(), flags, pos, match_len)) {
+    bool found(false);
+    if(flags & wxSD_SEARCH_BACKWARD) {
+        found = m_searchEngine.Find(findWhat, flags, 0, offset, pos, match_len);
+    } else {
+        found = m_searchEngine.Find(findWhat, flags, offset, GetLength(), pos, match_len);
+    }
+
+    if(found) {
 
         SetEnsureCaretIsVisible(pos);
 
@@ -2675,65 +2700,46 @@ void LEditor::FindPrevMarker()
 
 bool LEditor::ReplaceAll()
 {
-    int offset(0);
-
     wxString findWhat = m_findReplaceDlg->GetData().GetFindString();
     wxString replaceWith = m_findReplaceDlg->GetData().GetReplaceString();
     size_t flags = SearchFlags(m_findReplaceDlg->GetData());
 
-    int pos(0);
-    int match_len(0);
-    int posInChars(0);
-    int match_lenInChars(0);
-
-    wxString txt;
-    if(m_findReplaceDlg->GetData().GetFlags() & wxFRD_SELECTIONONLY) {
-        txt = GetSelectedText();
-    } else {
-        txt = GetText();
+    bool replaceInSelectionOnly = m_findReplaceDlg->GetData().GetFlags() & wxFRD_SELECTIONONLY;
+    int from(0);
+    int to = GetLength();
+    if(replaceInSelectionOnly) {
+        from = GetSelectionStart();
+        to = GetSelectionEnd();
     }
 
-    bool replaceInSelectionOnly = m_findReplaceDlg->GetData().GetFlags() & wxFRD_SELECTIONONLY;
+    // Collect all the matches before we modify the buffer
+    clEditorSearchEngine::Matches_t matches;
+    m_searchEngine.FindAll(findWhat, flags, from, to, matches);
 
     BeginUndoAction();
     m_findReplaceDlg->ResetReplacedCount();
 
     long savedPos = GetCurrentPos();
-    while(StringFindReplacer::Search(txt.wc_str(), offset, findWhat.wc_str(), flags, pos, match_len, posInChars,
-                                     match_lenInChars)) {
-        // Manipulate the buffer
-        txt.Remove(posInChars, match_lenInChars);
-        txt.insert(posInChars, replaceWith);
-
-        // When not in 'selection only' update the editor buffer as well
-        if(!replaceInSelectionOnly) {
-            SetSelectionStart(pos);
-            SetSelectionEnd(pos + match_len);
-            ReplaceSelection(replaceWith);
-        }
 
+    // Replace from the last match backward, so the positions of the remaining matches are still valid
+    int delta(0);
+    clEditorSearchEngine::Matches_t::const_reverse_iterator iter = matches.rbegin();
+    for(; iter != matches.rend(); ++iter) {
+        SetTargetStart(iter->first);
+        SetTargetEnd(iter->first + iter->second);
+        delta += ReplaceTarget(replaceWith) - iter->second;
         m_findReplaceDlg->IncReplacedCount();
-        offset = pos + clUTF8Length(replaceWith.wc_str(), replaceWith.length()); // match_len;
     }
 
     if(replaceInSelectionOnly) {
-
-        // Prepare the next selection
-        int selStart = GetSelectionStart();
-        int selEnd = selStart + txt.Len();
-
-        // replace the selection
-        ReplaceSelection(txt);
-
         // Keep the selection
-        SetSelectionStart(selStart);
-        SetSelectionEnd(selEnd);
+        SetSelectionStart(from);
+        SetSelectionEnd(to + delta);
 
         // place the caret at the end of the selection
         EnsureCaretVisible();
 
     } else {
-        // The editor buffer was already updated
         // Restore the caret
         SetCaretAt(savedPos);
     }
@@ -2753,33 +2759,50 @@ bool LEditor::MarkAllFinds()
     long savedPos = GetCurrentPos();
     size_t flags = SearchFlags(m_findReplaceDlg->GetData());
 
-    int pos(0);
-    int match_len(0);
-
     // remove reverse search
     flags &= ~wxSD_SEARCH_BACKWARD;
-    int offset(0);
 
-    wxString txt;
-    int fixed_offset(0);
+    int from(0);
+    int to = GetLength();
     if(m_findReplaceDlg->GetData().GetFlags() & wxFRD_SELECTIONONLY) {
-        txt = GetSelectedText();
-        fixed_offset = GetSelectionStart();
-    } else {
-        txt = GetText();
+        from = GetSelectionStart();
+        to = GetSelectionEnd();
     }
 
+    clEditorSearchEngine::Matches_t matches;
+    m_searchEngine.FindAll(findWhat, flags, from, to, matches);
+
     DelAllMarkers(smt_find_bookmark);
 
     // set the active indicator to be 1
     SetIndicatorCurrent(1);
 
-    while(StringFindReplacer::Search(txt.wc_str(), offset, findWhat.wc_str(), flags, pos, match_len)) {
-        MarkerAdd(LineFromPosition(fixed_offset + pos), smt_find_bookmark);
+    // Apply the results in a single batch: one marker per line and one indicator
+    // fill per run of adjacent matches
+    {
+        wxWindowUpdateLocker locker(this);
+        int lastLine(wxNOT_FOUND);
+        int runStart(wxNOT_FOUND);
+        int runEnd(wxNOT_FOUND);
+        for(size_t i = 0; i < matches.size(); ++i) {
+            int start = matches[i].first;
+            int end = start + matches[i].second;
+
+            int line = LineFromPosition(start);
+            if(line != lastLine) {
+                MarkerAdd(line, smt_find_bookmark);
+                lastLine = line;
+            }
 
-        // add indicator as well
-        IndicatorFillRange(fixed_offset + pos, match_len);
-        offset = pos + match_len;
+            if(start == runEnd) {
+                runEnd = end;
+            } else {
+                if(runStart != wxNOT_FOUND) { IndicatorFillRange(runStart, runEnd - runStart); }
+                runStart = start;
+                runEnd = end;
+            }
+        }
+        if(runStart != wxNOT_FOUND) { IndicatorFillRange(runStart, runEnd - runStart); }
     }
 
     // Restore the caret
@@ -2877,9 +2900,19 @@ void LEditor::OpenFile()
     // Read the file we currently support:
     // BOM, Auto-Detect encoding & User defined encoding
     m_fileBom.Clear();
-    ReadFileWithConversion(m_fileName.GetFullPath(), text, GetOptions()->GetFileFontEncoding(), &m_fileBom);
 
-    SetText(text);
+    // Files above the threshold are opened in "large file" mode. Switch to the plain text lexer
+    // before the content is loaded so scintilla won't lex it
+    bool largeFile = DoIsLargeFile();
+    if(largeFile != m_largeFile) {
+        m_largeFile = largeFile;
+        SetSyntaxHighlight(false);
+    }
+
+    if(!m_largeFile || !DoLoadLargeFile()) {
+        ReadFileWithConversion(m_fileName.GetFullPath(), text, GetOptions()->GetFileFontEncoding(), &m_fileBom);
+        SetText(text);
+    }
 
     m_modifyTime = GetFileLastModifiedTime();
 
@@ -2910,7 +2943,128 @@ void LEditor::OpenFile()
 
     SetProperty(wxT("lexer.cpp.track.preprocessor"), wxT("0"));
     SetProperty(wxT("lexer.cpp.update.preprocessor"), wxT("0"));
-    m_mgr->GetStatusBar()->SetMessage(_("Ready"));
+    if(m_largeFile) {
+        m_mgr->GetStatusBar()->SetMessage(_("Large file: syntax highlight and folding are disabled"));
+    } else {
+        m_mgr->GetStatusBar()->SetMessage(_("Ready"));
+    }
+}
+
+bool LEditor::DoIsLargeFile() const
+{
+    // The threshold is set in MB. 0 disables the large file mode
+    int threshold = clConfig::Get().Read(kConfigLargeFileSizeThreshold, 32);
+    if(threshold <= 0) { return false; }
+
+    wxULongLong size = m_fileName.GetSize();
+    return (size != wxInvalidSize) && (size >= wxULongLong(threshold) * 1024 * 1024);
+}
+
+// Return true if the buffer is entirely valid UTF-8 (no overlong forms, surrogates or truncated sequences)
+static bool IsValidUTF8(const char* buffer, size_t len)
+{
+    const unsigned char* p = (const unsigned char*)buffer;
+    size_t i = 0;
+    while(i < len) {
+        unsigned char ch = p[i];
+        if(ch < 0x80) {
+            ++i;
+            continue;
+        }
+
+        size_t trail = 0;
+        unsigned char min = 0x80, max = 0xBF; // the allowed range of the first trail byte
+        if(ch >= 0xC2 && ch <= 0xDF) {
+            trail = 1;
+        } else if(ch >= 0xE0 && ch <= 0xEF) {
+            trail = 2;
+            if(ch == 0xE0) { min = 0xA0; }
+            if(ch == 0xED) { max = 0x9F; }
+        } else if(ch >= 0xF0 && ch <= 0xF4) {
+            trail = 3;
+            if(ch == 0xF0) { min = 0x90; }
+            if(ch == 0xF4) { max = 0x8F; }
+        } else {
+            return false;
+        }
+
+        if(i + trail >= len) { return false; }
+        if(p[i + 1] < min || p[i + 1] > max) { return false; }
+        for(size_t j = 2; j <= trail; ++j) {
+            if((p[i + j] & 0xC0) != 0x80) { return false; }
+        }
+        i += trail + 1;
+    }
+    return true;
+}
+
+bool LEditor::DoLoadLargeFile()
+{
+    clMemoryMappedFile mmf(m_fileName.GetFullPath());
+    if(!mmf.IsOk() || mmf.GetSize() > (size_t)INT_MAX) { return false; }
+
+    wxStopWatch sw;
+    const char* data = mmf.GetData();
+    size_t size = mmf.GetSize();
+
+    // Sniff the encoding from the file prefix: a BOM comes first, otherwise use the user defined encoding
+    m_fileBom.SetData(data, wxMin(size, (size_t)4));
+    wxFontEncoding encoding = m_fileBom.Encoding();
+    if(encoding != wxFONTENCODING_SYSTEM) {
+        data += m_fileBom.Len();
+        size -= m_fileBom.Len();
+    } else {
+        m_fileBom.Clear();
+        encoding = GetOptions()->GetFileFontEncoding();
+    }
+
+    SetUndoCollection(false);
+    ClearAll();
+
+    // The bytes are handed to scintilla as-is only if the entire file is valid UTF-8: any invalid byte would be
+    // lost on save. Validating is cheap compared with the copy itself
+    if(encoding == wxFONTENCODING_UTF8 && IsValidUTF8(data, size)) {
+        // UTF-8 is scintilla's internal encoding: copy the bytes from the mapped view as-is, no conversion needed.
+        // Each chunk ends on a line boundary so scintilla never sees a partial character or a split CRLF
+        static const size_t LARGE_FILE_CHUNK_SIZE = 4 * 1024 * 1024;
+        Allocate((int)size + 1);
+        size_t offset = 0;
+        while(offset < size) {
+            size_t count = wxMin(LARGE_FILE_CHUNK_SIZE, size - offset);
+            if(offset + count < size) {
+                size_t eol = count;
+                while(eol > 0 && data[offset + eol - 1] != '\n') {
+                    --eol;
+                }
+                if(eol > 0) {
+                    count = eol;
+                } else {
+                    // A very long line: break it on a character boundary
+                    while(count > 1 && (data[offset + count] & 0xC0) == 0x80) {
+                        --count;
+                    }
+                }
+            }
+            AppendTextRaw(data + offset, (int)count);
+            offset += count;
+        }
+
+    } else {
+        // A single conversion pass directly from the mapped view
+        wxString text;
+        if(encoding != wxFONTENCODING_UTF8) {
+            wxCSConv fontEncConv(encoding);
+            if(fontEncConv.IsOk()) { text = wxString(data, fontEncConv, size); }
+        }
+        if(text.IsEmpty()) { text = wxString(data, wxConvUTF8, size); }
+        if(text.IsEmpty()) { text = wxString::From8BitData(data, size); }
+        SetText(text);
+    }
+    SetUndoCollection(true);
+
+    clSYSTEM() << "Large file" << m_fileName << "(" << mmf.GetSize() << "bytes) loaded in" << sw.Time() << "ms"
+               << clEndl;
+    return true;
 }
 
 void LEditor::SetEditorText(const wxString& text)
@@ -3661,7 +3815,8 @@ void LEditor::UpdateColours()
             SetKeyWords(4, GetPreProcessorsWords());
         }
     }
-    Colourise(0, wxSTC_INVALID_POSITION);
+    // Large files are styled on demand, when they are displayed
+    if(!m_largeFile) { Colourise(0, wxSTC_INVALID_POSITION); }
 }
 
 int LEditor::SafeGetChar(int pos)
@@ -3725,6 +3880,8 @@ int LEditor::GetCurrLineHeight()
 
 void LEditor::DoHighlightWord()
 {
+    if(m_largeFile) { return; }
+
     // Read the primary selected text
     int mainSelectionStart = GetSelectionNStart(GetMainSelection());
     int mainSelectionEnd = GetSelectionNEnd(GetMainSelection());
@@ -3835,21 +3992,11 @@ void LEditor::DoSetCaretAt(long pos)
 
 int LEditor::GetEOLByContent()
 {
-    if(GetLength() == 0) { return wxNOT_FOUND; }
-
-    // locate the first EOL
-    wxString txt = GetText();
-    size_t pos1 = static_cast<size_t>(txt.Find(wxT("\n")));
-    size_t pos2 = static_cast<size_t>(txt.Find(wxT("\r\n")));
-    size_t pos3 = static_cast<size_t>(txt.Find(wxT("\r")));
+    // the buffer is empty or it does not contain any EOL
+    if(GetLength() == 0 || GetLineCount() < 2) { return wxNOT_FOUND; }
 
-    size_t max_size_t = static_cast<size_t>(-1);
-    // the buffer is not empty but it does not contain any EOL as well
-    if(pos1 == max_size_t && pos2 == max_size_t && pos3 == max_size_t) { return wxNOT_FOUND; }
-
-    size_t first_eol_pos(0);
-    pos2 < pos1 ? first_eol_pos = pos2 : first_eol_pos = pos1;
-    pos3 < first_eol_pos ? first_eol_pos = pos3 : first_eol_pos = first_eol_pos;
+    // locate the first EOL. Scintilla already knows where the first line ends, no need to copy the buffer
+    int first_eol_pos = GetLineEndPosition(0);
 
     // get the EOL at first_eol_pos
     wxChar ch = SafeGetChar(first_eol_pos);
@@ -3942,6 +4089,12 @@ void LEditor::SetUserIndicator(int startPos, int len)
     IndicatorFillRange(startPos, len);
 }
 
+void LEditor::ClearUserIndicator(int startPos, int len)
+{
+    SetIndicatorCurrent(USER_INDICATOR);
+    IndicatorClearRange(startPos, len);
+}
+
 void LEditor::SetUserIndicatorStyleAndColour(int style, const wxColour& colour)
 {
     IndicatorSetForeground(USER_INDICATOR, colour);
@@ -4870,6 +5023,8 @@ void LEditor::OnTimer(wxTimerEvent& event)
     event.Skip();
     m_timerHighlightMarkers->Start(100, true);
     if(!HasFocus()) return;
+    // Large files: no word highlight and no context idle actions (XML tag matching), both span the whole document
+    if(m_largeFile) return;
 
     if(!HasSelection()) {
         HighlightWord(false);
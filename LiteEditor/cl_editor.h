@@ -27,6 +27,7 @@
 
 #include "bookmark_manager.h"
 #include "browse_record.h"
+#include "clEditorSearchEngine.h"
 #include "clEditorStateLocker.h"
 #include "cl_calltip.h"
 #include "cl_defs.h"
@@ -231,6 +232,8 @@ protected:
     std::map<int, std::vector<BreakpointInfo> > m_breakpointsInfo;
     bool m_autoAdjustHScrollbarWidth;
     bool m_reloadingFile;
+    bool m_largeFile;
+    clEditorSearchEngine m_searchEngine;
     bool m_disableSmartIndent;
     bool m_disableSemicolonShift;
     clEditorTipWindow* m_functionTip;
@@ -295,6 +298,13 @@ public:
     void SetReloadingFile(const bool& reloadingFile) { this->m_reloadingFile = reloadingFile; }
     const bool& GetReloadingFile() const { return m_reloadingFile; }
 
+    /**
+     * @brief return true if this editor holds a file bigger than the "large file" threshold.
+     * In this mode, lexing, folding and word wrapping are disabled and the searches are performed
+     * directly on the document
+     */
+    bool IsLargeFile() const { return m_largeFile; }
+
     clEditorTipWindow* GetFunctionTip() { return m_functionTip; }
 
     bool IsFocused() const;
@@ -845,6 +855,7 @@ public:
     // User Indicators API
     virtual void SetUserIndicatorStyleAndColour(int style, const wxColour& colour);
     virtual void SetUserIndicator(int startPos, int len);
+    virtual void ClearUserIndicator(int startPos, int len);
     virtual void ClearUserIndicators();
     virtual int GetUserIndicatorStart(int pos);
     virtual int GetUserIndicatorEnd(int pos);
@@ -979,6 +990,11 @@ private:
     size_t GetCodeNavModifier();
     // Conevert FindReplaceDialog flags to wxSD flags
     size_t SearchFlags(const FindReplaceData& data);
+    bool DoIsLargeFile() const;
+    /**
+     * @brief load the file from a memory mapped view, return false if the file could not be mapped
+     */
+    bool DoLoadLargeFile();
 
     void AddDebuggerContextMenu(wxMenu* menu);
     void RemoveDebuggerContextMenu(wxMenu* menu);
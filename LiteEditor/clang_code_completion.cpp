@@ -108,7 +108,7 @@ void ClangCodeCompletion::Release()
     ms_instance = 0;
 }
 
-void ClangCodeCompletion::ClearCache() { m_clang.ClearCache(); }
+void ClangCodeCompletion::ClearCache(bool purgeDisk) { m_clang.ClearCache(purgeDisk); }
 
 void ClangCodeCompletion::CodeComplete(IEditor* editor)
 {
@@ -85,7 +85,10 @@ public:
      */
     void Calltip(IEditor* editor);
     void CancelCodeComplete();
-    void ClearCache();
+    /**
+     * @brief dispose all the translation units. When 'purgeDisk' is true, the TUs saved on disk are deleted too
+     */
+    void ClearCache(bool purgeDisk = false);
     bool IsCacheEmpty();
 
 protected:
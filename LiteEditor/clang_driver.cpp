@@ -258,13 +258,10 @@ FileTypeCmpArgs_t ClangDriver::DoPrepareCompilationArgs(const wxString& projectN
             ButtonDetails(), ButtonDetails(), CheckboxDetails(wxT("CodeCompletionMissingCompilationDB")));
 
     } else {
-        cdb.Open();
-        if(cdb.IsOpened()) {
-            CL_DEBUG(wxT("Loading compilation flags for file: %s"), fnSourceFile.GetFullPath().c_str());
-            wxString compilationLine, cwd;
-            cdb.CompilationLine(fnSourceFile.GetFullPath(), compilationLine, cwd);
-            cdb.Close();
-
+        CL_DEBUG(wxT("Loading compilation flags for file: %s"), fnSourceFile.GetFullPath().c_str());
+        wxString compilationLine, cwd;
+        // The database is only opened if its content is not already in memory
+        if(cdb.CompilationLine(fnSourceFile.GetFullPath(), compilationLine, cwd)) {
             CompilerCommandLineParser cclp(compilationLine, cwd);
             cclp.MakeAbsolute(cwd);
             CL_DEBUG(wxT("Loaded compilation flags: %s"), compilationLine.c_str());
@@ -433,9 +430,9 @@ FileTypeCmpArgs_t ClangDriver::DoPrepareCompilationArgs(const wxString& projectN
     return cmpArgs;
 }
 
-void ClangDriver::ClearCache()
+void ClangDriver::ClearCache(bool purgeDisk)
 {
-    m_pchMakerThread.ClearCache();
+    m_pchMakerThread.ClearCache(purgeDisk);
     wxLogNull NoLog;
     std::for_each(m_filesTable.begin(), m_filesTable.end(), [&](const wxStringMap_t::value_type& vt) {
         // Delete the temp files (the keys in the cache)
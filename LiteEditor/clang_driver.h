@@ -84,7 +84,7 @@ public:
     void SetContext(WorkingContext context) { this->m_context = context; }
     WorkingContext GetContext() const { return m_context; }
 
-    void ClearCache();
+    void ClearCache(bool purgeDisk = false);
     bool IsCacheEmpty();
 
     // Event Handlers
@@ -35,6 +35,7 @@
 #include "fileextmanager.h"
 #include "globals.h"
 #include "procutils.h"
+#include "wxStringHash.h"
 #include "y.tab.h"
 #include <wx/app.h>
 #include <wx/regex.h>
@@ -75,10 +76,31 @@ void ClangWorkerThread::ProcessRequest(ThreadRequest* request)
     CL_DEBUG(wxT("==========> [ ClangPchMakerThread ] ProcessRequest started: %s"), task->GetFileName().c_str());
     CL_DEBUG(wxT("ClangWorkerThread:: processing request %d"), (int)task->GetContext());
 
+    bool isGoto = (task->GetContext() == CTX_GotoDecl || task->GetContext() == CTX_GotoImpl);
+    wxString flagsHash = DoGetFlagsHash(task);
+    wxString sourceHash = wxString::Format("%lx", (unsigned long)std::hash<wxString>()(task->GetDirtyBuffer()));
+
     ClangCacheEntry cacheEntry = findEntry(task->GetFileName());
     CXTranslationUnit TU = cacheEntry.TU;
     CL_DEBUG(wxT("ClangWorkerThread:: found cached TU: %p"), (void*)TU);
 
+    if(!TU && isGoto) {
+        // Navigation can be served by a TU saved earlier, as long as nothing it depends on has changed
+        cacheEntry = m_cache.LoadPersisted(task->GetIndex(), task->GetFileName(), flagsHash, sourceHash);
+        TU = cacheEntry.TU;
+        if(TU) {
+            wxCriticalSectionLocker locker(m_criticalSection);
+            m_cache.AddDiskHit();
+        }
+    }
+
+    if(TU && cacheEntry.fromDisk && !isGoto) {
+        // A TU loaded from disk can not be re-parsed nor used for code completion: replace it
+        clang_disposeTranslationUnit(TU);
+        TU = NULL;
+        cacheEntry = ClangCacheEntry();
+    }
+
     bool reparseRequired = true;
     if(!TU) {
 
@@ -88,6 +110,7 @@ void ClangWorkerThread::ProcessRequest(ThreadRequest* request)
         cacheEntry.lastReparse = time(NULL);
         cacheEntry.TU = TU;
         cacheEntry.sourceFile = task->GetFileName();
+        cacheEntry.flagsHash = flagsHash;
     }
 
     if(!TU) {
@@ -118,6 +141,9 @@ void ClangWorkerThread::ProcessRequest(ThreadRequest* request)
         }
     }
 
+    // From here on, the TU reflects the buffer sent with this request
+    cacheEntry.sourceHash = sourceHash;
+
     // Construct a cache-returner class
     // which makes sure that the TU is cached
     // when we leave the current scope
@@ -212,7 +238,8 @@ void ClangWorkerThread::ProcessRequest(ThreadRequest* request)
         time_t fileModificationTime = fnSource.GetModificationTime().GetTicks();
         time_t lastReparseTime = cacheEntry.lastReparse;
 
-        if(fileModificationTime > lastReparseTime) {
+        // A TU loaded from disk was already validated against the buffer (and it can not be re-parsed)
+        if(!cacheEntry.fromDisk && fileModificationTime > lastReparseTime) {
 
             // The file needs to be re-parsed
             DoSetStatusMsg(wxString::Format(wxT("clang: re-parsing file %s...\n"), cacheEntry.sourceFile));
@@ -272,18 +299,37 @@ ClangCacheEntry ClangWorkerThread::findEntry(const wxString& filename)
 
 void ClangWorkerThread::DoCacheResult(ClangCacheEntry entry)
 {
-    wxCriticalSectionLocker locker(m_criticalSection);
-    m_cache.AddPCH(entry);
+    // A TU is only saved to disk when it leaves the cache: saving it takes a while, so it is done
+    // without holding the lock
+    std::vector<ClangCacheEntry> evicted;
+    {
+        wxCriticalSectionLocker locker(m_criticalSection);
+        m_cache.AddPCH(entry, &evicted);
+    }
+
+    for(size_t i = 0; i < evicted.size(); ++i) {
+        m_cache.Persist(evicted.at(i));
+        clang_disposeTranslationUnit(evicted.at(i).TU);
+    }
 
     CL_DEBUG(wxT("caching Translation Unit file: %s, %p"), entry.sourceFile.c_str(), (void*)entry.TU);
     CL_DEBUG(wxT(" ==========> [ ClangPchMakerThread ] PCH creation ended successfully <=============="));
 }
 
-void ClangWorkerThread::ClearCache()
+void ClangWorkerThread::ClearCache(bool purgeDisk)
 {
+    // Unless they are purged, the live TUs are saved to disk so they survive a workspace reload or a restart.
+    // Like the evicted TUs, they are saved without holding the lock
+    std::vector<ClangCacheEntry> removed;
     {
         wxCriticalSectionLocker locker(m_criticalSection);
-        m_cache.Clear();
+        CL_DEBUG(wxT("clang TU cache: %s"), m_cache.GetStats().ToString().c_str());
+        m_cache.Clear(purgeDisk, &removed);
+    }
+
+    for(size_t i = 0; i < removed.size(); ++i) {
+        m_cache.Persist(removed.at(i));
+        clang_disposeTranslationUnit(removed.at(i).TU);
     }
 
     this->DoSetStatusMsg(wxT("clang: cache cleared"));
@@ -299,6 +345,24 @@ bool ClangWorkerThread::IsCacheEmpty()
     return m_cache.IsEmpty();
 }
 
+ClangTUCache::Stats ClangWorkerThread::GetCacheStats()
+{
+    wxCriticalSectionLocker locker(m_criticalSection);
+    return m_cache.GetStats();
+}
+
+wxString ClangWorkerThread::DoGetFlagsHash(ClangThreadRequest* req)
+{
+    int argc(0);
+    char** argv = MakeCommandLine(req, argc, FileExtManager::GetType(req->GetFileName()));
+    wxString commandLine;
+    for(int i = 0; i < argc; ++i) {
+        commandLine << wxString(argv[i], wxConvUTF8) << " ";
+    }
+    ClangUtils::FreeArgv(argv, argc);
+    return wxString::Format("%lx", (unsigned long)std::hash<wxString>()(commandLine));
+}
+
 char** ClangWorkerThread::MakeCommandLine(ClangThreadRequest* req, int& argc, FileExtManager::FileType fileType)
 {
     bool isHeader = !(fileType == FileExtManager::TypeSourceC || fileType == FileExtManager::TypeSourceCpp);
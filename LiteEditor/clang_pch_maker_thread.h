@@ -156,6 +156,7 @@ public:
 
 protected:
     char** MakeCommandLine(ClangThreadRequest* req, int& argc, FileExtManager::FileType fileType);
+    wxString DoGetFlagsHash(ClangThreadRequest* req);
     void DoCacheResult(ClangCacheEntry entry);
     void DoSetStatusMsg(const wxString& msg);
     bool DoGotoDefinition(CXTranslationUnit& TU, ClangThreadRequest* request, ClangThreadReply* reply);
@@ -165,8 +166,9 @@ protected:
 public:
     virtual void ProcessRequest(ThreadRequest* task);
     ClangCacheEntry findEntry(const wxString& filename);
-    void ClearCache();
+    void ClearCache(bool purgeDisk = false);
     bool IsCacheEmpty();
+    ClangTUCache::Stats GetCacheStats();
 };
 
 ////////////////////////////////////////////////////////////
@@ -25,114 +25,307 @@
 
 #if HAS_LIBCLANG
 
+#include "cl_config.h"
+#include "cl_standard_paths.h"
 #include "clangpch_cache.h"
 #include "file_logger.h"
 #include "fileutils.h"
+#include "wxStringHash.h"
+#include <algorithm>
+#include <vector>
 #include <wx/dir.h>
 #include <wx/log.h>
 #include <wx/stdpaths.h>
+#include <wx/tokenzr.h>
+
+// Maximum number of TUs kept on disk
+#define CLANG_MAX_PERSISTED_TU 32
+
+namespace
+{
+struct InclusionsCollector {
+    wxString mainFile;
+    wxString content;
+};
+
+void CollectInclusions(CXFile includedFile, CXSourceLocation*, unsigned, CXClientData clientData)
+{
+    InclusionsCollector* collector = reinterpret_cast<InclusionsCollector*>(clientData);
+    CXString cxFileName = clang_getFileName(includedFile);
+    wxString fileName = wxString(clang_getCString(cxFileName), wxConvUTF8);
+    clang_disposeString(cxFileName);
+
+    // The main file is validated by its content, see ClangCacheEntry::sourceHash
+    if(fileName.IsEmpty() || fileName == collector->mainFile) { return; }
+    collector->content << (long)clang_getFileTime(includedFile) << "|" << fileName << "\n";
+}
+} // namespace
+
+wxString ClangTUCache::Stats::ToString() const
+{
+    return wxString::Format("hits: %u, misses: %u, disk hits: %u, evictions: %u, hit rate: %.1f%%", (unsigned)hits,
+                            (unsigned)misses, (unsigned)diskHits, (unsigned)evictions, GetHitRate() * 100.0);
+}
 
 ClangTUCache::ClangTUCache()
     : m_maxItems(10)
+    , m_memoryBudget(0)
+    , m_memoryUsage(0)
 {
+    m_maxItems = wxMax(1, clConfig::Get().Read(kConfigClangTUCacheMaxItems, 10));
+    m_memoryBudget = (size_t)wxMax(64, clConfig::Get().Read(kConfigClangTUCacheMemoryBudget, 1024)) * 1024 * 1024;
+
+    wxFileName cacheDir(clStandardPaths::Get().GetUserDataDir(), "");
+    cacheDir.AppendDir("clang-cache");
+    cacheDir.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+    m_cacheDir = cacheDir.GetPath();
 }
 
 ClangTUCache::~ClangTUCache() {}
 
 ClangCacheEntry ClangTUCache::GetPCH(const wxString& filename)
 {
-    std::map<wxString, ClangCacheEntry>::iterator iter = m_cache.find(filename);
-    if(iter == m_cache.end()) { return ClangCacheEntry(); }
+    std::map<wxString, Item>::iterator iter = m_cache.find(filename);
+    if(iter == m_cache.end()) {
+        ++m_stats.misses;
+        return ClangCacheEntry();
+    }
+
     // Remove this entry from the cache. It is up to the caller to place it back!
-    ClangCacheEntry entry = iter->second;
-    m_cache.erase(iter);
-    return entry;
+    ++m_stats.hits;
+    return DoRemove(iter);
 }
 
-void ClangTUCache::AddPCH(ClangCacheEntry entry)
+void ClangTUCache::AddPCH(ClangCacheEntry entry, std::vector<ClangCacheEntry>* evicted)
 {
+    entry.lastAccessed = time(NULL);
+    entry.memoryUsage = GetMemoryUsage(entry.TU);
+
     // See if we already have a cache entry for this file name
-    std::map<wxString, ClangCacheEntry>::iterator iter = m_cache.find(entry.sourceFile);
-    if(iter != m_cache.end() && iter->second.TU == entry.TU) {
-        // the entry in the cache is the same as this one
-        // Just update the access-time
-        iter->second.lastAccessed = time(NULL);
-        return;
+    std::map<wxString, Item>::iterator iter = m_cache.find(entry.sourceFile);
+    if(iter != m_cache.end()) {
+        if(iter->second.entry.TU == entry.TU) {
+            // the entry in the cache is the same as this one
+            // Just update it and mark it as the most recently used
+            m_memoryUsage -= wxMin(m_memoryUsage, iter->second.entry.memoryUsage);
+            m_memoryUsage += entry.memoryUsage;
+            iter->second.entry = entry;
+            m_lru.splice(m_lru.begin(), m_lru, iter->second.lruIter);
+            return;
+        }
+        // A different TU for the same file: replace it
+        DoDispose(iter);
     }
 
-    entry.lastAccessed = time(NULL);
-    m_cache.insert(std::make_pair(entry.sourceFile, entry));
-
-    if(m_cache.size() > m_maxItems) {
-        CL_DEBUG1(wxT("clang PCH cache size reached its maximum size, removing last accessed entry"));
-        time_t oldest_timestamp = time(NULL);
-        // iterate over the cache and remove the oldest item from the cache
-        std::map<wxString, ClangCacheEntry>::iterator it = m_cache.begin();
-        wxString key_to_remove;
-        for(; it != m_cache.end(); it++) {
-            if(it->second.lastAccessed <= oldest_timestamp) {
-                key_to_remove = it->first;
-                oldest_timestamp = it->second.lastAccessed;
-            }
-        }
+    m_lru.push_front(entry.sourceFile);
+    Item item;
+    item.entry = entry;
+    item.lruIter = m_lru.begin();
+    m_cache.insert(std::make_pair(entry.sourceFile, item));
+    m_memoryUsage += entry.memoryUsage;
+    DoEvict(evicted);
+}
 
-        if(key_to_remove.IsEmpty() == false) {
-            CL_DEBUG(wxT("Removing entry for key: %s"), key_to_remove.c_str());
-            RemoveEntry(key_to_remove);
+void ClangTUCache::DoEvict(std::vector<ClangCacheEntry>* evicted)
+{
+    // Always keep the most recently used TU, even if it is over the budget on its own
+    while(m_cache.size() > 1 && (m_cache.size() > m_maxItems || m_memoryUsage > m_memoryBudget)) {
+        std::map<wxString, Item>::iterator iter = m_cache.find(m_lru.back());
+        if(iter == m_cache.end()) {
+            // Can't happen
+            m_lru.pop_back();
+            continue;
+        }
+        CL_DEBUG(wxT("clang TU cache is full (%u TUs, %u MB), evicting: %s"), (unsigned)m_cache.size(),
+                 (unsigned)(m_memoryUsage / (1024 * 1024)), iter->first.c_str());
+        ++m_stats.evictions;
+        if(evicted) {
+            evicted->push_back(DoRemove(iter));
+        } else {
+            DoDispose(iter);
         }
     }
+    CL_DEBUG(wxT("clang TU cache: %s"), m_stats.ToString().c_str());
 }
 
-void ClangTUCache::Clear()
+ClangCacheEntry ClangTUCache::DoRemove(std::map<wxString, Item>::iterator iter)
+{
+    ClangCacheEntry entry = iter->second.entry;
+    m_memoryUsage -= wxMin(m_memoryUsage, entry.memoryUsage);
+    m_lru.erase(iter->second.lruIter);
+    m_cache.erase(iter);
+    return entry;
+}
+
+void ClangTUCache::DoDispose(std::map<wxString, Item>::iterator iter)
+{
+    // The TU saved on disk (entry.fileTU) is kept, it is validated when loaded
+    ClangCacheEntry entry = DoRemove(iter);
+    CL_DEBUG(wxT("clang_disposeTranslationUnit for TU: %p"), (void*)entry.TU);
+    if(entry.TU) { clang_disposeTranslationUnit(entry.TU); }
+}
+
+void ClangTUCache::Clear(bool purgeDisk, std::vector<ClangCacheEntry>* removed)
 {
     CL_DEBUG(wxT("clang PCH cache cleared!"));
-    std::map<wxString, ClangCacheEntry>::iterator it = m_cache.begin();
-    for(; it != m_cache.end(); it++) {
-        if(it->second.TU) {
-            CL_DEBUG(wxT("Deleting TU: %p"), (void*)it->second.TU);
-            clang_disposeTranslationUnit(it->second.TU);
+    while(!m_cache.empty()) {
+        if(removed && !purgeDisk) {
+            removed->push_back(DoRemove(m_cache.begin()));
+        } else {
+            DoDispose(m_cache.begin());
         }
     }
-    m_cache.clear();
-
-    // Clear the TU from the file system
-    // if(WorkspaceST::Get()->IsOpen()) {
-    //    wxString clangFileSystemCacheDir;
-    //    clangFileSystemCacheDir << WorkspaceST::Get()->GetWorkspaceFileName().GetPath()
-    //                            << wxFileName::GetPathSeparator()
-    //                            << wxT(".clang");
-    //    DeleteDirectoryContent(clangFileSystemCacheDir);
-    //}
+    if(purgeDisk) { DeleteDirectoryContent(m_cacheDir); }
 }
 
 void ClangTUCache::RemoveEntry(const wxString& filename)
 {
-    std::map<wxString, ClangCacheEntry>::iterator iter = m_cache.find(filename);
-    if(iter != m_cache.end()) {
-        CL_DEBUG(wxT("clang_disposeTranslationUnit for TU: %p"), (void*)iter->second.TU);
-        clang_disposeTranslationUnit(iter->second.TU);
-        {
-            wxLogNull nolog;
-            clRemoveFile(iter->second.fileTU);
-        }
-        // it is now safe to erase the iter
-        m_cache.erase(iter);
-    }
+    std::map<wxString, Item>::iterator iter = m_cache.find(filename);
+    if(iter != m_cache.end()) { DoDispose(iter); }
 }
 
 bool ClangTUCache::Contains(const wxString& filename) const { return m_cache.find(filename) != m_cache.end(); }
 
 wxString ClangTUCache::GetTuFileName(const wxString& sourceFile) const
 {
-    std::map<wxString, ClangCacheEntry>::const_iterator iter = m_cache.find(sourceFile);
-    if(iter != m_cache.end()) return iter->second.fileTU;
+    std::map<wxString, Item>::const_iterator iter = m_cache.find(sourceFile);
+    if(iter != m_cache.end()) return iter->second.entry.fileTU;
     return wxT("");
 }
 
+size_t ClangTUCache::GetMemoryUsage(CXTranslationUnit TU)
+{
+    if(!TU) { return 0; }
+    size_t total = 0;
+    CXTUResourceUsage usage = clang_getCXTUResourceUsage(TU);
+    for(unsigned i = 0; i < usage.numEntries; ++i) {
+        // All the resource kinds reported by clang are memory kinds
+        if(usage.entries[i].kind >= CXTUResourceUsage_MEMORY_IN_BYTES_BEGIN &&
+           usage.entries[i].kind <= CXTUResourceUsage_MEMORY_IN_BYTES_END) {
+            total += usage.entries[i].amount;
+        }
+    }
+    clang_disposeCXTUResourceUsage(usage);
+    return total;
+}
+
+wxString ClangTUCache::DoGetPersistentFile(const wxString& sourceFile, const wxString& flagsHash) const
+{
+    wxString key;
+    key << sourceFile << "|" << flagsHash;
+    wxFileName fn(m_cacheDir, wxString::Format("%lx.TU", (unsigned long)std::hash<wxString>()(key)));
+    return fn.GetFullPath();
+}
+
+wxString ClangTUCache::Persist(const ClangCacheEntry& entry) const
+{
+    if(!entry.TU || entry.fromDisk) { return ""; }
+
+    wxString tuFile = DoGetPersistentFile(entry.sourceFile, entry.flagsHash);
+    wxFileName depsFile(tuFile);
+    depsFile.SetExt("deps");
+
+    if(clang_saveTranslationUnit(entry.TU, tuFile.mb_str(wxConvUTF8).data(), clang_defaultSaveOptions(entry.TU)) !=
+       CXSaveError_None) {
+        CL_DEBUG(wxT("Failed to save TU for file: %s"), entry.sourceFile.c_str());
+        wxLogNull nolog;
+        clRemoveFile(tuFile);
+        return "";
+    }
+
+    // The sidecar file: the key, the buffer hash and the time stamps of all the included files
+    InclusionsCollector collector;
+    collector.mainFile = entry.sourceFile;
+    collector.content << entry.sourceFile << "\n" << entry.flagsHash << "\n" << entry.sourceHash << "\n";
+    clang_getInclusions(entry.TU, CollectInclusions, &collector);
+    if(!FileUtils::WriteFileContent(depsFile, collector.content)) {
+        wxLogNull nolog;
+        clRemoveFile(tuFile);
+        return "";
+    }
+
+    CL_DEBUG(wxT("clang TU for file %s saved to %s"), entry.sourceFile.c_str(), tuFile.c_str());
+    DoPrunePersisted();
+    return tuFile;
+}
+
+ClangCacheEntry ClangTUCache::LoadPersisted(CXIndex index, const wxString& sourceFile, const wxString& flagsHash,
+                                            const wxString& sourceHash) const
+{
+    wxString tuFile = DoGetPersistentFile(sourceFile, flagsHash);
+    wxFileName depsFile(tuFile);
+    depsFile.SetExt("deps");
+    if(!wxFileName::FileExists(tuFile) || !depsFile.FileExists()) { return ClangCacheEntry(); }
+
+    wxString content;
+    if(!FileUtils::ReadFileContent(depsFile, content)) { return ClangCacheEntry(); }
+
+    bool isValid = false;
+    wxArrayString lines = ::wxStringTokenize(content, "\n", wxTOKEN_RET_EMPTY_ALL);
+    if(lines.GetCount() >= 3 && lines.Item(0) == sourceFile && lines.Item(1) == flagsHash &&
+       lines.Item(2) == sourceHash) {
+        isValid = true;
+        for(size_t i = 3; i < lines.GetCount() && isValid; ++i) {
+            if(lines.Item(i).IsEmpty()) { continue; }
+            long savedTime = 0;
+            wxString fileName = lines.Item(i).AfterFirst('|');
+            if(!lines.Item(i).BeforeFirst('|').ToLong(&savedTime) || !wxFileName::FileExists(fileName) ||
+               (long)FileUtils::GetFileModificationTime(fileName) != savedTime) {
+                CL_DEBUG(wxT("clang TU saved for %s is stale (%s was modified)"), sourceFile.c_str(),
+                         fileName.c_str());
+                isValid = false;
+            }
+        }
+    }
+
+    if(!isValid) {
+        wxLogNull nolog;
+        clRemoveFile(tuFile);
+        clRemoveFile(depsFile.GetFullPath());
+        return ClangCacheEntry();
+    }
+
+    ClangCacheEntry entry;
+    entry.TU = clang_createTranslationUnit(index, tuFile.mb_str(wxConvUTF8).data());
+    if(!entry.TU) { return ClangCacheEntry(); }
+
+    entry.sourceFile = sourceFile;
+    entry.flagsHash = flagsHash;
+    entry.sourceHash = sourceHash;
+    entry.fileTU = tuFile;
+    entry.fromDisk = true;
+    entry.lastReparse = FileUtils::GetFileModificationTime(tuFile);
+    CL_DEBUG(wxT("clang TU for file %s loaded from %s"), sourceFile.c_str(), tuFile.c_str());
+    return entry;
+}
+
+void ClangTUCache::DoPrunePersisted() const
+{
+    wxArrayString files;
+    wxDir::GetAllFiles(m_cacheDir, &files, wxT("*.TU"), wxDIR_FILES);
+    if(files.GetCount() <= CLANG_MAX_PERSISTED_TU) { return; }
+
+    // Remove the oldest files
+    std::vector<std::pair<time_t, wxString> > byAge;
+    for(size_t i = 0; i < files.GetCount(); ++i) {
+        byAge.push_back(std::make_pair(FileUtils::GetFileModificationTime(files.Item(i)), files.Item(i)));
+    }
+    std::sort(byAge.begin(), byAge.end());
+
+    wxLogNull nolog;
+    for(size_t i = 0; i < byAge.size() - CLANG_MAX_PERSISTED_TU; ++i) {
+        wxFileName depsFile(byAge[i].second);
+        depsFile.SetExt("deps");
+        clRemoveFile(byAge[i].second);
+        clRemoveFile(depsFile.GetFullPath());
+    }
+}
+
 void ClangTUCache::DeleteDirectoryContent(const wxString& directory)
 {
     wxArrayString files;
     wxDir::GetAllFiles(directory, &files, wxT("*.TU"));
+    wxDir::GetAllFiles(directory, &files, wxT("*.deps"));
     wxLogNull nolog;
 
     CL_DEBUG(wxT("Clearing clang TU cache from %s"), directory.c_str());
@@ -29,8 +29,10 @@
 #if HAS_LIBCLANG
 
 #include <wx/string.h>
+#include <list>
 #include <map>
 #include <set>
+#include <vector>
 #include "globals.h"
 #include <clang-c/Index.h>
 
@@ -42,10 +44,14 @@ public:
 	wxString          fileTU;
 	wxString          sourceFile;
 	time_t            lastReparse;
+	wxString          flagsHash;    // hash of the command line used to parse the TU
+	wxString          sourceHash;   // hash of the buffer the TU was created from
+	size_t            memoryUsage;  // bytes, as reported by clang
+	bool              fromDisk;     // loaded from a saved AST: it can not be re-parsed
 	
 public:
 	
-	ClangCacheEntry() : TU(NULL), lastAccessed(0), lastReparse(0) {}
+	ClangCacheEntry() : TU(NULL), lastAccessed(0), lastReparse(0), memoryUsage(0), fromDisk(false) {}
 	ClangCacheEntry(const ClangCacheEntry &rhs) {
 		*this = rhs;
 	}
@@ -56,6 +62,10 @@ public:
 		this->fileTU       = rhs.fileTU;
 		this->sourceFile   = rhs.sourceFile;
 		this->lastReparse  = rhs.lastReparse;
+		this->flagsHash    = rhs.flagsHash;
+		this->sourceHash   = rhs.sourceHash;
+		this->memoryUsage  = rhs.memoryUsage;
+		this->fromDisk     = rhs.fromDisk;
 	}
 	
 	bool IsOk() const {
@@ -63,26 +73,106 @@ public:
 	}
 };
 
+/**
+ * @class ClangTUCache
+ * @brief an LRU cache of translation units, bounded by the number of TUs and by the memory clang reports for them.
+ * TUs can be saved to disk (keyed by the source file and the flags hash) together with the modification
+ * time of every file they include, so they can be loaded back - even after a restart - as long as none of
+ * these files changed
+ */
 class ClangTUCache
 {
+public:
+	struct Stats {
+		size_t hits;
+		size_t misses;
+		size_t diskHits;
+		size_t evictions;
+		Stats() : hits(0), misses(0), diskHits(0), evictions(0) {}
+		double GetHitRate() const {
+			size_t total = hits + misses;
+			return total ? (double)(hits + diskHits) / (double)total : 0.0;
+		}
+		wxString ToString() const;
+	};
+
+protected:
+	typedef std::list<wxString> LRUList_t;
+	struct Item {
+		ClangCacheEntry  entry;
+		LRUList_t::iterator lruIter;
+	};
+
+	std::map<wxString, Item> m_cache;
+	LRUList_t                m_lru; // most recently used first
+	size_t                   m_maxItems;
+	size_t                   m_memoryBudget;
+	size_t                   m_memoryUsage;
+	wxString                 m_cacheDir;
+	Stats                    m_stats;
+
 protected:
-	std::map<wxString, ClangCacheEntry> m_cache;
-	size_t                              m_maxItems;
+	void DoEvict(std::vector<ClangCacheEntry> *evicted);
+	ClangCacheEntry DoRemove(std::map<wxString, Item>::iterator iter);
+	void DoDispose(std::map<wxString, Item>::iterator iter);
+	wxString DoGetPersistentFile(const wxString &sourceFile, const wxString &flagsHash) const;
+	void DoPrunePersisted() const;
 	
 public:
 	ClangTUCache();
 	virtual ~ClangTUCache();
 
 	ClangCacheEntry GetPCH(const wxString &filename);
-	void AddPCH(ClangCacheEntry entry);
+	/**
+	 * @brief add a TU to the cache. If 'evicted' is not NULL, the TUs evicted to make room for it are
+	 * moved there instead of being disposed: the caller can save them with Persist() and dispose them
+	 * without holding the cache lock
+	 */
+	void AddPCH(ClangCacheEntry entry, std::vector<ClangCacheEntry> *evicted = NULL);
 	void RemoveEntry(const wxString &filename);
-	void Clear();
+	/**
+	 * @brief remove all the TUs. When 'purgeDisk' is true, the TUs saved on disk are deleted as well.
+	 * Otherwise, if 'removed' is not NULL, the TUs are moved there instead of being disposed, like AddPCH()
+	 * does with the evicted ones: the caller can save them with Persist() and dispose them without holding the lock
+	 */
+	void Clear(bool purgeDisk = false, std::vector<ClangCacheEntry> *removed = NULL);
     bool Contains(const wxString &filename) const;
 	wxString GetTuFileName(const wxString &sourceFile) const;
 	bool IsEmpty() const {
 		return m_cache.empty();
 	}
 	
+	/**
+	 * @brief save the TU to disk. This does not touch the cache itself, so it can be called without holding
+	 * the cache lock
+	 * @return the saved file, or an empty string
+	 */
+	wxString Persist(const ClangCacheEntry &entry) const;
+
+	/**
+	 * @brief load a TU saved earlier (in this or a previous session). Return an empty entry if there is none,
+	 * if it was created from a different buffer or if any of the files it includes was modified since.
+	 * Like Persist(), this does not touch the cache itself
+	 */
+	ClangCacheEntry LoadPersisted(CXIndex index, const wxString &sourceFile, const wxString &flagsHash,
+	                              const wxString &sourceHash) const;
+
+	/**
+	 * @brief record a TU that was served by LoadPersisted()
+	 */
+	void AddDiskHit() {
+		++m_stats.diskHits;
+	}
+
+	/**
+	 * @brief the memory used by a TU, in bytes
+	 */
+	static size_t GetMemoryUsage(CXTranslationUnit TU);
+
+	const Stats& GetStats() const {
+		return m_stats;
+	}
+
 	static void DeleteDirectoryContent(const wxString &directory);
 };
 #endif // HAS_LIBCLANG
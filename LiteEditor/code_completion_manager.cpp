@@ -41,6 +41,7 @@
 #include "compiler_command_line_parser.h"
 #include "language.h"
 #include "code_completion_api.h"
+#include "CxxPreProcessorIncludeCache.h"
 
 static CodeCompletionManager* ms_CodeCompletionManager = NULL;
 
@@ -87,6 +88,11 @@ CodeCompletionManager::CodeCompletionManager()
         wxEVT_WORKSPACE_CLOSED, wxCommandEventHandler(CodeCompletionManager::OnWorkspaceClosed), NULL, this);
     EventNotifier::Get()->Bind(
         wxEVT_ENVIRONMENT_VARIABLES_MODIFIED, &CodeCompletionManager::OnEnvironmentVariablesModified, this);
+    EventNotifier::Get()->Bind(wxEVT_FILE_SYSTEM_UPDATED, &CodeCompletionManager::OnFileSystemUpdated, this);
+    EventNotifier::Get()->Bind(wxEVT_FILE_DELETED, &CodeCompletionManager::OnFileSystemUpdated, this);
+    EventNotifier::Get()->Bind(wxEVT_FOLDER_DELETED, &CodeCompletionManager::OnFileSystemUpdated, this);
+    EventNotifier::Get()->Bind(wxEVT_FILE_RENAMED, &CodeCompletionManager::OnFileSystemUpdated, this);
+    EventNotifier::Get()->Bind(wxEVT_FILE_SAVEAS, &CodeCompletionManager::OnFileSystemUpdated, this);
     // Start the worker threads
     m_preProcessorThread.Start();
     m_usingNamespaceThread.Start();
@@ -115,6 +121,11 @@ CodeCompletionManager::~CodeCompletionManager()
     wxTheApp->Unbind(wxEVT_ACTIVATE_APP, &CodeCompletionManager::OnAppActivated, this);
     EventNotifier::Get()->Unbind(
         wxEVT_ENVIRONMENT_VARIABLES_MODIFIED, &CodeCompletionManager::OnEnvironmentVariablesModified, this);
+    EventNotifier::Get()->Unbind(wxEVT_FILE_SYSTEM_UPDATED, &CodeCompletionManager::OnFileSystemUpdated, this);
+    EventNotifier::Get()->Unbind(wxEVT_FILE_DELETED, &CodeCompletionManager::OnFileSystemUpdated, this);
+    EventNotifier::Get()->Unbind(wxEVT_FOLDER_DELETED, &CodeCompletionManager::OnFileSystemUpdated, this);
+    EventNotifier::Get()->Unbind(wxEVT_FILE_RENAMED, &CodeCompletionManager::OnFileSystemUpdated, this);
+    EventNotifier::Get()->Unbind(wxEVT_FILE_SAVEAS, &CodeCompletionManager::OnFileSystemUpdated, this);
 }
 
 void CodeCompletionManager::WordCompletion(LEditor* editor, const wxString& expr, const wxString& word)
@@ -362,6 +373,8 @@ void CodeCompletionManager::GotoDecl(LEditor* editor)
 void CodeCompletionManager::OnBuildEnded(clBuildEvent& e)
 {
     e.Skip();
+    // The build may have generated headers that could not be found so far
+    CxxPreProcessorIncludeCache::Get().ClearMissing();
     DoUpdateCompilationDatabase();
     m_buildInProgress = false;
 }
@@ -420,6 +433,8 @@ void CodeCompletionManager::OnParseThreadCollectedMacros(const wxArrayString& de
 void CodeCompletionManager::OnFileSaved(clCommandEvent& event)
 {
     event.Skip();
+    // The saved file may be a new file that resolves an include that could not be found so far
+    CxxPreProcessorIncludeCache::Get().ClearMissing();
     if(TagsManagerST::Get()->GetCtagsOptions().GetCcColourFlags() & CC_COLOUR_MACRO_BLOCKS) {
         ProcessMacros(clMainFrame::Get()->GetMainBook()->FindEditor(event.GetFileName()));
     }
@@ -585,6 +600,14 @@ void CodeCompletionManager::OnWorkspaceClosed(wxCommandEvent& event)
     event.Skip();
     LanguageST::Get()->ClearAdditionalScopesCache();
     Project::ClearBacktickCache();
+    CxxPreProcessorIncludeCache::Get().Clear();
+}
+
+void CodeCompletionManager::OnFileSystemUpdated(clFileSystemEvent& event)
+{
+    event.Skip();
+    // Files were added, removed or renamed: the resolved include statements can not be trusted
+    CxxPreProcessorIncludeCache::Get().Clear();
 }
 
 void CodeCompletionManager::OnEnvironmentVariablesModified(clCommandEvent& event)
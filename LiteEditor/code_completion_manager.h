@@ -30,6 +30,7 @@
 #include <wx/filename.h>
 #include "cl_editor.h"
 #include "cl_command_event.h"
+#include "clFileSystemEvent.h"
 #include <wx/event.h>
 #include "CompileCommandsCreateor.h"
 #include "CxxPreProcessorThread.h"
@@ -74,6 +75,7 @@ protected:
     void OnWorkspaceConfig(wxCommandEvent& event);
     void OnWorkspaceClosed(wxCommandEvent& event);
     void OnEnvironmentVariablesModified(clCommandEvent &event);
+    void OnFileSystemUpdated(clFileSystemEvent& event);
     
 public:
     CodeCompletionManager();
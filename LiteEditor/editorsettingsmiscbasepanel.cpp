@@ -124,6 +124,12 @@ EditorSettingsMiscBasePanel::EditorSettingsMiscBasePanel(wxWindow* parent, wxWin
     
     staticBoxSizer4->Add(m_checkBoxRestoreSession, 0, wxALL, WXC_FROM_DIP(5));
     
+    m_checkBoxRestoreSessionLazily = new wxCheckBox(m_panel1, wxID_ANY, _("Load the session editors on demand"), wxDefaultPosition, wxDLG_UNIT(m_panel1, wxSize(-1,-1)), 0);
+    m_checkBoxRestoreSessionLazily->SetValue(false);
+    m_checkBoxRestoreSessionLazily->SetToolTip(_("Restore the tabs of the last session without loading their files.\nA file is loaded when its tab is selected for the first time"));
+    
+    staticBoxSizer4->Add(m_checkBoxRestoreSessionLazily, 0, wxALL, WXC_FROM_DIP(5));
+    
     wxFlexGridSizer* flexGridSizer77 = new wxFlexGridSizer(0, 2, 0, 0);
     flexGridSizer77->SetFlexibleDirection( wxBOTH );
     flexGridSizer77->SetNonFlexibleGrowMode( wxFLEX_GROWMODE_SPECIFIED );
@@ -56,6 +56,7 @@ protected:
     wxCheckBox* m_versionCheckOnStartup;
     wxCheckBox* m_checkBoxPromptReleaseOnly;
     wxCheckBox* m_checkBoxRestoreSession;
+    wxCheckBox* m_checkBoxRestoreSessionLazily;
     wxStaticText* m_staticText79;
     wxTextCtrl* m_webSearchPrefix;
     wxPanel* m_panel23;
@@ -124,6 +125,7 @@ public:
     wxCheckBox* GetVersionCheckOnStartup() { return m_versionCheckOnStartup; }
     wxCheckBox* GetCheckBoxPromptReleaseOnly() { return m_checkBoxPromptReleaseOnly; }
     wxCheckBox* GetCheckBoxRestoreSession() { return m_checkBoxRestoreSession; }
+    wxCheckBox* GetCheckBoxRestoreSessionLazily() { return m_checkBoxRestoreSessionLazily; }
     wxStaticText* GetStaticText79() { return m_staticText79; }
     wxTextCtrl* GetWebSearchPrefix() { return m_webSearchPrefix; }
     wxPanel* GetPanel1() { return m_panel1; }
@@ -99,6 +99,7 @@ EditorSettingsMiscPanel::EditorSettingsMiscPanel(wxWindow* parent)
     m_choice4->SetStringSelection(
         FileLogger::GetVerbosityAsString(clConfig::Get().Read(kConfigLogVerbosity, FileLogger::Error)));
     m_checkBoxRestoreSession->SetValue(clConfig::Get().Read(kConfigRestoreLastSession, true));
+    m_checkBoxRestoreSessionLazily->SetValue(clConfig::Get().Read(kConfigRestoreSessionLazily, true));
     m_textCtrlPattern->ChangeValue(clConfig::Get().Read(kConfigFrameTitlePattern, wxString("$workspace $fullpath")));
     m_statusbarShowLine->SetValue(clConfig::Get().Read(kConfigStatusbarShowLine, true));
     m_statusbarShowCol->SetValue(clConfig::Get().Read(kConfigStatusbarShowColumn, true));
@@ -143,6 +144,7 @@ void EditorSettingsMiscPanel::Save(OptionsConfigPtr options)
     clConfig::Get().Write(kConfigMaxItemsInFindReplaceDialog, ::wxStringToInt(m_maxItemsFindReplace->GetValue(), 15));
     clConfig::Get().Write(kConfigMaxOpenedTabs, ::wxStringToInt(m_spinCtrlMaxOpenTabs->GetValue(), 15));
     clConfig::Get().Write(kConfigRestoreLastSession, m_checkBoxRestoreSession->IsChecked());
+    clConfig::Get().Write(kConfigRestoreSessionLazily, m_checkBoxRestoreSessionLazily->IsChecked());
     clConfig::Get().Write(kConfigFrameTitlePattern, m_textCtrlPattern->GetValue());
     clConfig::Get().Write(kConfigStatusbarShowLine, m_statusbarShowLine->IsChecked());
     clConfig::Get().Write(kConfigStatusbarShowColumn, m_statusbarShowCol->IsChecked());
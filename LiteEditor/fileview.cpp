@@ -1528,7 +1528,17 @@ wxTreeItemId FileViewTree::FindItemByPath(wxTreeItemId& projectHTI, const wxStri
     if(curItem.IsOk()) {
         DoBuildSubTreeIfNeeded(curItem);
 
-        // We found the virtual folder that should contain the filename
+        // We found the virtual folder that should contain the filename. When the project knows the file,
+        // its item is simply the child with the same name
+        if(!vdFullPath.IsEmpty()) {
+            wxTreeItemId child = DoGetItemByText(curItem, wxFileName(fileName).GetFullName());
+            FilewViewTreeItemData* childData = ItemData(child);
+            if(childData && childData->GetData().IsFile() && childData->GetData().GetFile() == fileName) {
+                return child;
+            }
+        }
+
+        // Compare the full paths
         wxTreeItemIdValue cookie;
         wxTreeItemId child = GetFirstChild(curItem, cookie);
         while(child.IsOk()) {
@@ -1561,6 +1571,8 @@ wxTreeItemId FileViewTree::ItemByFullPath(const wxString& fullPath)
     wxTreeItemId parent = GetItemParent(m_projectsMap[projname]);
     wxArrayString texts = wxStringTokenize(fullPath, wxT(":"), wxTOKEN_STRTOK);
     for(size_t i = 0; i < texts.GetCount(); i++) {
+        // Virtual folders are populated only when expanded
+        DoBuildSubTreeIfNeeded(parent);
         parent = DoGetItemByText(parent, texts.Item(i));
         if(parent.IsOk() == false) { return wxTreeItemId(); }
     }
@@ -2951,6 +2963,21 @@ void FileViewTree::DoAddChildren(const wxTreeItemId& parentItem)
         proj->GetFolders("", folders);
     }
 
+    // The children are appended already sorted (folders first, then files, by name - see OnCompareItems)
+    // so we don't need to sort the tree items afterwards
+    std::sort(folders.begin(), folders.end(), [](const wxString& a, const wxString& b) {
+        return a.AfterLast(':').CmpNoCase(b.AfterLast(':')) < 0;
+    });
+    std::vector<std::pair<wxString, wxString> > sortedFiles; // <display name, full path>
+    sortedFiles.reserve(files.size());
+    for(size_t i = 0; i < files.size(); ++i) {
+        sortedFiles.push_back({ wxFileName(files.Item(i)).GetFullName(), files.Item(i) });
+    }
+    std::sort(sortedFiles.begin(), sortedFiles.end(),
+              [](const std::pair<wxString, wxString>& a, const std::pair<wxString, wxString>& b) {
+                  return a.first.CmpNoCase(b.first) < 0;
+              });
+
     // First, we add the virtual folders
     for(size_t i = 0; i < folders.size(); ++i) {
         const wxString& childVdFullPath = folders.Item(i);
@@ -2973,10 +3000,10 @@ void FileViewTree::DoAddChildren(const wxTreeItemId& parentItem)
     BuildConfigPtr buildConf = proj->GetBuildConfiguration();
     wxString buildConfName = buildConf ? buildConf->GetName() : "";
 
-    for(size_t i = 0; i < files.size(); ++i) {
-        const wxString& filepath = files.Item(i);
-        wxFileName fn(filepath);
-        ProjectItem fileItem(vdFullPath + ":" + fn.GetFullName(), fn.GetFullName(), filepath, ProjectItem::TypeFile);
+    for(size_t i = 0; i < sortedFiles.size(); ++i) {
+        const wxString& displayName = sortedFiles[i].first;
+        const wxString& filepath = sortedFiles[i].second;
+        ProjectItem fileItem(vdFullPath + ":" + displayName, displayName, filepath, ProjectItem::TypeFile);
 
         int iconIndex = GetIconIndex(fileItem);
         wxTreeItemId hti = AppendItem(parentItem,                // parent
@@ -2987,16 +3014,12 @@ void FileViewTree::DoAddChildren(const wxTreeItemId& parentItem)
         DoSetItemBackgroundColour(hti, coloursList, fileItem);
 
         // If the file is disabled for the current build configuration, mark it as such
-        clProjectFile::Ptr_t fileInfo = proj->GetFile(fn.GetFullPath());
+        clProjectFile::Ptr_t fileInfo = proj->GetFile(filepath);
         if(fileInfo && !buildConfName.IsEmpty() && fileInfo->IsExcludeFromConfiguration(buildConfName)) {
             // Set the item text with disabled colour
             ExcludeFileFromBuildUI(hti, true);
         }
     }
-
-    // Now, add the files
-    m_itemsToSort[parentItem] = true;
-    SortTree();
 }
 
 ProjectPtr FileViewTree::GetItemProject(const wxTreeItemId& item) const
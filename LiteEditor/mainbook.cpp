@@ -27,6 +27,7 @@
 #include "clAuiMainNotebookTabArt.h"
 #include "clFileOrFolderDropTarget.h"
 #include "clImageViewer.h"
+#include "clLazyEditorPage.h"
 #include "clang_code_completion.h"
 #include "close_all_dlg.h"
 #include "ctags_manager.h"
@@ -46,6 +47,7 @@
 #include "theme_handler.h"
 #include <algorithm>
 #include <wx/regex.h>
+#include <wx/stopwatch.h>
 #include <wx/wupdlock.h>
 #include <wx/xrc/xmlres.h>
 
@@ -57,6 +59,7 @@ MainBook::MainBook(wxWindow* parent)
     , m_useBuffereLimit(true)
     , m_isWorkspaceReloading(false)
     , m_reloadingDoRaise(true)
+    , m_loadingLazyPage(false)
     , m_filesModifiedDlg(NULL)
 {
     CreateGuiControls();
@@ -350,9 +353,41 @@ void MainBook::RestoreSession(SessionEntry& session)
 {
     if(session.GetTabInfoArr().empty()) return; // nothing to restore
 
+    wxStopWatch sw;
     CloseAll(false);
     size_t sel = session.GetSelectedTab();
     const std::vector<TabInfo>& vTabInfoArr = session.GetTabInfoArr();
+
+    if(clConfig::Get().Read(kConfigRestoreSessionLazily, true)) {
+        // Add a placeholder page per tab, only the selected tab is loaded now
+        {
+            clWindowUpdateLocker locker(this);
+            for(size_t i = 0; i < vTabInfoArr.size(); i++) {
+                const TabInfo& ti = vTabInfoArr[i];
+                wxFileName fn(ti.GetFileName());
+                if(!fn.FileExists()) {
+                    if(i < sel) {
+                        // have to adjust selected tab number because couldn't open tab
+                        sel--;
+                    }
+                    continue;
+                }
+                m_reloadingDoRaise = false;
+                AddPage(new clLazyEditorPage(m_book, ti), fn.GetFullName(), fn.GetFullPath());
+                m_reloadingDoRaise = true;
+            }
+        }
+        if(sel < m_book->GetPageCount()) {
+            m_book->SetSelection(sel);
+            DoLoadLazyPage(m_book->GetPage(sel));
+        }
+        clSYSTEM() << "Session restored:" << m_book->GetPageCount() << "tabs (loaded on demand) in" << sw.Time()
+                   << "ms" << clEndl;
+        clGetManager()->SetStatusMessage(
+            wxString::Format(_("Session restored: %d tabs in %ld ms"), (int)m_book->GetPageCount(), sw.Time()), 5);
+        return;
+    }
+
     for(size_t i = 0; i < vTabInfoArr.size(); i++) {
         const TabInfo& ti = vTabInfoArr[i];
         m_reloadingDoRaise = (i == vTabInfoArr.size() - 1); // Raise() when opening only the last editor
@@ -371,8 +406,64 @@ void MainBook::RestoreSession(SessionEntry& session)
         editor->LoadCollapsedFoldsFromArray(ti.GetCollapsedFolds());
     }
     m_book->SetSelection(sel);
+    clSYSTEM() << "Session restored:" << m_book->GetPageCount() << "tabs in" << sw.Time() << "ms" << clEndl;
+    clGetManager()->SetStatusMessage(
+        wxString::Format(_("Session restored: %d tabs in %ld ms"), (int)m_book->GetPageCount(), sw.Time()), 5);
+}
+
+clLazyEditorPage* MainBook::DoFindLazyPage(const wxString& fileName)
+{
+    wxFileName fn(fileName);
+    for(size_t i = 0; i < m_book->GetPageCount(); i++) {
+        clLazyEditorPage* page = dynamic_cast<clLazyEditorPage*>(m_book->GetPage(i));
+        if(page && wxFileName(page->GetFileName()) == fn) { return page; }
+    }
+    return NULL;
 }
 
+LEditor* MainBook::DoLoadLazyPage(wxWindow* win)
+{
+    // 'win' may already be gone (e.g. when called with CallAfter), check that it is still ours before using it
+    int index = m_book->GetPageIndex(win);
+    if(index == wxNOT_FOUND || m_loadingLazyPage) { return NULL; }
+    clLazyEditorPage* page = dynamic_cast<clLazyEditorPage*>(win);
+    if(!page) { return NULL; }
+
+    // Copy what we need, the page is destroyed below
+    TabInfo ti = page->GetTabInfo();
+    wxFileName fileName(ti.GetFileName());
+    wxString label = m_book->GetPageText(index);
+    bool selected = (m_book->GetSelection() == index);
+
+    m_loadingLazyPage = true;
+    LEditor* editor = NULL;
+    {
+        clWindowUpdateLocker locker(this);
+        editor = new LEditor(m_book);
+        editor->Create(ManagerST::Get()->GetProjectNameByFile(fileName.GetFullPath()), fileName);
+
+        // Put the editor in place of the placeholder
+        m_book->InsertPage(index, editor, label, false);
+        m_book->SetPageToolTip(index, fileName.GetFullPath());
+        editor->SetSyntaxHighlight();
+        ManagerST::Get()->GetBreakpointsMgr()->RefreshBreakpointsForEditor(editor);
+        MarkEditorReadOnly(editor);
+
+        editor->SetFirstVisibleLine(ti.GetFirstVisibleLine());
+        editor->SetEnsureCaretIsVisible(editor->PositionFromLine(ti.GetCurrentLine()));
+        editor->LoadMarkersFromArray(ti.GetBookmarks());
+        editor->LoadCollapsedFoldsFromArray(ti.GetCollapsedFolds());
+
+        if(selected) { m_book->SetSelection(index); }
+        m_book->RemovePage(index + 1, false);
+        page->Destroy();
+    }
+    m_loadingLazyPage = false;
+    return editor;
+}
+
+void MainBook::LoadLazyPageVoid(wxWindow* win) { DoLoadLazyPage(win); }
+
 LEditor* MainBook::GetActiveEditor(bool includeDetachedEditors)
 {
     if(includeDetachedEditors) {
@@ -383,6 +474,10 @@ LEditor* MainBook::GetActiveEditor(bool includeDetachedEditors)
     }
 
     if(!GetCurrentPage()) { return NULL; }
+    if(!m_loadingLazyPage && dynamic_cast<clLazyEditorPage*>(GetCurrentPage())) {
+        // The active tab was restored from the session but not loaded yet
+        return DoLoadLazyPage(GetCurrentPage());
+    }
     return dynamic_cast<LEditor*>(GetCurrentPage());
 }
 
@@ -403,10 +498,14 @@ void MainBook::GetAllTabs(clTab::Vec_t& tabs)
         t.window = tabInfo->GetWindow();
 
         LEditor* editor = dynamic_cast<LEditor*>(t.window);
+        clLazyEditorPage* lazyPage = dynamic_cast<clLazyEditorPage*>(t.window);
         if(editor) {
             t.isFile = true;
             t.isModified = editor->IsModified();
             t.filename = editor->GetFileName();
+        } else if(lazyPage) {
+            t.isFile = true;
+            t.filename = lazyPage->GetFileName();
         }
         tabs.push_back(t);
     });
@@ -484,7 +583,9 @@ LEditor* MainBook::FindEditor(const wxString& fileName)
     for(; iter != m_detachedEditors.end(); ++iter) {
         if((*iter)->GetEditor()->GetFileName().GetFullPath() == fileName) { return (*iter)->GetEditor(); }
     }
-    return NULL;
+
+    // the file may be restored from the session but not loaded yet
+    return DoLoadLazyPage(DoFindLazyPage(fileName));
 }
 
 wxWindow* MainBook::FindPage(const wxString& text)
@@ -1087,6 +1188,12 @@ long MainBook::GetBookStyle() { return 0; }
 
 bool MainBook::DoSelectPage(wxWindow* win)
 {
+    if(dynamic_cast<clLazyEditorPage*>(win)) {
+        // First time this tab is selected: load its file. Not from within the book event
+        CallAfter(&MainBook::LoadLazyPageVoid, win);
+        return true;
+    }
+
     LEditor* editor = dynamic_cast<LEditor*>(win);
     if(editor) {
         editor->SetActive();
@@ -1320,8 +1427,31 @@ FilesModifiedDlg* MainBook::GetFilesModifiedDlg()
     return m_filesModifiedDlg;
 }
 
+static TabInfo CreateTabInfo(LEditor* editor)
+{
+    TabInfo oTabInfo;
+    oTabInfo.SetFileName(editor->GetFileName().GetFullPath());
+    oTabInfo.SetFirstVisibleLine(editor->GetFirstVisibleLine());
+    oTabInfo.SetCurrentLine(editor->GetCurrentLine());
+
+    wxArrayString astrBookmarks;
+    editor->StoreMarkersToArray(astrBookmarks);
+    oTabInfo.SetBookmarks(astrBookmarks);
+
+    std::vector<int> folds;
+    editor->StoreCollapsedFoldsToArray(folds);
+    oTabInfo.SetCollapsedFolds(folds);
+    return oTabInfo;
+}
+
 void MainBook::CreateSession(SessionEntry& session, wxArrayInt* excludeArr)
 {
+    if(!excludeArr) {
+        // A session of all the tabs: keep the tabs that were restored but not loaded yet
+        DoCreateSessionWithLazyPages(session);
+        return;
+    }
+
     std::vector<LEditor*> editors;
     GetAllEditors(editors, kGetAll_RetainOrder);
 
@@ -1344,20 +1474,30 @@ void MainBook::CreateSession(SessionEntry& session, wxArrayInt* excludeArr)
         }
 
         if(editors[i] == GetActiveEditor()) { session.SetSelectedTab(vTabInfoArr.size()); }
-        TabInfo oTabInfo;
-        oTabInfo.SetFileName(editors[i]->GetFileName().GetFullPath());
-        oTabInfo.SetFirstVisibleLine(editors[i]->GetFirstVisibleLine());
-        oTabInfo.SetCurrentLine(editors[i]->GetCurrentLine());
+        vTabInfoArr.push_back(CreateTabInfo(editors[i]));
+    }
+    session.SetTabInfoArr(vTabInfoArr);
+}
 
-        wxArrayString astrBookmarks;
-        editors[i]->StoreMarkersToArray(astrBookmarks);
-        oTabInfo.SetBookmarks(astrBookmarks);
+void MainBook::DoCreateSessionWithLazyPages(SessionEntry& session)
+{
+    session.SetSelectedTab(0);
+    std::vector<TabInfo> vTabInfoArr;
+    for(size_t i = 0; i < m_book->GetPageCount(); i++) {
+        wxWindow* page = m_book->GetPage(i);
+        clLazyEditorPage* lazyPage = dynamic_cast<clLazyEditorPage*>(page);
+        LEditor* editor = dynamic_cast<LEditor*>(page);
+        if(lazyPage) {
+            if((int)i == m_book->GetSelection()) { session.SetSelectedTab(vTabInfoArr.size()); }
+            vTabInfoArr.push_back(lazyPage->GetTabInfo());
+            continue;
+        }
 
-        std::vector<int> folds;
-        editors[i]->StoreCollapsedFoldsToArray(folds);
-        oTabInfo.SetCollapsedFolds(folds);
+        // Skip other pages and editors which belong to the SFTP
+        if(!editor || dynamic_cast<IEditor*>(editor)->GetClientData("sftp")) { continue; }
 
-        vTabInfoArr.push_back(oTabInfo);
+        if((int)i == m_book->GetSelection()) { session.SetSelectedTab(vTabInfoArr.size()); }
+        vTabInfoArr.push_back(CreateTabInfo(editor));
     }
     session.SetTabInfoArr(vTabInfoArr);
 }
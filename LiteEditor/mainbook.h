@@ -39,6 +39,7 @@
 #include <wx/panel.h>
 
 class FilesModifiedDlg;
+class clLazyEditorPage;
 enum OF_extra { OF_None = 0x00000001, OF_AddJump = 0x00000002, OF_PlaceNextToCurrent = 0x00000004 };
 
 class MessagePane;
@@ -55,6 +56,7 @@ private:
     EditorFrame::List_t m_detachedEditors;
     bool m_isWorkspaceReloading;
     bool m_reloadingDoRaise; // Prevents multiple Raises() during RestoreSession()
+    bool m_loadingLazyPage;  // A placeholder page is being replaced with its editor
     FilesModifiedDlg* m_filesModifiedDlg;
     std::unordered_map<wxString, TagEntryPtr> m_currentNavBarTags;
 
@@ -111,6 +113,22 @@ private:
      */
     void DoOpenFile(const wxString& filename, const wxString& content = "");
 
+    /**
+     * @brief return the placeholder page of a file restored from the session, if it was not loaded yet
+     */
+    clLazyEditorPage* DoFindLazyPage(const wxString& fileName);
+
+    /**
+     * @brief replace a placeholder page with an editor for its file, restoring the editor state
+     * from the session. Returns the editor, or NULL if 'page' is not a placeholder page
+     */
+    LEditor* DoLoadLazyPage(wxWindow* page);
+
+    /**
+     * @brief create a session of all the tabs, in the tabs order, including the tabs that were not loaded yet
+     */
+    void DoCreateSessionWithLazyPages(SessionEntry& session);
+
     /**
      * @brief update the navigation bar (C++)
      * @param editor
@@ -236,6 +254,7 @@ public:
     void CloseAllButThisVoid(wxWindow* win);
     void CloseTabsToTheRight(wxWindow* win);
     void CloseAllVoid(bool cancellable);
+    void LoadLazyPageVoid(wxWindow* win);
 
     wxString GetPageTitle(wxWindow* win) const;
     void SetPageTitle(wxWindow* page, const wxString& name);
@@ -26,6 +26,7 @@
 #ifndef DIFFCONFIG_H
 #define DIFFCONFIG_H
 
+#include "clDTL.h"
 #include "cl_config.h" // Base class: clConfigItem
 #include "codelite_exports.h"
 
@@ -37,6 +38,8 @@ public:
         kCopyRightToLeftAndMove = (1 << 1),
         diffShowLineNumbers = (1 << 2),
         diffHideOverviewBar = (1 << 3),
+        diffAlgorithmMyers = (1 << 4),
+        diffAlgorithmPatience = (1 << 5),
     };
 
     // View mode
@@ -98,6 +101,25 @@ public:
         }
     }
 
+    /**
+     * @brief the line matching algorithm. Histogram is the default
+     */
+    clDTL::DiffAlgorithm GetAlgorithm() const
+    {
+        if(m_flags & diffAlgorithmMyers) { return clDTL::kMyers; }
+        if(m_flags & diffAlgorithmPatience) { return clDTL::kPatience; }
+        return clDTL::kHistogram;
+    }
+    void SetAlgorithm(clDTL::DiffAlgorithm algorithm)
+    {
+        m_flags &= ~(diffAlgorithmMyers | diffAlgorithmPatience);
+        if(algorithm == clDTL::kMyers) {
+            m_flags |= diffAlgorithmMyers;
+        } else if(algorithm == clDTL::kPatience) {
+            m_flags |= diffAlgorithmPatience;
+        }
+    }
+
     void SetFlags(size_t flags) { this->m_flags = flags; }
     size_t GetFlags() const { return m_flags; }
 
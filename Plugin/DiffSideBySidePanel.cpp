@@ -31,13 +31,17 @@
 #include "drawingutils.h"
 #include "editor_config.h"
 #include "event_notifier.h"
+#include "file_logger.h"
 #include "fileutils.h"
 #include "globals.h"
 #include "lexer_configuration.h"
 #include "plugin.h"
+#include <wx/choice.h>
 #include <wx/filedlg.h>
+#include <wx/gauge.h>
 #include <wx/menu.h>
 #include <wx/msgdlg.h>
+#include <wx/utils.h>
 
 #define RED_MARKER 5
 #define GREEN_MARKER 6
@@ -52,6 +56,47 @@
 
 #define NUMBER_MARGIN_ID 0
 
+/**
+ * @class DiffFolderThread
+ * @brief compares two folders in the background and reports the progress to the panel
+ */
+class DiffFolderThread : public wxThread, public clFolderDiff::Progress
+{
+    DiffSideBySidePanel* m_panel;
+    wxString m_leftFolder;
+    wxString m_rightFolder;
+    clFolderDiff::Vec_t m_result;
+
+public:
+    DiffFolderThread(DiffSideBySidePanel* panel, const wxString& leftFolder, const wxString& rightFolder)
+        : wxThread(wxTHREAD_JOINABLE)
+        , m_panel(panel)
+        , m_leftFolder(leftFolder.c_str())
+        , m_rightFolder(rightFolder.c_str())
+    {
+    }
+    virtual ~DiffFolderThread() {}
+
+    virtual void* Entry()
+    {
+        if(clFolderDiff::Compare(m_leftFolder, m_rightFolder, m_result, this)) {
+            m_panel->CallAfter(&DiffSideBySidePanel::OnFolderDiffDone);
+        }
+        return NULL;
+    }
+
+    virtual void OnProgress(size_t compared, size_t total)
+    {
+        m_panel->CallAfter(&DiffSideBySidePanel::OnFolderDiffProgress, compared, total);
+    }
+    virtual bool IsCancelled() { return TestDestroy(); }
+
+    /**
+     * @brief the comparison result, valid once the thread is done
+     */
+    clFolderDiff::Vec_t& GetResult() { return m_result; }
+};
+
 DiffSideBySidePanel::DiffSideBySidePanel(wxWindow* parent)
     : DiffSideBySidePanelBase(parent)
     , m_darkTheme(DrawingUtils::IsThemeDark())
@@ -60,6 +105,9 @@ DiffSideBySidePanel::DiffSideBySidePanel(wxWindow* parent)
     , m_showLinenos(false)
     , m_showOverviewBar(true)
     , m_storeFilepaths(true)
+    , m_choiceFolderFiles(NULL)
+    , m_gaugeFolderDiff(NULL)
+    , m_folderDiffThread(NULL)
 {
     m_config.Load();
     m_showLinenos = m_config.ShowLineNumbers();
@@ -82,11 +130,31 @@ DiffSideBySidePanel::DiffSideBySidePanel(wxWindow* parent)
             wxCommandEventHandler(DiffSideBySidePanel::OnMenuCopyRight2Left));
     Connect(ID_COPY_RIGHT_TO_LEFT_AND_MOVE, wxEVT_COMMAND_MENU_SELECTED,
             wxCommandEventHandler(DiffSideBySidePanel::OnMenuCopyRight2Left));
+
+    // The diff algorithm
+    m_menu278->AppendSeparator();
+    m_menu278->AppendRadioItem(ID_DIFF_ALGORITHM_HISTOGRAM, _("Histogram Diff"));
+    m_menu278->AppendRadioItem(ID_DIFF_ALGORITHM_PATIENCE, _("Patience Diff"));
+    m_menu278->AppendRadioItem(ID_DIFF_ALGORITHM_MYERS, _("Myers Diff"));
+    Bind(wxEVT_MENU, &DiffSideBySidePanel::OnAlgorithm, this, ID_DIFF_ALGORITHM_HISTOGRAM, ID_DIFF_ALGORITHM_MYERS);
+    Bind(wxEVT_UPDATE_UI, &DiffSideBySidePanel::OnAlgorithmUI, this, ID_DIFF_ALGORITHM_HISTOGRAM,
+         ID_DIFF_ALGORITHM_MYERS);
+
+    // The list of modified files, visible only when comparing folders
+    m_choiceFolderFiles = new wxChoice(this, wxID_ANY);
+    m_choiceFolderFiles->Hide();
+    GetSizer()->Insert(1, m_choiceFolderFiles, 0, wxALL | wxEXPAND, 2);
+    m_choiceFolderFiles->Bind(wxEVT_CHOICE, &DiffSideBySidePanel::OnFolderFileSelected, this);
+    m_gaugeFolderDiff = new wxGauge(this, wxID_ANY, 100);
+    m_gaugeFolderDiff->Hide();
+    GetSizer()->Insert(2, m_gaugeFolderDiff, 0, wxALL | wxEXPAND, 2);
     CallAfter(&DiffSideBySidePanel::DoLayout);
 }
 
 DiffSideBySidePanel::~DiffSideBySidePanel()
 {
+    DoStopFolderDiff();
+
     if((m_flags & kDeleteLeftOnExit)) { clRemoveFile(m_textCtrlLeftFile->GetValue()); }
     if((m_flags & kDeleteRightOnExit)) { clRemoveFile(m_textCtrlRightFile->GetValue()); }
 
@@ -133,7 +201,7 @@ void DiffSideBySidePanel::Diff()
     // Prepare the diff
     clDTL d;
     d.Diff(m_textCtrlLeftFile->GetValue(), m_textCtrlRightFile->GetValue(),
-           m_config.IsSingleViewMode() ? clDTL::kOnePane : clDTL::kTwoPanes);
+           m_config.IsSingleViewMode() ? clDTL::kOnePane : clDTL::kTwoPanes, m_config.GetAlgorithm());
     clDTL::LineInfoVec_t& resultLeft = const_cast<clDTL::LineInfoVec_t&>(d.GetResultLeft());
     clDTL::LineInfoVec_t& resultRight = const_cast<clDTL::LineInfoVec_t&>(d.GetResultRight());
     m_sequences = d.GetSequences();
@@ -762,6 +830,154 @@ void DiffSideBySidePanel::DiffNew(const wxFileName& left, const wxFileName& righ
     CallAfter(&DiffSideBySidePanel::Diff); // trigger a diff
 }
 
+void DiffSideBySidePanel::DiffFolders(const wxString& leftFolder, const wxString& rightFolder)
+{
+    m_staticTextLeft->Hide();
+    m_staticTextRight->Hide();
+    m_config.SetViewMode(DiffConfig::kViewVerticalSplit);
+    m_splitter->Unsplit();
+    m_splitter->SplitVertically(m_splitterPageLeft, m_splitterPageRight);
+
+    m_leftFolder = leftFolder;
+    m_rightFolder = rightFolder;
+    m_folderEntries.clear();
+
+    // Hashing the files of large folders takes a while: they are compared in the background
+    DoStopFolderDiff();
+    m_choiceFolderFiles->Hide();
+    m_gaugeFolderDiff->SetValue(0);
+    m_gaugeFolderDiff->Show();
+    Layout();
+
+    m_folderDiffThread = new DiffFolderThread(this, m_leftFolder, m_rightFolder);
+    if(m_folderDiffThread->Create() != wxTHREAD_NO_ERROR || m_folderDiffThread->Run() != wxTHREAD_NO_ERROR) {
+        wxDELETE(m_folderDiffThread);
+        wxBusyCursor bc;
+        clFolderDiff::Compare(m_leftFolder, m_rightFolder, m_folderEntries);
+        DoShowFolderEntries();
+    }
+}
+
+void DiffSideBySidePanel::OnFolderDiffProgress(size_t compared, size_t total)
+{
+    if(!m_folderDiffThread) { return; }
+    m_gaugeFolderDiff->SetRange(wxMax(total, (size_t)1));
+    m_gaugeFolderDiff->SetValue(wxMin(compared, total));
+}
+
+void DiffSideBySidePanel::OnFolderDiffDone()
+{
+    if(!m_folderDiffThread) { return; }
+    m_folderDiffThread->Wait();
+    m_folderEntries.swap(m_folderDiffThread->GetResult());
+    wxDELETE(m_folderDiffThread);
+    DoShowFolderEntries();
+}
+
+void DiffSideBySidePanel::DoStopFolderDiff()
+{
+    if(m_folderDiffThread) {
+        if(m_folderDiffThread->IsAlive()) {
+            m_folderDiffThread->Delete(NULL, wxTHREAD_WAIT_BLOCK);
+        } else {
+            m_folderDiffThread->Wait();
+        }
+        wxDELETE(m_folderDiffThread);
+    }
+}
+
+void DiffSideBySidePanel::DoShowFolderEntries()
+{
+    // The files that exist on one side only are listed too: selecting one shows its content
+    wxArrayString items;
+    for(size_t i = 0; i < m_folderEntries.size(); ++i) {
+        const clFolderDiff::Entry& entry = m_folderEntries[i];
+        wxString item = entry.m_relativePath;
+        if(entry.m_status == clFolderDiff::kLeftOnly) {
+            item << " " << _("(left side only)");
+        } else if(entry.m_status == clFolderDiff::kRightOnly) {
+            item << " " << _("(right side only)");
+        }
+        items.Add(item);
+    }
+
+    m_gaugeFolderDiff->Hide();
+    m_choiceFolderFiles->Set(items);
+    m_choiceFolderFiles->Show();
+    Layout();
+
+    if(items.IsEmpty()) {
+        ::wxMessageBox(_("No modified files were found"), "CodeLite", wxICON_INFORMATION | wxCENTER | wxOK);
+        return;
+    }
+
+    // Diff the first file
+    m_choiceFolderFiles->SetSelection(0);
+    wxCommandEvent dummy;
+    OnFolderFileSelected(dummy);
+}
+
+void DiffSideBySidePanel::OnFolderFileSelected(wxCommandEvent& event)
+{
+    wxUnusedVar(event);
+    int sel = m_choiceFolderFiles->GetSelection();
+    if(sel == wxNOT_FOUND || sel >= (int)m_folderEntries.size()) { return; }
+
+    const clFolderDiff::Entry& entry = m_folderEntries[sel];
+    wxString leftFile = wxFileName(m_leftFolder, "").GetPath(wxPATH_GET_SEPARATOR) + entry.m_relativePath;
+    wxString rightFile = wxFileName(m_rightFolder, "").GetPath(wxPATH_GET_SEPARATOR) + entry.m_relativePath;
+    if(entry.m_status == clFolderDiff::kModified) {
+        m_textCtrlLeftFile->ChangeValue(leftFile);
+        m_textCtrlRightFile->ChangeValue(rightFile);
+        Diff();
+        return;
+    }
+
+    // Nothing to diff: show the file on its side
+    bool leftOnly = (entry.m_status == clFolderDiff::kLeftOnly);
+    m_textCtrlLeftFile->ChangeValue(leftOnly ? leftFile : wxString());
+    m_textCtrlRightFile->ChangeValue(leftOnly ? wxString() : rightFile);
+    DoClean();
+    PrepareViews();
+    wxStyledTextCtrl* stc = leftOnly ? m_stcLeft : m_stcRight;
+    stc->SetReadOnly(false);
+    stc->LoadFile(leftOnly ? leftFile : rightFile);
+    stc->SetSavePoint();
+    stc->SetReadOnly(true);
+}
+
+void DiffSideBySidePanel::OnAlgorithm(wxCommandEvent& event)
+{
+    switch(event.GetId()) {
+    case ID_DIFF_ALGORITHM_PATIENCE:
+        m_config.SetAlgorithm(clDTL::kPatience);
+        break;
+    case ID_DIFF_ALGORITHM_MYERS:
+        m_config.SetAlgorithm(clDTL::kMyers);
+        break;
+    default:
+        m_config.SetAlgorithm(clDTL::kHistogram);
+        break;
+    }
+    m_config.Save();
+    Diff();
+}
+
+void DiffSideBySidePanel::OnAlgorithmUI(wxUpdateUIEvent& event)
+{
+    switch(event.GetId()) {
+    case ID_DIFF_ALGORITHM_PATIENCE:
+        event.Check(m_config.GetAlgorithm() == clDTL::kPatience);
+        break;
+    case ID_DIFF_ALGORITHM_MYERS:
+        event.Check(m_config.GetAlgorithm() == clDTL::kMyers);
+        break;
+    default:
+        event.Check(m_config.GetAlgorithm() == clDTL::kHistogram);
+        break;
+    }
+}
+
 void DiffSideBySidePanel::OnRefreshDiffUI(wxUpdateUIEvent& event) { wxUnusedVar(event); }
 void DiffSideBySidePanel::OnLeftPickerUI(wxUpdateUIEvent& event) { event.Enable(!IsOriginSourceControl()); }
 
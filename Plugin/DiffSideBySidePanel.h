@@ -31,14 +31,24 @@
 #include <vector>
 #include "clDTL.h"
 #include "DiffConfig.h"
+#include "clFolderDiff.h"
+
+class wxChoice;
+class wxGauge;
+class DiffFolderThread;
 
 class WXDLLIMPEXP_SDK DiffSideBySidePanel : public DiffSideBySidePanelBase
 {
+    friend class DiffFolderThread;
+
     enum {
         ID_COPY_LEFT_TO_RIGHT = wxID_HIGHEST + 1,
         ID_COPY_LEFT_TO_RIGHT_AND_MOVE,
         ID_COPY_RIGHT_TO_LEFT,
         ID_COPY_RIGHT_TO_LEFT_AND_MOVE,
+        ID_DIFF_ALGORITHM_HISTOGRAM,
+        ID_DIFF_ALGORITHM_PATIENCE,
+        ID_DIFF_ALGORITHM_MYERS,
     };
 
     typedef std::vector<int> Markers_t;
@@ -109,6 +119,14 @@ protected:
     bool m_showOverviewBar;
     bool m_storeFilepaths;
 
+    // Folders comparison
+    wxChoice* m_choiceFolderFiles;
+    wxGauge* m_gaugeFolderDiff;
+    wxString m_leftFolder;
+    wxString m_rightFolder;
+    clFolderDiff::Vec_t m_folderEntries;
+    DiffFolderThread* m_folderDiffThread;
+
 protected:
     wxString DoGetContentNoPlaceholders(wxStyledTextCtrl* stc) const;
     bool IsLeftReadOnly() const { return m_flags & kLeftReadOnly; }
@@ -147,6 +165,13 @@ protected:
     virtual void OnShowOverviewBarUI(wxUpdateUIEvent& event);
     virtual void OnPaneloverviewEraseBackground(wxEraseEvent& event);
     void OnPageClosing(wxNotifyEvent& event);
+    void OnAlgorithm(wxCommandEvent& event);
+    void OnAlgorithmUI(wxUpdateUIEvent& event);
+    void OnFolderFileSelected(wxCommandEvent& event);
+    void OnFolderDiffProgress(size_t compared, size_t total);
+    void OnFolderDiffDone();
+    void DoStopFolderDiff();
+    void DoShowFolderEntries();
 
     void PrepareViews();
     void UpdateViews(const wxString& left, const wxString& right);
@@ -190,6 +215,12 @@ public:
      */
     void DiffNew(const wxFileName& left, const wxFileName& right);
     
+    /**
+     * @brief compare two folders in the background. The files that differ or exist on one side
+     * only are listed at the top of the view and each one is shown once it is selected
+     */
+    void DiffFolders(const wxString& leftFolder, const wxString& rightFolder);
+    
     /**
      * @brief set the initial files to diff
      * Once set, you should call Diff() function
@@ -44,7 +44,10 @@
 #include "wx/sstream.h"
 #include "wx/tokenzr.h"
 #include <algorithm>
+#include <functional>
 #include <wx/stopwatch.h>
+#include <wx/thread.h>
+#include <wx/xml/xml.h>
 
 static bool OS_WINDOWS = wxGetOsVersion() & wxOS_WINDOWS ? true : false;
 
@@ -72,6 +75,71 @@ static wxString GetMakeDirCmd(BuildConfigPtr bldConf, const wxString& relPath =
     return text;
 }
 
+namespace
+{
+const wxString MAKEFILE_INPUTS_HASH = "## Inputs hash: ";
+
+// Projects with fewer files generate their file targets on the calling thread
+const size_t FILE_TARGETS_PER_WORKER = 250;
+
+void HashString(const wxString& str, wxUint64& hash)
+{
+    const wxCharBuffer buffer = str.mb_str(wxConvUTF8);
+    for(const char* p = buffer.data(); p && *p; ++p) {
+        hash ^= (unsigned char)*p;
+        hash *= wxULL(1099511628211);
+    }
+    // Terminate each input so "ab" + "c" and "a" + "bc" hash differently
+    hash ^= 0xff;
+    hash *= wxULL(1099511628211);
+}
+
+wxString XmlNodeToString(wxXmlNode* node)
+{
+    // The document takes the ownership of the node
+    wxXmlDocument doc;
+    doc.SetRoot(node);
+
+    wxString content;
+    wxStringOutputStream sos(&content);
+    doc.Save(sos);
+    return content;
+}
+
+wxString ReadMakefileInputsHash(const wxString& makefile)
+{
+    // The hash is part of the makefile banner, so only the head of the file is read
+    wxLogNull noLog;
+    wxFFile fp(makefile, "rb");
+    if(!fp.IsOpened()) { return wxEmptyString; }
+
+    char buffer[512];
+    size_t count = fp.Read(buffer, sizeof(buffer));
+    wxString head = wxString::From8BitData(buffer, count);
+    int where = head.Find(MAKEFILE_INPUTS_HASH);
+    if(where == wxNOT_FOUND) { return wxEmptyString; }
+    return head.Mid(where + MAKEFILE_INPUTS_HASH.length()).BeforeFirst('\n').Trim();
+}
+
+class FileTargetsWorker : public wxThread
+{
+    std::function<void()> m_func;
+
+public:
+    FileTargetsWorker(const std::function<void()>& func)
+        : wxThread(wxTHREAD_JOINABLE)
+        , m_func(func)
+    {
+    }
+
+    void* Entry()
+    {
+        m_func();
+        return NULL;
+    }
+};
+} // namespace
+
 BuilderGnuMake::BuilderGnuMake()
     : Builder("Default")
     , m_objectChunks(1)
@@ -469,22 +537,51 @@ void BuilderGnuMake::GenerateMakefile(ProjectPtr proj, const wxString& confToBui
     fn << PATH_SEP << proj->GetName() << wxT(".mk");
 
     // skip the next test if the makefile does not exist
-    if(wxFileName::FileExists(fn)) {
+    bool makefileExists = wxFileName::FileExists(fn);
+    if(makefileExists) {
         if(!force) {
             if(proj->IsModified() == false) { return; }
         }
     }
 
+    EvnVarList vars;
+    EnvironmentConfig::Instance()->ReadObject(wxT("Variables"), &vars);
+    EnvMap varMap = vars.GetVariables(wxT(""), true, proj->GetName(), bldConf->GetName());
+
+    // A modified (or freshly loaded) project does not always mean that its makefile changed:
+    // compare the inputs with the ones the existing makefile was generated from. A forced
+    // generation (e.g. "Rebuild") always writes the makefile
+    wxString inputsHash = DoGetMakefileInputsHash(proj, bldConf, confToBuild, varMap, depsProj);
+    if(makefileExists && !force && ReadMakefileInputsHash(fn) == inputsHash) {
+        clDEBUG() << "Makefile" << fn << "is up to date" << clEndl;
+        proj->SetModified(false);
+        return;
+    }
+
+    // The makefile is written section by section into a temporary file which then replaces the
+    // existing makefile. This way, we never hold the entire makefile in memory
+    wxString tmpfile = fn + ".tmp";
+    wxFFile output;
+    output.Open(tmpfile, wxT("w+"));
+    if(!output.IsOpened()) {
+        clWARNING() << "Failed to open file:" << tmpfile << clEndl;
+        return;
+    }
+
     // Load the current project files
     m_projectFilesMetadata = &(proj->GetFiles());
 
     // generate the selected configuration for this project
-    // wxTextOutputStream text(output);
     wxString text;
+    auto flushText = [&]() {
+        output.Write(text);
+        text.Clear();
+    };
 
     text << wxT("##") << wxT("\n");
     text << wxT("## Auto Generated makefile by CodeLite IDE") << wxT("\n");
     text << wxT("## any manual changes will be erased      ") << wxT("\n");
+    text << MAKEFILE_INPUTS_HASH << inputsHash << wxT("\n");
     text << wxT("##") << wxT("\n");
 
     // Create the makefile variables
@@ -496,10 +593,6 @@ void BuilderGnuMake::GenerateMakefile(ProjectPtr proj, const wxString& confToBui
     // so user will be able to override any of the default
     // variables by defining its own
     //----------------------------------------------------------
-    EvnVarList vars;
-    EnvironmentConfig::Instance()->ReadObject(wxT("Variables"), &vars);
-    EnvMap varMap = vars.GetVariables(wxT(""), true, proj->GetName(), bldConf->GetName());
-
     text << wxT("##") << wxT("\n");
     text << wxT("## User defined environment variables") << wxT("\n");
     text << wxT("##") << wxT("\n");
@@ -510,7 +603,10 @@ void BuilderGnuMake::GenerateMakefile(ProjectPtr proj, const wxString& confToBui
         text << name << wxT(":=") << value << wxT("") << wxT("\n");
     }
 
+    flushText();
+
     CreateListMacros(proj, confToBuild, text); // list of srcs and list of objects
+    flushText();
 
     //-----------------------------------------------------------
     // create the build targets
@@ -531,20 +627,24 @@ void BuilderGnuMake::GenerateMakefile(ProjectPtr proj, const wxString& confToBui
     CreateMakeDirsTarget(proj, bldConf, targetName, text);
     CreatePreBuildEvents(proj, bldConf, text);
     CreatePreCompiledHeaderTarget(bldConf, text);
+    flushText();
 
     //-----------------------------------------------------------
     // Create a list of targets that should be built according to
     // projects' file list
     //-----------------------------------------------------------
     CreateFileTargets(proj, confToBuild, text);
+    flushText();
+
     CreateCleanTargets(proj, confToBuild, text);
+    flushText();
 
-    // dump the content to a file
-    wxFFile output;
-    output.Open(fn, wxT("w+"));
-    if(output.IsOpened()) {
-        output.Write(text);
-        output.Close();
+    bool ok = !output.Error();
+    output.Close();
+    if(!ok || !::wxRenameFile(tmpfile, fn, true)) {
+        clWARNING() << "Failed to write makefile:" << fn << clEndl;
+        ::wxRemoveFile(tmpfile);
+        return;
     }
 
     // mark the project as non-modified one
@@ -705,8 +805,6 @@ void BuilderGnuMake::CreateFileTargets(ProjectPtr proj, const wxString& confToBu
     // get the compiler settings
     CompilerPtr cmp = BuildSettingsConfigST::Get()->GetCompiler(cmpType);
     bool generateDependenciesFiles = cmp->GetGenerateDependeciesFile() && !cmp->GetDependSuffix().IsEmpty();
-    bool supportPreprocessOnlyFiles =
-        !cmp->GetSwitch(wxT("PreprocessOnly")).IsEmpty() && !cmp->GetPreprocessSuffix().IsEmpty();
 
     std::vector<wxFileName> abs_files, rel_paths;
 
@@ -729,14 +827,73 @@ void BuilderGnuMake::CreateFileTargets(ProjectPtr proj, const wxString& confToBu
     text << wxT("## Objects\n");
     text << wxT("##\n");
 
-    Compiler::CmpFileTypeInfo ft;
+    wxString cwd = proj->GetFileName().GetPath();
 
-    // Collect all the sub-directories that we generate files for
-    wxArrayString subDirs;
+    // The rules of each file do not depend on the other files, so large projects create them on
+    // worker threads. Each worker handles a contiguous range of files to keep the project order
+    size_t workersCount = wxMax(1, wxThread::GetCPUCount());
+    workersCount = wxMin(workersCount, (size_t)8);
+    workersCount = wxMin(workersCount, abs_files.size() / FILE_TARGETS_PER_WORKER);
 
-    wxString cwd = proj->GetFileName().GetPath();
+    if(workersCount < 2) {
+        DoCreateFileTargets(abs_files, rel_paths, 0, abs_files.size(), cmp, cwd, text);
 
-    for(size_t i = 0; i < abs_files.size(); i++) {
+    } else {
+        // Make sure the file types table is initialized before it is shared with the workers
+        FileExtManager::Init();
+
+        std::vector<wxString> chunks(workersCount);
+        std::vector<std::function<void()> > jobs;
+        size_t chunkSize = (abs_files.size() + workersCount - 1) / workersCount;
+        for(size_t i = 0; i < workersCount; ++i) {
+            size_t first = wxMin(i * chunkSize, abs_files.size());
+            size_t last = wxMin(first + chunkSize, abs_files.size());
+            jobs.push_back(
+                [&, i, first, last]() { DoCreateFileTargets(abs_files, rel_paths, first, last, cmp, cwd, chunks[i]); });
+        }
+
+        wxStopWatch sw;
+        std::vector<FileTargetsWorker*> workers;
+        for(size_t i = 0; i < jobs.size(); ++i) {
+            FileTargetsWorker* worker = new FileTargetsWorker(jobs[i]);
+            if(worker->Create() == wxTHREAD_NO_ERROR && worker->Run() == wxTHREAD_NO_ERROR) {
+                workers.push_back(worker);
+            } else {
+                // Could not start the thread, do its share here
+                delete worker;
+                jobs[i]();
+            }
+        }
+
+        for(size_t i = 0; i < workers.size(); ++i) {
+            workers[i]->Wait();
+            delete workers[i];
+        }
+
+        for(size_t i = 0; i < chunks.size(); ++i) {
+            text << chunks[i];
+        }
+        clDEBUG() << "File targets for" << proj->GetName() << ":" << abs_files.size() << "files with" << workersCount
+                  << "threads in" << sw.Time() << "ms" << clEndl;
+    }
+
+    if(generateDependenciesFiles) {
+        text << wxT("\n");
+        text << wxT("-include ") << wxT("$(IntermediateDirectory)/*$(DependSuffix)\n");
+    }
+}
+
+void BuilderGnuMake::DoCreateFileTargets(const std::vector<wxFileName>& abs_files,
+                                         const std::vector<wxFileName>& rel_paths, size_t first, size_t last,
+                                         const CompilerPtr& cmp, const wxString& cwd, wxString& text)
+{
+    // Note: this function is called from worker threads. Besides its arguments, it only reads the file types table
+    bool generateDependenciesFiles = cmp->GetGenerateDependeciesFile() && !cmp->GetDependSuffix().IsEmpty();
+    bool supportPreprocessOnlyFiles =
+        !cmp->GetSwitch(wxT("PreprocessOnly")).IsEmpty() && !cmp->GetPreprocessSuffix().IsEmpty();
+
+    Compiler::CmpFileTypeInfo ft;
+    for(size_t i = first; i < last; i++) {
         // is this file interests the compiler?
         if(cmp->GetCmpFileType(abs_files.at(i).GetExt().Lower(), ft)) {
             wxString absFileName;
@@ -827,11 +984,8 @@ void BuilderGnuMake::CreateFileTargets(ProjectPtr proj, const wxString& confToBu
         }
     }
 
-    if(generateDependenciesFiles) {
-        text << wxT("\n");
-        text << wxT("-include ") << wxT("$(IntermediateDirectory)/*$(DependSuffix)\n");
-    }
 }
+
 static wxString GetIntermediateFolder(BuildConfigPtr bldConf)
 {
     wxString IntermediateDirectory = bldConf->GetIntermediateDirectory();
@@ -1205,12 +1359,7 @@ void BuilderGnuMake::CreateConfigsVariables(ProjectPtr proj, BuildConfigPtr bldC
     asOptions.Replace(";", " ");
 
     // Let the plugins add their content here
-    clBuildEvent e(wxEVT_GET_ADDITIONAL_COMPILEFLAGS);
-    e.SetProjectName(proj->GetName());
-    e.SetConfigurationName(bldConf->GetName());
-    EventNotifier::Get()->ProcessEvent(e);
-
-    wxString additionalCompileFlags = e.GetCommand();
+    wxString additionalCompileFlags = DoGetAdditionalCompileFlags(proj, bldConf);
     if(additionalCompileFlags.IsEmpty() == false) {
         buildOpts << wxT(" ") << additionalCompileFlags;
         cBuildOpts << wxT(" ") << additionalCompileFlags;
@@ -1706,7 +1855,7 @@ wxString BuilderGnuMake::DoGetCompilerMacro(const wxString& filename)
     return compilerMacro;
 }
 
-wxString BuilderGnuMake::DoGetTargetPrefix(const wxFileName& filename, const wxString& cwd, CompilerPtr cmp)
+wxString BuilderGnuMake::DoGetTargetPrefix(const wxFileName& filename, const wxString& cwd, const CompilerPtr& cmp)
 {
     wxString lastDir;
     wxString ret;
@@ -1770,6 +1919,80 @@ wxString BuilderGnuMake::DoGetMarkerFileDir(const wxString& projname, const wxSt
         return path;
 }
 
+wxString BuilderGnuMake::DoGetMakefileInputsHash(ProjectPtr proj, BuildConfigPtr bldConf, const wxString& confToBuild,
+                                                 EnvMap& varMap, const wxArrayString& depsProj)
+{
+    wxUint64 hash = wxULL(14695981039346656037);
+    HashString(GetName(), hash);
+    HashString(confToBuild, hash);
+
+    // The project as it is in memory (it may not be saved yet): its settings and the files built
+    // by this configuration
+    HashString(proj->GetName(), hash);
+    HashString(proj->GetFileName().GetFullPath(), hash);
+    ProjectSettingsPtr settings = proj->GetSettings();
+    if(settings) { HashString(XmlNodeToString(settings->ToXml()), hash); }
+
+    wxArrayString files;
+    const Project::FilesMap_t& filesTable = proj->GetFiles();
+    std::for_each(filesTable.begin(), filesTable.end(), [&](const Project::FilesMap_t::value_type& vt) {
+        if(!vt.second->IsExcludeFromConfiguration(confToBuild)) { files.Add(vt.second->GetFilename()); }
+    });
+    files.Sort();
+    for(size_t i = 0; i < files.size(); ++i) {
+        HashString(files.Item(i), hash);
+    }
+
+    // The build configuration (merged with the project global settings) and the compiler settings
+    HashString(XmlNodeToString(bldConf->ToXml()), hash);
+    CompilerPtr cmp = BuildSettingsConfigST::Get()->GetCompiler(bldConf->GetCompilerType());
+    if(cmp) { HashString(XmlNodeToString(cmp->ToXml()), hash); }
+
+    // The flags added by the plugins and the pre/post build commands, with their macros expanded
+    HashString(DoGetAdditionalCompileFlags(proj, bldConf), hash);
+    BuildCommandList cmds;
+    bldConf->GetPreBuildCommands(cmds);
+    HashString("PreBuild", hash);
+    std::for_each(cmds.begin(), cmds.end(), [&](const BuildCommand& cmd) {
+        if(!cmd.GetEnabled()) { return; }
+        HashString(MacroManager::Instance()->Expand(cmd.GetCommand(), clGetManager(), proj->GetName(),
+                                                    bldConf->GetName()),
+                   hash);
+    });
+    cmds.clear();
+    bldConf->GetPostBuildCommands(cmds);
+    HashString("PostBuild", hash);
+    std::for_each(cmds.begin(), cmds.end(), [&](const BuildCommand& cmd) {
+        if(!cmd.GetEnabled()) { return; }
+        HashString(MacroManager::Instance()->Expand(cmd.GetCommand(), clGetManager(), proj->GetName(),
+                                                    bldConf->GetName()),
+                   hash);
+    });
+
+    // The environment and the workspace
+    HashString(varMap.String(), hash);
+    HashString(clCxxWorkspaceST::Get()->GetEnvironmentVariabels(), hash);
+    HashString(clCxxWorkspaceST::Get()->GetWorkspaceFileName().GetFullPath(), hash);
+    HashString(clCxxWorkspaceST::Get()->GetBuildMatrix()->GetSelectedConfigurationName(), hash);
+    HashString(clCxxWorkspaceST::Get()->GetStartupDir(), hash);
+    for(size_t i = 0; i < depsProj.size(); ++i) {
+        HashString(depsProj.Item(i), hash);
+    }
+
+    // $(Date) is written into the makefile
+    HashString(wxDateTime::Now().FormatDate(), hash);
+    return wxString::Format("%08x%08x", (unsigned)(hash >> 32), (unsigned)hash);
+}
+
+wxString BuilderGnuMake::DoGetAdditionalCompileFlags(ProjectPtr proj, BuildConfigPtr bldConf)
+{
+    clBuildEvent e(wxEVT_GET_ADDITIONAL_COMPILEFLAGS);
+    e.SetProjectName(proj->GetName());
+    e.SetConfigurationName(bldConf->GetName());
+    EventNotifier::Get()->ProcessEvent(e);
+    return e.GetCommand();
+}
+
 bool BuilderGnuMake::HasPostbuildCommands(BuildConfigPtr bldConf) const
 {
     BuildCommandList cmds;
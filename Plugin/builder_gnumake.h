@@ -27,9 +27,11 @@
 
 #include "builder.h"
 #include "codelite_exports.h"
+#include "evnvarlist.h"
 #include "project.h"
 #include "workspace.h"
 #include <wx/txtstrm.h>
+#include <vector>
 #include <wx/wfstream.h>
 /*
  * Build using a generated (Gnu) Makefile - this is made as a traditional multistep build :
@@ -98,7 +100,19 @@ private:
     wxString GetProjectMakeCommand(ProjectPtr proj, const wxString& confToBuild, const wxString& target,
                                    bool addCleanTarget, bool cleanOnly);
     wxString DoGetCompilerMacro(const wxString& filename);
-    wxString DoGetTargetPrefix(const wxFileName& filename, const wxString& cwd, CompilerPtr cmp);
+    wxString DoGetTargetPrefix(const wxFileName& filename, const wxString& cwd, const CompilerPtr& cmp);
+    void DoCreateFileTargets(const std::vector<wxFileName>& abs_files, const std::vector<wxFileName>& rel_paths,
+                             size_t first, size_t last, const CompilerPtr& cmp, const wxString& cwd, wxString& text);
+    /**
+     * @brief return a hash of everything that goes into the project makefile. When it matches the hash
+     * stored in the existing makefile, the makefile is up to date and is not generated again
+     */
+    wxString DoGetMakefileInputsHash(ProjectPtr proj, BuildConfigPtr bldConf, const wxString& confToBuild,
+                                     EnvMap& varMap, const wxArrayString& depsProj);
+    /**
+     * @brief ask the plugins for the flags they add to the compiler options
+     */
+    wxString DoGetAdditionalCompileFlags(ProjectPtr proj, BuildConfigPtr bldConf);
     wxString DoGetMarkerFileDir(const wxString& projname, const wxString& projectPath = "");
 };
 #endif // BUILDER_GNUMAKE_H
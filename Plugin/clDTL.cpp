@@ -25,10 +25,322 @@
 
 #include "clDTL.h"
 #include "dtl/dtl.hpp"
+#include "wxStringHash.h"
+#include <algorithm>
+#include <climits>
+#include <unordered_map>
 #include <wx/ffile.h>
-#include <wx/tokenzr.h>
 #include <wx/utils.h>
 
+namespace
+{
+// Regions without anchors that are bigger than this (in lines) are not passed to Myers,
+// they are reported as replaced instead
+const size_t MYERS_MAX_LINES = 20000;
+
+// Lines that appear more often than this are not used as histogram anchors
+const int HISTOGRAM_MAX_CHAIN = 64;
+
+// Beyond this depth, the remaining regions are diffed with Myers
+const int MAX_RECURSION_DEPTH = 512;
+
+struct DiffEdit {
+    int m_type;
+    int m_line; // index in the left lines for LINE_COMMON and LINE_REMOVED, right lines for LINE_ADDED
+    DiffEdit(int type, int line) : m_type(type), m_line(line) {}
+};
+typedef std::vector<DiffEdit> DiffScript_t;
+
+/**
+ * @brief split the content into lines, each line keeps its EOL
+ */
+void SplitLines(const wxString& content, std::vector<wxString>& lines)
+{
+    size_t start = 0;
+    while ( start < content.length() ) {
+        size_t where = content.find('\n', start);
+        if ( where == wxString::npos ) {
+            lines.push_back( content.Mid(start) );
+            break;
+        }
+        lines.push_back( content.Mid(start, where - start + 1) );
+        start = where + 1;
+    }
+}
+
+/**
+ * @brief diff two sequences of interned lines and build an edit script
+ */
+class DiffEngine
+{
+    const std::vector<int>& m_a;
+    const std::vector<int>& m_b;
+    clDTL::DiffAlgorithm m_algorithm;
+    DiffScript_t& m_script;
+
+public:
+    DiffEngine(const std::vector<int>& a, const std::vector<int>& b, clDTL::DiffAlgorithm algorithm, DiffScript_t& script)
+        : m_a(a)
+        , m_b(b)
+        , m_algorithm(algorithm)
+        , m_script(script)
+    {
+    }
+
+    void Diff(int aStart, int aEnd, int bStart, int bEnd, int depth)
+    {
+        // Common prefix
+        while ( aStart < aEnd && bStart < bEnd && m_a[aStart] == m_b[bStart] ) {
+            m_script.push_back( DiffEdit(clDTL::LINE_COMMON, aStart) );
+            ++aStart;
+            ++bStart;
+        }
+
+        // Common suffix
+        int suffix = 0;
+        while ( aEnd - suffix > aStart && bEnd - suffix > bStart && m_a[aEnd - suffix - 1] == m_b[bEnd - suffix - 1] ) {
+            ++suffix;
+        }
+
+        DiffMiddle(aStart, aEnd - suffix, bStart, bEnd - suffix, depth);
+        for(int i = aEnd - suffix; i < aEnd; ++i) {
+            m_script.push_back( DiffEdit(clDTL::LINE_COMMON, i) );
+        }
+    }
+
+private:
+    void Replace(int aStart, int aEnd, int bStart, int bEnd)
+    {
+        for(int i = aStart; i < aEnd; ++i) {
+            m_script.push_back( DiffEdit(clDTL::LINE_REMOVED, i) );
+        }
+        for(int i = bStart; i < bEnd; ++i) {
+            m_script.push_back( DiffEdit(clDTL::LINE_ADDED, i) );
+        }
+    }
+
+    void DiffMiddle(int aStart, int aEnd, int bStart, int bEnd, int depth)
+    {
+        if ( aStart == aEnd || bStart == bEnd ) {
+            Replace(aStart, aEnd, bStart, bEnd);
+            return;
+        }
+
+        bool done = false;
+        if ( m_algorithm == clDTL::kPatience && depth < MAX_RECURSION_DEPTH ) {
+            done = Patience(aStart, aEnd, bStart, bEnd, depth);
+        } else if ( m_algorithm == clDTL::kHistogram && depth < MAX_RECURSION_DEPTH ) {
+            done = Histogram(aStart, aEnd, bStart, bEnd, depth);
+        }
+
+        if ( !done ) {
+            // Only bound the cost when Myers is used as a fallback
+            Myers(aStart, aEnd, bStart, bEnd, m_algorithm != clDTL::kMyers);
+        }
+    }
+
+    /**
+     * @brief Myers O(ND) diff (by dtl) on the interned lines. When 'bounded' is set,
+     * regions that are too big are reported as replaced
+     */
+    void Myers(int aStart, int aEnd, int bStart, int bEnd, bool bounded)
+    {
+        if ( bounded && (size_t)((aEnd - aStart) + (bEnd - bStart)) > MYERS_MAX_LINES ) {
+            Replace(aStart, aEnd, bStart, bEnd);
+            return;
+        }
+
+        std::vector<int> a(m_a.begin() + aStart, m_a.begin() + aEnd);
+        std::vector<int> b(m_b.begin() + bStart, m_b.begin() + bEnd);
+        dtl::Diff<int, std::vector<int> > diff(a, b);
+        diff.onHuge();
+        diff.compose();
+
+        const std::vector<std::pair<int, dtl::elemInfo> >& seq = diff.getSes().getSequence();
+        int ai = aStart;
+        int bi = bStart;
+        for(size_t i=0; i<seq.size(); ++i) {
+            switch(seq.at(i).second.type) {
+            case dtl::SES_COMMON:
+                m_script.push_back( DiffEdit(clDTL::LINE_COMMON, ai++) );
+                ++bi;
+                break;
+            case dtl::SES_DELETE:
+                m_script.push_back( DiffEdit(clDTL::LINE_REMOVED, ai++) );
+                break;
+            case dtl::SES_ADD:
+                m_script.push_back( DiffEdit(clDTL::LINE_ADDED, bi++) );
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief anchor the diff on the longest increasing sequence of lines that are unique in both regions.
+     * Return false if there are no such lines
+     */
+    bool Patience(int aStart, int aEnd, int bStart, int bEnd, int depth)
+    {
+        struct Occurrence {
+            int countA;
+            int countB;
+            int posA;
+            int posB;
+            Occurrence() : countA(0), countB(0), posA(0), posB(0) {}
+        };
+
+        std::unordered_map<int, Occurrence> occurrences;
+        for(int i = aStart; i < aEnd; ++i) {
+            Occurrence& o = occurrences[m_a[i]];
+            ++o.countA;
+            o.posA = i;
+        }
+        for(int i = bStart; i < bEnd; ++i) {
+            std::unordered_map<int, Occurrence>::iterator iter = occurrences.find(m_b[i]);
+            if ( iter != occurrences.end() ) {
+                ++iter->second.countB;
+                iter->second.posB = i;
+            }
+        }
+
+        // The unique lines, ordered by their position in 'a'
+        std::vector<std::pair<int, int> > pairs;
+        for(int i = aStart; i < aEnd; ++i) {
+            const Occurrence& o = occurrences[m_a[i]];
+            if ( o.countA == 1 && o.countB == 1 ) {
+                pairs.push_back( std::make_pair(i, o.posB) );
+            }
+        }
+        if ( pairs.empty() ) {
+            return false;
+        }
+
+        // Longest increasing subsequence on the 'b' positions (patience sorting)
+        std::vector<int> tails;                        // index in 'pairs' of the smallest tail of each pile
+        std::vector<int> prev(pairs.size(), wxNOT_FOUND); // back pointers
+        for(size_t i = 0; i < pairs.size(); ++i) {
+            int lo = 0;
+            int hi = (int)tails.size();
+            while ( lo < hi ) {
+                int mid = (lo + hi) / 2;
+                if ( pairs[tails[mid]].second < pairs[i].second ) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            if ( lo > 0 ) {
+                prev[i] = tails[lo - 1];
+            }
+            if ( lo == (int)tails.size() ) {
+                tails.push_back( (int)i );
+            } else {
+                tails[lo] = (int)i;
+            }
+        }
+
+        std::vector<int> anchors;
+        for(int i = tails.back(); i != wxNOT_FOUND; i = prev[i]) {
+            anchors.push_back( i );
+        }
+        std::reverse(anchors.begin(), anchors.end());
+
+        // Diff the regions between the anchors
+        int ai = aStart;
+        int bi = bStart;
+        for(size_t i = 0; i < anchors.size(); ++i) {
+            const std::pair<int, int>& anchor = pairs[anchors[i]];
+            Diff(ai, anchor.first, bi, anchor.second, depth + 1);
+            m_script.push_back( DiffEdit(clDTL::LINE_COMMON, anchor.first) );
+            ai = anchor.first + 1;
+            bi = anchor.second + 1;
+        }
+        Diff(ai, aEnd, bi, bEnd, depth + 1);
+        return true;
+    }
+
+    /**
+     * @brief split the regions around the longest common run that starts with one of the
+     * least frequent lines of 'a'. Return false if no anchor could be found
+     */
+    bool Histogram(int aStart, int aEnd, int bStart, int bEnd, int depth)
+    {
+        // line -> <count, first position> in 'a'
+        std::unordered_map<int, std::pair<int, int> > histogram;
+        for(int i = aStart; i < aEnd; ++i) {
+            std::pair<int, int>& h = histogram[m_a[i]];
+            if ( h.first == 0 ) {
+                h.second = i;
+            }
+            ++h.first;
+        }
+
+        bool hasCommon = false;
+        int lowestCount = INT_MAX;
+        for(int i = bStart; i < bEnd; ++i) {
+            std::unordered_map<int, std::pair<int, int> >::const_iterator iter = histogram.find(m_b[i]);
+            if ( iter != histogram.end() ) {
+                hasCommon = true;
+                lowestCount = wxMin(lowestCount, iter->second.first);
+            }
+        }
+
+        if ( !hasCommon ) {
+            // Nothing in common, this is a replacement
+            Replace(aStart, aEnd, bStart, bEnd);
+            return true;
+        }
+
+        if ( lowestCount > HISTOGRAM_MAX_CHAIN ) {
+            return false;
+        }
+
+        // Unique lines: anchor on all of them at once
+        if ( lowestCount == 1 && Patience(aStart, aEnd, bStart, bEnd, depth) ) {
+            return true;
+        }
+
+        // Pick the longest run that starts at one of the least frequent lines
+        int bestA = wxNOT_FOUND;
+        int bestB = wxNOT_FOUND;
+        int bestLen = 0;
+        for(int i = bStart; i < bEnd; ++i) {
+            std::unordered_map<int, std::pair<int, int> >::const_iterator iter = histogram.find(m_b[i]);
+            if ( iter == histogram.end() || iter->second.first != lowestCount ) {
+                continue;
+            }
+
+            int ai = iter->second.second;
+            int bi = i;
+            while ( ai > aStart && bi > bStart && m_a[ai - 1] == m_b[bi - 1] ) {
+                --ai;
+                --bi;
+            }
+            int len = 0;
+            while ( ai + len < aEnd && bi + len < bEnd && m_a[ai + len] == m_b[bi + len] ) {
+                ++len;
+            }
+            if ( len > bestLen ) {
+                bestA = ai;
+                bestB = bi;
+                bestLen = len;
+            }
+        }
+
+        if ( bestLen == 0 ) {
+            return false;
+        }
+
+        Diff(aStart, bestA, bStart, bestB, depth + 1);
+        for(int i = 0; i < bestLen; ++i) {
+            m_script.push_back( DiffEdit(clDTL::LINE_COMMON, bestA + i) );
+        }
+        Diff(bestA + bestLen, aEnd, bestB + bestLen, bEnd, depth + 1);
+        return true;
+    }
+};
+} // namespace
+
 clDTL::clDTL()
 {
 }
@@ -37,7 +349,7 @@ clDTL::~clDTL()
 {
 }
 
-void clDTL::Diff(const wxFileName& fnLeft, const wxFileName& fnRight, DiffMode mode)
+void clDTL::Diff(const wxFileName& fnLeft, const wxFileName& fnRight, DiffMode mode, DiffAlgorithm algorithm)
 {
     wxString leftFile, rightFile;
 
@@ -57,26 +369,35 @@ void clDTL::Diff(const wxFileName& fnLeft, const wxFileName& fnRight, DiffMode m
     m_resultRight.clear();
     m_sequences.clear();
 
-    typedef wxString elem;
-    typedef std::pair<elem, dtl::elemInfo> sesElem;
-
-    wxArrayString leftLines = wxStringTokenize(leftFile, "\n", wxTOKEN_RET_DELIMS);
-    wxArrayString rightLines = wxStringTokenize(rightFile, "\n", wxTOKEN_RET_DELIMS);
-
-    std::vector<elem> leftLinesVec;
-    std::vector<elem> rightLinesVec;
-    leftLinesVec.insert(leftLinesVec.end(), leftLines.begin(), leftLines.end());
-    rightLinesVec.insert(rightLinesVec.end(), rightLines.begin(), rightLines.end());
-
-    dtl::Diff<elem, std::vector<elem> > diff(leftLinesVec, rightLinesVec);
-    diff.onHuge();
-    diff.compose();
+    std::vector<wxString> leftLines;
+    std::vector<wxString> rightLines;
+    SplitLines(leftFile, leftLines);
+    SplitLines(rightFile, rightLines);
+
+    // Intern the lines: from here on, lines are compared by their ids
+    std::unordered_map<wxString, int> ids;
+    ids.reserve( leftLines.size() + rightLines.size() );
+    std::vector<int> leftIds;
+    std::vector<int> rightIds;
+    leftIds.reserve( leftLines.size() );
+    rightIds.reserve( rightLines.size() );
+    for(size_t i=0; i<leftLines.size(); ++i) {
+        leftIds.push_back( ids.insert(std::make_pair(leftLines[i], (int)ids.size())).first->second );
+    }
+    for(size_t i=0; i<rightLines.size(); ++i) {
+        rightIds.push_back( ids.insert(std::make_pair(rightLines[i], (int)ids.size())).first->second );
+    }
 
-    if ( 0 == diff.getEditDistance() ) {
+    if ( leftIds == rightIds ) {
         // nothing to be done - files are identical
         return;
     }
 
+    DiffScript_t seq;
+    seq.reserve( leftIds.size() + rightIds.size() );
+    DiffEngine engine(leftIds, rightIds, algorithm, seq);
+    engine.Diff(0, (int)leftIds.size(), 0, (int)rightIds.size(), 0);
+
     if ( mode & clDTL::kTwoPanes ) {
 
         ///////////////////////////////////////////////////////////////////
@@ -85,8 +406,6 @@ void clDTL::Diff(const wxFileName& fnLeft, const wxFileName& fnRight, DiffMode m
         // pane all deletions while on the right pane all the new lines
         ///////////////////////////////////////////////////////////////////
 
-        // Loop over the diff and check if it is a whitespace only diff
-        std::vector<sesElem> seq = diff.getSes().getSequence();
         m_resultLeft.reserve( seq.size() );
         m_resultRight.reserve( seq.size() );
 
@@ -101,8 +420,8 @@ void clDTL::Diff(const wxFileName& fnLeft, const wxFileName& fnRight, DiffMode m
         LineInfoVec_t tmpSeqRight;
 
         for(size_t i=0; i<seq.size(); ++i) {
-            switch(seq.at(i).second.type) {
-            case dtl::SES_COMMON: {
+            switch(seq.at(i).m_type) {
+            case LINE_COMMON: {
                 if ( state == STATE_IN_SEQ ) {
 
                     // set the sequence size
@@ -123,14 +442,14 @@ void clDTL::Diff(const wxFileName& fnLeft, const wxFileName& fnRight, DiffMode m
                     tmpSeqRight.clear();
                     seqSize = 0;
                 }
-                clDTL::LineInfo line(seq.at(i).first, LINE_COMMON);
+                clDTL::LineInfo line(leftLines.at(seq.at(i).m_line), LINE_COMMON);
                 m_resultLeft.push_back( line );
                 m_resultRight.push_back( line );
                 break;
 
             }
-            case dtl::SES_ADD: {
-                clDTL::LineInfo lineRight(seq.at(i).first, LINE_ADDED);
+            case LINE_ADDED: {
+                clDTL::LineInfo lineRight(rightLines.at(seq.at(i).m_line), LINE_ADDED);
                 tmpSeqRight.push_back( lineRight );
 
                 if ( state == STATE_NONE ) {
@@ -140,8 +459,8 @@ void clDTL::Diff(const wxFileName& fnLeft, const wxFileName& fnRight, DiffMode m
                 break;
 
             }
-            case dtl::SES_DELETE: {
-                clDTL::LineInfo lineLeft(seq.at(i).first, LINE_REMOVED);
+            case LINE_REMOVED: {
+                clDTL::LineInfo lineLeft(leftLines.at(seq.at(i).m_line), LINE_REMOVED);
                 tmpSeqLeft.push_back( lineLeft );
 
                 if ( state == STATE_NONE ) {
@@ -178,34 +497,33 @@ void clDTL::Diff(const wxFileName& fnLeft, const wxFileName& fnRight, DiffMode m
         // One pane diff view
         // designed for displayed on a single editor
         ///////////////////////////////////////////////////////////////////
-        std::vector<sesElem> seq = diff.getSes().getSequence();
         m_resultLeft.reserve( seq.size() );
         int seqStartLine = wxNOT_FOUND;
         for(size_t i=0; i<seq.size(); ++i) {
-            switch(seq.at(i).second.type) {
-            case dtl::SES_COMMON: {
+            switch(seq.at(i).m_type) {
+            case LINE_COMMON: {
                 if ( seqStartLine != wxNOT_FOUND ) {
                     m_sequences.push_back( std::make_pair(seqStartLine, m_resultLeft.size()) );
                     seqStartLine = wxNOT_FOUND;
                 }
-                clDTL::LineInfo line(seq.at(i).first, LINE_COMMON);
+                clDTL::LineInfo line(leftLines.at(seq.at(i).m_line), LINE_COMMON);
                 m_resultLeft.push_back( line );
                 break;
             }
-            case dtl::SES_ADD: {
+            case LINE_ADDED: {
                 if ( seqStartLine == wxNOT_FOUND ) {
                     seqStartLine = m_resultLeft.size();
                 }
-                clDTL::LineInfo line(seq.at(i).first, LINE_ADDED);
+                clDTL::LineInfo line(rightLines.at(seq.at(i).m_line), LINE_ADDED);
                 m_resultLeft.push_back( line );
                 break;
 
             }
-            case dtl::SES_DELETE: {
+            case LINE_REMOVED: {
                 if ( seqStartLine == wxNOT_FOUND ) {
                     seqStartLine = m_resultLeft.size();
                 }
-                clDTL::LineInfo line(seq.at(i).first, LINE_REMOVED);
+                clDTL::LineInfo line(leftLines.at(seq.at(i).m_line), LINE_REMOVED);
                 m_resultLeft.push_back( line );
                 break;
             }
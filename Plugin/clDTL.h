@@ -84,6 +84,21 @@ public:
         kOnePane  = 0x02
     };
 
+    /**
+     * @brief the algorithm used to diff the lines that remain after the common
+     * prefix and suffix are trimmed
+     * kMyers     - the classic O(ND) diff
+     * kPatience  - anchor the diff on the lines that are unique in both files
+     * kHistogram - anchor the diff on the least frequent lines (falls back to patience for unique lines)
+     * Regions without anchors are diffed with Myers, as long as they are small enough. Bigger regions
+     * are reported as replaced
+     */
+    enum DiffAlgorithm {
+        kMyers = 0,
+        kPatience,
+        kHistogram
+    };
+
 private:
     LineInfoVec_t m_resultLeft;
     LineInfoVec_t m_resultRight;
@@ -97,7 +112,7 @@ public:
      * @brief "diff" two files and store the result in the m_result member
      * When 2 files are identical, the result is empty
      */
-    void Diff(const wxFileName& fnLeft, const wxFileName& fnRight, DiffMode mode);
+    void Diff(const wxFileName& fnLeft, const wxFileName& fnRight, DiffMode mode, DiffAlgorithm algorithm = kHistogram);
 
     const LineInfoVec_t& GetResultLeft() const {
         return m_resultLeft;
@@ -72,4 +72,24 @@ clDiffFrame::clDiffFrame(wxWindow* parent, const wxFileName& left, const wxFileN
     SetIcons(b);
 }
 
+clDiffFrame::clDiffFrame(wxWindow* parent, const wxString& leftFolder, const wxString& rightFolder)
+    : wxFrame(parent, wxID_ANY, _("CodeLite - Folders Diff View"), wxDefaultPosition, wxDefaultSize,
+              wxDEFAULT_FRAME_STYLE | wxFRAME_FLOAT_ON_PARENT)
+{
+    wxBoxSizer* sz = new wxBoxSizer(wxVERTICAL);
+    SetSizer(sz);
+    DiffSideBySidePanel* p = new DiffSideBySidePanel(this);
+    sz->Add(p, 1, wxEXPAND, 0);
+    p->SetSaveFilepaths(false);
+    p->DiffFolders(leftFolder, rightFolder);
+    WindowAttrManager::Load(this);
+    wxIconBundle b;
+    {
+        wxIcon icn;
+        icn.CopyFromBitmap(clGetManager()->GetStdIcons()->LoadBitmap("diff"));
+        b.AddIcon(icn);
+    }
+    SetIcons(b);
+}
+
 clDiffFrame::~clDiffFrame() {}
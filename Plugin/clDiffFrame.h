@@ -12,6 +12,10 @@ public:
                 bool originSourceControl);
     clDiffFrame(wxWindow* parent);
     clDiffFrame(wxWindow* parent, const wxFileName& left, const wxFileName& right, bool isTempFile);
+    /**
+     * @brief compare two folders
+     */
+    clDiffFrame(wxWindow* parent, const wxString& leftFolder, const wxString& rightFolder);
     ~clDiffFrame();
 };
 
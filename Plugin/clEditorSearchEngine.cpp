@@ -0,0 +1,332 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2017 Eran Ifrah
+// File name            : clEditorSearchEngine.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "clEditorSearchEngine.h"
+#include "stringsearcher.h"
+#include <climits>
+#include <string.h>
+#include <wx/stc/stc.h>
+
+namespace
+{
+// ASCII case folding table. Bytes >= 0x80 (UTF-8 sequences) are left as-is
+struct CaseFoldTable {
+    unsigned char fold[256];
+    CaseFoldTable()
+    {
+        for(int i = 0; i < 256; ++i) {
+            fold[i] = (i >= 'A' && i <= 'Z') ? (i - 'A' + 'a') : i;
+        }
+    }
+};
+static const CaseFoldTable s_caseFold;
+
+inline bool IsWordByte(unsigned char ch)
+{
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '_';
+}
+
+// Return the position of the next 'ch' in [from, last], or INT_MAX
+inline int FindByte(const unsigned char* buffer, int from, int last, unsigned char ch)
+{
+    if(from > last) { return INT_MAX; }
+    // memchr is vectorized by the C runtime
+    const void* p = memchr(buffer + from, ch, last - from + 1);
+    return p ? (int)((const unsigned char*)p - buffer) : INT_MAX;
+}
+} // namespace
+
+clEditorSearchEngine::clEditorSearchEngine(wxStyledTextCtrl* stc)
+    : m_stc(stc)
+    , m_flags(0)
+    , m_compiled(false)
+    , m_mode(kLiteral)
+    , m_needleLen(0)
+{
+}
+
+clEditorSearchEngine::~clEditorSearchEngine() {}
+
+bool clEditorSearchEngine::Compile(const wxString& findWhat, size_t flags)
+{
+    // The direction does not change the compiled search
+    flags &= ~wxSD_SEARCH_BACKWARD;
+    if(m_compiled && m_findWhat == findWhat && m_flags == flags) { return true; }
+
+    m_compiled = false;
+    m_findWhat = findWhat;
+    m_flags = flags;
+    m_needle = findWhat.mb_str(wxConvUTF8);
+    m_needleLen = m_needle.data() ? strlen(m_needle.data()) : 0;
+    if(m_needleLen == 0) { return false; }
+
+    if(flags & (wxSD_REGULAREXPRESSION | wxSD_WILDCARD)) {
+#ifndef __WXMAC__
+        int re_flags = wxRE_ADVANCED;
+#else
+        int re_flags = wxRE_DEFAULT;
+#endif
+        if(!(flags & wxSD_MATCHCASE)) { re_flags |= wxRE_ICASE; }
+        re_flags |= wxRE_NEWLINE; // Handle \n as a special character
+
+        wxString pattern = (flags & wxSD_WILDCARD) ? StringFindReplacer::WildcardToRegex(findWhat) : findWhat;
+        if(!m_regex.Compile(pattern, re_flags)) { return false; }
+        m_mode = kRegex;
+
+    } else {
+        m_mode = kLiteral;
+        if(!(flags & wxSD_MATCHCASE)) {
+            // Our folding table only handles ASCII. Let scintilla fold anything else
+            for(size_t i = 0; i < m_needleLen; ++i) {
+                if((unsigned char)m_needle.data()[i] >= 0x80) {
+                    m_mode = kScintilla;
+                    break;
+                }
+            }
+            if(m_mode == kLiteral) {
+                for(size_t i = 0; i < m_needleLen; ++i) {
+                    m_needle.data()[i] = s_caseFold.fold[(unsigned char)m_needle.data()[i]];
+                }
+            }
+        }
+    }
+    m_compiled = true;
+    return true;
+}
+
+bool clEditorSearchEngine::IsWholeWord(const char* buffer, int pos, int len) const
+{
+    if(pos > 0 && IsWordByte(buffer[pos - 1])) { return false; }
+    if((pos + len) < m_stc->GetLength() && IsWordByte(buffer[pos + len])) { return false; }
+    return true;
+}
+
+void clEditorSearchEngine::DoLiteralSearch(const char* buffer, int from, int to, size_t maxMatches,
+                                           Matches_t& matches)
+{
+    const unsigned char* hay = (const unsigned char*)buffer;
+    const unsigned char* needle = (const unsigned char*)m_needle.data();
+    const int needleLen = (int)m_needleLen;
+    const int last = to - needleLen;
+    const bool matchCase = (m_flags & wxSD_MATCHCASE);
+    const bool wholeWord = (m_flags & wxSD_MATCHWHOLEWORD);
+
+    // Locate the candidates by their first byte. When ignoring case, we track the next
+    // position of both the lower and the upper case variants so each byte is scanned once
+    unsigned char first = needle[0];
+    unsigned char firstUpper = (!matchCase && first >= 'a' && first <= 'z') ? (first - 'a' + 'A') : first;
+    int nextLower = from - 1;
+    int nextUpper = (firstUpper == first) ? INT_MAX : from - 1;
+
+    int i = from;
+    while(i <= last) {
+        if(nextLower < i) { nextLower = FindByte(hay, i, last, first); }
+        if(nextUpper < i) { nextUpper = FindByte(hay, i, last, firstUpper); }
+        i = wxMin(nextLower, nextUpper);
+        if(i == INT_MAX) { break; }
+
+        bool match = true;
+        if(matchCase) {
+            match = (memcmp(hay + i + 1, needle + 1, needleLen - 1) == 0);
+        } else {
+            for(int j = 1; j < needleLen; ++j) {
+                if(s_caseFold.fold[hay[i + j]] != needle[j]) {
+                    match = false;
+                    break;
+                }
+            }
+        }
+
+        if(match && (!wholeWord || IsWholeWord(buffer, i, needleLen))) {
+            matches.push_back(std::make_pair(i, needleLen));
+            if(matches.size() >= maxMatches) { break; }
+            i += needleLen;
+        } else {
+            ++i;
+        }
+    }
+}
+
+bool clEditorSearchEngine::DoLiteralSearchBackward(const char* buffer, int from, int to, int& pos)
+{
+    const unsigned char* hay = (const unsigned char*)buffer;
+    const unsigned char* needle = (const unsigned char*)m_needle.data();
+    const int needleLen = (int)m_needleLen;
+    const bool matchCase = (m_flags & wxSD_MATCHCASE);
+    const bool wholeWord = (m_flags & wxSD_MATCHWHOLEWORD);
+
+    for(int i = to - needleLen; i >= from; --i) {
+        int j = 0;
+        if(matchCase) {
+            while(j < needleLen && hay[i + j] == needle[j]) {
+                ++j;
+            }
+        } else {
+            while(j < needleLen && s_caseFold.fold[hay[i + j]] == needle[j]) {
+                ++j;
+            }
+        }
+        if(j == needleLen && (!wholeWord || IsWholeWord(buffer, i, needleLen))) {
+            pos = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+void clEditorSearchEngine::DoRegexSearch(const char* buffer, int from, int to, size_t maxMatches, Matches_t& matches)
+{
+    // wxRegEx works on wide chars: convert the range once and map the match offsets back to bytes
+    wxString text = wxString::FromUTF8(buffer + from, to - from);
+    if(text.IsEmpty()) {
+        // Not a valid UTF-8 range
+        DoScintillaSearch(from, to, maxMatches, matches);
+        return;
+    }
+
+    const wxChar* start = text.wc_str();
+    const size_t textLen = text.length();
+    const unsigned char* bytes = (const unsigned char*)buffer;
+
+    // A cursor that walks the text and the buffer together
+    size_t charPos = 0;
+    int bytePos = from;
+
+    // The range may start in the middle of a line
+    const bool fromLineStart = (from == 0 || buffer[from - 1] == '\n');
+
+    size_t cur = 0;
+    while(cur < textLen) {
+        bool atLineStart = (cur == 0) ? fromLineStart : (start[cur - 1] == wxT('\n'));
+        int matchFlags = atLineStart ? 0 : wxRE_NOTBOL;
+        if(!m_regex.Matches(start + cur, matchFlags, textLen - cur)) { break; }
+
+        size_t matchStart(0), matchLen(0);
+        m_regex.GetMatch(&matchStart, &matchLen);
+        matchStart += cur;
+
+        int matchBytes[2] = { 0, 0 };
+        size_t targets[2] = { matchStart, matchStart + matchLen };
+        for(int n = 0; n < 2; ++n) {
+            while(charPos < targets[n]) {
+                unsigned char ch = bytes[bytePos];
+                int seqLen = (ch < 0x80) ? 1 : (ch < 0xE0) ? 2 : (ch < 0xF0) ? 3 : 4;
+                bytePos += seqLen;
+                // Characters outside of the BMP take 2 wchar_t on Windows
+                charPos += (seqLen == 4 && sizeof(wchar_t) == 2) ? 2 : 1;
+            }
+            matchBytes[n] = bytePos;
+        }
+
+        matches.push_back(std::make_pair(matchBytes[0], matchBytes[1] - matchBytes[0]));
+        if(matches.size() >= maxMatches) { break; }
+        cur = matchStart + (matchLen ? matchLen : 1);
+    }
+}
+
+void clEditorSearchEngine::DoScintillaSearch(int from, int to, size_t maxMatches, Matches_t& matches)
+{
+    int flags = 0;
+    if(m_flags & wxSD_MATCHCASE) { flags |= wxSTC_FIND_MATCHCASE; }
+    if(m_flags & wxSD_MATCHWHOLEWORD) { flags |= wxSTC_FIND_WHOLEWORD; }
+
+    // Case folding may change the length of the text in bytes: the length of a match is taken from the
+    // target scintilla sets, not from the needle. The target belongs to the editor, so restore it when done
+    int targetStart = m_stc->GetTargetStart();
+    int targetEnd = m_stc->GetTargetEnd();
+    int searchFlags = m_stc->GetSearchFlags();
+    m_stc->SetSearchFlags(flags);
+    while(from < to) {
+        m_stc->SetTargetStart(from);
+        m_stc->SetTargetEnd(to);
+        int pos = m_stc->SearchInTarget(m_findWhat);
+        if(pos == wxNOT_FOUND) { break; }
+        int end = m_stc->GetTargetEnd();
+        matches.push_back(std::make_pair(pos, end - pos));
+        if(matches.size() >= maxMatches) { break; }
+        from = (end > pos) ? end : pos + 1;
+    }
+    m_stc->SetSearchFlags(searchFlags);
+    m_stc->SetTargetStart(targetStart);
+    m_stc->SetTargetEnd(targetEnd);
+}
+
+void clEditorSearchEngine::DoSearch(int from, int to, size_t maxMatches, Matches_t& matches)
+{
+    from = wxMax(from, 0);
+    to = wxMin(to, m_stc->GetLength());
+    if(from >= to) { return; }
+
+    if(m_mode == kScintilla) {
+        DoScintillaSearch(from, to, maxMatches, matches);
+        return;
+    }
+
+    // Make the document contiguous in memory and search it in place
+    const char* buffer = m_stc->GetCharacterPointer();
+    if(!buffer) { return; }
+
+    if(m_mode == kLiteral) {
+        DoLiteralSearch(buffer, from, to, maxMatches, matches);
+    } else {
+        DoRegexSearch(buffer, from, to, maxMatches, matches);
+    }
+}
+
+bool clEditorSearchEngine::Find(const wxString& findWhat, size_t flags, int from, int to, int& pos, int& matchLen)
+{
+    if(!Compile(findWhat, flags)) { return false; }
+
+    Matches_t matches;
+    if(flags & wxSD_SEARCH_BACKWARD) {
+        if(m_mode == kLiteral) {
+            from = wxMax(from, 0);
+            to = wxMin(to, m_stc->GetLength());
+            const char* buffer = m_stc->GetCharacterPointer();
+            if(!buffer || from >= to || !DoLiteralSearchBackward(buffer, from, to, pos)) { return false; }
+            matchLen = (int)m_needleLen;
+            return true;
+        }
+        DoSearch(from, to, (size_t)-1, matches);
+        if(matches.empty()) { return false; }
+        pos = matches.back().first;
+        matchLen = matches.back().second;
+        return true;
+    }
+
+    DoSearch(from, to, 1, matches);
+    if(matches.empty()) { return false; }
+    pos = matches.front().first;
+    matchLen = matches.front().second;
+    return true;
+}
+
+size_t clEditorSearchEngine::FindAll(const wxString& findWhat, size_t flags, int from, int to, Matches_t& matches)
+{
+    matches.clear();
+    if(!Compile(findWhat, flags)) { return 0; }
+    DoSearch(from, to, (size_t)-1, matches);
+    return matches.size();
+}
@@ -0,0 +1,91 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2017 Eran Ifrah
+// File name            : clEditorSearchEngine.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef CLEDITORSEARCHENGINE_H
+#define CLEDITORSEARCHENGINE_H
+
+#include "codelite_exports.h"
+#include <utility>
+#include <vector>
+#include <wx/regex.h>
+#include <wx/string.h>
+
+class wxStyledTextCtrl;
+
+/**
+ * @class clEditorSearchEngine
+ * @brief search an editor document in place. The engine works directly on scintilla's UTF-8 buffer
+ * so positions and lengths are returned in bytes (i.e. scintilla positions). The last compiled
+ * search (needle, case folding and regular expression) is kept and reused as long as
+ * the search string and flags do not change
+ */
+class WXDLLIMPEXP_SDK clEditorSearchEngine
+{
+public:
+    typedef std::vector<std::pair<int, int> > Matches_t; // <position, length>
+
+protected:
+    enum eSearchMode {
+        kLiteral,
+        kRegex,
+        kScintilla,
+    };
+
+    wxStyledTextCtrl* m_stc;
+    wxString m_findWhat;
+    size_t m_flags;
+    bool m_compiled;
+    eSearchMode m_mode;
+    wxCharBuffer m_needle;
+    size_t m_needleLen;
+    wxRegEx m_regex;
+
+protected:
+    bool Compile(const wxString& findWhat, size_t flags);
+    void DoLiteralSearch(const char* buffer, int from, int to, size_t maxMatches, Matches_t& matches);
+    bool DoLiteralSearchBackward(const char* buffer, int from, int to, int& pos);
+    void DoRegexSearch(const char* buffer, int from, int to, size_t maxMatches, Matches_t& matches);
+    void DoScintillaSearch(int from, int to, size_t maxMatches, Matches_t& matches);
+    bool IsWholeWord(const char* buffer, int pos, int len) const;
+    void DoSearch(int from, int to, size_t maxMatches, Matches_t& matches);
+
+public:
+    clEditorSearchEngine(wxStyledTextCtrl* stc);
+    virtual ~clEditorSearchEngine();
+
+    /**
+     * @brief find the first match of 'findWhat' in the range [from, to). With wxSD_SEARCH_BACKWARD, find the last one
+     * @param flags wxSD_* flags
+     */
+    bool Find(const wxString& findWhat, size_t flags, int from, int to, int& pos, int& matchLen);
+
+    /**
+     * @brief find all the (non overlapping) matches of 'findWhat' in the range [from, to)
+     * @return the number of matches found
+     */
+    size_t FindAll(const wxString& findWhat, size_t flags, int from, int to, Matches_t& matches);
+};
+
+#endif // CLEDITORSEARCHENGINE_H
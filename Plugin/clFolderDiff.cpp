@@ -0,0 +1,225 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2017 Eran Ifrah
+// File name            : clFolderDiff.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "clFilesCollector.h"
+#include "clFolderDiff.h"
+#include "file_logger.h"
+#include "fileutils.h"
+#include <map>
+#include <wx/filename.h>
+#include <wx/stopwatch.h>
+#include <wx/thread.h>
+
+namespace
+{
+struct FolderDiffJob {
+    wxString m_left;
+    wxString m_right;
+    clFolderDiff::eStatus m_status;
+    FolderDiffJob(const wxString& left, const wxString& right)
+        : m_left(left)
+        , m_right(right)
+        , m_status(clFolderDiff::kIdentical)
+    {
+    }
+};
+
+// Shared by the workers: the number of jobs done and whether the comparison was cancelled
+class FolderDiffState
+{
+    wxCriticalSection m_cs;
+    size_t m_done;
+    bool m_cancelled;
+
+public:
+    FolderDiffState()
+        : m_done(0)
+        , m_cancelled(false)
+    {
+    }
+
+    /**
+     * @brief count a job as done. Return false if the comparison was cancelled
+     */
+    bool JobDone()
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        ++m_done;
+        return !m_cancelled;
+    }
+    size_t GetDone()
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        return m_done;
+    }
+    void Cancel()
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        m_cancelled = true;
+    }
+    bool IsCancelled()
+    {
+        wxCriticalSectionLocker locker(m_cs);
+        return m_cancelled;
+    }
+};
+
+// Compare every 'step'-th job starting with 'first'
+void CompareJobs(std::vector<FolderDiffJob>& jobs, size_t first, size_t step, FolderDiffState& state)
+{
+    for(size_t i = first; i < jobs.size(); i += step) {
+        FolderDiffJob& job = jobs[i];
+        if(wxFileName::GetSize(job.m_left) != wxFileName::GetSize(job.m_right)) {
+            job.m_status = clFolderDiff::kModified;
+        } else if(FileUtils::GetFileHash(job.m_left) != FileUtils::GetFileHash(job.m_right)) {
+            job.m_status = clFolderDiff::kModified;
+        }
+        if(!state.JobDone()) { break; }
+    }
+}
+
+class FolderDiffWorker : public wxThread
+{
+    std::vector<FolderDiffJob>& m_jobs;
+    size_t m_first;
+    size_t m_step;
+    FolderDiffState& m_state;
+
+public:
+    FolderDiffWorker(std::vector<FolderDiffJob>& jobs, size_t first, size_t step, FolderDiffState& state)
+        : wxThread(wxTHREAD_JOINABLE)
+        , m_jobs(jobs)
+        , m_first(first)
+        , m_step(step)
+        , m_state(state)
+    {
+    }
+
+    void* Entry()
+    {
+        // Each worker owns every 'step'-th job, so the jobs can be updated without locking
+        CompareJobs(m_jobs, m_first, m_step, m_state);
+        return NULL;
+    }
+};
+} // namespace
+
+wxString clFolderDiff::GetRelativePath(const wxString& fullpath, const wxString& root)
+{
+    wxFileName fn(fullpath);
+    fn.MakeRelativeTo(root);
+    return fn.GetFullPath();
+}
+
+bool clFolderDiff::Compare(const wxString& leftFolder, const wxString& rightFolder, clFolderDiff::Vec_t& result,
+                           clFolderDiff::Progress* progress)
+{
+    result.clear();
+
+    clFilesScanner scanner;
+    std::vector<wxString> leftFiles;
+    std::vector<wxString> rightFiles;
+    scanner.Scan(leftFolder, leftFiles);
+    scanner.Scan(rightFolder, rightFiles);
+
+    // relative path -> <left full path, right full path>
+    std::map<wxString, std::pair<wxString, wxString> > files;
+    for(size_t i = 0; i < leftFiles.size(); ++i) {
+        files[GetRelativePath(leftFiles[i], leftFolder)].first = leftFiles[i];
+    }
+    for(size_t i = 0; i < rightFiles.size(); ++i) {
+        files[GetRelativePath(rightFiles[i], rightFolder)].second = rightFiles[i];
+    }
+    if(progress && progress->IsCancelled()) { return false; }
+
+    // The files that exist on both sides are compared in parallel
+    std::vector<FolderDiffJob> jobs;
+    std::map<wxString, std::pair<wxString, wxString> >::const_iterator iter = files.begin();
+    for(; iter != files.end(); ++iter) {
+        if(!iter->second.first.IsEmpty() && !iter->second.second.IsEmpty()) {
+            jobs.push_back(FolderDiffJob(iter->second.first, iter->second.second));
+        }
+    }
+
+    size_t workersCount = wxMax(1, wxThread::GetCPUCount());
+    workersCount = wxMin(workersCount, (size_t)8);
+    workersCount = wxMin(workersCount, jobs.size());
+
+    wxStopWatch sw;
+    FolderDiffState state;
+    std::vector<FolderDiffWorker*> workers;
+    std::vector<size_t> failedSlots;
+    for(size_t i = 0; i < workersCount; ++i) {
+        FolderDiffWorker* worker = new FolderDiffWorker(jobs, i, workersCount, state);
+        if(worker->Create() == wxTHREAD_NO_ERROR && worker->Run() == wxTHREAD_NO_ERROR) {
+            workers.push_back(worker);
+        } else {
+            delete worker;
+            failedSlots.push_back(i);
+        }
+    }
+
+    // The share of the threads that could not be started is done here
+    for(size_t i = 0; i < failedSlots.size(); ++i) {
+        CompareJobs(jobs, failedSlots[i], workersCount, state);
+    }
+
+    // Report the progress until the workers are done
+    while(progress) {
+        size_t done = state.GetDone();
+        progress->OnProgress(done, jobs.size());
+        if(done >= jobs.size()) { break; }
+        if(progress->IsCancelled()) {
+            state.Cancel();
+            break;
+        }
+        wxThread::Sleep(100);
+    }
+
+    for(size_t i = 0; i < workers.size(); ++i) {
+        workers[i]->Wait();
+        delete workers[i];
+    }
+    if(state.IsCancelled()) { return false; }
+
+    // Collect the results, in the order of the relative paths
+    size_t jobIndex = 0;
+    for(iter = files.begin(); iter != files.end(); ++iter) {
+        Entry entry;
+        entry.m_relativePath = iter->first;
+        if(iter->second.second.IsEmpty()) {
+            entry.m_status = kLeftOnly;
+        } else if(iter->second.first.IsEmpty()) {
+            entry.m_status = kRightOnly;
+        } else {
+            entry.m_status = jobs[jobIndex++].m_status;
+        }
+        if(entry.m_status != kIdentical) { result.push_back(entry); }
+    }
+
+    clDEBUG() << "Folder diff:" << leftFolder << "<->" << rightFolder << ":" << jobs.size() << "pairs compared with"
+              << workersCount << "threads in" << sw.Time() << "ms" << clEndl;
+    return true;
+}
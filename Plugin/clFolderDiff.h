@@ -0,0 +1,87 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2017 Eran Ifrah
+// File name            : clFolderDiff.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef CLFOLDERDIFF_H
+#define CLFOLDERDIFF_H
+
+#include "codelite_exports.h"
+#include <vector>
+#include <wx/string.h>
+
+/**
+ * @class clFolderDiff
+ * @brief compare two folders and report which files differ. Files that exist on both sides are
+ * compared by their size and then by a hash of their content. The files are hashed by a pool of
+ * worker threads
+ */
+class WXDLLIMPEXP_SDK clFolderDiff
+{
+public:
+    enum eStatus {
+        kIdentical = 0,
+        kModified,
+        kLeftOnly,
+        kRightOnly,
+    };
+
+    struct Entry {
+        wxString m_relativePath;
+        eStatus m_status;
+        Entry()
+            : m_status(kIdentical)
+        {
+        }
+    };
+    typedef std::vector<Entry> Vec_t;
+
+    /**
+     * @class Progress
+     * @brief receives the progress of Compare(). It is called on the thread that runs Compare()
+     */
+    class Progress
+    {
+    public:
+        virtual ~Progress() {}
+        virtual void OnProgress(size_t compared, size_t total) = 0;
+        /**
+         * @brief return true to stop the comparison
+         */
+        virtual bool IsCancelled() { return false; }
+    };
+
+protected:
+    static wxString GetRelativePath(const wxString& fullpath, const wxString& root);
+
+public:
+    /**
+     * @brief compare the content of two folders, recursively. The result is sorted by the relative path
+     * and does not include the identical files
+     * @return false if the comparison was cancelled through 'progress'
+     */
+    static bool Compare(const wxString& leftFolder, const wxString& rightFolder, Vec_t& result,
+                        Progress* progress = NULL);
+};
+
+#endif // CLFOLDERDIFF_H
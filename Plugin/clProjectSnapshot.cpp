@@ -0,0 +1,218 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2018 Eran Ifrah
+// file name            : clProjectSnapshot.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "clProjectSnapshot.h"
+#include "file_logger.h"
+#include "fileutils.h"
+#include "wxStringHash.h"
+#include <wx/datstrm.h>
+#include <wx/log.h>
+#include <wx/wfstream.h>
+#include <cstring>
+#include <wx/xml/xml.h>
+
+// Increase this when the format changes
+#define SNAPSHOT_MAGIC "CLPS"
+#define SNAPSHOT_VERSION 1
+
+namespace
+{
+struct SnapshotHeader {
+    wxUint64 m_modificationTime;
+    wxUint64 m_size;
+    wxUint64 m_hash;
+
+    SnapshotHeader()
+        : m_modificationTime(0)
+        , m_size(0)
+        , m_hash(0)
+    {
+    }
+
+    bool operator==(const SnapshotHeader& other) const
+    {
+        return m_modificationTime == other.m_modificationTime && m_size == other.m_size && m_hash == other.m_hash;
+    }
+};
+
+// A node is written as: type, name, content, attributes count, attributes, children count, children
+void WriteNode(wxDataOutputStream& out, const wxXmlNode* node)
+{
+    out.Write8((wxUint8)node->GetType());
+    out.WriteString(node->GetName());
+    out.WriteString(node->GetContent());
+
+    wxUint32 count = 0;
+    for(const wxXmlAttribute* attr = node->GetAttributes(); attr; attr = attr->GetNext()) {
+        ++count;
+    }
+    out.Write32(count);
+    for(const wxXmlAttribute* attr = node->GetAttributes(); attr; attr = attr->GetNext()) {
+        out.WriteString(attr->GetName());
+        out.WriteString(attr->GetValue());
+    }
+
+    count = 0;
+    for(const wxXmlNode* child = node->GetChildren(); child; child = child->GetNext()) {
+        ++count;
+    }
+    out.Write32(count);
+    for(const wxXmlNode* child = node->GetChildren(); child; child = child->GetNext()) {
+        WriteNode(out, child);
+    }
+}
+
+wxXmlNode* ReadNode(wxDataInputStream& in, wxInputStream& stream)
+{
+    wxXmlNodeType type = (wxXmlNodeType)in.Read8();
+    wxString name = in.ReadString();
+    wxString content = in.ReadString();
+    if(!stream.IsOk()) { return NULL; }
+
+    wxXmlNode* node = new wxXmlNode(NULL, type, name, content);
+    wxUint32 count = in.Read32();
+    wxXmlAttribute* lastAttr = NULL;
+    for(wxUint32 i = 0; i < count && stream.IsOk(); ++i) {
+        wxString attrName = in.ReadString();
+        wxString attrValue = in.ReadString();
+        wxXmlAttribute* attr = new wxXmlAttribute(attrName, attrValue);
+        if(lastAttr) {
+            lastAttr->SetNext(attr);
+        } else {
+            node->SetAttributes(attr);
+        }
+        lastAttr = attr;
+    }
+
+    // Link the children directly: wxXmlNode::AddChild() walks the whole list of children
+    count = stream.IsOk() ? in.Read32() : 0;
+    wxXmlNode* lastChild = NULL;
+    for(wxUint32 i = 0; i < count && stream.IsOk(); ++i) {
+        wxXmlNode* child = ReadNode(in, stream);
+        if(!child) { break; }
+        child->SetParent(node);
+        if(lastChild) {
+            lastChild->SetNext(child);
+        } else {
+            node->SetChildren(child);
+        }
+        lastChild = child;
+    }
+
+    if(!stream.IsOk()) {
+        delete node;
+        return NULL;
+    }
+    return node;
+}
+
+void GetHeader(const wxFileName& xmlFile, SnapshotHeader& header, bool withHash)
+{
+    header.m_modificationTime = (wxUint64)FileUtils::GetFileModificationTime(xmlFile);
+    header.m_size = (wxUint64)FileUtils::GetFileSize(xmlFile);
+    header.m_hash = withHash ? FileUtils::GetFileHash(xmlFile) : 0;
+}
+} // namespace
+
+wxFileName clProjectSnapshot::GetSnapshotFile(const wxString& cacheFolder, const wxFileName& xmlFile)
+{
+    // Projects with the same name can live in different folders
+    size_t pathHash = std::hash<wxString>()(xmlFile.GetFullPath());
+    wxString name;
+    name << xmlFile.GetName() << "-" << wxString::Format("%lx", (unsigned long)pathHash) << ".snapshot";
+    return wxFileName(cacheFolder, name);
+}
+
+bool clProjectSnapshot::Save(const wxFileName& snapshotFile, const wxFileName& xmlFile, const wxXmlDocument& doc)
+{
+    if(!doc.IsOk()) { return false; }
+
+    SnapshotHeader header;
+    GetHeader(xmlFile, header, true);
+
+    wxLogNull noLog;
+    if(!snapshotFile.DirExists()) { snapshotFile.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL); }
+
+    // Write to a temporary file first, so a snapshot is never read while it is being written
+    wxFileName tmpFile(snapshotFile);
+    tmpFile.SetExt("tmp");
+    {
+        wxFileOutputStream stream(tmpFile.GetFullPath());
+        if(!stream.IsOk()) { return false; }
+
+        wxDataOutputStream out(stream);
+        out.Write8((const wxUint8*)SNAPSHOT_MAGIC, 4);
+        out.Write32(SNAPSHOT_VERSION);
+        out.Write64(header.m_modificationTime);
+        out.Write64(header.m_size);
+        out.Write64(header.m_hash);
+        out.WriteString(doc.GetVersion());
+        out.WriteString(doc.GetFileEncoding());
+        WriteNode(out, doc.GetDocumentNode());
+        if(!stream.Close()) { return false; }
+    }
+    return ::wxRenameFile(tmpFile.GetFullPath(), snapshotFile.GetFullPath(), true);
+}
+
+bool clProjectSnapshot::Load(const wxFileName& snapshotFile, const wxFileName& xmlFile, wxXmlDocument& doc)
+{
+    if(!snapshotFile.FileExists()) { return false; }
+
+    wxLogNull noLog;
+    wxFileInputStream stream(snapshotFile.GetFullPath());
+    if(!stream.IsOk()) { return false; }
+
+    wxDataInputStream in(stream);
+    wxUint8 magic[4] = { 0, 0, 0, 0 };
+    in.Read8(magic, 4);
+    if(memcmp(magic, SNAPSHOT_MAGIC, 4) != 0 || in.Read32() != SNAPSHOT_VERSION) { return false; }
+
+    SnapshotHeader saved;
+    saved.m_modificationTime = in.Read64();
+    saved.m_size = in.Read64();
+    saved.m_hash = in.Read64();
+    if(!stream.IsOk()) { return false; }
+
+    // Check the cheap attributes before reading the project file
+    SnapshotHeader current;
+    GetHeader(xmlFile, current, false);
+    current.m_hash = saved.m_hash;
+    if(!(current == saved)) { return false; }
+    if(FileUtils::GetFileHash(xmlFile) != saved.m_hash) { return false; }
+
+    wxString version = in.ReadString();
+    wxString encoding = in.ReadString();
+    wxXmlNode* docNode = ReadNode(in, stream);
+    if(!docNode || docNode->GetType() != wxXML_DOCUMENT_NODE) {
+        wxDELETE(docNode);
+        clWARNING() << "Corrupted project snapshot:" << snapshotFile.GetFullPath() << clEndl;
+        return false;
+    }
+
+    doc.SetDocumentNode(docNode);
+    doc.SetVersion(version);
+    doc.SetFileEncoding(encoding);
+    return doc.IsOk();
+}
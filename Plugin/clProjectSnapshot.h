@@ -0,0 +1,60 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2018 Eran Ifrah
+// file name            : clProjectSnapshot.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef CLPROJECTSNAPSHOT_H
+#define CLPROJECTSNAPSHOT_H
+
+#include "codelite_exports.h"
+#include <wx/filename.h>
+#include <wx/string.h>
+
+class wxXmlDocument;
+
+/**
+ * @class clProjectSnapshot
+ * @brief a binary copy of a parsed project file. Loading it is much faster than parsing the XML again.
+ * A snapshot is only used if the project file still has the same modification time, size and content hash
+ */
+class WXDLLIMPEXP_SDK clProjectSnapshot
+{
+public:
+    /**
+     * @brief return the snapshot file of 'xmlFile', stored in 'cacheFolder'
+     */
+    static wxFileName GetSnapshotFile(const wxString& cacheFolder, const wxFileName& xmlFile);
+
+    /**
+     * @brief save 'doc', parsed from 'xmlFile', into 'snapshotFile'
+     */
+    static bool Save(const wxFileName& snapshotFile, const wxFileName& xmlFile, const wxXmlDocument& doc);
+
+    /**
+     * @brief load 'doc' from 'snapshotFile'. Return false if there is no snapshot or if 'xmlFile' was
+     * modified since it was taken
+     */
+    static bool Load(const wxFileName& snapshotFile, const wxFileName& xmlFile, wxXmlDocument& doc);
+};
+
+#endif // CLPROJECTSNAPSHOT_H
@@ -23,18 +23,22 @@
 //////////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////
 
+#include "clJSONStream.h"
 #include "compilation_database.h"
 #include "file_logger.h"
 #include "fileextmanager.h"
 #include "fileutils.h"
-#include "json_node.h"
 #include "project.h"
 #include "workspace.h"
+#include "wxStringHash.h"
 #include <algorithm>
+#include <functional>
+#include <unordered_map>
 #include <wx/dir.h>
 #include <wx/ffile.h>
 #include <wx/filename.h>
 #include <wx/log.h>
+#include <wx/thread.h>
 #include <wx/tokenzr.h>
 
 const wxString DB_VERSION = "2.0";
@@ -42,10 +46,183 @@ const wxString DB_VERSION = "2.0";
 struct wxFileNameSorter {
     bool operator()(const wxFileName& one, const wxFileName& two) const
     {
-        return one.GetModificationTime().GetTicks() > two.GetModificationTime().GetTicks();
+        return one.GetModificationTime().GetTicks() < two.GetModificationTime().GetTicks();
     }
 };
 
+namespace
+{
+/**
+ * @brief a process wide, in-memory copy of the compilation database.
+ * Most of the files of a project are compiled with the same flags, so each distinct
+ * (flags, working directory) pair is stored once and the files point to it
+ */
+class CompilationFlagsCache
+{
+    struct FlagSet {
+        wxString m_flags;
+        wxString m_cwd;
+    };
+
+    typedef std::unordered_map<wxString, size_t> Index_t;
+
+    wxMutex m_mutex;
+    wxString m_dbFile;
+    bool m_loaded;
+    size_t m_generation;
+    std::vector<FlagSet> m_flagSets;
+    Index_t m_files;
+    Index_t m_folders;
+
+public:
+    CompilationFlagsCache()
+        : m_loaded(false)
+        , m_generation(0)
+    {
+    }
+
+    static CompilationFlagsCache& Get()
+    {
+        static CompilationFlagsCache cache;
+        return cache;
+    }
+
+    bool IsLoaded(const wxString& dbFile)
+    {
+        wxMutexLocker locker(m_mutex);
+        return m_loaded && (m_dbFile == dbFile);
+    }
+
+    void Invalidate(const wxString& dbFile)
+    {
+        wxMutexLocker locker(m_mutex);
+        ++m_generation;
+        if(m_dbFile == dbFile) {
+            m_loaded = false;
+            m_flagSets.clear();
+            m_files.clear();
+            m_folders.clear();
+        }
+    }
+
+    /**
+     * @brief load the whole table in a single pass. Throws wxSQLite3Exception
+     */
+    void Load(const wxString& dbFile, wxSQLite3Database* db)
+    {
+        size_t generation;
+        {
+            wxMutexLocker locker(m_mutex);
+            generation = m_generation;
+        }
+
+        std::vector<FlagSet> flagSets;
+        Index_t flagSetsIndex, files, folders;
+
+        wxSQLite3ResultSet rs =
+            db->ExecuteQuery("SELECT FILE_NAME, FILE_PATH, CWD, COMPILE_FLAGS FROM COMPILATION_TABLE");
+        wxString key;
+        while(rs.NextRow()) {
+            FlagSet fs;
+            fs.m_cwd = rs.GetString(2);
+            fs.m_flags = rs.GetString(3);
+
+            key.Clear();
+            key << fs.m_cwd << "\n" << fs.m_flags;
+            std::pair<Index_t::iterator, bool> where = flagSetsIndex.insert(std::make_pair(key, flagSets.size()));
+            if(where.second) { flagSets.push_back(fs); }
+
+            size_t index = where.first->second;
+            files.insert(std::make_pair(rs.GetString(0), index));
+            // Keep the first file of each folder, like the old FILE_PATH query did
+            folders.insert(std::make_pair(rs.GetString(1), index));
+        }
+
+        wxMutexLocker locker(m_mutex);
+        if(generation != m_generation) {
+            // The database was updated while we were loading it
+            return;
+        }
+        m_dbFile = dbFile;
+        m_flagSets.swap(flagSets);
+        m_files.swap(files);
+        m_folders.swap(folders);
+        m_loaded = true;
+        clDEBUG() << "Compilation database loaded:" << m_files.size() << "files," << m_flagSets.size()
+                  << "distinct flag sets" << clEndl;
+    }
+
+    bool Lookup(const wxString& dbFile, const wxString& file, const wxString& folder, wxString& flags, wxString& cwd)
+    {
+        wxMutexLocker locker(m_mutex);
+        if(!m_loaded || m_dbFile != dbFile) { return false; }
+
+        Index_t::const_iterator iter = m_files.find(file);
+        if(iter == m_files.end()) {
+            // Could not find the cpp file for this file, try to locate *any* file from this directory
+            iter = m_folders.find(folder);
+            if(iter == m_folders.end()) { return false; }
+        }
+        flags = m_flagSets[iter->second].m_flags;
+        cwd = m_flagSets[iter->second].m_cwd;
+        return true;
+    }
+};
+
+/**
+ * @brief stream the entries of a compile_commands.json file. 'file' and 'cwd' are passed normalized
+ * @return false if the file could not be read or is malformed. The entries before the error are still reported
+ */
+typedef std::function<void(const wxString& file, const wxString& cwd, const wxString& command)>
+    CompileCommandCallback_t;
+bool ForEachCompileCommand(const wxFileName& compile_commands, const CompileCommandCallback_t& callback)
+{
+    clJSONStreamReader reader(compile_commands);
+    if(!reader.IsOk() || reader.Next() != clJSONStreamReader::kArrayStart) { return false; }
+
+    wxString cmd, file, cwd;
+    while(true) {
+        clJSONStreamReader::eToken token = reader.Next();
+        if(token == clJSONStreamReader::kArrayEnd) { return true; }
+        if(token != clJSONStreamReader::kObjectStart) {
+            if(token == clJSONStreamReader::kError || token == clJSONStreamReader::kEOF || !reader.SkipValue()) {
+                return false;
+            }
+            continue;
+        }
+
+        // Each object has 3 properties:
+        // directory, command, file
+        cmd.Clear();
+        file.Clear();
+        cwd.Clear();
+        while((token = reader.Next()) == clJSONStreamReader::kKey) {
+            clJSONStreamReader::StringView key = reader.GetValue();
+            wxString* value = NULL;
+            if(key == "command") {
+                value = &cmd;
+            } else if(key == "file") {
+                value = &file;
+            } else if(key == "directory") {
+                value = &cwd;
+            }
+
+            token = reader.Next();
+            if(value && token == clJSONStreamReader::kString) {
+                *value = reader.GetString();
+            } else if(!reader.SkipValue()) {
+                return false;
+            }
+        }
+        if(token != clJSONStreamReader::kObjectEnd) { return false; }
+
+        if(!file.IsEmpty() && !cwd.IsEmpty() && !cmd.IsEmpty()) {
+            callback(wxFileName(file).GetFullPath(), wxFileName(cwd, "").GetPath(), cmd);
+        }
+    }
+}
+} // namespace
+
 CompilationDatabase::CompilationDatabase()
     : m_db(NULL)
 {
@@ -91,45 +268,30 @@ wxFileName CompilationDatabase::GetFileName() const
     return dbfile;
 }
 
-void CompilationDatabase::CompilationLine(const wxString& filename, wxString& compliationLine, wxString& cwd)
+bool CompilationDatabase::CompilationLine(const wxString& filename, wxString& compliationLine, wxString& cwd)
 {
-    if(!IsOpened()) return;
-
-    try {
-
-        wxFileName file(filename);
-        if(FileExtManager::GetType(file.GetFullName()) == FileExtManager::TypeHeader) {
-            // This file is a header file, try locating the C++ file for it
-            file.SetExt(wxT("cpp"));
-        }
+    wxFileName file(filename);
+    if(FileExtManager::GetType(file.GetFullName()) == FileExtManager::TypeHeader) {
+        // This file is a header file, try locating the C++ file for it
+        file.SetExt(wxT("cpp"));
+    }
 
-        wxString sql;
-        sql = wxT("SELECT COMPILE_FLAGS,CWD FROM COMPILATION_TABLE WHERE FILE_NAME=?");
-        wxSQLite3Statement st = m_db->PrepareStatement(sql);
-        st.Bind(1, file.GetFullPath());
-        wxSQLite3ResultSet rs = st.ExecuteQuery();
+    // Once loaded, the lookups are served from memory
+    const wxString dbFile = GetFileName().GetFullPath();
+    CompilationFlagsCache& cache = CompilationFlagsCache::Get();
+    if(!cache.IsLoaded(dbFile)) {
+        if(!IsOpened()) { Open(); }
+        if(!IsOpened()) { return false; }
 
-        if(rs.NextRow()) {
-            compliationLine = rs.GetString(0);
-            cwd = rs.GetString(1);
-            return;
+        try {
+            cache.Load(dbFile, m_db);
 
-        } else {
-            // Could not find the cpp file for this file, try to locate *any* file from this directory
-            sql = "SELECT COMPILE_FLAGS,CWD FROM COMPILATION_TABLE WHERE FILE_PATH=?";
-            wxSQLite3Statement st2 = m_db->PrepareStatement(sql);
-            st2.Bind(1, file.GetPath());
-            wxSQLite3ResultSet rs2 = st2.ExecuteQuery();
-            if(rs2.NextRow()) {
-                compliationLine = rs2.GetString(0);
-                cwd = rs2.GetString(1);
-                return;
-            }
+        } catch(wxSQLite3Exception& e) {
+            wxUnusedVar(e);
+            return false;
         }
-
-    } catch(wxSQLite3Exception& e) {
-        wxUnusedVar(e);
     }
+    return cache.Lookup(dbFile, file.GetFullPath(), file.GetPath(), compliationLine, cwd);
 }
 
 void CompilationDatabase::Close()
@@ -164,12 +326,99 @@ void CompilationDatabase::Initialize()
         wxFileName compile_commands = ConvertCodeLiteCompilationDatabaseToCMake(clCustomCompileFile);
         if(compile_commands.IsOk()) { files.push_back(compile_commands); }
     }
-    // Sort the files by modification time
+    // Sort the files by modification time, oldest first: the entries of newer files replace the older ones
     std::sort(files.begin(), files.end(), wxFileNameSorter());
 
-    for(size_t i = 0; i < files.size(); ++i) {
-        ProcessCMakeCompilationDatabase(files.at(i));
+    try {
+        // This database is a cache that can always be rebuilt: trade durability for import speed
+        m_db->ExecuteUpdate("PRAGMA synchronous = OFF");
+        m_db->ExecuteUpdate("PRAGMA journal_mode = MEMORY");
+
+        // All the files are imported in a single transaction with a single prepared statement
+        wxSQLite3Statement insertStmt = m_db->PrepareStatement(
+            "REPLACE INTO COMPILATION_TABLE (FILE_NAME, FILE_PATH, CWD, COMPILE_FLAGS) VALUES(?, ?, ?, ?)");
+        wxSQLite3Statement sourceStmt = m_db->PrepareStatement(
+            "REPLACE INTO SOURCES_TABLE (FILE_NAME, LAST_MODIFIED, FILE_SIZE, FILE_HASH) VALUES(?, ?, ?, ?)");
+
+        struct Source {
+            time_t m_lastModified;
+            size_t m_fileSize;
+            wxString m_hash;
+        };
+        std::vector<Source> sources(files.size());
+
+        // Only the files from the oldest modified one on are imported: the files before it are older and
+        // unchanged, so their entries are already in the database and would be replaced anyway by the newer files
+        m_db->Begin();
+        size_t firstModified = files.size();
+        for(size_t i = 0; i < files.size(); ++i) {
+            Source& source = sources.at(i);
+            source.m_lastModified = FileUtils::GetFileModificationTime(files.at(i));
+            source.m_fileSize = FileUtils::GetFileSize(files.at(i));
+            if(!IsSourceUpToDate(files.at(i), source.m_lastModified, source.m_fileSize, source.m_hash) &&
+               firstModified == files.size()) {
+                firstModified = i;
+            }
+        }
+
+        size_t imported = 0;
+        for(size_t i = firstModified; i < files.size(); ++i) {
+            const wxFileName& fn = files.at(i);
+            ProcessCMakeCompilationDatabase(fn, insertStmt);
+            ++imported;
+
+            sourceStmt.Bind(1, fn.GetFullPath());
+            sourceStmt.Bind(2, wxLongLong((wxLongLong_t)sources.at(i).m_lastModified));
+            sourceStmt.Bind(3, wxLongLong((wxLongLong_t)sources.at(i).m_fileSize));
+            sourceStmt.Bind(4, sources.at(i).m_hash);
+            sourceStmt.ExecuteUpdate();
+        }
+        m_db->Commit();
+        clDEBUG() << "CompilationDatabase: imported" << imported << "of" << files.size() << "files" << clEndl;
+
+        if(imported) {
+            // Let the next lookup reload the flags
+            CompilationFlagsCache::Get().Invalidate(GetFileName().GetFullPath());
+        }
+
+    } catch(wxSQLite3Exception& e) {
+        clWARNING() << "CompilationDatabase: import error:" << e.GetMessage() << clEndl;
+        try {
+            if(!m_db->GetAutoCommit()) { m_db->Rollback(); }
+        } catch(wxSQLite3Exception& e2) {
+            wxUnusedVar(e2);
+        }
+    }
+}
+
+bool CompilationDatabase::IsSourceUpToDate(const wxFileName& fn, time_t lastModified, size_t fileSize,
+                                           wxString& fileHash)
+{
+    wxSQLite3Statement st =
+        m_db->PrepareStatement("SELECT LAST_MODIFIED, FILE_SIZE, FILE_HASH FROM SOURCES_TABLE WHERE FILE_NAME=?");
+    st.Bind(1, fn.GetFullPath());
+    wxSQLite3ResultSet rs = st.ExecuteQuery();
+
+    bool found = rs.NextRow();
+    if(found && rs.GetInt64(0) == wxLongLong((wxLongLong_t)lastModified) &&
+       rs.GetInt64(1) == wxLongLong((wxLongLong_t)fileSize)) {
+        // Same timestamp and size: don't bother hashing it
+        fileHash = rs.GetString(2);
+        return true;
+    }
+
+    fileHash = wxString::Format("%016llx", (unsigned long long)FileUtils::GetFileHash(fn));
+    if(found && rs.GetString(2) == fileHash) {
+        // The file was re-written with the same content (e.g. by a re-run of cmake)
+        wxSQLite3Statement update =
+            m_db->PrepareStatement("UPDATE SOURCES_TABLE SET LAST_MODIFIED=?, FILE_SIZE=? WHERE FILE_NAME=?");
+        update.Bind(1, wxLongLong((wxLongLong_t)lastModified));
+        update.Bind(2, wxLongLong((wxLongLong_t)fileSize));
+        update.Bind(3, fn.GetFullPath());
+        update.ExecuteUpdate();
+        return true;
     }
+    return false;
 }
 
 void CompilationDatabase::CreateDatabase()
@@ -183,6 +432,9 @@ void CompilationDatabase::CreateDatabase()
         m_db->ExecuteUpdate("CREATE TABLE IF NOT EXISTS COMPILATION_TABLE (FILE_NAME TEXT, FILE_PATH TEXT, CWD TEXT, "
                             "COMPILE_FLAGS TEXT)");
         m_db->ExecuteUpdate("CREATE TABLE IF NOT EXISTS SCHEMA_VERSION (PROPERTY TEXT, VERSION TEXT)");
+        m_db->ExecuteUpdate("CREATE TABLE IF NOT EXISTS SOURCES_TABLE (FILE_NAME TEXT, LAST_MODIFIED INTEGER, "
+                            "FILE_SIZE INTEGER, FILE_HASH TEXT)");
+        m_db->ExecuteUpdate("CREATE UNIQUE INDEX IF NOT EXISTS SOURCES_TABLE_IDX1 ON SOURCES_TABLE(FILE_NAME)");
         m_db->ExecuteUpdate("CREATE UNIQUE INDEX IF NOT EXISTS COMPILATION_TABLE_IDX1 ON COMPILATION_TABLE(FILE_NAME)");
         m_db->ExecuteUpdate("CREATE UNIQUE INDEX IF NOT EXISTS SCHEMA_VERSION_IDX1 ON SCHEMA_VERSION(PROPERTY)");
         m_db->ExecuteUpdate("CREATE INDEX IF NOT EXISTS COMPILATION_TABLE_IDX2 ON COMPILATION_TABLE(FILE_PATH)");
@@ -205,6 +457,7 @@ void CompilationDatabase::DropTables()
     try {
 
         // Create the schema
+        m_db->ExecuteUpdate("DROP TABLE IF EXISTS SOURCES_TABLE");
         m_db->ExecuteUpdate("DROP TABLE COMPILATION_TABLE");
         m_db->ExecuteUpdate("DROP TABLE SCHEMA_VERSION");
 
@@ -258,7 +511,11 @@ bool CompilationDatabase::IsDbVersionUpToDate(const wxFileName& fn)
 bool CompilationDatabase::IsOk() const
 {
     wxFileName fnDb = GetFileName();
-    return fnDb.Exists() && IsDbVersionUpToDate(fnDb);
+    if(!fnDb.Exists()) { return false; }
+
+    // A database that was already loaded into memory was valid
+    if(CompilationFlagsCache::Get().IsLoaded(fnDb.GetFullPath())) { return true; }
+    return IsDbVersionUpToDate(fnDb);
 }
 
 FileNameVector_t CompilationDatabase::GetCompileCommandsFiles() const
@@ -310,83 +567,109 @@ FileNameVector_t CompilationDatabase::GetCompileCommandsFiles() const
     return files;
 }
 
-void CompilationDatabase::ProcessCMakeCompilationDatabase(const wxFileName& compile_commands)
+void CompilationDatabase::ProcessCMakeCompilationDatabase(const wxFileName& compile_commands,
+                                                          wxSQLite3Statement& st)
 {
-    JSONRoot root(compile_commands);
-    JSONElement arr = root.toElement();
-
-    try {
-
-        wxString sql;
-        sql = wxT("REPLACE INTO COMPILATION_TABLE (FILE_NAME, FILE_PATH, CWD, COMPILE_FLAGS) VALUES(?, ?, ?, ?)");
-        wxSQLite3Statement st = m_db->PrepareStatement(sql);
-        m_db->ExecuteUpdate("BEGIN");
-
-        for(int i = 0; i < arr.arraySize(); ++i) {
-            // Each object has 3 properties:
-            // directory, command, file
-            JSONElement element = arr.arrayItem(i);
-            if(element.hasNamedObject("file") && element.hasNamedObject("directory") &&
-               element.hasNamedObject("command")) {
-                wxString cmd = element.namedObject("command").toString();
-                wxString file = element.namedObject("file").toString();
-                wxString path = wxFileName(file).GetPath();
-                wxString cwd = element.namedObject("directory").toString();
-
-                cwd = wxFileName(cwd, "").GetPath();
-                file = wxFileName(file).GetFullPath();
-
-                st.Bind(1, file);
-                st.Bind(2, path);
-                st.Bind(3, cwd);
-                st.Bind(4, cmd);
-                st.ExecuteUpdate();
-            }
-        }
-
-        m_db->ExecuteUpdate("COMMIT");
-
-    } catch(wxSQLite3Exception& e) {
-        wxUnusedVar(e);
+    // compile_commands.json can be huge: stream it one entry at a time instead of loading it into a DOM
+    bool ok = ForEachCompileCommand(compile_commands, [&](const wxString& file, const wxString& cwd,
+                                                          const wxString& command) {
+        st.Bind(1, file);
+        st.Bind(2, wxFileName(file).GetPath());
+        st.Bind(3, cwd);
+        st.Bind(4, command);
+        st.ExecuteUpdate();
+    });
+    if(!ok) {
+        clWARNING() << "Compilation database:" << compile_commands.GetFullPath()
+                    << "could not be read completely" << clEndl;
     }
 }
 
 wxFileName CompilationDatabase::ConvertCodeLiteCompilationDatabaseToCMake(const wxFileName& compile_file)
 {
-    wxFFile fp(compile_file.GetFullPath(), wxT("rb"));
-    if(fp.IsOpened()) {
-        wxString content;
-        fp.ReadAll(&content, wxConvUTF8);
-
-        if(content.IsEmpty()) return wxFileName();
-
-        JSONRoot root(cJSON_Array);
-        JSONElement arr = root.toElement();
-        wxArrayString lines = ::wxStringTokenize(content, "\n\r", wxTOKEN_STRTOK);
-        for(size_t i = 0; i < lines.GetCount(); ++i) {
-            wxArrayString parts = ::wxStringTokenize(lines.Item(i), wxT("|"), wxTOKEN_STRTOK);
-            if(parts.GetCount() != 3) continue;
-
-            wxString file_name = wxFileName(parts.Item(0).Trim().Trim(false)).GetFullPath();
-            wxString cwd = parts.Item(1).Trim().Trim(false);
-            wxString cmp_flags = parts.Item(2).Trim().Trim(false);
-
-            JSONElement element = JSONElement::createObject();
-            element.addProperty("directory", cwd);
-            element.addProperty("command", cmp_flags);
-            element.addProperty("file", file_name);
-            arr.arrayAppend(element);
-        }
+    // codelite-cc keeps appending to the log while a build is running: move it aside before reading it,
+    // new records will go to a new log
+    wxFileName logFile(compile_file);
+    logFile.SetExt("compacting");
+    {
+        wxLogNull nl;
+        if(!::wxRenameFile(compile_file.GetFullPath(), logFile.GetFullPath(), true)) { return wxFileName(); }
+    }
 
-        wxFileName fn(compile_file.GetPath(), "compile_commands.json");
-        root.save(fn);
-        // Delete the old file
-        {
-            wxLogNull nl;
-            fp.Close();
-            if(compile_file.Exists()) { clRemoveFile(compile_file.GetFullPath()); }
+    wxString content;
+    if(!FileUtils::ReadFileContent(logFile, content) || content.IsEmpty()) {
+        clRemoveFile(logFile.GetFullPath());
+        return wxFileName();
+    }
+
+    // Compact: one entry per file, the newest record wins. Start with the entries of the previous compaction
+    // so the generated compile_commands.json keeps the files that were not compiled by this build
+    struct CompileCommand {
+        wxString m_file;
+        wxString m_cwd;
+        wxString m_command;
+    };
+    std::vector<CompileCommand> commands;
+    std::unordered_map<wxString, size_t> commandsIndex;
+    CompileCommand cc;
+
+    wxFileName fn(compile_file.GetPath(), "compile_commands.json");
+    if(fn.Exists()) {
+        ForEachCompileCommand(fn, [&](const wxString& file, const wxString& cwd, const wxString& command) {
+            cc.m_file = file;
+            cc.m_cwd = cwd;
+            cc.m_command = command;
+            if(commandsIndex.insert(std::make_pair(file, commands.size())).second) { commands.push_back(cc); }
+        });
+    }
+
+    size_t records = 0;
+    wxStringTokenizer lines(content, "\n\r", wxTOKEN_STRTOK);
+    while(lines.HasMoreTokens()) {
+        // file|cwd|flags. The flags may contain '|' too
+        wxString line = lines.GetNextToken();
+        wxString file = line.BeforeFirst('|');
+        wxString rest = line.AfterFirst('|');
+        wxString cwd = rest.BeforeFirst('|');
+        wxString flags = rest.AfterFirst('|');
+        if(file.IsEmpty() || cwd.IsEmpty() || flags.IsEmpty()) continue;
+        ++records;
+
+        cc.m_file = wxFileName(file.Trim().Trim(false)).GetFullPath();
+        cc.m_cwd = cwd.Trim().Trim(false);
+        cc.m_command = flags.Trim().Trim(false);
+
+        std::pair<std::unordered_map<wxString, size_t>::iterator, bool> where =
+            commandsIndex.insert(std::make_pair(cc.m_file, commands.size()));
+        if(where.second) {
+            commands.push_back(cc);
+        } else {
+            commands[where.first->second] = cc;
         }
-        return fn;
     }
-    return wxFileName();
+
+    clJSONStreamWriter writer(fn);
+    writer.StartArray();
+    for(size_t i = 0; i < commands.size(); ++i) {
+        writer.StartObject();
+        writer.WriteProperty("directory", commands[i].m_cwd);
+        writer.WriteProperty("command", commands[i].m_command);
+        writer.WriteProperty("file", commands[i].m_file);
+        writer.EndObject();
+    }
+    writer.EndArray();
+    if(!writer.Close()) {
+        // Don't leave the moved log behind: the next build starts a new one anyway
+        clWARNING() << "CompilationDatabase: failed to write" << fn.GetFullPath() << "," << records
+                    << "records discarded" << clEndl;
+        clRemoveFile(logFile.GetFullPath());
+        return wxFileName();
+    }
+
+    clDEBUG() << "CompilationDatabase: compacted" << records << "records into" << commands.size() << "entries"
+              << clEndl;
+
+    // Delete the log
+    clRemoveFile(logFile.GetFullPath());
+    return fn;
 }
@@ -43,8 +43,14 @@ protected:
     wxString GetDbVersion();
     /**
      * @brief create our compilation database out of CMake's compile_commands.json file
+     * @param st the prepared insert statement
      */
-    void ProcessCMakeCompilationDatabase( const wxFileName &compile_commands );
+    void ProcessCMakeCompilationDatabase(const wxFileName& compile_commands, wxSQLite3Statement& st);
+    /**
+     * @brief return true if 'fn' was already imported and did not change since (same timestamp and size,
+     * or same content hash). 'fileHash' is set to the hash of the file
+     */
+    bool IsSourceUpToDate(const wxFileName& fn, time_t lastModified, size_t fileSize, wxString& fileHash);
     
     wxFileName ConvertCodeLiteCompilationDatabaseToCMake( const wxFileName &compile_file );
     
@@ -70,7 +76,11 @@ public:
      * Note that this function does not check for the existance of the file
      */
     FileNameVector_t GetCompileCommandsFiles() const;
-    void CompilationLine(const wxString &filename, wxString &compliationLine, wxString &cwd);
+    /**
+     * @brief return the compilation line and the working directory for 'filename'. The first call loads
+     * the database into memory, all other lookups are served from memory
+     */
+    bool CompilationLine(const wxString &filename, wxString &compliationLine, wxString &cwd);
     void Initialize();
     bool IsOk() const;
 };
@@ -106,7 +106,7 @@ public:
  * @endcode
  *
  */
-class JobQueue
+class WXDLLIMPEXP_SDK JobQueue
 {
     wxMessageQueue<Job*>         m_queue;
     std::vector<JobQueueWorker*> m_threads;
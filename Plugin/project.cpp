@@ -113,9 +113,24 @@ bool Project::Create(const wxString& name, const wxString& description, const wx
 
 bool Project::Load(const wxString& path)
 {
-    if(!m_doc.Load(path)) {
+    wxXmlDocument doc;
+    if(!doc.Load(path) || !LoadFromXml(path, doc)) {
         return false;
     }
+    DoUpdateProjectSettings();
+    return true;
+}
+
+bool Project::LoadFromXml(const wxString& path, wxXmlDocument& doc)
+{
+    if(!doc.IsOk()) {
+        return false;
+    }
+
+    // Move the parsed nodes instead of copying them
+    m_doc.SetDocumentNode(doc.DetachDocumentNode());
+    m_doc.SetVersion(doc.GetVersion());
+    m_doc.SetFileEncoding(doc.GetFileEncoding());
 
     // ConvertToUnixFormat(m_doc.GetRoot());
 
@@ -132,8 +147,6 @@ bool Project::Load(const wxString& path)
     DoBuildCacheFromXml();
     SetModified(true);
     SetProjectLastModifiedTime(GetFileLastModifiedTime());
-
-    DoUpdateProjectSettings();
     return true;
 }
 
@@ -458,6 +458,19 @@ public:
      * \return
      */
     bool Load(const wxString& path);
+
+    /**
+     * @brief load the project from a document that was already parsed from 'path'. The content of 'doc'
+     * is moved into the project.
+     * Unlike Load(), this function only touches this project and can be called from a worker thread: the
+     * project settings are not created. Call LoadSettings() from the main thread before using the project
+     */
+    bool LoadFromXml(const wxString& path, wxXmlDocument& doc);
+
+    /**
+     * @brief create the project settings from the project XML
+     */
+    void LoadSettings() { DoUpdateProjectSettings(); }
     /**
      * \brief Create new project
      * \param name project name
@@ -40,6 +40,7 @@ SFTPSettings::SFTPSettings()
 #else
     , m_sshClient("ssh")
 #endif
+    , m_maxConnections(4)
 {
 }
 
@@ -49,6 +50,7 @@ void SFTPSettings::FromJSON(const JSONElement& json)
 {
     m_accounts.clear();
     m_sshClient = json.namedObject("sshClient").toString(m_sshClient);
+    m_maxConnections = json.namedObject("maxConnections").toSize_t(m_maxConnections);
     JSONElement arrAccounts = json.namedObject("accounts");
     int size = arrAccounts.arraySize();
     for(int i = 0; i < size; ++i) {
@@ -62,6 +64,7 @@ JSONElement SFTPSettings::ToJSON() const
 {
     JSONElement element = JSONElement::createObject(GetName());
     element.addProperty("sshClient", m_sshClient);
+    element.addProperty("maxConnections", m_maxConnections);
     JSONElement arrAccounts = JSONElement::createArray("accounts");
     element.append(arrAccounts);
     for(size_t i = 0; i < m_accounts.size(); ++i) {
@@ -34,6 +34,7 @@ class WXDLLIMPEXP_SDK SFTPSettings : public clConfigItem
 {
     SSHAccountInfo::Vect_t m_accounts;
     wxString m_sshClient;
+    size_t m_maxConnections;
 
 private:
     void MSWImportPuTTYAccounts();
@@ -52,6 +53,11 @@ public:
 
     void SetSshClient(const wxString& sshClient) { this->m_sshClient = sshClient; }
     const wxString& GetSshClient() const { return m_sshClient; }
+    /**
+     * @brief the number of connections (and concurrent transfers) opened per account
+     */
+    void SetMaxConnections(size_t maxConnections) { this->m_maxConnections = maxConnections; }
+    size_t GetMaxConnections() const { return m_maxConnections; }
     bool GetAccount(const wxString& name, SSHAccountInfo& account) const;
     SFTPSettings& Load();
     SFTPSettings& Save();
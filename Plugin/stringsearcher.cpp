@@ -62,11 +62,9 @@ wxString StringFindReplacer::GetString(const wxString& input, int from, bool sea
     }
 }
 
-bool StringFindReplacer::DoWildcardSearch(
-    const wxString& input, int startOffset, const wxString& find_what, size_t flags, int& pos, int& matchLen)
+wxString StringFindReplacer::WildcardToRegex(const wxString& wildcard)
 {
-    // Conver the wildcard to regex
-    wxString regexPattern = find_what;
+    wxString regexPattern = wildcard;
 
     // Escape braces
     regexPattern.Replace("(", "\\(");
@@ -80,8 +78,14 @@ bool StringFindReplacer::DoWildcardSearch(
     regexPattern.Replace("?", "."); // Any character
     regexPattern.Replace("*",
                          "[^\\n]*?"); // Non greedy wildcard '*', but don't allow matches to go beyond a single line
+    return regexPattern;
+}
 
-    return DoRESearch(input, startOffset, regexPattern, flags, pos, matchLen);
+bool StringFindReplacer::DoWildcardSearch(
+    const wxString& input, int startOffset, const wxString& find_what, size_t flags, int& pos, int& matchLen)
+{
+    // Conver the wildcard to regex
+    return DoRESearch(input, startOffset, WildcardToRegex(find_what), flags, pos, matchLen);
 }
 
 bool StringFindReplacer::DoRESearch(
@@ -68,6 +68,11 @@ protected:
                                int& matchLen);
 
 public:
+    /**
+     * @brief convert a wildcard pattern ('*' and '?') into a regular expression
+     */
+    static wxString WildcardToRegex(const wxString& wildcard);
+
     static bool
     Search(const wchar_t* input, int startOffset, const wchar_t* find_what, size_t flags, int& pos, int& matchLen);
     // overloaded method because of that ReplaceAll methods works on wxString and needs results in chars and other
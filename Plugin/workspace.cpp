@@ -43,6 +43,71 @@
 #include <wx/thread.h>
 #include <wx/tokenzr.h>
 #include "file_logger.h"
+#include "clProjectSnapshot.h"
+#include "cl_config.h"
+#include <wx/stopwatch.h>
+
+namespace
+{
+struct ProjectLoadJob {
+    wxString m_path;
+    wxFileName m_snapshotFile; // not set when snapshots are disabled
+    ProjectPtr m_project;
+    bool m_loaded;
+    bool m_fromSnapshot;
+    ProjectLoadJob(const wxString& path, const wxFileName& snapshotFile)
+        : m_path(path)
+        , m_snapshotFile(snapshotFile)
+        , m_project(new Project())
+        , m_loaded(false)
+        , m_fromSnapshot(false)
+    {
+    }
+};
+
+// Load every 'step'-th project starting with 'first'
+void LoadProjects(std::vector<ProjectLoadJob>& jobs, size_t first, size_t step)
+{
+    for(size_t i = first; i < jobs.size(); i += step) {
+        ProjectLoadJob& job = jobs[i];
+        wxXmlDocument doc;
+        if(job.m_snapshotFile.IsOk() && clProjectSnapshot::Load(job.m_snapshotFile, job.m_path, doc)) {
+            job.m_fromSnapshot = true;
+        } else {
+            if(!doc.Load(job.m_path)) {
+                continue;
+            }
+            if(job.m_snapshotFile.IsOk()) {
+                clProjectSnapshot::Save(job.m_snapshotFile, job.m_path, doc);
+            }
+        }
+        job.m_loaded = job.m_project->LoadFromXml(job.m_path, doc);
+    }
+}
+
+class ProjectLoadWorker : public wxThread
+{
+    std::vector<ProjectLoadJob>& m_jobs;
+    size_t m_first;
+    size_t m_step;
+
+public:
+    ProjectLoadWorker(std::vector<ProjectLoadJob>& jobs, size_t first, size_t step)
+        : wxThread(wxTHREAD_JOINABLE)
+        , m_jobs(jobs)
+        , m_first(first)
+        , m_step(step)
+    {
+    }
+
+    void* Entry()
+    {
+        // Each worker owns every 'step'-th job, so the jobs can be updated without locking
+        LoadProjects(m_jobs, m_first, m_step);
+        return NULL;
+    }
+};
+} // namespace
 
 clCxxWorkspace::clCxxWorkspace()
     : m_saveOnExit(true)
@@ -1234,15 +1299,88 @@ void clCxxWorkspace::DoUnselectActiveProject()
 
 void clCxxWorkspace::DoLoadProjectsFromXml(wxXmlNode* parentNode, const wxString& folder,
                                            std::vector<wxXmlNode*>& removedChildren)
+{
+    std::vector<std::pair<wxXmlNode*, wxString> > projects;
+    DoCollectProjectsFromXml(parentNode, folder, projects);
+
+    bool useSnapshots = clConfig::Get().Read(kConfigProjectSnapshots, true);
+    wxString snapshotsFolder = GetPrivateFolder() + wxFILE_SEP_PATH + "projects-cache";
+
+    std::vector<ProjectLoadJob> jobs;
+    jobs.reserve(projects.size());
+    for(size_t i = 0; i < projects.size(); ++i) {
+        // Convert the path to absolute path
+        wxFileName projectFile(projects[i].first->GetPropVal(wxT("Path"), wxEmptyString));
+        if(projectFile.IsRelative()) {
+            projectFile.MakeAbsolute(m_fileName.GetPath());
+        }
+        wxFileName snapshotFile;
+        if(useSnapshots) {
+            snapshotFile = clProjectSnapshot::GetSnapshotFile(snapshotsFolder, projectFile);
+        }
+        jobs.push_back(ProjectLoadJob(projectFile.GetFullPath(), snapshotFile));
+    }
+
+    // Parse the project files in parallel
+    wxStopWatch sw;
+    size_t workersCount = wxMax(1, wxThread::GetCPUCount());
+    workersCount = wxMin(workersCount, (size_t)8);
+    workersCount = wxMin(workersCount, jobs.size());
+
+    std::vector<ProjectLoadWorker*> workers;
+    std::vector<size_t> failedSlots;
+    for(size_t i = 1; i < workersCount; ++i) {
+        ProjectLoadWorker* worker = new ProjectLoadWorker(jobs, i, workersCount);
+        if(worker->Create() == wxTHREAD_NO_ERROR && worker->Run() == wxTHREAD_NO_ERROR) {
+            workers.push_back(worker);
+        } else {
+            delete worker;
+            failedSlots.push_back(i);
+        }
+    }
+
+    // This thread takes the first share, and the share of the threads that could not be started
+    if(workersCount) {
+        LoadProjects(jobs, 0, workersCount);
+    }
+    for(size_t i = 0; i < failedSlots.size(); ++i) {
+        LoadProjects(jobs, failedSlots[i], workersCount);
+    }
+    for(size_t i = 0; i < workers.size(); ++i) {
+        workers[i]->Wait();
+        delete workers[i];
+    }
+
+    // Add the projects in the workspace order. The project settings may access the global build
+    // settings, so they are created here, on the main thread
+    size_t fromSnapshot = 0;
+    for(size_t i = 0; i < jobs.size(); ++i) {
+        ProjectLoadJob& job = jobs[i];
+        if(!job.m_loaded) {
+            clWARNING() << "Corrupted project file" << job.m_path << clEndl;
+            removedChildren.push_back(projects[i].first);
+            continue;
+        }
+        if(job.m_fromSnapshot) {
+            ++fromSnapshot;
+        }
+        job.m_project->LoadSettings();
+        m_projects.insert(std::make_pair(job.m_project->GetName(), job.m_project));
+        job.m_project->AssociateToWorkspace(this);
+        job.m_project->SetWorkspaceFolder(projects[i].second);
+    }
+
+    clDEBUG() << "Loaded" << jobs.size() << "projects (" << fromSnapshot << "from snapshots) with" << workersCount
+              << "threads in" << sw.Time() << "ms" << clEndl;
+}
+
+void clCxxWorkspace::DoCollectProjectsFromXml(wxXmlNode* parentNode, const wxString& folder,
+                                              std::vector<std::pair<wxXmlNode*, wxString> >& projects)
 {
     wxXmlNode* child = parentNode->GetChildren();
     while(child) {
         if(child->GetName() == wxT("Project")) {
-            wxString projectPath = child->GetPropVal(wxT("Path"), wxEmptyString);
-            wxString errmsg;
-            if(!DoAddProject(projectPath, folder, errmsg)) {
-                removedChildren.push_back(child);
-            }
+            projects.push_back(std::make_pair(child, folder));
         } else if(child->GetName() == wxT("VirtualDirectory")) {
             // Virtual directory
             wxString currentFolder = folder;
@@ -1251,7 +1389,7 @@ void clCxxWorkspace::DoLoadProjectsFromXml(wxXmlNode* parentNode, const wxString
                 currentFolder << "/";
             }
             currentFolder << vdName;
-            DoLoadProjectsFromXml(child, currentFolder, removedChildren);
+            DoCollectProjectsFromXml(child, currentFolder, projects);
         } else if((child->GetName() == wxT("WorkspaceParserPaths")) ||
                   (child->GetName() == wxT("WorkspaceParserMacros"))) {
             wxString swtlw = XmlUtils::ReadString(m_doc.GetRoot(), "SWTLW");
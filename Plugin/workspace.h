@@ -97,6 +97,12 @@ private:
      */
     void DoLoadProjectsFromXml(wxXmlNode* parentNode, const wxString& folder, std::vector<wxXmlNode*>& removedChildren);
 
+    /**
+     * @brief collect the "Project" nodes and the workspace folder they belong to
+     */
+    void DoCollectProjectsFromXml(wxXmlNode* parentNode, const wxString& folder,
+                                  std::vector<std::pair<wxXmlNode*, wxString> >& projects);
+
     // return the wxXmlNode instance for the give path
     // the path is separated by "/"
     // return NULL if no such virtual directory exists
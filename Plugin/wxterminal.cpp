@@ -315,7 +315,7 @@ wxString wxTerminal::StartTTY()
     static_cast<UnixProcessImpl*>(m_dummyProcess)->SetReadHandle(master);
     static_cast<UnixProcessImpl*>(m_dummyProcess)->SetWriteHandler(master);
     static_cast<UnixProcessImpl*>(m_dummyProcess)->SetPid(wxNOT_FOUND);
-    static_cast<UnixProcessImpl*>(m_dummyProcess)->StartReaderThread();
+    static_cast<UnixProcessImpl*>(m_dummyProcess)->StartReading();
     return m_tty;
 }
 
@@ -36,6 +36,7 @@
 #include "fileutils.h"
 #include "json_node.h"
 #include "sftp.h"
+#include "sftp_manifest.h"
 #include "sftp_settings.h"
 #include "sftp_worker_thread.h"
 #include "sftp_workspace_settings.h"
@@ -50,6 +51,10 @@ const wxEventType wxEVT_SFTP_OPEN_SSH_ACCOUNT_MANAGER = ::wxNewEventType();
 const wxEventType wxEVT_SFTP_SETTINGS = ::wxNewEventType();
 const wxEventType wxEVT_SFTP_SETUP_WORKSPACE_MIRRORING = ::wxNewEventType();
 const wxEventType wxEVT_SFTP_DISABLE_WORKSPACE_MIRRORING = ::wxNewEventType();
+const wxEventType wxEVT_SFTP_SYNC_WORKSPACE_MIRRORING = ::wxNewEventType();
+
+// The number of local copies of closed remote files we keep around
+static const size_t SFTP_MAX_CLOSED_FILES = 50;
 
 // Exposed API (via events)
 // SFTP plugin provides SFTP functionality for codelite based on events
@@ -97,6 +102,10 @@ SFTP::SFTP(IManager* manager)
                       wxCommandEventHandler(SFTP::OnDisableWorkspaceMirroring), NULL, this);
     wxTheApp->Connect(wxEVT_SFTP_DISABLE_WORKSPACE_MIRRORING, wxEVT_UPDATE_UI,
                       wxUpdateUIEventHandler(SFTP::OnDisableWorkspaceMirroringUI), NULL, this);
+    wxTheApp->Connect(wxEVT_SFTP_SYNC_WORKSPACE_MIRRORING, wxEVT_MENU,
+                      wxCommandEventHandler(SFTP::OnSyncWorkspaceMirroring), NULL, this);
+    wxTheApp->Connect(wxEVT_SFTP_SYNC_WORKSPACE_MIRRORING, wxEVT_UPDATE_UI,
+                      wxUpdateUIEventHandler(SFTP::OnDisableWorkspaceMirroringUI), NULL, this);
 
     EventNotifier::Get()->Bind(wxEVT_WORKSPACE_LOADED, &SFTP::OnWorkspaceOpened, this);
     EventNotifier::Get()->Bind(wxEVT_WORKSPACE_CLOSED, &SFTP::OnWorkspaceClosed, this);
@@ -183,6 +192,10 @@ void SFTP::HookPopupMenu(wxMenu* menu, MenuType type)
                               wxITEM_NORMAL);
         sftpMenu->Append(item);
 
+        item = new wxMenuItem(sftpMenu, wxEVT_SFTP_SYNC_WORKSPACE_MIRRORING, _("S&ynchronize"), wxEmptyString,
+                              wxITEM_NORMAL);
+        sftpMenu->Append(item);
+
         item = new wxMenuItem(sftpMenu, wxEVT_SFTP_DISABLE_WORKSPACE_MIRRORING, _("&Disable"), wxEmptyString,
                               wxITEM_NORMAL);
         sftpMenu->Append(item);
@@ -222,6 +235,7 @@ void SFTP::UnPlug()
     m_treeView->Destroy();
 
     SFTPWorkerThread::Release();
+    SFTPManifest::Get().Save();
     wxTheApp->Disconnect(wxEVT_SFTP_OPEN_SSH_ACCOUNT_MANAGER, wxEVT_MENU, wxCommandEventHandler(SFTP::OnAccountManager),
                          NULL, this);
     wxTheApp->Disconnect(wxEVT_SFTP_SETTINGS, wxEVT_MENU, wxCommandEventHandler(SFTP::OnSettings), NULL, this);
@@ -231,6 +245,10 @@ void SFTP::UnPlug()
                          wxCommandEventHandler(SFTP::OnDisableWorkspaceMirroring), NULL, this);
     wxTheApp->Disconnect(wxEVT_SFTP_DISABLE_WORKSPACE_MIRRORING, wxEVT_UPDATE_UI,
                          wxUpdateUIEventHandler(SFTP::OnDisableWorkspaceMirroringUI), NULL, this);
+    wxTheApp->Disconnect(wxEVT_SFTP_SYNC_WORKSPACE_MIRRORING, wxEVT_MENU,
+                         wxCommandEventHandler(SFTP::OnSyncWorkspaceMirroring), NULL, this);
+    wxTheApp->Disconnect(wxEVT_SFTP_SYNC_WORKSPACE_MIRRORING, wxEVT_UPDATE_UI,
+                         wxUpdateUIEventHandler(SFTP::OnDisableWorkspaceMirroringUI), NULL, this);
 
     EventNotifier::Get()->Unbind(wxEVT_WORKSPACE_LOADED, &SFTP::OnWorkspaceOpened, this);
     EventNotifier::Get()->Unbind(wxEVT_WORKSPACE_CLOSED, &SFTP::OnWorkspaceClosed, this);
@@ -247,6 +265,7 @@ void SFTP::UnPlug()
     m_tabToggler.reset(NULL);
 
     // Delete the temporary files
+    m_closedFiles.clear();
     wxFileName::Rmdir(clSFTP::GetDefaultDownloadFolder(), wxPATH_RMDIR_RECURSIVE);
 }
 
@@ -286,6 +305,7 @@ void SFTP::OnWorkspaceClosed(wxCommandEvent& e)
     e.Skip();
     m_workspaceFile.Clear();
     m_workspaceSettings.Clear();
+    SFTPManifest::Get().Save();
 }
 
 void SFTP::OnFileSaved(clCommandEvent& e)
@@ -315,6 +335,40 @@ void SFTP::OnDisableWorkspaceMirroringUI(wxUpdateUIEvent& e)
     e.Enable(m_workspaceFile.IsOk() && m_workspaceSettings.IsOk());
 }
 
+void SFTP::OnSyncWorkspaceMirroring(wxCommandEvent& e)
+{
+    wxUnusedVar(e);
+    SFTPSettings settings;
+    settings.Load();
+
+    SSHAccountInfo account;
+    if(!settings.GetAccount(m_workspaceSettings.GetAccount(), account)) {
+        ::wxMessageBox(_("Could not locate account: ") + m_workspaceSettings.GetAccount(), _("SFTP"),
+                       wxOK | wxICON_ERROR);
+        return;
+    }
+
+    // Bring the workspace folder and the remote workspace folder up to date with each other
+    wxString remoteFolder = wxFileName(m_workspaceSettings.GetRemoteWorkspacePath(), wxPATH_UNIX).GetPath(
+        wxPATH_GET_VOLUME, wxPATH_UNIX);
+    SFTPThreadRequet* req = new SFTPThreadRequet(account, remoteFolder, m_workspaceFile.GetPath(), 0);
+    req->SetAction(eSFTPActions::kSync);
+    SFTPWorkerThread::Instance()->Add(req);
+}
+
+void SFTP::UploadConflict(const SFTPThreadRequet& req)
+{
+    wxString msg;
+    msg << _("The remote file '") << req.GetRemoteFile() << _("' was modified since it was last synchronized\n")
+        << _("Overwrite it with the local file '") << req.GetLocalFile() << "'?";
+    if(::wxMessageBox(msg, _("SFTP"), wxYES_NO | wxICON_WARNING) == wxYES) {
+        SFTPThreadRequet* forceReq = new SFTPThreadRequet(req);
+        forceReq->SetForce(true);
+        forceReq->SetRetryCounter(0);
+        SFTPWorkerThread::Instance()->Add(forceReq);
+    }
+}
+
 void SFTP::OnSaveFile(clSFTPEvent& e)
 {
     SFTPSettings settings;
@@ -369,6 +423,7 @@ void SFTP::AddRemoteFile(const RemoteFileInfo& remoteFile)
 {
     if(m_remoteFiles.count(remoteFile.GetLocalFile())) { m_remoteFiles.erase(remoteFile.GetLocalFile()); }
     m_remoteFiles.insert(std::make_pair(remoteFile.GetLocalFile(), remoteFile));
+    m_closedFiles.remove(remoteFile.GetLocalFile());
 }
 
 void SFTP::OnEditorClosed(wxCommandEvent& e)
@@ -379,11 +434,17 @@ void SFTP::OnEditorClosed(wxCommandEvent& e)
         wxString localFile = editor->GetFileName().GetFullPath();
         if(m_remoteFiles.count(localFile)) {
 
-            wxLogNull noLog;
-
-            // Remove the file from our cache
-            clRemoveFile(localFile);
+            // Keep the local copy: if the remote file does not change, opening it again
+            // does not need to download it. Only the most recently closed copies are kept
             m_remoteFiles.erase(localFile);
+            m_closedFiles.remove(localFile);
+            m_closedFiles.push_front(localFile);
+
+            wxLogNull noLog;
+            while(m_closedFiles.size() > SFTP_MAX_CLOSED_FILES) {
+                clRemoveFile(m_closedFiles.back());
+                m_closedFiles.pop_back();
+            }
         }
     }
 }
@@ -34,9 +34,11 @@
 #include "plugin.h"
 #include "remote_file_info.h"
 #include "sftp_workspace_settings.h"
+#include <list>
 
 class SFTPStatusPage;
 class SFTPTreeView;
+class SFTPThreadRequet;
 
 class SFTPClientData : public wxClientData
 {
@@ -66,6 +68,7 @@ class SFTP : public IPlugin
     SFTPStatusPage* m_outputPane;
     SFTPTreeView* m_treeView;
     RemoteFileInfo::Map_t m_remoteFiles;
+    std::list<wxString> m_closedFiles; // Local copies of closed remote files, most recently closed first
     clTabTogglerHelper::Ptr_t m_tabToggler;
 
 public:
@@ -76,6 +79,10 @@ public:
     void OpenWithDefaultApp(const wxString& localFileName);
     void OpenContainingFolder(const wxString& localFileName);
     void AddRemoteFile(const RemoteFileInfo& remoteFile);
+    /**
+     * @brief called when an upload was refused because the remote file was modified since it was last synchronized
+     */
+    void UploadConflict(const SFTPThreadRequet& req);
 
 protected:
     void OnReplaceInFiles(clFileSystemEvent& e);
@@ -84,6 +91,7 @@ protected:
     void OnSetupWorkspaceMirroring(wxCommandEvent& e);
     void OnDisableWorkspaceMirroring(wxCommandEvent& e);
     void OnDisableWorkspaceMirroringUI(wxUpdateUIEvent& e);
+    void OnSyncWorkspaceMirroring(wxCommandEvent& e);
     void OnWorkspaceOpened(wxCommandEvent& e);
     void OnWorkspaceClosed(wxCommandEvent& e);
     void OnFileSaved(clCommandEvent& e);
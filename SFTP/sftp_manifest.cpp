@@ -0,0 +1,229 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2018 Eran Ifrah
+// file name            : sftp_manifest.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "cl_standard_paths.h"
+#include "file_logger.h"
+#include "json_node.h"
+#include "sftp_manifest.h"
+#include <wx/ffile.h>
+
+namespace
+{
+// 64 bit FNV-1a
+const wxUint64 kHashSeed = wxULL(14695981039346656037);
+inline wxUint64 HashBytes(wxUint64 hash, const unsigned char* data, size_t len)
+{
+    for(size_t i = 0; i < len; ++i) {
+        hash ^= data[i];
+        hash *= wxULL(1099511628211);
+    }
+    return hash;
+}
+
+wxString HashToString(wxUint64 hash) { return wxString::Format("%016" wxLongLongFmtSpec "x", hash); }
+
+wxUint64 StringToHash(const wxString& str)
+{
+    wxULongLong_t hash = 0;
+    str.ToULongLong(&hash, 16);
+    return hash;
+}
+
+// JSONElement stores numbers as int: keep sizes and times as strings
+wxString NumberToString(wxULongLong_t number) { return wxString() << number; }
+
+wxULongLong_t StringToNumber(const wxString& str)
+{
+    wxULongLong_t number = 0;
+    str.ToULongLong(&number);
+    return number;
+}
+} // namespace
+
+SFTPManifest::SFTPManifest()
+    : m_loaded(false)
+    , m_modified(false)
+{
+}
+
+SFTPManifest::~SFTPManifest() {}
+
+SFTPManifest& SFTPManifest::Get()
+{
+    static SFTPManifest manifest;
+    return manifest;
+}
+
+wxString SFTPManifest::GetKey(const wxString& account, const wxString& remotePath) const
+{
+    return account + "|" + remotePath;
+}
+
+wxFileName SFTPManifest::GetFileName() const
+{
+    wxFileName fn(clStandardPaths::Get().GetUserDataDir(), "sftp-manifest.json");
+    fn.AppendDir("sftp");
+    return fn;
+}
+
+bool SFTPManifest::HashFile(const wxString& localFile, Entry& entry, size_t* fileSize)
+{
+    wxFFile fp(localFile, "rb");
+    if(!fp.IsOpened()) { return false; }
+
+    entry.m_blocks.clear();
+    entry.m_hash = kHashSeed;
+    size_t total = 0;
+    std::vector<unsigned char> buffer(kBlockSize);
+    while(true) {
+        size_t nbytes = fp.Read(buffer.data(), buffer.size());
+        if(nbytes == 0) { break; }
+        entry.m_blocks.push_back(HashBytes(kHashSeed, buffer.data(), nbytes));
+        entry.m_hash = HashBytes(entry.m_hash, buffer.data(), nbytes);
+        total += nbytes;
+    }
+    if(fileSize) { *fileSize = total; }
+    return !fp.Error();
+}
+
+size_t SFTPManifest::GetModifiedRanges(const Entry& oldEntry, const Entry& newEntry, size_t newSize,
+                                       Entry::Ranges_t& ranges)
+{
+    ranges.clear();
+    size_t total = 0;
+    for(size_t i = 0; i < newEntry.m_blocks.size(); ++i) {
+        if(i < oldEntry.m_blocks.size() && oldEntry.m_blocks[i] == newEntry.m_blocks[i]) { continue; }
+
+        size_t offset = i * kBlockSize;
+        size_t len = wxMin((size_t)kBlockSize, newSize - offset);
+        if(!ranges.empty() && (ranges.back().first + ranges.back().second) == offset) {
+            // Adjacent to the previous range: merge them
+            ranges.back().second += len;
+        } else {
+            ranges.push_back(std::make_pair(offset, len));
+        }
+        total += len;
+    }
+    return total;
+}
+
+void SFTPManifest::DoLoad()
+{
+    if(m_loaded) { return; }
+    m_loaded = true;
+
+    wxFileName fn = GetFileName();
+    if(!fn.FileExists()) { return; }
+
+    JSONRoot root(fn);
+    JSONElement files = root.toElement().namedObject("files");
+    int count = files.arraySize();
+    for(int i = 0; i < count; ++i) {
+        JSONElement file = files.arrayItem(i);
+        Entry entry;
+        entry.m_remoteSize = (size_t)StringToNumber(file.namedObject("remoteSize").toString());
+        entry.m_remoteModificationTime = (time_t)StringToNumber(file.namedObject("remoteModificationTime").toString());
+        entry.m_localModificationTime = (time_t)StringToNumber(file.namedObject("localModificationTime").toString());
+        entry.m_hash = StringToHash(file.namedObject("hash").toString());
+
+        // The block hashes are stored as one string of 16 hex digits per block
+        wxString blocks = file.namedObject("blocks").toString();
+        for(size_t pos = 0; (pos + 16) <= blocks.length(); pos += 16) {
+            entry.m_blocks.push_back(StringToHash(blocks.Mid(pos, 16)));
+        }
+        m_entries.insert(std::make_pair(file.namedObject("key").toString(), entry));
+    }
+    clDEBUG() << "SFTP: loaded manifest with" << m_entries.size() << "entries" << clEndl;
+}
+
+bool SFTPManifest::Find(const wxString& account, const wxString& remotePath, Entry& entry)
+{
+    wxMutexLocker locker(m_lock);
+    DoLoad();
+    std::unordered_map<wxString, Entry>::const_iterator iter = m_entries.find(GetKey(account, remotePath));
+    if(iter == m_entries.end()) { return false; }
+    entry = iter->second;
+    return true;
+}
+
+void SFTPManifest::Update(const wxString& account, const wxString& remotePath, const Entry& entry)
+{
+    wxMutexLocker locker(m_lock);
+    DoLoad();
+    m_entries[GetKey(account, remotePath)] = entry;
+    m_modified = true;
+}
+
+void SFTPManifest::Remove(const wxString& account, const wxString& remotePath)
+{
+    wxMutexLocker locker(m_lock);
+    DoLoad();
+    if(m_entries.erase(GetKey(account, remotePath))) { m_modified = true; }
+}
+
+void SFTPManifest::Rename(const wxString& account, const wxString& oldPath, const wxString& newPath)
+{
+    wxMutexLocker locker(m_lock);
+    DoLoad();
+    std::unordered_map<wxString, Entry>::iterator iter = m_entries.find(GetKey(account, oldPath));
+    if(iter == m_entries.end()) { return; }
+    Entry entry = iter->second;
+    m_entries.erase(iter);
+    m_entries[GetKey(account, newPath)] = entry;
+    m_modified = true;
+}
+
+void SFTPManifest::Save()
+{
+    wxMutexLocker locker(m_lock);
+    if(!m_modified) { return; }
+
+    JSONRoot root(cJSON_Object);
+    JSONElement files = JSONElement::createArray("files");
+    root.toElement().append(files);
+    std::unordered_map<wxString, Entry>::const_iterator iter = m_entries.begin();
+    for(; iter != m_entries.end(); ++iter) {
+        const Entry& entry = iter->second;
+        wxString blocks;
+        blocks.reserve(entry.m_blocks.size() * 16);
+        for(size_t i = 0; i < entry.m_blocks.size(); ++i) {
+            blocks << HashToString(entry.m_blocks[i]);
+        }
+
+        JSONElement file = JSONElement::createObject();
+        file.addProperty("key", iter->first);
+        file.addProperty("remoteSize", NumberToString(entry.m_remoteSize));
+        file.addProperty("remoteModificationTime", NumberToString(entry.m_remoteModificationTime));
+        file.addProperty("localModificationTime", NumberToString(entry.m_localModificationTime));
+        file.addProperty("hash", HashToString(entry.m_hash));
+        file.addProperty("blocks", blocks);
+        files.arrayAppend(file);
+    }
+
+    wxFileName fn = GetFileName();
+    fn.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+    root.save(fn);
+    m_modified = false;
+}
@@ -0,0 +1,98 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2018 Eran Ifrah
+// file name            : sftp_manifest.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef SFTPMANIFEST_H
+#define SFTPMANIFEST_H
+
+#include "wxStringHash.h"
+#include <vector>
+#include <wx/filename.h>
+#include <wx/string.h>
+#include <wx/thread.h>
+
+/**
+ * @class SFTPManifest
+ * @brief remembers the state of every file at the time it was last synchronized with the remote server:
+ * the remote size and modification time, the local modification time and the hash of the content
+ * (per block and for the whole file).
+ * This allows us to detect which side changed since, and to send only the modified blocks of a file.
+ * The manifest is shared by all the SFTP threads
+ */
+class SFTPManifest
+{
+public:
+    struct Entry {
+        size_t m_remoteSize = 0;
+        time_t m_remoteModificationTime = 0;
+        time_t m_localModificationTime = 0;
+        wxUint64 m_hash = 0;
+        std::vector<wxUint64> m_blocks;
+        typedef std::vector<std::pair<size_t, size_t> > Ranges_t; // <offset, length>
+    };
+
+    enum { kBlockSize = 8192 };
+
+protected:
+    std::unordered_map<wxString, Entry> m_entries; // "account|remote path" -> entry
+    wxMutex m_lock;
+    bool m_loaded;
+    bool m_modified;
+
+private:
+    SFTPManifest();
+    virtual ~SFTPManifest();
+    wxString GetKey(const wxString& account, const wxString& remotePath) const;
+    wxFileName GetFileName() const;
+    void DoLoad();
+
+public:
+    static SFTPManifest& Get();
+
+    /**
+     * @brief read 'localFile' and fill the content hashes of 'entry'
+     * @param fileSize [output] the number of bytes hashed
+     */
+    static bool HashFile(const wxString& localFile, Entry& entry, size_t* fileSize = NULL);
+
+    /**
+     * @brief compare the blocks of 'oldEntry' with the blocks of 'newEntry' and return the (merged)
+     * ranges of 'newEntry' that need to be sent
+     * @return the number of bytes that need to be sent
+     */
+    static size_t GetModifiedRanges(const Entry& oldEntry, const Entry& newEntry, size_t newSize,
+                                    Entry::Ranges_t& ranges);
+
+    bool Find(const wxString& account, const wxString& remotePath, Entry& entry);
+    void Update(const wxString& account, const wxString& remotePath, const Entry& entry);
+    void Remove(const wxString& account, const wxString& remotePath);
+    void Rename(const wxString& account, const wxString& oldPath, const wxString& newPath);
+
+    /**
+     * @brief write the manifest to the disk (if it was modified)
+     */
+    void Save();
+};
+
+#endif // SFTPMANIFEST_H
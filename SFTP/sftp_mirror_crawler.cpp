@@ -0,0 +1,154 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2018 Eran Ifrah
+// file name            : sftp_mirror_crawler.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "file_logger.h"
+#include "sftp_mirror_crawler.h"
+#include <wx/stopwatch.h>
+
+namespace
+{
+class SFTPCrawlerThread : public wxThread
+{
+    SFTPMirrorCrawler* m_crawler;
+    SFTPMirrorCrawler::ConnectFunc_t m_connect;
+
+public:
+    SFTPCrawlerThread(SFTPMirrorCrawler* crawler, const SFTPMirrorCrawler::ConnectFunc_t& connect)
+        : wxThread(wxTHREAD_JOINABLE)
+        , m_crawler(crawler)
+        , m_connect(connect)
+    {
+    }
+
+    void* Entry()
+    {
+        // A connection can not be shared between threads: open our own
+        clSFTP::Ptr_t sftp = m_connect();
+        if(sftp) { m_crawler->Work(sftp); }
+        return NULL;
+    }
+};
+} // namespace
+
+SFTPMirrorCrawler::SFTPMirrorCrawler()
+    : m_cond(m_lock)
+    , m_busy(0)
+{
+}
+
+SFTPMirrorCrawler::~SFTPMirrorCrawler() {}
+
+void SFTPMirrorCrawler::Work(clSFTP::Ptr_t sftp)
+{
+    while(true) {
+        wxString folder;
+        {
+            wxMutexLocker locker(m_lock);
+            // Wait for work, as long as another thread may still find more folders
+            while(m_folders.empty() && m_busy > 0 && m_error.IsEmpty()) {
+                m_cond.Wait();
+            }
+            if(m_folders.empty() || !m_error.IsEmpty()) {
+                m_cond.Broadcast();
+                return;
+            }
+            folder = m_folders.front();
+            m_folders.pop_front();
+            ++m_busy;
+        }
+
+        SFTPAttribute::List_t entries;
+        wxString error;
+        try {
+            entries = sftp->List(folder, clSFTP::SFTP_BROWSE_FILES | clSFTP::SFTP_BROWSE_FOLDERS);
+        } catch(clException& e) {
+            error = e.What();
+        }
+
+        wxMutexLocker locker(m_lock);
+        --m_busy;
+        if(!error.IsEmpty()) {
+            m_error = error;
+            m_cond.Broadcast();
+            return;
+        }
+
+        SFTPAttribute::List_t::const_iterator iter = entries.begin();
+        for(; iter != entries.end(); ++iter) {
+            SFTPAttribute::Ptr_t attr = *iter;
+            if(attr->GetName() == "." || attr->GetName() == ".." || attr->IsSymlink()) { continue; }
+
+            wxString path = folder;
+            if(!path.EndsWith("/")) { path << "/"; }
+            path << attr->GetName();
+            if(attr->IsFolder()) {
+                if(!attr->GetName().StartsWith(".")) { m_folders.push_back(path); }
+
+            } else if(attr->IsFile()) {
+                File file;
+                file.m_path = path;
+                file.m_size = attr->GetSize();
+                file.m_modificationTime = attr->GetModificationTime();
+                file.m_permissions = attr->GetPermissions();
+                m_files.push_back(file);
+            }
+        }
+        m_cond.Broadcast();
+    }
+}
+
+SFTPMirrorCrawler::Vec_t SFTPMirrorCrawler::Crawl(clSFTP::Ptr_t sftp, const wxString& root, size_t maxConnections,
+                                                  const ConnectFunc_t& connect)
+{
+    m_folders.clear();
+    m_folders.push_back(root);
+    m_files.clear();
+    m_error.Clear();
+    m_busy = 0;
+
+    wxStopWatch sw;
+    std::vector<SFTPCrawlerThread*> threads;
+    for(size_t i = 1; i < maxConnections; ++i) {
+        SFTPCrawlerThread* thread = new SFTPCrawlerThread(this, connect);
+        if(thread->Create() == wxTHREAD_NO_ERROR && thread->Run() == wxTHREAD_NO_ERROR) {
+            threads.push_back(thread);
+        } else {
+            delete thread;
+        }
+    }
+
+    // The calling thread takes part in the crawl. This also guarantees progress if the
+    // additional connections could not be opened
+    Work(sftp);
+    for(size_t i = 0; i < threads.size(); ++i) {
+        threads[i]->Wait();
+        delete threads[i];
+    }
+
+    if(!m_error.IsEmpty()) { throw clException(m_error); }
+    clDEBUG() << "SFTP: crawled" << root << ":" << m_files.size() << "files," << (threads.size() + 1)
+              << "connections," << sw.Time() << "ms" << clEndl;
+    return m_files;
+}
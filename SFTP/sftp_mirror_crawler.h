@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2018 Eran Ifrah
+// file name            : sftp_mirror_crawler.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef SFTPMIRRORCRAWLER_H
+#define SFTPMIRRORCRAWLER_H
+
+#include "cl_sftp.h"
+#include <deque>
+#include <functional>
+#include <vector>
+#include <wx/thread.h>
+
+/**
+ * @class SFTPMirrorCrawler
+ * @brief list a remote folder recursively. Listing a folder costs a round trip per sftp_readdir() call,
+ * so the folders are listed by several connections in parallel: the caller's connection plus
+ * up to 'maxConnections - 1' additional ones, created with the connect function
+ */
+class SFTPMirrorCrawler
+{
+public:
+    struct File {
+        wxString m_path; // the remote path
+        size_t m_size;
+        time_t m_modificationTime;
+        size_t m_permissions;
+    };
+    typedef std::vector<File> Vec_t;
+    typedef std::function<clSFTP::Ptr_t()> ConnectFunc_t;
+
+protected:
+    wxMutex m_lock;
+    wxCondition m_cond;
+    std::deque<wxString> m_folders; // folders waiting to be listed
+    size_t m_busy;                  // number of folders being listed right now
+    Vec_t m_files;
+    wxString m_error;
+
+public:
+    SFTPMirrorCrawler();
+    virtual ~SFTPMirrorCrawler();
+
+    /**
+     * @brief crawl 'root'. Hidden folders (e.g. .git) are not visited
+     * @throw clException if listing a folder failed
+     */
+    Vec_t Crawl(clSFTP::Ptr_t sftp, const wxString& root, size_t maxConnections, const ConnectFunc_t& connect);
+
+    /**
+     * @brief list folders until there are none left. Called by every connection
+     */
+    void Work(clSFTP::Ptr_t sftp);
+};
+
+#endif // SFTPMIRRORCRAWLER_H
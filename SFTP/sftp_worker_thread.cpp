@@ -25,16 +25,25 @@
 
 #include "SFTPStatusPage.h"
 #include "cl_ssh.h"
+#include "file_logger.h"
+#include "fileutils.h"
 #include "sftp.h"
+#include "sftp_manifest.h"
+#include "sftp_mirror_crawler.h"
+#include "sftp_settings.h"
 #include "sftp_worker_thread.h"
+#include "wxStringHash.h"
 #include <libssh/sftp.h>
 #include <wx/ffile.h>
 
+// Files modified less than this number of seconds ago are always transferred: their modification time
+// may not change on the next save
+#define SFTP_RACY_INTERVAL 2
+
 SFTPWorkerThread* SFTPWorkerThread::ms_instance = 0;
 
 SFTPWorkerThread::SFTPWorkerThread()
-    : m_sftp(NULL)
-    , m_plugin(NULL)
+    : m_plugin(NULL)
 {
 }
 
@@ -49,63 +58,332 @@ SFTPWorkerThread* SFTPWorkerThread::Instance()
 void SFTPWorkerThread::Release()
 {
     if(ms_instance) {
+        for(size_t i = 0; i < ms_instance->m_workers.size(); ++i) {
+            ms_instance->m_workers[i]->Stop();
+            delete ms_instance->m_workers[i];
+        }
+        ms_instance->m_workers.clear();
         ms_instance->Stop();
         delete ms_instance;
     }
     ms_instance = 0;
 }
 
+void SFTPWorkerThread::DoStartWorkers()
+{
+    size_t maxConnections = SFTPSettings().Load().GetMaxConnections();
+    maxConnections = wxMax(1, wxMin(maxConnections, (size_t)16));
+    for(size_t i = 1; i < maxConnections; ++i) {
+        SFTPWorkerThread* worker = new SFTPWorkerThread();
+        worker->SetNotifyWindow(GetNotifiedWindow());
+        worker->SetSftpPlugin(m_plugin);
+        worker->Start();
+        m_workers.push_back(worker);
+    }
+}
+
+void SFTPWorkerThread::Add(ThreadRequest* request)
+{
+    SFTPThreadRequet* req = dynamic_cast<SFTPThreadRequet*>(request);
+    if(!req) {
+        WorkerThread::Add(request);
+        return;
+    }
+
+    if(this == ms_instance && m_workers.empty()) { DoStartWorkers(); }
+
+    // The requests of an account must be processed in the order they were added: a rename or a delete changes
+    // the paths the following requests work on. So each account has a single queue, served by one thread that
+    // owns the account's connection (this is also the thread a kConnect request refreshes). Different accounts
+    // are served in parallel
+    size_t index = std::hash<wxString>()(req->GetAccount().GetAccountName()) % (m_workers.size() + 1);
+    if(index == 0) {
+        WorkerThread::Add(request);
+    } else {
+        m_workers[index - 1]->WorkerThread::Add(request);
+    }
+}
+
+SFTPAttribute::Ptr_t SFTPWorkerThread::DoStat(clSFTP::Ptr_t sftp, const wxString& remotePath)
+{
+    try {
+        return sftp->Stat(remotePath);
+
+    } catch(clException& e) {
+        // No such file
+        wxUnusedVar(e);
+        return SFTPAttribute::Ptr_t(NULL);
+    }
+}
+
+void SFTPWorkerThread::DoUpdateManifest(const wxString& account, const wxString& remotePath,
+                                        const wxString& localFile, SFTPAttribute::Ptr_t remoteAttr)
+{
+    SFTPManifest::Entry entry;
+    if(!remoteAttr || !SFTPManifest::HashFile(localFile, entry)) { return; }
+    entry.m_remoteSize = remoteAttr->GetSize();
+    entry.m_remoteModificationTime = remoteAttr->GetModificationTime();
+    entry.m_localModificationTime = FileUtils::GetFileModificationTime(localFile);
+    SFTPManifest::Get().Update(account, remotePath, entry);
+}
+
+void SFTPWorkerThread::DoUpload(clSFTP::Ptr_t sftp, SFTPThreadRequet* req)
+{
+    wxString accountName = req->GetAccount().GetAccountName();
+    wxString msg;
+
+    wxFileName localFile(req->GetLocalFile());
+    time_t localModificationTime = FileUtils::GetFileModificationTime(localFile);
+    SFTPAttribute::Ptr_t remoteAttr = DoStat(sftp, req->GetRemoteFile());
+
+    // The remote file has the size and the modification time of the local file: nothing to do
+    if(remoteAttr && remoteAttr->IsFile() && (time(NULL) - localModificationTime) >= SFTP_RACY_INTERVAL &&
+       remoteAttr->GetSize() == FileUtils::GetFileSize(localFile) &&
+       remoteAttr->GetModificationTime() == localModificationTime) {
+        SFTPManifest::Entry base;
+        if(!SFTPManifest::Get().Find(accountName, req->GetRemoteFile(), base)) {
+            DoUpdateManifest(accountName, req->GetRemoteFile(), req->GetLocalFile(), remoteAttr);
+        }
+        msg << "File is up to date: " << req->GetLocalFile() << " -> " << req->GetRemoteFile();
+        DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_OK);
+        return;
+    }
+
+    // Compare the remote file with its state when we last synchronized it. If it changed,
+    // someone else modified it and we must not overwrite it silently
+    SFTPManifest::Entry base;
+    bool hasBase = SFTPManifest::Get().Find(accountName, req->GetRemoteFile(), base);
+    bool remoteModified = remoteAttr && hasBase && (remoteAttr->GetSize() != base.m_remoteSize ||
+                                                    remoteAttr->GetModificationTime() != base.m_remoteModificationTime);
+    if(remoteModified && !req->IsForce()) {
+        msg << "Conflict: " << req->GetRemoteFile() << " was modified on the remote server since it was last "
+            << "synchronized. File was not uploaded";
+        DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_ERROR);
+        m_plugin->CallAfter(&SFTP::UploadConflict, *req);
+        return;
+    }
+
+    SFTPManifest::Entry entry;
+    size_t localSize = 0;
+    if(!SFTPManifest::HashFile(req->GetLocalFile(), entry, &localSize)) {
+        throw clException(wxString() << "Could not read file: " << req->GetLocalFile());
+    }
+
+    DoReportStatusBarMessage(wxString() << _("Uploading file: ") << req->GetRemoteFile());
+    bool uploaded = false;
+    if(remoteAttr && hasBase && !remoteModified) {
+        // We know the content of the remote file: send only the blocks that changed
+        SFTPManifest::Entry::Ranges_t ranges;
+        size_t bytes = SFTPManifest::GetModifiedRanges(base, entry, localSize, ranges);
+        if(bytes <= (localSize / 2)) {
+            try {
+                sftp->WriteRanges(localFile, req->GetRemoteFile(), ranges, localSize);
+                msg << "Successfully uploaded file: " << req->GetLocalFile() << " -> " << req->GetRemoteFile()
+                    << " (" << bytes << "/" << localSize << " bytes sent)";
+                uploaded = true;
+
+            } catch(clException& e) {
+                // The blocks are written in place, so the remote file may now be partially updated.
+                // Forget what we knew about it and replace it with a full upload (which is atomic).
+                // If that fails too, the next attempt will not have a base to compare with and will
+                // upload the whole file
+                clWARNING() << "SFTP: partial upload of" << req->GetRemoteFile() << "failed:" << e.What()
+                            << ". Uploading the entire file" << clEndl;
+                SFTPManifest::Get().Remove(accountName, req->GetRemoteFile());
+            }
+        }
+    }
+
+    if(!uploaded) {
+        SFTPAttribute::Ptr_t attr(new SFTPAttribute(NULL));
+        attr->SetPermissions(req->GetPermissions());
+        sftp->CreateRemoteFile(req->GetRemoteFile(), localFile, attr);
+        msg << "Successfully uploaded file: " << req->GetLocalFile() << " -> " << req->GetRemoteFile();
+    }
+
+    // Give the remote file the local modification time, so the next upload can be skipped
+    // if the file did not change
+    try {
+        sftp->SetModificationTime(req->GetRemoteFile(), localModificationTime);
+    } catch(clException& e) {
+        wxUnusedVar(e);
+    }
+
+    remoteAttr = DoStat(sftp, req->GetRemoteFile());
+    if(remoteAttr) {
+        entry.m_remoteSize = remoteAttr->GetSize();
+        entry.m_remoteModificationTime = remoteAttr->GetModificationTime();
+        entry.m_localModificationTime = localModificationTime;
+        SFTPManifest::Get().Update(accountName, req->GetRemoteFile(), entry);
+    }
+
+    DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_OK);
+    DoReportStatusBarMessage("");
+}
+
+void SFTPWorkerThread::DoSync(clSFTP::Ptr_t sftp, SFTPThreadRequet* req)
+{
+    wxString accountName = req->GetAccount().GetAccountName();
+    wxString remoteRoot = req->GetRemoteFile();
+    wxString localRoot = req->GetLocalFile();
+
+    DoReportStatusBarMessage(wxString() << _("Synchronizing: ") << remoteRoot);
+
+    // List the remote folder using several connections
+    SFTPThreadRequet connectReq(*req);
+    SFTPMirrorCrawler crawler;
+    SFTPMirrorCrawler::Vec_t files = crawler.Crawl(sftp, remoteRoot, SFTPSettings().Load().GetMaxConnections(),
+                                                   [&]() { return DoConnect(&connectReq); });
+
+    size_t downloads = 0, uploads = 0, conflicts = 0;
+    for(size_t i = 0; i < files.size(); ++i) {
+        const SFTPMirrorCrawler::File& file = files[i];
+        wxString relativePath = file.m_path.Mid(remoteRoot.length());
+        if(relativePath.StartsWith("/")) { relativePath.Remove(0, 1); }
+        wxFileName localFile(relativePath, wxPATH_UNIX);
+        localFile.MakeAbsolute(localRoot);
+
+        SFTPManifest::Entry base;
+        bool hasBase = SFTPManifest::Get().Find(accountName, file.m_path, base);
+        bool download = false, upload = false;
+        if(!localFile.FileExists()) {
+            download = true;
+
+        } else if(!hasBase) {
+            // Both sides have the file, but we never synchronized it
+            SFTPManifest::Entry entry;
+            time_t localModificationTime = FileUtils::GetFileModificationTime(localFile);
+            if(FileUtils::GetFileSize(localFile) == file.m_size && localModificationTime == file.m_modificationTime &&
+               SFTPManifest::HashFile(localFile.GetFullPath(), entry)) {
+                entry.m_remoteSize = file.m_size;
+                entry.m_remoteModificationTime = file.m_modificationTime;
+                entry.m_localModificationTime = localModificationTime;
+                SFTPManifest::Get().Update(accountName, file.m_path, entry);
+            } else {
+                DoReportMessage(accountName, wxString() << "Conflict: " << localFile.GetFullPath() << " and "
+                                                        << file.m_path << " differ",
+                                SFTPThreadMessage::STATUS_ERROR);
+                ++conflicts;
+            }
+            continue;
+
+        } else {
+            bool remoteModified =
+                (file.m_size != base.m_remoteSize || file.m_modificationTime != base.m_remoteModificationTime);
+            bool localModified = (FileUtils::GetFileModificationTime(localFile) != base.m_localModificationTime);
+            if(localModified) {
+                // The file was touched, check its content
+                SFTPManifest::Entry entry;
+                if(SFTPManifest::HashFile(localFile.GetFullPath(), entry) && entry.m_hash == base.m_hash) {
+                    localModified = false;
+                }
+            }
+
+            if(localModified && remoteModified) {
+                DoReportMessage(accountName, wxString() << "Conflict: " << localFile.GetFullPath()
+                                                        << " was modified both locally and on the remote server",
+                                SFTPThreadMessage::STATUS_ERROR);
+                ++conflicts;
+            } else {
+                download = remoteModified;
+                upload = localModified;
+            }
+        }
+
+        // The transfers are performed by the worker threads
+        if(download) {
+            SFTPThreadRequet* transferReq =
+                new SFTPThreadRequet(req->GetAccount(), file.m_path, localFile.GetFullPath(), file.m_permissions);
+            transferReq->SetAction(eSFTPActions::kSyncDownload);
+            SFTPWorkerThread::Instance()->Add(transferReq);
+            ++downloads;
+
+        } else if(upload) {
+            SFTPWorkerThread::Instance()->Add(
+                new SFTPThreadRequet(req->GetAccount(), file.m_path, localFile.GetFullPath(), file.m_permissions));
+            ++uploads;
+        }
+    }
+
+    wxString msg;
+    msg << "Synchronized " << localRoot << " <-> " << remoteRoot << ": " << files.size() << " remote files, "
+        << downloads << " to download, " << uploads << " to upload, " << conflicts << " conflicts";
+    DoReportMessage(accountName, msg, conflicts ? SFTPThreadMessage::STATUS_ERROR : SFTPThreadMessage::STATUS_OK);
+    DoReportStatusBarMessage("");
+}
+
+SFTPAttribute::Ptr_t SFTPWorkerThread::DoGetUpToDateLocalFile(clSFTP::Ptr_t sftp, SFTPThreadRequet* req)
+{
+    wxFileName localFile(req->GetLocalFile());
+    if(!localFile.FileExists()) { return SFTPAttribute::Ptr_t(NULL); }
+
+    time_t localModificationTime = FileUtils::GetFileModificationTime(localFile);
+    if((time(NULL) - localModificationTime) < SFTP_RACY_INTERVAL) { return SFTPAttribute::Ptr_t(NULL); }
+
+    SFTPAttribute::Ptr_t attr = sftp->Stat(req->GetRemoteFile());
+    if(attr && attr->GetSize() == FileUtils::GetFileSize(localFile) &&
+       attr->GetModificationTime() == localModificationTime) {
+        return attr;
+    }
+    return SFTPAttribute::Ptr_t(NULL);
+}
+
 void SFTPWorkerThread::ProcessRequest(ThreadRequest* request)
 {
     SFTPThreadRequet* req = dynamic_cast<SFTPThreadRequet*>(request);
-    // Check if we need to open an ssh connection
-    wxString currentAccout = m_sftp ? m_sftp->GetAccount() : "";
-    wxString requestAccount = req->GetAccount().GetAccountName();
+    wxString accountName = req->GetAccount().GetAccountName();
 
-    if(currentAccout.IsEmpty() || currentAccout != requestAccount) {
-        m_sftp.reset(NULL);
-        DoConnect(req);
+    // Use the connection we already have for this account
+    clSFTP::Ptr_t sftp;
+    if(m_sessions.count(accountName) && req->GetAction() != eSFTPActions::kConnect) {
+        sftp = m_sessions[accountName];
+    } else {
+        m_sessions.erase(accountName);
+        sftp = DoConnect(req);
+        if(sftp) { m_sessions[accountName] = sftp; }
     }
 
     if(req->GetAction() == eSFTPActions::kConnect) {
         // Nothing more to be done here
-        // Disconnect
-        m_sftp.reset(NULL);
         return;
     }
 
     wxString msg;
-    wxString accountName = req->GetAccount().GetAccountName();
-    if(m_sftp && m_sftp->IsConnected()) {
+    if(sftp && sftp->IsConnected()) {
         msg.Clear();
         try {
             switch(req->GetAction()) {
             case eSFTPActions::kConnect:
                 // We don't really need this case. Just make the compiler silence
                 return;
-            case eSFTPActions::kUpload: {
-                DoReportStatusBarMessage(wxString() << _("Uploading file: ") << req->GetRemoteFile());
-                SFTPAttribute::Ptr_t attr(new SFTPAttribute(NULL));
-                attr->SetPermissions(req->GetPermissions());
-                m_sftp->CreateRemoteFile(req->GetRemoteFile(), wxFileName(req->GetLocalFile()), attr);
-                msg << "Successfully uploaded file: " << req->GetLocalFile() << " -> " << req->GetRemoteFile();
-                DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_OK);
-                DoReportStatusBarMessage("");
+            case eSFTPActions::kUpload:
+                DoUpload(sftp, req);
+                break;
+            case eSFTPActions::kSync:
+                DoSync(sftp, req);
                 break;
-            }
             case eSFTPActions::kDownload:
+            case eSFTPActions::kSyncDownload:
             case eSFTPActions::kDownloadAndOpenContainingFolder:
             case eSFTPActions::kDownloadAndOpenWithDefaultApp: {
-                DoReportStatusBarMessage(wxString() << _("Downloading file: ") << req->GetRemoteFile());
-                wxMemoryBuffer buffer;
-                SFTPAttribute::Ptr_t fileAttr = m_sftp->Read(req->GetRemoteFile(), buffer);
-                wxFFile fp(req->GetLocalFile(), "w+b");
-                if(fp.IsOpened()) {
-                    fp.Write(buffer.GetData(), buffer.GetDataLen());
-                    fp.Close();
-                }
+                SFTPAttribute::Ptr_t fileAttr = DoGetUpToDateLocalFile(sftp, req);
+                if(fileAttr) {
+                    msg << "File is up to date: " << req->GetLocalFile() << " <- " << req->GetRemoteFile();
 
-                msg << "Successfully downloaded file: " << req->GetLocalFile() << " <- " << req->GetRemoteFile();
+                } else {
+                    DoReportStatusBarMessage(wxString() << _("Downloading file: ") << req->GetRemoteFile());
+                    wxFileName::Mkdir(wxFileName(req->GetLocalFile()).GetPath(), wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+                    fileAttr = sftp->Read(req->GetRemoteFile(), wxFileName(req->GetLocalFile()));
+
+                    // Keep the remote modification time, so the next download can be skipped
+                    if(fileAttr && fileAttr->GetModificationTime()) {
+                        wxDateTime modificationTime((time_t)fileAttr->GetModificationTime());
+                        wxFileName(req->GetLocalFile()).SetTimes(NULL, &modificationTime, NULL);
+                    }
+                    msg << "Successfully downloaded file: " << req->GetLocalFile() << " <- "
+                        << req->GetRemoteFile();
+                }
+                DoUpdateManifest(accountName, req->GetRemoteFile(), req->GetLocalFile(), fileAttr);
                 DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_OK);
                 DoReportStatusBarMessage("");
 
@@ -120,7 +398,7 @@ void SFTPWorkerThread::ProcessRequest(ThreadRequest* request)
                 } else if(req->GetAction() == eSFTPActions::kDownloadAndOpenContainingFolder) {
                     m_plugin->CallAfter(&SFTP::OpenContainingFolder, req->GetLocalFile());
 
-                } else {
+                } else if(req->GetAction() == eSFTPActions::kDownloadAndOpenWithDefaultApp) {
                     m_plugin->CallAfter(&SFTP::OpenWithDefaultApp, req->GetLocalFile());
                 }
                 break;
@@ -128,7 +406,8 @@ void SFTPWorkerThread::ProcessRequest(ThreadRequest* request)
             case eSFTPActions::kRename: {
                 DoReportStatusBarMessage(wxString() << _("Renaming: ") << req->GetRemoteFile() << " -> "
                                                     << req->GetNewRemoteFile());
-                m_sftp->Rename(req->GetRemoteFile(), req->GetNewRemoteFile());
+                sftp->Rename(req->GetRemoteFile(), req->GetNewRemoteFile());
+                SFTPManifest::Get().Rename(accountName, req->GetRemoteFile(), req->GetNewRemoteFile());
                 wxString msg;
                 msg << _("Renamed ") << req->GetRemoteFile() << " -> " << req->GetNewRemoteFile();
                 DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_OK);
@@ -136,7 +415,8 @@ void SFTPWorkerThread::ProcessRequest(ThreadRequest* request)
             }
             case eSFTPActions::kDelete: {
                 DoReportStatusBarMessage(wxString() << _("Deleting: ") << req->GetRemoteFile());
-                m_sftp->UnlinkFile(req->GetRemoteFile());
+                sftp->UnlinkFile(req->GetRemoteFile());
+                SFTPManifest::Get().Remove(accountName, req->GetRemoteFile());
                 wxString msg;
                 msg << _("Deleted ") << req->GetRemoteFile();
                 DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_OK);
@@ -149,7 +429,9 @@ void SFTPWorkerThread::ProcessRequest(ThreadRequest* request)
             msg << "SFTP error: " << e.What();
             DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_ERROR);
             DoReportStatusBarMessage(msg);
-            m_sftp.reset(NULL);
+
+            // The connection may be broken, open a new one on the next request
+            m_sessions.erase(accountName);
 
             // Requeue our request
             if(req->GetRetryCounter() == 0) {
@@ -157,16 +439,16 @@ void SFTPWorkerThread::ProcessRequest(ThreadRequest* request)
                 msg << "Retrying to upload file: " << req->GetRemoteFile();
                 DoReportMessage(req->GetAccount().GetAccountName(), msg, SFTPThreadMessage::STATUS_NONE);
 
-                // first time trying this request, requeue it
+                // first time trying this request, requeue it (on this thread, to keep the order)
                 SFTPThreadRequet* retryReq = static_cast<SFTPThreadRequet*>(req->Clone());
                 retryReq->SetRetryCounter(1);
-                Add(retryReq);
+                WorkerThread::Add(retryReq);
             }
         }
     }
 }
 
-void SFTPWorkerThread::DoConnect(SFTPThreadRequet* req)
+clSFTP::Ptr_t SFTPWorkerThread::DoConnect(SFTPThreadRequet* req)
 {
     wxString accountName = req->GetAccount().GetAccountName();
     clSSH::Ptr_t ssh(new clSSH(req->GetAccount().GetHost(), req->GetAccount().GetUsername(),
@@ -179,21 +461,22 @@ void SFTPWorkerThread::DoConnect(SFTPThreadRequet* req)
         if(!ssh->AuthenticateServer(message)) { ssh->AcceptServerAuthentication(); }
 
         ssh->Login();
-        m_sftp.reset(new clSFTP(ssh));
+        clSFTP::Ptr_t sftp(new clSFTP(ssh));
 
         // associate the account with the connection
-        m_sftp->SetAccount(req->GetAccount().GetAccountName());
-        m_sftp->Initialize();
+        sftp->SetAccount(req->GetAccount().GetAccountName());
+        sftp->Initialize();
 
         wxString msg;
         msg << "Successfully connected to " << accountName;
         DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_OK);
+        return sftp;
 
     } catch(clException& e) {
         wxString msg;
         msg << "Connect error. " << e.What();
         DoReportMessage(accountName, msg, SFTPThreadMessage::STATUS_ERROR);
-        m_sftp.reset(NULL);
+        return clSFTP::Ptr_t(NULL);
     }
 }
 
@@ -271,6 +554,8 @@ SFTPThreadRequet& SFTPThreadRequet::operator=(const SFTPThreadRequet& other)
     m_uploadSuccess = other.m_uploadSuccess;
     m_action = other.m_action;
     m_permissions = other.m_permissions;
+    m_newRemoteFile = other.m_newRemoteFile;
+    m_force = other.m_force;
     return *this;
 }
 
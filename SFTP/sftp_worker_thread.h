@@ -30,6 +30,8 @@
 #include "remote_file_info.h"
 #include "ssh_account_info.h"
 #include "worker_thread.h" // Base class: WorkerThread
+#include <map>
+#include <vector>
 
 class SFTP;
 
@@ -41,6 +43,8 @@ enum class eSFTPActions {
     kDownloadAndOpenContainingFolder,
     kRename,
     kDelete,
+    kSync,         // synchronize a local folder with a remote folder
+    kSyncDownload, // download a file as part of a synchronization (the file is not opened)
 };
 
 class SFTPThreadRequet : public ThreadRequest
@@ -53,6 +57,7 @@ class SFTPThreadRequet : public ThreadRequest
     eSFTPActions m_action;
     size_t m_permissions = 0;
     wxString m_newRemoteFile;
+    bool m_force = false;
 
 public:
     SFTPThreadRequet(const SSHAccountInfo& accountInfo, const wxString& remoteFile, const wxString& localFile,
@@ -82,6 +87,11 @@ public:
     ThreadRequest* Clone() const;
     void SetNewRemoteFile(const wxString& newRemoteFile) { this->m_newRemoteFile = newRemoteFile; }
     const wxString& GetNewRemoteFile() const { return m_newRemoteFile; }
+    /**
+     * @brief when set, an upload overwrites the remote file even if it was modified since it was last synchronized
+     */
+    void SetForce(bool force) { this->m_force = force; }
+    bool IsForce() const { return m_force; }
 };
 
 class SFTPThreadMessage
@@ -110,11 +120,19 @@ public:
     int GetStatus() const { return m_status; }
 };
 
+/**
+ * @class SFTPWorkerThread
+ * @brief the SFTP transfer engine. The instance dispatches the requests among itself and a number of
+ * additional worker threads (SFTPSettings::GetMaxConnections() in total). All the requests of an account go to
+ * the same thread, so they are processed in the order they were added, and the accounts are served in parallel.
+ * Each thread keeps the connections of its accounts open
+ */
 class SFTPWorkerThread : public WorkerThread
 {
     static SFTPWorkerThread* ms_instance;
-    clSFTP::Ptr_t m_sftp;
+    std::map<wxString, clSFTP::Ptr_t> m_sessions; // account name -> connection
     SFTP* m_plugin;
+    std::vector<SFTPWorkerThread*> m_workers; // the additional threads (owned by the instance)
 
 public:
     static SFTPWorkerThread* Instance();
@@ -123,13 +141,26 @@ public:
 private:
     SFTPWorkerThread();
     virtual ~SFTPWorkerThread();
-    void DoConnect(SFTPThreadRequet* req);
+    clSFTP::Ptr_t DoConnect(SFTPThreadRequet* req);
+    void DoStartWorkers();
+    SFTPAttribute::Ptr_t DoStat(clSFTP::Ptr_t sftp, const wxString& remotePath);
+    SFTPAttribute::Ptr_t DoGetUpToDateLocalFile(clSFTP::Ptr_t sftp, SFTPThreadRequet* req);
+    void DoUpload(clSFTP::Ptr_t sftp, SFTPThreadRequet* req);
+    void DoSync(clSFTP::Ptr_t sftp, SFTPThreadRequet* req);
+    void DoUpdateManifest(const wxString& account, const wxString& remotePath, const wxString& localFile,
+                          SFTPAttribute::Ptr_t remoteAttr);
     void DoReportMessage(const wxString& account, const wxString& message, int status);
     void DoReportStatusBarMessage(const wxString& message);
 
 public:
     virtual void ProcessRequest(ThreadRequest* request);
     void SetSftpPlugin(SFTP* sftp);
+
+    /**
+     * @brief queue a request. This hides WorkerThread::Add(): the request is passed to the thread
+     * that handles its account
+     */
+    void Add(ThreadRequest* request);
 };
 
 #endif // SFTPWRITERTHREAD_H
@@ -57,6 +57,7 @@
 
 // ------------------------------------------------------------
 #define MIN_TOKEN_LEN 3
+#define MAX_CACHED_WORDS 20000
 // ------------------------------------------------------------
 IHunSpell::IHunSpell() :
     m_caseSensitiveUserDictionary(true),
@@ -122,6 +123,13 @@ void IHunSpell::CloseEngine()
         SaveUserDict(m_userDictPath + s_userDict);
     }
     m_pSpell = NULL;
+    ClearWordCache();
+}
+// ------------------------------------------------------------
+void IHunSpell::ClearWordCache()
+{
+    m_wordCache.clear();
+    m_tagCache.clear();
 }
 // ------------------------------------------------------------
 bool IHunSpell::CheckWord(const wxString& word) const
@@ -136,20 +144,35 @@ bool IHunSpell::CheckWord(const wxString& word) const
     if(m_userDict.count(word) != 0)
         return true;
 
+    // ask hunspell only once per distinct word
+    WordCache::const_iterator iter = m_wordCache.find(word);
+    if(iter != m_wordCache.end())
+        return iter->second;
+
     // see if hex number
-    if(rehex.Matches(word))
-        return true;
+    bool correct = rehex.Matches(word) || (Hunspell_spell(m_pSpell, word.ToUTF8()) != 0);
 
-    return Hunspell_spell(m_pSpell, word.ToUTF8()) != 0;
+    // keep the cache bounded, a full reset is cheaper than tracking usage
+    if(m_wordCache.size() >= MAX_CACHED_WORDS)
+        m_wordCache.clear();
+    m_wordCache.insert(std::make_pair(word, correct));
+    return correct;
 }
 // ------------------------------------------------------------
 bool IHunSpell::IsTag(const wxString& word) const
 {
     if(GetIgnoreSymbolsInTagsDatabase()) {
+        WordCache::const_iterator iter = m_tagCache.find(word);
+        if(iter != m_tagCache.end())
+            return iter->second;
+
         std::vector<TagEntryPtr> tags;
         TagsManagerST::Get()->FindSymbol(word, tags);
-        if(!tags.empty())
-            return true;
+
+        if(m_tagCache.size() >= MAX_CACHED_WORDS)
+            m_tagCache.clear();
+        m_tagCache.insert(std::make_pair(word, !tags.empty()));
+        return !tags.empty();
     }
 
     return false;
@@ -196,65 +219,102 @@ void IHunSpell::CheckCppSpelling(const wxString& check)
 
         m_pSpellDlg->SetPHs(this);
     }
-    posLen query;
-
-    for(int i = 0; i < pEditor->GetLength(); i++) {
-        switch(pTextCtrl->GetStyleAt(i)) {
-        case SCT_STRING: {
-            query.first = i;
-
-            while(pTextCtrl->GetStyleAt(i++) == SCT_STRING)
-                ;
-            query.second = i;
-
-            if(IsScannerType(kString)) m_parseValues.push_back(make_pair(query, kString));
-        } break;
-        case SCT_CPP_COM: {
-            query.first = i;
-
-            while(pTextCtrl->GetStyleAt(i++) == SCT_CPP_COM)
-                ;
-            query.second = i;
-
-            if(IsScannerType(kCppComment)) m_parseValues.push_back(make_pair(query, kCppComment));
-        } break;
-        case SCT_C_COM: {
-            query.first = i;
-
-            while(pTextCtrl->GetStyleAt(i++) == SCT_C_COM)
-                ;
-            query.second = i;
-
-            if(IsScannerType(kCComment)) m_parseValues.push_back(make_pair(query, kCComment));
-        } break;
-        case SCT_DOX_1: {
-            query.first = i;
-
-            while(pTextCtrl->GetStyleAt(i++) == SCT_DOX_1)
-                ;
-            query.second = i;
-
-            if(IsScannerType(kDox1)) m_parseValues.push_back(make_pair(query, kDox1));
-        } break;
-        case SCT_DOX_2: {
-            query.first = i;
-
-            while(pTextCtrl->GetStyleAt(i++) == SCT_DOX_2)
-                ;
-            query.second = i;
-
-            if(IsScannerType(kDox2)) m_parseValues.push_back(make_pair(query, kDox2));
-        } break;
-        }
-    }
+    ParseCppRanges(pTextCtrl, 0, pTextCtrl->GetLength());
+
     int errors = 0;
 
     if(!m_pPlugIn->GetCheckContinuous()) {
         retVal = CheckCppType(pEditor);
 
         if(errors == 0 && retVal != kSpellingCanceled) ::wxMessageBox(_("No spelling errors found!"));
-    } else
+    } else {
+        pEditor->ClearUserIndicators();
         retVal = MarkErrors(pEditor);
+    }
+}
+// ------------------------------------------------------------
+int IHunSpell::MarkCppSpelling(IEditor* pEditor, int startPos, int endPos)
+{
+    if(!pEditor || !InitEngine()) return 0;
+
+    ParseCppRanges(pEditor->GetCtrl(), startPos, endPos);
+    ClearIndicators(pEditor, startPos, endPos);
+    return MarkErrors(pEditor);
+}
+// ------------------------------------------------------------
+int IHunSpell::MarkSpelling(IEditor* pEditor, int startPos, int endPos)
+{
+    if(!pEditor || !InitEngine()) return 0;
+
+    int counter = 0;
+    wxString text = pEditor->GetTextRange(startPos, endPos) + wxT(" ");
+    ClearIndicators(pEditor, startPos, endPos);
+
+    wxStringTokenizer tkz(text, s_defDelimiters);
+    while(tkz.HasMoreTokens()) {
+        wxString token = tkz.GetNextToken();
+        int pos = startPos + tkz.GetPosition() - token.Len() - 1;
+
+        // ignore token shorter then MIN_TOKEN_LEN
+        if(token.Len() <= MIN_TOKEN_LEN) continue;
+
+        if(!CheckWord(token)) {
+            pEditor->SetUserIndicator(pos, token.Len());
+            counter++;
+        }
+    }
+    return counter;
+}
+// ------------------------------------------------------------
+void IHunSpell::ParseCppRanges(wxStyledTextCtrl* pTextCtrl, int startPos, int endPos)
+{
+    m_parseValues.clear();
+    if(startPos >= endPos) return;
+
+    // make sure the lexer has styled the range, then fetch all the styles with a single call
+    if(pTextCtrl->GetEndStyled() < endPos) {
+        pTextCtrl->Colourise(pTextCtrl->GetEndStyled(), endPos);
+    }
+    wxMemoryBuffer styledText = pTextCtrl->GetStyledText(startPos, endPos);
+    const unsigned char* data = (const unsigned char*)styledText.GetData();
+    const int count = styledText.GetDataLen() / 2; // pairs of character and style
+
+    int i = 0;
+    while(i < count) {
+        const unsigned char style = data[(i * 2) + 1];
+        int j = i + 1;
+        while(j < count && data[(j * 2) + 1] == style)
+            ++j;
+
+        int type = 0;
+        switch(style) {
+        case SCT_STRING:
+            type = kString;
+            break;
+        case SCT_CPP_COM:
+            type = kCppComment;
+            break;
+        case SCT_C_COM:
+            type = kCComment;
+            break;
+        case SCT_DOX_1:
+            type = kDox1;
+            break;
+        case SCT_DOX_2:
+            type = kDox2;
+            break;
+        }
+
+        if(type && IsScannerType(type)) {
+            m_parseValues.push_back(std::make_pair(posLen(startPos + i, startPos + j), type));
+        }
+        i = j;
+    }
+}
+// ------------------------------------------------------------
+void IHunSpell::ClearIndicators(IEditor* pEditor, int startPos, int endPos)
+{
+    pEditor->ClearUserIndicator(startPos, endPos - startPos);
 }
 // ------------------------------------------------------------
 void IHunSpell::CheckSpelling(const wxString& check)
@@ -594,7 +654,6 @@ int IHunSpell::MarkErrors(IEditor* pEditor)
     wxStringTokenizer tkz;
 
     int counter = 0;
-    pEditor->ClearUserIndicators();
 
     for(wxUint32 i = 0; i < m_parseValues.size(); i++) {
         posLen pl = m_parseValues[i].first;
@@ -655,6 +714,7 @@ void IHunSpell::SetCaseSensitiveUserDictionary(const bool caseSensitiveUserDicti
 
 void IHunSpell::AddWord(const wxString& word)
 {
+    m_wordCache.erase(word);
 #if wxUSE_STL
     // Implicit conversions are disabled when building with wxUSE_STL=1
     Hunspell_add(m_pSpell, word.mb_str().data());
@@ -41,6 +41,7 @@
 #include <vector>
 #include <utility>
 #include <unordered_set>
+#include <unordered_map>
 #include "wxStringHash.h"
 // ------------------------------------------------------------
 WX_DECLARE_STRING_HASH_MAP(wxString, languageMap);
@@ -51,6 +52,7 @@ typedef std::vector<parseEntry> partList;
 class CorrectSpellingDlg;
 class SpellCheck;
 class IEditor;
+class wxStyledTextCtrl;
 // ------------------------------------------------------------
 class IHunSpell
 {
@@ -118,6 +120,12 @@ public:
     void CheckCppSpelling(const wxString& check);
     /// makes a spell check for the given plain text. Canceled is set to true when the user cancels.
     void CheckSpelling(const wxString& check);
+    /// marks misspelled words in cpp strings and comments between startPos and endPos (continuous mode)
+    int MarkCppSpelling(IEditor* pEditor, int startPos, int endPos);
+    /// marks misspelled words in plain text between startPos and endPos (continuous mode)
+    int MarkSpelling(IEditor* pEditor, int startPos, int endPos);
+    /// clears the cached per-word results
+    void ClearWordCache();
     /// retrieves all predefined language names, used as key to get the filename
     void GetAllLanguageKeyNames(wxArrayString& lang);
     /// checks for predefined language names, which could be found in path
@@ -181,6 +189,8 @@ protected:
 
     int CheckCppType(IEditor* pEditor);
     int MarkErrors(IEditor* pEditor);
+    void ParseCppRanges(wxStyledTextCtrl* pTextCtrl, int startPos, int endPos);
+    void ClearIndicators(IEditor* pEditor, int startPos, int endPos);
     void InitLanguageList();
 
     bool LoadUserDict(const wxString& filename);
@@ -202,6 +212,10 @@ protected:
 
     partList m_parseValues; // list with position results for CPP parsing
 
+    typedef std::unordered_map<wxString, bool> WordCache;
+    mutable WordCache m_wordCache; // hunspell results per distinct word
+    mutable WordCache m_tagCache;  // tags database results per distinct word
+
     int m_scanners; // flags for scanner types
 };
 #endif // _HUNSPELLINTERFACE_
@@ -50,6 +50,7 @@
 #include <wx/xrc/xmlres.h>
 #include <wx/tokenzr.h>
 #include <wx/stc/stc.h>
+#include <algorithm>
 
 #include "res/spellcheck16.b2c"
 #include "res/spellcheck22.b2c"
@@ -97,6 +98,11 @@ CL_PLUGIN_API int GetPluginInterfaceVersion() { return PLUGIN_INTERFACE_VERSION;
 SpellCheck::SpellCheck(IManager* manager)
     : IPlugin(manager)
     , m_pLastEditor(nullptr)
+    , m_lastModificationCount(0)
+    , m_lastFirstVisibleLine(-1)
+    , m_dirtyCtrl(nullptr)
+    , m_dirtyStart(-1)
+    , m_dirtyEnd(-1)
 {
     Init();
 }
@@ -109,6 +115,7 @@ SpellCheck::~SpellCheck()
     m_topWin->Unbind(wxEVT_COMMAND_MENU_SELECTED, &SpellCheck::OnCheck, this, XRCID(s_doCheckID.ToUTF8()));
     m_topWin->Unbind(wxEVT_COMMAND_MENU_SELECTED, &SpellCheck::OnContinousCheck, this, XRCID(s_contCheckID.ToUTF8()));
     m_topWin->Unbind(wxEVT_CONTEXT_MENU_EDITOR, &SpellCheck::OnContextMenu, this);
+    m_topWin->Unbind(wxEVT_STC_MODIFIED, &SpellCheck::OnStcModified, this);
     m_topWin->Unbind(wxEVT_WORKSPACE_LOADED, &SpellCheck::OnWspLoaded, this);
     m_topWin->Unbind(wxEVT_WORKSPACE_CLOSED, &SpellCheck::OnWspClosed, this);
 
@@ -150,6 +157,7 @@ void SpellCheck::Init()
     }
     m_timer.Bind(wxEVT_TIMER, &SpellCheck::OnTimer, this);
     m_topWin->Bind(wxEVT_CONTEXT_MENU_EDITOR, &SpellCheck::OnContextMenu, this);
+    m_topWin->Bind(wxEVT_STC_MODIFIED, &SpellCheck::OnStcModified, this);
     m_topWin->Bind(wxEVT_WORKSPACE_LOADED, &SpellCheck::OnWspLoaded, this);
     m_topWin->Bind(wxEVT_WORKSPACE_CLOSED, &SpellCheck::OnWspClosed, this);
 
@@ -387,18 +395,8 @@ void SpellCheck::OnContinousCheck(wxCommandEvent& e)
         IEditor* editor = m_mgr->GetActiveEditor();
 
         if (editor) {
-            wxString text = editor->GetEditorText();
-
-            switch(editor->GetLexerId()) {
-            case wxSTC_LEX_CPP: {
-                if(m_mgr->IsWorkspaceOpen()) {
-                    m_pEngine->CheckCppSpelling(text);
-                }
-            } break;
-            default: {
-                m_pEngine->CheckSpelling(text);
-            } break;
-            }
+            m_pLastEditor = nullptr;
+            DoContinuousCheck(editor);
             m_timer.Start(PARSE_TIME);
         }
     }
@@ -415,24 +413,109 @@ void SpellCheck::OnTimer(wxTimerEvent& e)
     if(!editor) return;
 
     if(GetCheckContinuous()) {
-        // Only run the checks if we've not run them or the file is modified.
-        const auto modificationCount(editor->GetModificationCount());
-        if((editor == m_pLastEditor) && (m_lastModificationCount == modificationCount)) {
-            return;
+        DoContinuousCheck(editor);
+    }
+}
+// ------------------------------------------------------------
+void SpellCheck::DoContinuousCheck(IEditor* editor)
+{
+    wxStyledTextCtrl* ctrl = editor->GetCtrl();
+
+    // Only run the checks if we've not run them, the file is modified or the view has scrolled.
+    const auto modificationCount(editor->GetModificationCount());
+    const int firstVisibleLine = ctrl->GetFirstVisibleLine();
+    if((editor == m_pLastEditor) && (m_lastModificationCount == modificationCount) &&
+       (m_lastFirstVisibleLine == firstVisibleLine)) {
+        return;
+    }
+
+    if(editor != m_pLastEditor) {
+        // Marks left from a previous check of this editor may be stale, only the visible part is re-checked
+        editor->ClearUserIndicators();
+    }
+
+    m_pLastEditor = editor;
+    m_lastModificationCount = modificationCount;
+    m_lastFirstVisibleLine = firstVisibleLine;
+
+    // The visible lines
+    const int firstLine = ctrl->DocLineFromVisible(firstVisibleLine);
+    const int lastLine = ctrl->DocLineFromVisible(firstVisibleLine + ctrl->LinesOnScreen());
+    const int visibleStart = ctrl->PositionFromLine(firstLine);
+    const int visibleEnd = ctrl->GetLineEndPosition(lastLine);
+    DoCheckRange(editor, visibleStart, visibleEnd);
+
+    // And whatever was modified outside of them since the last run
+    if((m_dirtyCtrl == ctrl) && (m_dirtyStart != -1)) {
+        const int dirtyStart = ctrl->PositionFromLine(ctrl->LineFromPosition(m_dirtyStart));
+        const int dirtyEnd = ctrl->GetLineEndPosition(ctrl->LineFromPosition(m_dirtyEnd));
+        if(dirtyStart < visibleStart) {
+            DoCheckRange(editor, dirtyStart, std::min(dirtyEnd, visibleStart));
         }
+        if(dirtyEnd > visibleEnd) {
+            DoCheckRange(editor, std::max(dirtyStart, visibleEnd), dirtyEnd);
+        }
+    }
+    m_dirtyCtrl = nullptr;
+    m_dirtyStart = m_dirtyEnd = -1;
+}
+// ------------------------------------------------------------
+void SpellCheck::DoCheckRange(IEditor* editor, int startPos, int endPos)
+{
+    if(startPos >= endPos) return;
 
-        m_pLastEditor = editor;
-        m_lastModificationCount = modificationCount;
+    switch(editor->GetLexerId()) {
+    case wxSTC_LEX_CPP: {
+        if(m_mgr->IsWorkspaceOpen()) {
+            m_pEngine->MarkCppSpelling(editor, startPos, endPos);
+        }
+    } break;
+    default: {
+        m_pEngine->MarkSpelling(editor, startPos, endPos);
+    } break;
+    }
+}
+// ------------------------------------------------------------
+void SpellCheck::OnStcModified(wxStyledTextEvent& e)
+{
+    e.Skip();
+    if(!GetCheckContinuous()) return;
 
-        switch(editor->GetLexerId()) {
-        case wxSTC_LEX_CPP: {
-            if(m_mgr->IsWorkspaceOpen()) {
-                m_pEngine->CheckCppSpelling(editor->GetEditorText());
-            }
-        } break;
-        default: {
-            m_pEngine->CheckSpelling(editor->GetEditorText());
-        } break;
+    const int modType = e.GetModificationType();
+    if(!(modType & (wxSTC_MOD_INSERTTEXT | wxSTC_MOD_DELETETEXT))) return;
+
+    // The handler sees the modifications of every STC (output, build and find panes...): only the active
+    // editor is tracked
+    wxStyledTextCtrl* ctrl = dynamic_cast<wxStyledTextCtrl*>(e.GetEventObject());
+    if(!ctrl) return;
+    IEditor* editor = m_mgr->GetActiveEditor();
+    if(!editor || editor->GetCtrl() != ctrl) return;
+
+    if(ctrl != m_dirtyCtrl) {
+        // Only the modifications of a single editor are tracked, switching editors triggers a check anyway
+        m_dirtyCtrl = ctrl;
+        m_dirtyStart = m_dirtyEnd = -1;
+    }
+
+    const int pos = e.GetPosition();
+    const int len = e.GetLength();
+    if(modType & wxSTC_MOD_INSERTTEXT) {
+        if(m_dirtyStart == -1) {
+            m_dirtyStart = pos;
+            m_dirtyEnd = pos + len;
+        } else {
+            if(m_dirtyEnd >= pos) m_dirtyEnd += len;
+            m_dirtyStart = std::min(m_dirtyStart, pos);
+            m_dirtyEnd = std::max(m_dirtyEnd, pos + len);
+        }
+    } else {
+        if(m_dirtyStart == -1) {
+            m_dirtyStart = m_dirtyEnd = pos;
+        } else {
+            if(m_dirtyEnd > pos) m_dirtyEnd = std::max(pos, m_dirtyEnd - len);
+            if(m_dirtyStart > pos) m_dirtyStart = std::max(pos, m_dirtyStart - len);
+            m_dirtyStart = std::min(m_dirtyStart, pos);
+            m_dirtyEnd = std::max(m_dirtyEnd, pos);
         }
     }
 }
@@ -462,10 +545,15 @@ void SpellCheck::SetCheckContinuous(bool value)
 void SpellCheck::OnWspLoaded(wxCommandEvent& e)
 {
     m_currentWspPath = e.GetString();
+    m_pEngine->ClearWordCache();
     e.Skip();
 }
 // ------------------------------------------------------------
-void SpellCheck::OnWspClosed(wxCommandEvent& e) { e.Skip(); }
+void SpellCheck::OnWspClosed(wxCommandEvent& e)
+{
+    m_pEngine->ClearWordCache();
+    e.Skip();
+}
 // ------------------------------------------------------------
 void SpellCheck::OnSuggestion(wxCommandEvent& e)
 {
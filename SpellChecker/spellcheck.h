@@ -40,6 +40,7 @@
 #include "spellcheckeroptions.h"
 #include <wx/timer.h>
 #include "cl_command_event.h"
+#include <wx/stc/stc.h>
 //------------------------------------------------------------
 class IHunSpell;
 class SpellCheck : public IPlugin
@@ -82,7 +83,10 @@ protected:
     void SaveSettings();
     void ClearIndicatorsFromEditors();
     void OnContextMenu(clContextMenuEvent& e);
+    void OnStcModified(wxStyledTextEvent& e);
     void AppendSubMenuItems(wxMenu& subMenu);
+    void DoContinuousCheck(IEditor* editor);
+    void DoCheckRange(IEditor* editor, int startPos, int endPos);
 
 protected:
     IHunSpell* m_pEngine;
@@ -92,6 +96,10 @@ protected:
 
     IEditor* m_pLastEditor;             // The editor checked last time the spell check ran.
     wxUint64 m_lastModificationCount;   // Modification count of the editor last time the spell check ran.
+    int m_lastFirstVisibleLine;         // First visible line of the editor last time the spell check ran.
+    wxStyledTextCtrl* m_dirtyCtrl;      // The control that received the modifications below.
+    int m_dirtyStart;                   // Start of the range modified since the last check, -1 if none.
+    int m_dirtyEnd;                     // End of the range modified since the last check.
 };
 //------------------------------------------------------------
 #endif // SpellCheck
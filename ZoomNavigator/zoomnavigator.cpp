@@ -88,7 +88,6 @@ ZoomNavigator::ZoomNavigator(IManager* manager)
 
     m_topWindow->Connect(wxEVT_IDLE, wxIdleEventHandler(ZoomNavigator::OnIdle), NULL, this);
     EventNotifier::Get()->Connect(wxEVT_INIT_DONE, wxCommandEventHandler(ZoomNavigator::OnInitDone), NULL, this);
-    EventNotifier::Get()->Connect(wxEVT_FILE_SAVED, clCommandEventHandler(ZoomNavigator::OnFileSaved), NULL, this);
     EventNotifier::Get()->Connect(wxEVT_ZN_SETTINGS_UPDATED, wxCommandEventHandler(ZoomNavigator::OnSettingsChanged),
                                   NULL, this);
     m_topWindow->Connect(XRCID("zn_settings"), wxEVT_COMMAND_MENU_SELECTED,
@@ -104,7 +103,6 @@ void ZoomNavigator::UnPlug()
     EventNotifier::Get()->Disconnect(wxEVT_INIT_DONE, wxCommandEventHandler(ZoomNavigator::OnInitDone), NULL, this);
     EventNotifier::Get()->Disconnect(wxEVT_ZN_SETTINGS_UPDATED, wxCommandEventHandler(ZoomNavigator::OnSettingsChanged),
                                      NULL, this);
-    EventNotifier::Get()->Disconnect(wxEVT_FILE_SAVED, clCommandEventHandler(ZoomNavigator::OnFileSaved), NULL, this);
 
     m_topWindow->Disconnect(wxEVT_IDLE, wxIdleEventHandler(ZoomNavigator::OnIdle), NULL, this);
     m_topWindow->Disconnect(XRCID("zn_settings"), wxEVT_COMMAND_MENU_SELECTED,
@@ -118,6 +116,9 @@ void ZoomNavigator::UnPlug()
         m_mgr->GetWorkspacePaneNotebook()->RemovePage(index);
     }
     zoompane->Destroy();
+
+    // Writes any pending change
+    wxDELETE(m_config);
 }
 
 clToolBar* ZoomNavigator::CreateToolBar(wxWindow* parent)
@@ -199,7 +200,9 @@ void ZoomNavigator::DoUpdate()
     wxStyledTextCtrl* stc = curEditor->GetCtrl();
     CHECK_CONDITION(stc);
 
-    if(curEditor->GetFileName().GetFullPath() != m_curfile) {
+    // The preview shares the editor's document, so it is always up to date. We only need to re-attach
+    // when switching editors, or re-apply the lexer when the file was renamed
+    if(!m_text->IsAttachedTo(stc) || curEditor->GetFileName().GetFullPath() != m_curfile) {
         SetEditorText(curEditor);
     }
 
@@ -216,6 +219,9 @@ void ZoomNavigator::SetEditorText(IEditor* editor)
 {
     m_curfile.Clear();
     m_text->UpdateText(editor);
+    // Switching documents clears the highlight
+    m_markerFirstLine = wxNOT_FOUND;
+    m_markerLastLine = wxNOT_FOUND;
     if(editor) {
         m_curfile = editor->GetFileName().GetFullPath();
         m_text->UpdateLexer(editor);
@@ -235,7 +241,6 @@ void ZoomNavigator::SetZoomTextScrollPosToMiddle(wxStyledTextCtrl* stc)
     if(first < 0) first = 0;
 
     m_text->SetFirstVisibleLine(first);
-    m_text->ClearSelections();
 }
 
 void ZoomNavigator::PatchUpHighlights(const int first, const int last)
@@ -311,17 +316,6 @@ void ZoomNavigator::OnSettingsChanged(wxCommandEvent& e)
     }
 }
 
-void ZoomNavigator::OnFileSaved(clCommandEvent& e)
-{
-    e.Skip();
-
-    if(e.GetString() == m_curfile) {
-        // Update the file content
-        m_curfile.Clear();
-        DoUpdate();
-    }
-}
-
 void ZoomNavigator::OnWorkspaceClosed(wxCommandEvent& e)
 {
     e.Skip();
@@ -345,7 +339,6 @@ void ZoomNavigator::OnInitDone(wxCommandEvent& e)
 {
     e.Skip();
     m_startupCompleted = true;
-    m_text->Startup();
 }
 
 void ZoomNavigator::OnIdle(wxIdleEvent& e)
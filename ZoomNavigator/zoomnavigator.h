@@ -84,7 +84,6 @@ public:
     void OnPreviewClicked(wxMouseEvent& e);
     void OnSettings(wxCommandEvent& e);
     void OnSettingsChanged(wxCommandEvent& e);
-    void OnFileSaved(clCommandEvent& e);
     void OnWorkspaceClosed(wxCommandEvent& e);
     void OnEnablePlugin(wxCommandEvent& e);
     void OnInitDone(wxCommandEvent& e);
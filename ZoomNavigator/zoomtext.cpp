@@ -52,39 +52,46 @@ ZoomText::ZoomText(wxWindow* parent,
                    long style,
                    const wxString& name)
     : wxStyledTextCtrl(parent, id, pos, size, style | wxNO_BORDER, name)
+    , m_highlightAlpha(10)
 {
     znConfigItem data;
     clConfig conf("zoom-navigator.conf");
     conf.ReadItem(&data);
     
-    SetEditable(false);
     SetUseHorizontalScrollBar(false);
     SetUseVerticalScrollBar(data.IsUseScrollbar());
-    HideSelection(true);
 
     SetMarginWidth(1, 0);
     SetMarginWidth(2, 0);
     SetMarginWidth(3, 0);
 
+    // The document is shared with the editor: make sure nothing in this view can modify it
+    UsePopUp(false);
+    SetDropTarget(NULL);
+    Bind(wxEVT_KEY_DOWN, &ZoomText::OnKeyDown, this);
+    Bind(wxEVT_MIDDLE_DOWN, &ZoomText::OnMiddleClick, this);
+    Bind(wxEVT_MIDDLE_UP, &ZoomText::OnMiddleClick, this);
+
+    // Markers and indicators are stored in the document: hide the editor's ones
+    for(int i = 0; i <= wxSTC_INDIC_MAX; ++i) {
+        IndicatorSetStyle(i, wxSTC_INDIC_HIDDEN);
+    }
+    SetCaretWidth(0);
 
     m_zoomFactor = data.GetZoomFactor();
     m_colour = data.GetHighlightColour();
-    MarkerSetBackground(1, m_colour);
+    DoUpdateHighlightColour();
     SetZoom(m_zoomFactor);
     EventNotifier::Get()->Connect(
         wxEVT_ZN_SETTINGS_UPDATED, wxCommandEventHandler(ZoomText::OnSettingsChanged), NULL, this);
     EventNotifier::Get()->Connect(wxEVT_CL_THEME_CHANGED, wxCommandEventHandler(ZoomText::OnThemeChanged), NULL, this);
-    MarkerDefine(1, wxSTC_MARK_BACKGROUND, m_colour, m_colour);
 
 #ifndef __WXMSW__
     SetTwoPhaseDraw(false);
     SetBufferedDraw(false);
-    SetLayoutCache(wxSTC_CACHE_DOCUMENT);
+    // Caching the layout of the whole document costs as much memory as the document itself
+    SetLayoutCache(wxSTC_CACHE_PAGE);
 #endif
-    MarkerSetAlpha(1, 10);
-    
-    m_timer = new wxTimer(this);
-    Bind(wxEVT_TIMER, &ZoomText::OnTimer, this, m_timer->GetId());
 }
 
 ZoomText::~ZoomText()
@@ -93,12 +100,9 @@ ZoomText::~ZoomText()
         wxEVT_ZN_SETTINGS_UPDATED, wxCommandEventHandler(ZoomText::OnSettingsChanged), NULL, this);
     EventNotifier::Get()->Disconnect(
         wxEVT_CL_THEME_CHANGED, wxCommandEventHandler(ZoomText::OnThemeChanged), NULL, this);
-    Unbind(wxEVT_TIMER, &ZoomText::OnTimer, this, m_timer->GetId());
-    
-    if(m_timer->IsRunning()) {
-        m_timer->Stop();
-    }
-    wxDELETE(m_timer);
+    Unbind(wxEVT_KEY_DOWN, &ZoomText::OnKeyDown, this);
+    Unbind(wxEVT_MIDDLE_DOWN, &ZoomText::OnMiddleClick, this);
+    Unbind(wxEVT_MIDDLE_UP, &ZoomText::OnMiddleClick, this);
 }
 
 void ZoomText::UpdateLexer(IEditor* editor)
@@ -120,20 +124,23 @@ void ZoomText::UpdateLexer(IEditor* editor)
     if(!lexer) {
         lexer = EditorConfigST::Get()->GetLexer("Text");
     }
-    lexer->Apply(this, true);
 
-    if(lexer->IsDark()) {
-        MarkerSetAlpha(1, 10);
-    } else {
-        MarkerSetAlpha(1, 20);
-    }
+    // The lexer, its keywords and properties belong to the document which is owned by the editor.
+    // Apply the styles while the view holds a private document so the editor settings are left untouched.
+    // The styles themselves (colours, fonts) are per view and are kept when the document is attached again
+    void* doc = GetDocPointer();
+    AddRefDocument(doc);
+    SetDocPointer(NULL);
+    lexer->Apply(this, true);
+    SetDocPointer(doc);
+    ReleaseDocument(doc);
 
+    m_highlightAlpha = lexer->IsDark() ? 10 : 20;
     SetZoom(m_zoomFactor);
-    SetEditable(false);
     SetUseHorizontalScrollBar(false);
     SetUseVerticalScrollBar(data.IsUseScrollbar());
-    HideSelection(true);
-    MarkerSetBackground(1, m_colour);
+    SetCaretWidth(0);
+    DoUpdateHighlightColour();
 }
 
 void ZoomText::OnSettingsChanged(wxCommandEvent& e)
@@ -144,9 +151,8 @@ void ZoomText::OnSettingsChanged(wxCommandEvent& e)
     if(conf.ReadItem(&data)) {
         m_zoomFactor = data.GetZoomFactor();
         m_colour = data.GetHighlightColour();
-        MarkerSetBackground(1, m_colour);
+        DoUpdateHighlightColour();
         SetZoom(m_zoomFactor);
-        Colourise(0, wxSTC_INVALID_POSITION);
     }
 }
 
@@ -155,11 +161,9 @@ void ZoomText::UpdateText(IEditor* editor)
     if(!editor) {
         DoClear();
 
-    } else {
-        SetReadOnly(false);
-        SetText(editor->GetEditorText());
-        SetReadOnly(true);
-        SetCurrentPos(editor->GetCurrentPosition());
+    } else if(!IsAttachedTo(editor->GetCtrl())) {
+        // Share the editor's document (this also keeps it alive until we detach from it)
+        SetDocPointer(editor->GetCtrl()->GetDocPointer());
     }
 }
 
@@ -173,10 +177,10 @@ void ZoomText::HighlightLines(int start, int end)
         if(start < 0) start = 0;
     }
 
-    MarkerDeleteAll(1);
-    for(int i = start; i <= end; ++i) {
-        MarkerAdd(i, 1);
-    }
+    // Unlike markers, the selection is not stored in the document. Don't use SetSelection() here as it
+    // would scroll the view
+    SetCurrentPos(GetLineEndPosition(end));
+    SetAnchor(PositionFromLine(start));
 }
 
 void ZoomText::OnThemeChanged(wxCommandEvent& e)
@@ -185,40 +189,29 @@ void ZoomText::OnThemeChanged(wxCommandEvent& e)
     UpdateLexer(NULL);
 }
 
-void ZoomText::OnTimer(wxTimerEvent& event)
+void ZoomText::OnKeyDown(wxKeyEvent& e)
 {
-    // sanity
-    if(!m_classes.IsEmpty() || IsEmpty()) {
-        m_timer->Start(1000, true);
-        return;
-    }
+    // The view is read only. Note that we can't use SetReadOnly() as it applies to the document
+    wxUnusedVar(e);
+}
     
-    IEditor* editor = clGetManager()->GetActiveEditor();
-    if(!editor) {
-        m_timer->Start(1000, true);
-        return;
-    }
-
-    if(m_classes.IsEmpty() && !editor->GetKeywordClasses().IsEmpty() &&
-       (editor->GetFileName().GetFullPath() == m_filename)) {
-        // Sync between the keywords
-        SetKeyWords(1, editor->GetKeywordClasses()); // classes
-        SetKeyWords(3, editor->GetKeywordLocals());  // locals
-        Colourise(0, GetLength());
-    }
-    m_timer->Start(1000, true);
+void ZoomText::OnMiddleClick(wxMouseEvent& e)
+{
+    // Don't let the primary selection be pasted into the document
+    wxUnusedVar(e);
 }
 
-void ZoomText::DoClear()
+void ZoomText::DoUpdateHighlightColour()
 {
-    m_classes.clear();
-    m_locals.clear();
-    SetReadOnly(false);
-    SetText("");
-    SetReadOnly(true);
+    HideSelection(false);
+    SetSelBackground(true, m_colour);
+    SetSelAlpha(m_highlightAlpha);
+    SetSelEOLFilled(true);
 }
 
-void ZoomText::Startup()
+void ZoomText::DoClear()
 {
-    m_timer->Start(1000, true);
+    // Release the editor's document and switch to an empty one
+    m_filename.clear();
+    SetDocPointer(NULL);
 }
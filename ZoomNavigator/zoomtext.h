@@ -36,19 +36,25 @@
 #include <wx/stc/stc.h>
 #include "ieditor.h"
 
+/**
+ * @class ZoomText
+ * @brief a zoomed out view of the active editor. The view shares the editor's Scintilla document (text, styling
+ * and lexer state) instead of holding a copy of it, so it must never modify it: the keyboard, the context menu
+ * and drag & drop are disabled, and the visible lines are highlighted with the (per view) selection
+ */
 class ZoomText : public wxStyledTextCtrl
 {
     int m_zoomFactor;
     wxColour m_colour;
     wxString m_filename;
-    wxString m_classes;
-    wxString m_locals;
-    wxTimer* m_timer;
+    int m_highlightAlpha;
     
 protected:
     void OnThemeChanged(wxCommandEvent& e);
-    void OnTimer(wxTimerEvent& event);
+    void OnKeyDown(wxKeyEvent& e);
+    void OnMiddleClick(wxMouseEvent& e);
     void DoClear();
+    void DoUpdateHighlightColour();
     
 public:
     ZoomText(wxWindow* parent,
@@ -60,10 +66,15 @@ public:
     virtual ~ZoomText();
     void UpdateLexer(IEditor* editor);
     void OnSettingsChanged(wxCommandEvent& e);
+    /**
+     * @brief attach the view to the editor's document. Passing NULL detaches it
+     */
     void UpdateText(IEditor* editor);
+    /**
+     * @brief return true if the view is showing the document of 'stc'
+     */
+    bool IsAttachedTo(wxStyledTextCtrl* stc) { return stc && (stc->GetDocPointer() == GetDocPointer()); }
     void HighlightLines(int start, int end);
-    
-    void Startup();
 };
 
 #endif // ZOOM_NAV_TEXT
@@ -30,50 +30,35 @@ extern int ExecuteProcessWIN(const std::string& commandline);
 #include <string.h>
 #include <string>
 #include <sys/wait.h>
-#include <sys/file.h>
-#include <sys/stat.h>
+#include <fcntl.h>
 #include <sys/stat.h>
 
-void WriteContent( const std::string& logfile, const std::string& filename, const std::string& flags )
+void WriteContent( const std::string& logfile, const std::string& content )
 {
-    // Open the file
-    int fd = ::open(logfile.c_str(), O_CREAT|O_APPEND, 0660);
-    ::chmod(logfile.c_str(), 0660);
-
-    // Lock it
+    // No locking: with O_APPEND the kernel moves the file offset to the end and writes the
+    // record as a single operation, so parallel compilations never wait for each other and
+    // their records never interleave
+    int fd = ::open(logfile.c_str(), O_WRONLY|O_CREAT|O_APPEND, 0660);
     if ( fd < 0 )
         return;
 
-    if(::flock(fd, LOCK_EX) < 0) {
-        return;
-    }
-
-    char cwd[1024];
-    memset(cwd, 0, sizeof(cwd));
-    char* pcwd = ::getcwd(cwd, sizeof(cwd));
-    (void) pcwd;
-
-    std::string line = filename + "|" + cwd + "|" + flags + "\n";
-
-    FILE* fp = fopen(logfile.c_str(), "a+b");
-    if ( !fp ) {
-        perror("fopen");
+    const char* p = content.c_str();
+    size_t left = content.length();
+    while ( left > 0 ) {
+        ssize_t written = ::write(fd, p, left);
+        if ( written < 0 ) {
+            if ( errno == EINTR )
+                continue;
+            break;
+        }
+        p += written;
+        left -= written;
     }
-
-    // Write the content
-    ::fprintf(fp, "%s", line.c_str());
-    ::fflush(fp);
-    ::fclose(fp);
-
-    // Release the lock
-    ::flock(fd, LOCK_UN);
-
-    // close the fd
     ::close(fd);
 }
 
 #endif
-extern void WriteContent( const std::string& logfile, const std::string& filename, const std::string& flags );
+extern void WriteContent( const std::string& logfile, const std::string& content );
 
 // A thin wrapper around gcc
 // Its soul purpose is to parse gcc's output and to store the parsed output
@@ -113,16 +98,26 @@ int main(int argc, char **argv)
         commandline += arg + " ";
     }
 
-    if ( pdb ) {
+    if ( pdb && !file_names.empty() ) {
+        char cwd[4096];
+        memset(cwd, 0, sizeof(cwd));
+        char* pcwd = ::getcwd(cwd, sizeof(cwd));
+        (void) pcwd;
+
+        // All the records of this invocation are written with a single append.
+        // Duplicate records (the same file compiled again) are removed by CodeLite when
+        // it compacts the log
+        std::string content;
         for(size_t i=0; i<file_names.size(); ++i) {
 #if __DEBUG
             printf("filename: %s\n", file_names.at(i).c_str());
 #endif
-            std::string logfile = pdb;
-            logfile += ".txt";
+            content += file_names.at(i) + "|" + cwd + "|" + commandline + "\n";
+        }
 
-            WriteContent(logfile, file_names.at(i), commandline);
-        }
+        std::string logfile = pdb;
+        logfile += ".txt";
+        WriteContent(logfile, content);
     }
 
 #ifdef _WIN32
@@ -28,50 +28,22 @@ int ExecuteProcessWIN(const std::string& commandline)
     return ret;
 }
 
-void WriteContent( const std::string& logfile, const std::string& filename, const std::string& flags )
+void WriteContent( const std::string& logfile, const std::string& content )
 {
-    // Open the file
+    // Open the file for append only access: each WriteFile() is then performed at the current end
+    // of the file as a single operation, so there is no need to lock the file
     HANDLE hFile = ::CreateFile(logfile.c_str(),
-                                GENERIC_WRITE,
-                                FILE_SHARE_WRITE,
+                                FILE_APPEND_DATA,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
                                 NULL,
                                 OPEN_ALWAYS,
                                 FILE_ATTRIBUTE_NORMAL,
                                 NULL);
-    if( !hFile )
+    if( hFile == INVALID_HANDLE_VALUE )
         return;
 
-    OVERLAPPED ov;
-    memset(&ov, 0, sizeof(ov));
-    ov.hEvent = 0x0;
-    ov.Offset = UINT_MAX;
-    // Obtain the lock over the file
-    BOOL res = ::LockFileEx(hFile,
-                            LOCKFILE_EXCLUSIVE_LOCK,
-                            0,                       // must be 0
-                            UINT_MAX,                // number of bytes to lock
-                            0,                       // crap, set it 0
-                            &ov);
-    //int error = GetLastError();
-    if ( !res ) {
-        ::CloseHandle(hFile);
-        return;
-    }
-
-    // Move the write pointer to the end
-    ::SetFilePointer(hFile, 0, NULL, FILE_END);
-
-    char cwd[1024];
-    memset(cwd, 0, sizeof(cwd));
-    ::getcwd(cwd, sizeof(cwd));
-
-    std::string line = filename + "|" + cwd + "|" + flags + "\n";
-
     DWORD dwBytesWritten = 0;
-    ::WriteFile(hFile, line.c_str(), line.length(), &dwBytesWritten, NULL);
-
-    // Unlock the entire file
-    ::UnlockFile(hFile, 0, 0, UINT_MAX, 0);
+    ::WriteFile(hFile, content.c_str(), content.length(), &dwBytesWritten, NULL);
     ::CloseHandle(hFile);
 }
 
@@ -0,0 +1,267 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2018 Eran Ifrah
+// file name            : cppcheck_result_cache.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "cppcheck_result_cache.h"
+#include "file_logger.h"
+#include "fileutils.h"
+#include "json_node.h"
+#include <unordered_set>
+
+wxDEFINE_EVENT(wxEVT_CPPCHECK_KEYS_READY, wxCommandEvent);
+
+namespace
+{
+/**
+ * @brief return the files named by the #include directives of 'content'
+ */
+void ScanIncludes(const wxString& content, wxArrayString& quoted, wxArrayString& angled)
+{
+    size_t pos = 0;
+    while((pos = content.find("include", pos)) != wxString::npos) {
+        size_t start = pos;
+        pos += 7;
+
+        // Make sure this is a preprocessor line: only spaces and '#' before the "include" word
+        size_t lineStart = content.rfind('\n', start);
+        lineStart = (lineStart == wxString::npos) ? 0 : lineStart + 1;
+        wxString prefix = content.Mid(lineStart, start - lineStart);
+        prefix.Trim().Trim(false);
+        if(prefix != "#") { continue; }
+
+        size_t open = content.find_first_not_of(" \t", pos);
+        if(open == wxString::npos) { break; }
+        wxChar closeChar = (content[open] == '"') ? '"' : ((content[open] == '<') ? '>' : 0);
+        if(closeChar == 0) { continue; }
+        size_t close = content.find(closeChar, open + 1);
+        if(close == wxString::npos || content.find('\n', open) < close) { continue; }
+
+        wxString name = content.Mid(open + 1, close - open - 1);
+        (closeChar == '"') ? quoted.Add(name) : angled.Add(name);
+        pos = close;
+    }
+}
+
+// JSONElement stores numbers as int: keep the hashes as strings
+wxString HashToString(wxULongLong_t hash) { return wxString::Format("%" wxLongLongFmtSpec "x", hash); }
+
+wxULongLong_t StringToHash(const wxString& str)
+{
+    wxULongLong_t hash = 0;
+    str.ToULongLong(&hash, 16);
+    return hash;
+}
+} // namespace
+
+CppCheckResultCache::CppCheckResultCache()
+    : m_modified(false)
+{
+}
+
+CppCheckResultCache::~CppCheckResultCache() {}
+
+bool CppCheckResultCache::Find(const wxString& file, const Key& key, wxArrayString& report) const
+{
+    std::unordered_map<wxString, Entry>::const_iterator iter = m_entries.find(file);
+    if(iter == m_entries.end() || !(iter->second.m_key == key)) { return false; }
+    report = iter->second.m_report;
+    return true;
+}
+
+void CppCheckResultCache::Update(const wxString& file, const Key& key, const wxArrayString& report)
+{
+    Entry& entry = m_entries[file];
+    entry.m_key = key;
+    entry.m_report = report;
+    m_modified = true;
+}
+
+void CppCheckResultCache::Clear()
+{
+    m_entries.clear();
+    m_fileName.Clear();
+    m_modified = false;
+}
+
+void CppCheckResultCache::Load(const wxFileName& fileName)
+{
+    Clear();
+    m_fileName = fileName;
+    if(!fileName.FileExists()) { return; }
+
+    JSONRoot root(fileName);
+    JSONElement files = root.toElement().namedObject("files");
+    int count = files.arraySize();
+    for(int i = 0; i < count; ++i) {
+        JSONElement file = files.arrayItem(i);
+        Entry entry;
+        entry.m_key.m_contentHash = StringToHash(file.namedObject("contentHash").toString());
+        entry.m_key.m_includesHash = (size_t)StringToHash(file.namedObject("includesHash").toString());
+        entry.m_key.m_settingsHash = (size_t)StringToHash(file.namedObject("settingsHash").toString());
+        entry.m_report = file.namedObject("report").toArrayString();
+        m_entries.insert(std::make_pair(file.namedObject("file").toString(), entry));
+    }
+    clDEBUG() << "CppCheck: loaded" << m_entries.size() << "cached results from" << fileName << clEndl;
+}
+
+void CppCheckResultCache::Save()
+{
+    if(!m_modified || !m_fileName.IsOk()) { return; }
+
+    JSONRoot root(cJSON_Object);
+    JSONElement files = JSONElement::createArray("files");
+    root.toElement().append(files);
+    std::unordered_map<wxString, Entry>::const_iterator iter = m_entries.begin();
+    for(; iter != m_entries.end(); ++iter) {
+        JSONElement file = JSONElement::createObject();
+        file.addProperty("file", iter->first);
+        file.addProperty("contentHash", HashToString(iter->second.m_key.m_contentHash));
+        file.addProperty("includesHash", HashToString(iter->second.m_key.m_includesHash));
+        file.addProperty("settingsHash", HashToString(iter->second.m_key.m_settingsHash));
+        file.addProperty("report", iter->second.m_report);
+        files.arrayAppend(file);
+    }
+    root.save(m_fileName);
+    m_modified = false;
+}
+
+wxString CppCheckResultCache::GetFileFromReportLine(const wxString& line)
+{
+    // file:line: severity: message. Skip the colon of a drive letter
+    size_t pos = (line.length() > 2 && line[1] == ':') ? 2 : 0;
+    while((pos = line.find(':', pos)) != wxString::npos) {
+        size_t end = pos + 1;
+        while(end < line.length() && wxIsdigit(line[end])) {
+            ++end;
+        }
+        if(end > (pos + 1) && end < line.length() && line[end] == ':') { return line.Left(pos); }
+        pos = end;
+    }
+    return wxEmptyString;
+}
+
+CppCheckKeysThread::CppCheckKeysThread(wxEvtHandler* owner, const wxArrayString& files,
+                                       const wxArrayString& includePaths, size_t settingsHash)
+    : wxThread(wxTHREAD_JOINABLE)
+    , m_owner(owner)
+    , m_settingsHash(settingsHash)
+{
+    // Deep copies: the strings are used by the thread
+    for(size_t i = 0; i < files.size(); ++i) {
+        m_files.Add(files.Item(i).c_str());
+    }
+    for(size_t i = 0; i < includePaths.size(); ++i) {
+        m_includePaths.Add(includePaths.Item(i).c_str());
+    }
+}
+
+CppCheckKeysThread::~CppCheckKeysThread() {}
+
+void* CppCheckKeysThread::Entry()
+{
+    for(size_t i = 0; i < m_files.size(); ++i) {
+        if(TestDestroy()) { return NULL; }
+        wxFileName fn(m_files.Item(i));
+        fn.Normalize();
+        wxString file = fn.GetFullPath();
+        m_keys.push_back(std::make_pair(file, DoGetKey(file)));
+    }
+
+    wxCommandEvent event(wxEVT_CPPCHECK_KEYS_READY);
+    event.SetClientData(this);
+    m_owner->AddPendingEvent(event);
+    return NULL;
+}
+
+const wxArrayString& CppCheckKeysThread::DoGetIncludes(const wxString& file)
+{
+    std::unordered_map<wxString, wxArrayString>::const_iterator iter = m_includesMemo.find(file);
+    if(iter != m_includesMemo.end()) { return iter->second; }
+
+    wxArrayString& includes = m_includesMemo[file];
+    wxString content;
+    if(!FileUtils::ReadFileContent(file, content)) { return includes; }
+
+    wxArrayString quoted, angled;
+    ScanIncludes(content, quoted, angled);
+
+    // Resolve the names the way the preprocessor does: "" includes are searched first next to the file.
+    // Files that can not be found (e.g. system headers) are ignored, cppcheck does not see them either
+    wxString currentDir = wxFileName(file).GetPath();
+    for(size_t i = 0; i < quoted.size() + angled.size(); ++i) {
+        bool isQuoted = (i < quoted.size());
+        const wxString& name = isQuoted ? quoted.Item(i) : angled.Item(i - quoted.size());
+        if(isQuoted) {
+            wxFileName fn(currentDir + wxFILE_SEP_PATH + name);
+            if(fn.FileExists()) {
+                fn.Normalize();
+                includes.Add(fn.GetFullPath());
+                continue;
+            }
+        }
+        for(size_t j = 0; j < m_includePaths.size(); ++j) {
+            wxFileName fn(m_includePaths.Item(j) + wxFILE_SEP_PATH + name);
+            if(fn.FileExists()) {
+                fn.Normalize();
+                includes.Add(fn.GetFullPath());
+                break;
+            }
+        }
+    }
+    return includes;
+}
+
+CppCheckResultCache::Key CppCheckKeysThread::DoGetKey(const wxString& file)
+{
+    CppCheckResultCache::Key key;
+    key.m_contentHash = FileUtils::GetFileHash(file);
+    key.m_settingsHash = m_settingsHash;
+
+    // Walk the include closure
+    std::unordered_set<wxString> visited;
+    std::vector<wxString> queue;
+    queue.push_back(file);
+    visited.insert(file);
+    wxString state;
+    while(!queue.empty()) {
+        wxString current = queue.back();
+        queue.pop_back();
+
+        const wxArrayString& includes = DoGetIncludes(current);
+        for(size_t i = 0; i < includes.size(); ++i) {
+            if(visited.insert(includes.Item(i)).second) {
+                queue.push_back(includes.Item(i));
+                key.m_includes.Add(includes.Item(i));
+            }
+        }
+    }
+
+    key.m_includes.Sort();
+    for(size_t i = 0; i < key.m_includes.size(); ++i) {
+        state << key.m_includes.Item(i) << "|" << (long)FileUtils::GetFileModificationTime(key.m_includes.Item(i))
+              << "\n";
+    }
+    key.m_includesHash = std::hash<wxString>()(state);
+    return key;
+}
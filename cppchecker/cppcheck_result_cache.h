@@ -0,0 +1,158 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2018 Eran Ifrah
+// file name            : cppcheck_result_cache.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef CPPCHECKRESULTCACHE_H
+#define CPPCHECKRESULTCACHE_H
+
+#include "wxStringHash.h"
+#include <vector>
+#include <wx/arrstr.h>
+#include <wx/event.h>
+#include <wx/filename.h>
+#include <wx/thread.h>
+
+/**
+ * @class CppCheckResultCache
+ * @brief the cppcheck report of every file checked, kept as long as the file, the files it includes
+ * and the cppcheck options did not change.
+ * The cache is saved in the workspace private folder
+ */
+class CppCheckResultCache
+{
+public:
+    struct Key {
+        wxUint64 m_contentHash = 0;  // the file content
+        size_t m_includesHash = 0;   // the paths and the modification times of the files it includes (recursively)
+        size_t m_settingsHash = 0;   // the cppcheck options
+        wxArrayString m_includes;    // the files it includes (recursively)
+
+        bool operator==(const Key& other) const
+        {
+            return m_contentHash == other.m_contentHash && m_includesHash == other.m_includesHash &&
+                   m_settingsHash == other.m_settingsHash;
+        }
+    };
+
+protected:
+    struct Entry {
+        Key m_key;
+        wxArrayString m_report;
+    };
+
+    std::unordered_map<wxString, Entry> m_entries;
+    wxFileName m_fileName;
+    bool m_modified;
+
+public:
+    CppCheckResultCache();
+    virtual ~CppCheckResultCache();
+
+    /**
+     * @brief load the cache from the disk (replacing the current content)
+     */
+    void Load(const wxFileName& fileName);
+    void Save();
+    void Clear();
+    const wxFileName& GetFileName() const { return m_fileName; }
+
+    /**
+     * @brief return the report of a file if it is still valid
+     */
+    bool Find(const wxString& file, const Key& key, wxArrayString& report) const;
+
+    /**
+     * @brief store the report of a file
+     */
+    void Update(const wxString& file, const Key& key, const wxArrayString& report);
+
+    /**
+     * @brief return the file name in a report line in the format of "--template gcc", or an empty string
+     */
+    static wxString GetFileFromReportLine(const wxString& line);
+};
+
+// Sent by CppCheckKeysThread when the keys are ready. The client data is the thread that sent it
+wxDECLARE_EVENT(wxEVT_CPPCHECK_KEYS_READY, wxCommandEvent);
+
+/**
+ * @class CppCheckKeysThread
+ * @brief computes the cache keys of the files to check. This reads and hashes every file and the files
+ * it includes, so it is not done on the main thread
+ */
+class CppCheckKeysThread : public wxThread
+{
+public:
+    typedef std::vector<std::pair<wxString, CppCheckResultCache::Key> > KeysVec_t;
+
+protected:
+    wxEvtHandler* m_owner;
+    wxArrayString m_files;
+    wxArrayString m_includePaths;
+    size_t m_settingsHash;
+    KeysVec_t m_keys;
+
+    // The files included by every header we scanned
+    std::unordered_map<wxString, wxArrayString> m_includesMemo;
+
+protected:
+    const wxArrayString& DoGetIncludes(const wxString& file);
+    CppCheckResultCache::Key DoGetKey(const wxString& file);
+
+public:
+    /**
+     * @param includePaths the include paths passed to cppcheck
+     * @param settingsHash the hash of the cppcheck options
+     */
+    CppCheckKeysThread(wxEvtHandler* owner, const wxArrayString& files, const wxArrayString& includePaths,
+                       size_t settingsHash);
+    virtual ~CppCheckKeysThread();
+
+    virtual void* Entry();
+    void Start()
+    {
+        Create();
+        Run();
+    }
+
+    /**
+     * @brief stop the thread and wait for it
+     */
+    void Stop()
+    {
+        if(IsAlive()) {
+            Delete(NULL, wxTHREAD_WAIT_BLOCK);
+        } else {
+            Wait(wxTHREAD_WAIT_BLOCK);
+        }
+    }
+
+    /**
+     * @brief the normalized path and the key of each file, in the order they were given.
+     * Valid once wxEVT_CPPCHECK_KEYS_READY was received
+     */
+    const KeysVec_t& GetKeys() const { return m_keys; }
+};
+
+#endif // CPPCHECKRESULTCACHE_H
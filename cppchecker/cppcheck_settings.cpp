@@ -28,6 +28,7 @@
 #include <memory>
 #include <wx/stdpaths.h>
 #include <wx/tokenzr.h>
+#include <wx/thread.h>
 #include "cppcheck_settings.h"
 #include "plugin.h"
 #include <stdio.h>
@@ -60,6 +61,8 @@ CppCheckSettings::CppCheckSettings()
     , m_Force(false)
     , m_Jobs(1)
     , m_CheckConfig(false)
+    , m_Incremental(true)
+    , m_RunOnSave(false)
     , m_saveSuppressedWarnings(false)
     , m_SuppressSystemIncludes(false)
     , m_saveIncludeDirs(false)
@@ -79,6 +82,8 @@ void CppCheckSettings::Serialize(Archive& arch)
     arch.Write(wxT("option.cpp11Standards"), m_Cpp11Standards);
     arch.Write(wxT("option.force"), m_Force);
     arch.Write(wxT("option.jobs"), m_Jobs);
+    arch.Write(wxT("option.incremental"), m_Incremental);
+    arch.Write(wxT("option.runOnSave"), m_RunOnSave);
     arch.Write(wxT("m_excludeFiles"), m_excludeFiles);
 
     if(m_saveSuppressedWarnings) {
@@ -114,6 +119,8 @@ void CppCheckSettings::DeSerialize(Archive& arch)
     arch.Read(wxT("option.cpp11Standards"), m_Cpp11Standards);
     arch.Read(wxT("option.force"), m_Force);
     arch.Read(wxT("option.jobs"), m_Jobs);
+    arch.Read(wxT("option.incremental"), m_Incremental);
+    arch.Read(wxT("option.runOnSave"), m_RunOnSave);
 
     arch.Read(wxT("m_excludeFiles"), m_excludeFiles);
 
@@ -173,6 +180,12 @@ void CppCheckSettings::RemoveSuppressedWarning(const wxString& key)
     m_SuppressedWarnings1.erase(key);
 }
 
+int CppCheckSettings::GetJobsCount() const
+{
+    if(!GetIncremental()) { return GetJobs(); }
+    return wxMax(GetJobs(), wxThread::GetCPUCount());
+}
+
 wxString CppCheckSettings::GetOptions() const
 {
     wxString options;
@@ -185,7 +198,8 @@ wxString CppCheckSettings::GetOptions() const
     if(GetPortability()) {
         options << wxT(" --enable=portability ");
     }
-    if(GetUnusedFunctions()) {
+    // unusedFunction is a whole program check: it can not be done on a subset of the files (nor with -j)
+    if(GetUnusedFunctions() && !GetIncremental()) {
         options << wxT(" --enable=unusedFunction ");
     }
     if(GetMissingIncludes()) {
@@ -206,8 +220,8 @@ wxString CppCheckSettings::GetOptions() const
     if(GetForce()) {
         options << wxT("--force ");
     }
-    if(GetJobs() > 1) {
-        options << wxT("-j") << GetJobs() << " ";
+    if(GetJobsCount() > 1) {
+        options << wxT("-j") << GetJobsCount() << " ";
     }
     if(GetCheckConfig()) {
         options << wxT("--check-config "); // Though this turns off other checks, afaict it does not harm to emit them
@@ -53,6 +53,8 @@ class CppCheckSettings : public SerializedObject
     bool m_Force;
     int m_Jobs;
     bool m_CheckConfig;
+    bool m_Incremental;
+    bool m_RunOnSave;
     wxArrayString m_excludeFiles;
     wxStringMap_t m_SuppressedWarnings0;     // The items unchecked in the checklistbox
     wxStringMap_t m_SuppressedWarnings1;     // The checked ones
@@ -80,6 +82,8 @@ public:
     bool GetForce() const { return m_Force; }
     int GetJobs() const { return m_Jobs; }
     bool GetCheckConfig() const { return m_CheckConfig; }
+    bool GetIncremental() const { return m_Incremental; }
+    bool GetRunOnSave() const { return m_RunOnSave; }
     const wxArrayString& GetExcludeFiles() const { return m_excludeFiles; }
     const wxStringMap_t* GetSuppressedWarningsStrings0() const { return &m_SuppressedWarnings0; }
     const wxStringMap_t* GetSuppressedWarningsStrings1() const { return &m_SuppressedWarnings1; }
@@ -101,6 +105,8 @@ public:
     void SetForce(bool Force) { m_Force = Force; }
     void SetJobs(int jobs) { m_Jobs = jobs; }
     void SetCheckConfig(bool checkconfig) { m_CheckConfig = checkconfig; }
+    void SetIncremental(bool incremental) { m_Incremental = incremental; }
+    void SetRunOnSave(bool runOnSave) { m_RunOnSave = runOnSave; }
     void SetExcludeFiles(const wxArrayString& excludeFiles) { m_excludeFiles = excludeFiles; }
     void AddSuppressedWarning(const wxString& key, const wxString& label, bool checked);
     void RemoveSuppressedWarning(const wxString& key);
@@ -119,6 +125,11 @@ public:
     virtual void DeSerialize(Archive& arch);
 
     wxString GetOptions() const;
+    /**
+     * @brief return the number of jobs to pass to cppcheck. In incremental mode we use all the cores
+     * (unless the user asked for more)
+     */
+    int GetJobsCount() const;
     void LoadProjectSpecificSettings(ProjectPtr proj);
 };
 
@@ -52,6 +52,8 @@
 #include "globals.h"
 #include "file_logger.h"
 #include "macros.h"
+#include "clFilesCollector.h"
+#include "wxStringHash.h"
 
 static CppCheckPlugin* thePlugin = NULL;
 
@@ -87,11 +89,14 @@ CppCheckPlugin::CppCheckPlugin(IManager* manager)
     , m_analysisInProgress(false)
     , m_fileCount(0)
     , m_fileProcessed(1)
+    , m_analysisStopped(false)
+    , m_keysThread(NULL)
 {
     FileExtManager::Init();
 
     Bind(wxEVT_ASYNC_PROCESS_OUTPUT, &CppCheckPlugin::OnCppCheckReadData, this);
     Bind(wxEVT_ASYNC_PROCESS_TERMINATED, &CppCheckPlugin::OnCppCheckTerminated, this);
+    Bind(wxEVT_CPPCHECK_KEYS_READY, &CppCheckPlugin::OnKeysReady, this);
 
     m_longName = _("CppCheck integration for CodeLite IDE");
     m_shortName = wxT("CppCheck");
@@ -139,6 +144,7 @@ CppCheckPlugin::CppCheckPlugin(IManager* manager)
         wxEVT_WORKSPACE_CLOSED, wxCommandEventHandler(CppCheckPlugin::OnWorkspaceClosed), NULL, this);
 
     EventNotifier::Get()->Bind(wxEVT_CONTEXT_MENU_EDITOR, &CppCheckPlugin::OnEditorContextMenu, this);
+    EventNotifier::Get()->Bind(wxEVT_FILE_SAVED, &CppCheckPlugin::OnFileSaved, this);
     m_view = new CppCheckReportPage(m_mgr->GetOutputPaneNotebook(), m_mgr, this);
 
     //	wxBookCtrlBase *book = m_mgr->GetOutputPaneNotebook();
@@ -192,6 +198,7 @@ void CppCheckPlugin::UnPlug()
     m_tabHelper.reset(NULL);
     Unbind(wxEVT_ASYNC_PROCESS_OUTPUT, &CppCheckPlugin::OnCppCheckReadData, this);
     Unbind(wxEVT_ASYNC_PROCESS_TERMINATED, &CppCheckPlugin::OnCppCheckTerminated, this);
+    Unbind(wxEVT_CPPCHECK_KEYS_READY, &CppCheckPlugin::OnKeysReady, this);
 
     m_mgr->GetTheApp()->Disconnect(XRCID("cppcheck_settings_item"),
                                    wxEVT_COMMAND_MENU_SELECTED,
@@ -225,6 +232,7 @@ void CppCheckPlugin::UnPlug()
                                    (wxEvtHandler*)this);
 
     EventNotifier::Get()->Unbind(wxEVT_CONTEXT_MENU_EDITOR, &CppCheckPlugin::OnEditorContextMenu, this);
+    EventNotifier::Get()->Unbind(wxEVT_FILE_SAVED, &CppCheckPlugin::OnFileSaved, this);
     EventNotifier::Get()->Disconnect(
         wxEVT_WORKSPACE_CLOSED, wxCommandEventHandler(CppCheckPlugin::OnWorkspaceClosed), NULL, this);
 
@@ -238,7 +246,9 @@ void CppCheckPlugin::UnPlug()
     m_view->Destroy();
 
     // terminate the cppcheck daemon
+    DoStopKeysThread();
     wxDELETE(m_cppcheckProcess);
+    m_cache.Save();
 }
 
 wxMenu* CppCheckPlugin::CreateFileExplorerPopMenu()
@@ -427,12 +437,24 @@ void CppCheckPlugin::OnCheckProjectItem(wxCommandEvent& e)
 void CppCheckPlugin::OnCppCheckTerminated(clProcessEvent& e)
 {
     m_filelist.Clear();
+    if(!m_savedFile.IsEmpty() && !m_analysisStopped) {
+        wxArrayString includes;
+        if(!m_pendingKeys.empty()) { includes = m_pendingKeys.begin()->second.m_includes; }
+        DoShowSavedFileReport(m_output, includes);
+    }
+    DoStoreResults();
 
     if(m_cppcheckProcess) delete m_cppcheckProcess;
     m_cppcheckProcess = NULL;
 
+    DoFinishAnalysis();
+}
+
+void CppCheckPlugin::DoFinishAnalysis()
+{
     m_view->PrintStatusMessage();
-    m_view->GotoFirstError();
+    if(m_savedFile.IsEmpty()) { m_view->GotoFirstError(); }
+    m_savedFile.Clear();
 }
 
 void CppCheckPlugin::OnSettingsItem(wxCommandEvent& WXUNUSED(e)) { DoSettingsItem(); }
@@ -477,14 +499,15 @@ void CppCheckPlugin::DoSettingsItem(ProjectPtr project /*= NULL*/)
 void CppCheckPlugin::GetFileListFromDir(const wxString& root)
 {
     m_filelist.Clear();
-    wxArrayString tmparr;
-    wxDir::GetAllFiles(root, &tmparr);
+    std::vector<wxString> files;
+    clFilesScanner scanner;
+    scanner.Scan(root, files, "*.c;*.cpp;*.cxx;*.cc;*.c++", "", { ".git", ".svn", ".codelite" });
 
-    for(size_t i = 0; i < tmparr.GetCount(); i++) {
-        switch(FileExtManager::GetType(tmparr.Item(i))) {
+    for(size_t i = 0; i < files.size(); i++) {
+        switch(FileExtManager::GetType(files[i])) {
         case FileExtManager::TypeSourceC:
         case FileExtManager::TypeSourceCpp: {
-            m_filelist.Add(tmparr.Item(i));
+            m_filelist.Add(files[i]);
             break;
         }
 
@@ -497,7 +520,7 @@ void CppCheckPlugin::GetFileListFromDir(const wxString& root)
 void CppCheckPlugin::DoProcess(ProjectPtr proj)
 {
     wxString command = DoGetCommand(proj);
-    m_view->AppendLine(wxString::Format(_("Starting cppcheck: %s\n"), command.c_str()));
+    if(m_savedFile.IsEmpty()) { m_view->AppendLine(wxString::Format(_("Starting cppcheck: %s\n"), command.c_str())); }
 
 #if defined(__WXMSW__)
     // Under Windows, we set the working directory to the binary folder
@@ -557,8 +580,16 @@ void CppCheckPlugin::StopAnalysis()
 {
     // Clear the files queue
     if(m_cppcheckProcess) {
-        // terminate the m_cppcheckProcess
+        // terminate the m_cppcheckProcess. The partial output must not be cached
+        m_analysisStopped = true;
         m_cppcheckProcess->Terminate();
+
+    } else if(m_keysThread) {
+        // Still looking for the modified files
+        DoStopKeysThread();
+        m_filelist.Clear();
+        m_pendingKeys.clear();
+        m_savedFile.Clear();
     }
 }
 
@@ -587,29 +618,196 @@ void CppCheckPlugin::RemoveExcludedFiles()
 
 void CppCheckPlugin::OnWorkspaceClosed(wxCommandEvent& e)
 {
+    DoStopKeysThread();
+    m_savedFile.Clear();
     m_view->Clear();
+    m_cache.Save();
+    m_cache.Clear();
     e.Skip();
 }
 
-void CppCheckPlugin::DoStartTest(ProjectPtr proj /*=NULL*/)
+void CppCheckPlugin::DoStartTest(ProjectPtr proj /*=NULL*/, bool runOnSave /*=false*/)
 {
     RemoveExcludedFiles();
     if(!m_filelist.GetCount()) {
-        wxMessageBox(_("No files to check"), "CppCheck", wxOK | wxCENTRE, m_mgr->GetTheApp()->GetTopWindow());
+        if(!runOnSave) {
+            wxMessageBox(_("No files to check"), "CppCheck", wxOK | wxCENTRE, m_mgr->GetTheApp()->GetTopWindow());
+        }
         return;
     }
-    SetTabVisible(true);
-    m_view->Clear();
+
+    // Don't steal the focus when checking a file that was just saved, and keep the report of the other files
+    if(!runOnSave) {
+        SetTabVisible(true);
+        m_view->Clear();
+    }
     m_view->SetGaugeRange(m_filelist.GetCount());
 
     // We need to load any project-specific settings: definitions and undefines
     // (We couldn't do that with the rest of the settings as the workspace hadn't yet been loaded)
     m_settings.LoadProjectSpecificSettings(proj); // NB we still do this if !proj, as that will clear any stale settings
 
+    m_output.Clear();
+    m_pendingKeys.clear();
+    m_analysisStopped = false;
+    m_savedFile = runOnSave ? m_filelist.Item(0) : wxString();
+    if(m_settings.GetIncremental()) {
+        // Reading and hashing the files (and what they include) is done in the background,
+        // the check goes on in OnKeysReady()
+        DoLoadCache();
+        DoStopKeysThread();
+        m_keysProject = proj;
+        m_keysThread = new CppCheckKeysThread(
+            this, m_filelist, DoGetIncludePaths(proj), std::hash<wxString>()(DoGetCommandOptions(proj)));
+        m_keysThread->Start();
+        return;
+    }
+
+    // Start the test
+    DoProcess(proj);
+}
+
+void CppCheckPlugin::OnKeysReady(wxCommandEvent& event)
+{
+    if(!m_keysThread || event.GetClientData() != m_keysThread) {
+        return; // a stopped run
+    }
+    m_keysThread->Wait(wxTHREAD_WAIT_BLOCK);
+    CppCheckKeysThread::KeysVec_t keys = m_keysThread->GetKeys();
+    wxDELETE(m_keysThread);
+    ProjectPtr proj = m_keysProject;
+    m_keysProject.reset();
+
+    DoUseCachedResults(keys);
+    if(m_filelist.IsEmpty()) {
+        // Nothing changed
+        DoFinishAnalysis();
+        return;
+    }
+
     // Start the test
     DoProcess(proj);
 }
 
+void CppCheckPlugin::DoStopKeysThread()
+{
+    if(m_keysThread) {
+        m_keysThread->Stop();
+        wxDELETE(m_keysThread);
+    }
+    m_keysProject.reset();
+}
+
+void CppCheckPlugin::DoShowSavedFileReport(const wxString& output, const wxArrayString& includes)
+{
+    wxArrayString files = includes;
+    wxFileName fn(m_savedFile);
+    fn.Normalize();
+    files.Add(fn.GetFullPath());
+
+    wxArrayString problems;
+    wxArrayString lines = ::wxStringTokenize(output, "\r\n", wxTOKEN_STRTOK);
+    for(size_t i = 0; i < lines.size(); ++i) {
+        if(!CppCheckResultCache::GetFileFromReportLine(lines.Item(i)).IsEmpty()) { problems.Add(lines.Item(i)); }
+    }
+    m_view->ReplaceFileReport(files, problems);
+}
+
+void CppCheckPlugin::DoLoadCache()
+{
+    wxFileName fnCache(clCxxWorkspaceST::Get()->GetPrivateFolder(), "cppcheck.cache");
+    if(m_cache.GetFileName() != fnCache) {
+        m_cache.Save();
+        m_cache.Load(fnCache);
+    }
+}
+
+void CppCheckPlugin::DoUseCachedResults(const CppCheckKeysThread::KeysVec_t& keys)
+{
+    wxArrayString filesToCheck;
+    wxStringSet_t reportedLines; // a header included by several files is reported by each of them
+    size_t cachedCount = 0;
+    wxString cachedReport;
+    for(size_t i = 0; i < keys.size() && i < m_filelist.GetCount(); ++i) {
+        const wxString& file = keys.at(i).first;
+        const CppCheckResultCache::Key& key = keys.at(i).second;
+        wxArrayString report;
+        if(m_cache.Find(file, key, report)) {
+            ++cachedCount;
+            for(size_t j = 0; j < report.size(); ++j) {
+                if(reportedLines.insert(report.Item(j)).second) { cachedReport << report.Item(j) << "\n"; }
+            }
+        } else {
+            filesToCheck.Add(m_filelist.Item(i));
+            m_pendingKeys.insert(std::make_pair(file, key));
+        }
+    }
+
+    if(cachedCount && !m_savedFile.IsEmpty()) {
+        // The saved file did not change since it was last checked
+        DoShowSavedFileReport(cachedReport, keys.at(0).second.m_includes);
+
+    } else if(cachedCount) {
+        m_view->AppendLine(wxString::Format(_("Using the results of %d unchanged files from the cache\n"),
+                                            (int)cachedCount));
+        m_view->AppendLine(cachedReport);
+    }
+    m_filelist = filesToCheck;
+}
+
+void CppCheckPlugin::DoStoreResults()
+{
+    if(!m_analysisStopped && !m_pendingKeys.empty()) {
+        // Assign each reported problem to the files that were checked: either the file itself
+        // or one of the files it includes. Map each of these files to the checked files first
+        std::unordered_map<wxString, wxArrayString> checkedFiles;
+        std::map<wxString, CppCheckResultCache::Key>::const_iterator iter = m_pendingKeys.begin();
+        for(; iter != m_pendingKeys.end(); ++iter) {
+            checkedFiles[iter->first].Add(iter->first);
+            const wxArrayString& includes = iter->second.m_includes;
+            for(size_t i = 0; i < includes.size(); ++i) {
+                wxArrayString& files = checkedFiles[includes.Item(i)];
+                if(files.IsEmpty() || files.Last() != iter->first) { files.Add(iter->first); }
+            }
+        }
+
+        std::map<wxString, wxArrayString> reports;
+        wxArrayString lines = ::wxStringTokenize(m_output, "\r\n", wxTOKEN_STRTOK);
+        for(size_t i = 0; i < lines.size(); ++i) {
+            wxString file = CppCheckResultCache::GetFileFromReportLine(lines.Item(i));
+            if(file.IsEmpty()) { continue; }
+            wxFileName fn(file);
+            fn.Normalize();
+            file = fn.GetFullPath();
+
+            std::unordered_map<wxString, wxArrayString>::const_iterator checkedIter = checkedFiles.find(file);
+            if(checkedIter == checkedFiles.end()) { continue; }
+            for(size_t n = 0; n < checkedIter->second.size(); ++n) {
+                reports[checkedIter->second.Item(n)].Add(lines.Item(i));
+            }
+        }
+
+        for(iter = m_pendingKeys.begin(); iter != m_pendingKeys.end(); ++iter) {
+            m_cache.Update(iter->first, iter->second, reports[iter->first]);
+        }
+        m_cache.Save();
+    }
+    m_pendingKeys.clear();
+    m_output.Clear();
+}
+
+wxArrayString CppCheckPlugin::DoGetIncludePaths(ProjectPtr proj)
+{
+    wxArrayString includePaths = m_settings.GetIncludeDirs();
+    if(proj) {
+        wxArrayString projectSearchPaths = proj->GetIncludePaths();
+        for(size_t i = 0; i < projectSearchPaths.GetCount(); ++i) {
+            includePaths.Add(wxFileName(projectSearchPaths.Item(i), "").GetPath());
+        }
+    }
+    return includePaths;
+}
+
 wxString CppCheckPlugin::DoGetCommand(ProjectPtr proj)
 {
     // Linux / Mac way: spawn the process and execute the command
@@ -622,6 +820,18 @@ wxString CppCheckPlugin::DoGetCommand(ProjectPtr proj)
 
     // build the command
     cmd << path << " ";
+    cmd << DoGetCommandOptions(proj);
+    cmd << wxT(" --file-list=");
+    ::WrapWithQuotes(fileList);
+    cmd << fileList << " ";
+    CL_DEBUG("cppcheck command: %s", cmd);
+    ::WrapInShell(cmd);
+    return cmd;
+}
+
+wxString CppCheckPlugin::DoGetCommandOptions(ProjectPtr proj)
+{
+    wxString cmd;
     cmd << m_settings.GetOptions();
 
     // Append here project specifc search paths
@@ -639,12 +849,6 @@ wxString CppCheckPlugin::DoGetCommand(ProjectPtr proj)
             cmd << " -D" << projMacros.Item(i);
         }
     }
-
-    cmd << wxT(" --file-list=");
-    ::WrapWithQuotes(fileList);
-    cmd << fileList << " ";
-    CL_DEBUG("cppcheck command: %s", cmd);
-    ::WrapInShell(cmd);
     return cmd;
 }
 
@@ -676,7 +880,29 @@ wxString CppCheckPlugin::DoGenerateFileList()
 void CppCheckPlugin::OnCppCheckReadData(clProcessEvent& e)
 {
     e.Skip();
-    m_view->AppendLine(e.GetOutput());
+    if(!m_pendingKeys.empty() || !m_savedFile.IsEmpty()) { m_output << e.GetOutput(); }
+
+    // A check run on save updates the report once it is complete
+    if(m_savedFile.IsEmpty()) { m_view->AppendLine(e.GetOutput()); }
+}
+
+void CppCheckPlugin::OnFileSaved(clCommandEvent& event)
+{
+    event.Skip();
+    if(!m_settings.GetRunOnSave() || AnalysisInProgress() || !clCxxWorkspaceST::Get()->IsOpen()) { return; }
+
+    // Only the saved translation unit is checked
+    wxString filename = event.GetFileName();
+    FileExtManager::FileType type = FileExtManager::GetType(filename);
+    if(type != FileExtManager::TypeSourceC && type != FileExtManager::TypeSourceCpp) { return; }
+
+    ProjectPtr proj;
+    wxString projectName = m_mgr->GetProjectNameByFile(filename);
+    if(!projectName.IsEmpty()) { proj = clCxxWorkspaceST::Get()->GetProject(projectName); }
+
+    m_filelist.Clear();
+    m_filelist.Add(filename);
+    DoStartTest(proj, true);
 }
 
 void CppCheckPlugin::OnEditorContextMenu(clContextMenuEvent& event)
@@ -30,6 +30,9 @@
 #include "asyncprocess.h"
 #include "cppcheck_settings.h"
 #include "clTabTogglerHelper.h"
+#include "cl_command_event.h"
+#include "cppcheck_result_cache.h"
+#include <map>
 
 class wxMenuItem;
 class CppCheckReportPage;
@@ -49,11 +52,41 @@ class CppCheckPlugin : public IPlugin
     CppCheckSettings m_settings;
     size_t m_fileProcessed;
     clTabTogglerHelper::Ptr_t m_tabHelper;
+    CppCheckResultCache m_cache;
+    std::map<wxString, CppCheckResultCache::Key> m_pendingKeys; // the files being checked (incremental mode)
+    wxString m_output;                                          // the output of the running check
+    bool m_analysisStopped;
+    wxString m_savedFile; // the running check was triggered by saving this file
+    CppCheckKeysThread* m_keysThread;
+    ProjectPtr m_keysProject; // the project being checked while the keys are computed
 
 protected:
     wxString DoGetCommand(ProjectPtr proj);
+    wxString DoGetCommandOptions(ProjectPtr proj);
+    wxArrayString DoGetIncludePaths(ProjectPtr proj);
     wxString DoGenerateFileList();
 
+    /**
+     * @brief incremental mode: show the cached report of the files that did not change
+     * and remove them from the list of files to check
+     */
+    void DoUseCachedResults(const CppCheckKeysThread::KeysVec_t& keys);
+    /**
+     * @brief incremental mode: store the report of the files that were just checked
+     */
+    void DoStoreResults();
+    void DoLoadCache();
+    void DoStopKeysThread();
+    /**
+     * @brief run on save: replace the problems previously reported for the saved file (and the files it includes)
+     * with the problems found in 'output'. The rest of the report is kept
+     */
+    void DoShowSavedFileReport(const wxString& output, const wxArrayString& includes);
+    /**
+     * @brief the check is complete: show the summary
+     */
+    void DoFinishAnalysis();
+
 protected:
     wxMenu* CreateEditorPopMenu();
     wxMenu* CreateFileExplorerPopMenu();
@@ -65,7 +98,7 @@ protected:
     void RemoveExcludedFiles();
     void SetTabVisible(bool clearContent);
     void DoProcess(ProjectPtr proj);
-    void DoStartTest(ProjectPtr proj = NULL);
+    void DoStartTest(ProjectPtr proj = NULL, bool runOnSave = false);
     ProjectPtr FindSelectedProject();
     void DoSettingsItem(ProjectPtr project = NULL);
 
@@ -128,6 +161,16 @@ protected:
      */
     void OnEditorContextMenu(clContextMenuEvent& event);
 
+    /**
+     * @brief a file was saved. Check it if the "Run on save" option is set
+     */
+    void OnFileSaved(clCommandEvent& event);
+
+    /**
+     * @brief incremental mode: the cache keys of the files to check are ready
+     */
+    void OnKeysReady(wxCommandEvent& event);
+
 public:
     CppCheckPlugin(IManager* manager);
     ~CppCheckPlugin();
@@ -148,7 +191,7 @@ public:
     /**
      * @brief return true if analysis currently running
      */
-    bool AnalysisInProgress() const { return m_cppcheckProcess != NULL; }
+    bool AnalysisInProgress() const { return m_cppcheckProcess != NULL || m_keysThread != NULL; }
 
     /**
      * @brief return the progress
@@ -26,6 +26,8 @@
 #include "cppcheckreportpage.h"
 #include <wx/tokenzr.h>
 #include "cppchecker.h"
+#include "cppcheck_result_cache.h"
+#include "macros.h"
 #include "plugin.h"
 #include <wx/regex.h>
 #include <wx/log.h>
@@ -121,6 +123,39 @@ void CppCheckReportPage::AppendLine(const wxString& line)
     m_stc->ScrollToLine(m_stc->GetLineCount() - 1);
 }
 
+void CppCheckReportPage::ReplaceFileReport(const wxArrayString& files, const wxArrayString& lines)
+{
+    wxStringSet_t replacedFiles;
+    replacedFiles.insert(files.begin(), files.end());
+
+    wxString text;
+    wxStringSet_t reportedLines;
+    wxArrayString currentLines = ::wxStringTokenize(m_stc->GetText(), "\n", wxTOKEN_STRTOK);
+    for(size_t i = 0; i < currentLines.GetCount(); ++i) {
+        const wxString& line = currentLines.Item(i);
+        if(line.StartsWith("=====")) {
+            continue; // the summary of the previous check, PrintStatusMessage() adds a new one
+        }
+        wxString file = CppCheckResultCache::GetFileFromReportLine(line);
+        if(!file.IsEmpty()) {
+            wxFileName fn(file);
+            fn.Normalize();
+            if(replacedFiles.count(fn.GetFullPath())) { continue; }
+        }
+        reportedLines.insert(line);
+        text << line << "\n";
+    }
+
+    for(size_t i = 0; i < lines.GetCount(); ++i) {
+        if(reportedLines.insert(lines.Item(i)).second) { text << lines.Item(i) << "\n"; }
+    }
+
+    m_stc->SetReadOnly(false);
+    m_stc->ClearAll();
+    m_stc->AppendText(text);
+    m_stc->SetReadOnly(true);
+}
+
 // Lexing function
 // int CppCheckReportPage::ColorLine ( int, const char *text, size_t &start, size_t &len )
 //{
@@ -78,6 +78,10 @@ public:
     void Clear();
     size_t GetErrorCount() const;
     void AppendLine(const wxString& line);
+    /**
+     * @brief replace the problems reported in 'files' with 'lines'. The rest of the report is kept
+     */
+    void ReplaceFileReport(const wxArrayString& files, const wxArrayString& lines);
     void PrintStatusMessage();
     void SetGaugeRange(int range);
     void SetMessage(const wxString& msg);
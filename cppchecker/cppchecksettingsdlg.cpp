@@ -49,6 +49,8 @@ CppCheckSettingsDialog::CppCheckSettingsDialog(wxWindow* parent, CppCheckSetting
     m_cbOptionForce->SetValue(settings->GetForce());
     m_cbJobs->SetValue(settings->GetJobs() > 1);
     m_spinCtrlJobs->SetValue(settings->GetJobs());
+    m_cbIncremental->SetValue(settings->GetIncremental());
+    m_cbRunOnSave->SetValue(settings->GetRunOnSave());
 
     m_listBoxExcludelist->Append(settings->GetExcludeFiles());
 
@@ -106,6 +108,8 @@ void CppCheckSettingsDialog::OnBtnOK(wxCommandEvent& e)
         m_settings->SetJobs(1);
     }
     m_settings->SetCheckConfig(m_cbCheckConfig->IsChecked());
+    m_settings->SetIncremental(m_cbIncremental->IsChecked());
+    m_settings->SetRunOnSave(m_cbRunOnSave->IsChecked());
 
     m_settings->SetExcludeFiles(m_listBoxExcludelist->GetStrings());
 
@@ -106,6 +106,18 @@ CppCheckSettingsDialogBase::CppCheckSettingsDialogBase(wxWindow* parent, wxWindo
     
     boxSizer36->Add(m_cbCheckConfig, 0, wxALL|wxEXPAND, 5);
     
+    m_cbIncremental = new wxCheckBox(m_ChecksPanel, wxID_ANY, _("Incremental analysis"), wxDefaultPosition, wxSize(-1, -1), 0);
+    m_cbIncremental->SetValue(true);
+    m_cbIncremental->SetToolTip(_("Keep the results of the files that did not change (nor the files they include) since they were last checked, and check only the other files"));
+    
+    boxSizer36->Add(m_cbIncremental, 0, wxALL|wxEXPAND, 5);
+    
+    m_cbRunOnSave = new wxCheckBox(m_ChecksPanel, wxID_ANY, _("Run on save"), wxDefaultPosition, wxSize(-1, -1), 0);
+    m_cbRunOnSave->SetValue(false);
+    m_cbRunOnSave->SetToolTip(_("Check a source file whenever it is saved"));
+    
+    boxSizer36->Add(m_cbRunOnSave, 0, wxALL|wxEXPAND, 5);
+    
     m_ExcludePanel = new wxPanel(m_notebook1, wxID_ANY, wxDefaultPosition, wxSize(-1, -1), wxTAB_TRAVERSAL);
     m_notebook1->AddPage(m_ExcludePanel, _("Exclude"), false);
     
@@ -45,6 +45,8 @@ protected:
     wxCheckBox* m_cbJobs;
     wxSpinCtrl* m_spinCtrlJobs;
     wxCheckBox* m_cbCheckConfig;
+    wxCheckBox* m_cbIncremental;
+    wxCheckBox* m_cbRunOnSave;
     wxPanel* m_ExcludePanel;
     wxStaticText* m_staticText1;
     wxListBox* m_listBoxExcludelist;
@@ -126,6 +128,8 @@ public:
     wxCheckBox* GetCbJobs() { return m_cbJobs; }
     wxSpinCtrl* GetSpinCtrlJobs() { return m_spinCtrlJobs; }
     wxCheckBox* GetCbCheckConfig() { return m_cbCheckConfig; }
+    wxCheckBox* GetCbIncremental() { return m_cbIncremental; }
+    wxCheckBox* GetCbRunOnSave() { return m_cbRunOnSave; }
     wxPanel* GetChecksPanel() { return m_ChecksPanel; }
     wxStaticText* GetStaticText1() { return m_staticText1; }
     wxListBox* GetListBoxExcludelist() { return m_listBoxExcludelist; }
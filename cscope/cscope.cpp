@@ -30,10 +30,8 @@
 #include "cscopestatusmessage.h"
 #include "cscopetab.h"
 #include "csscopeconfdata.h"
-#include "dirsaver.h"
 #include "event_notifier.h"
-#include "exelocator.h"
-#include "procutils.h"
+#include "fileextmanager.h"
 #include "workspace.h"
 #include "wx/ffile.h"
 #include <wx/app.h>
@@ -73,6 +71,7 @@ CL_PLUGIN_API int GetPluginInterfaceVersion() { return PLUGIN_INTERFACE_VERSION;
 Cscope::Cscope(IManager* manager)
     : IPlugin(manager)
     , m_topWindow(NULL)
+    , m_queryId(0)
 {
     m_longName = _("CScope Integration for CodeLite");
     m_shortName = CSCOPE_NAME;
@@ -86,6 +85,7 @@ Cscope::Cscope(IManager* manager)
 
     Connect(wxEVT_CSCOPE_THREAD_DONE, wxCommandEventHandler(Cscope::OnCScopeThreadEnded), NULL, this);
     Connect(wxEVT_CSCOPE_THREAD_UPDATE_STATUS, wxCommandEventHandler(Cscope::OnCScopeThreadUpdateStatus), NULL, this);
+    Connect(wxEVT_CSCOPE_THREAD_RESULTS, wxCommandEventHandler(Cscope::OnCScopeThreadResults), NULL, this);
 
     // start the helper thread
     CScopeThreadST::Get()->Start();
@@ -103,6 +103,8 @@ Cscope::Cscope(IManager* manager)
     clKeyboardManager::Get()->AddGlobalAccelerator("cscope_create_db", "Alt-4",
                                                    "Plugins::CScope::Create CScope database");
     EventNotifier::Get()->Bind(wxEVT_CONTEXT_MENU_EDITOR, &Cscope::OnEditorContentMenu, this);
+    EventNotifier::Get()->Bind(wxEVT_FILE_SAVED, &Cscope::OnFileSaved, this);
+    EventNotifier::Get()->Bind(wxEVT_WORKSPACE_CLOSED, &Cscope::OnWorkspaceClosed, this);
 }
 
 Cscope::~Cscope() {}
@@ -252,7 +254,10 @@ void Cscope::UnPlug()
         }
     }
     EventNotifier::Get()->Unbind(wxEVT_CONTEXT_MENU_EDITOR, &Cscope::OnEditorContentMenu, this);
+    EventNotifier::Get()->Unbind(wxEVT_FILE_SAVED, &Cscope::OnFileSaved, this);
+    EventNotifier::Get()->Unbind(wxEVT_WORKSPACE_CLOSED, &Cscope::OnWorkspaceClosed, this);
     CScopeThreadST::Get()->Stop();
+    CScopeThreadST::Get()->SaveIndex();
     CScopeThreadST::Free();
 }
 
@@ -303,77 +308,46 @@ wxMenu* Cscope::CreateEditorPopMenu()
     return menu;
 }
 
-wxString Cscope::DoCreateListFile(bool force)
+wxArrayString Cscope::DoGetFileList()
 {
     // get the scope
     CScopeConfData settings;
     m_mgr->GetConfigTool()->ReadObject(wxT("CscopeSettings"), &settings);
 
-    // create temporary file and save the file there
-    wxString privateFolder = clCxxWorkspaceST::Get()->GetPrivateFolder();
-    wxFileName list_file(privateFolder, "cscope_file.list");
-    if(force || settings.GetRebuildOption() || !list_file.FileExists()) {
-        wxArrayString projects;
-        m_mgr->GetWorkspace()->GetProjectList(projects);
-        wxString err_msg;
-        std::vector<wxFileName> files;
-        wxArrayString tmpfiles;
-        m_cscopeWin->SetMessage(_("Creating file list..."), 5);
-
-        if(settings.GetScanScope() == SCOPE_ENTIRE_WORKSPACE) {
-            m_mgr->GetWorkspace()->GetWorkspaceFiles(tmpfiles);
-        } else {
-            // SCOPE_ACTIVE_PROJECT
-            ProjectPtr proj = m_mgr->GetWorkspace()->GetActiveProject();
-            if(proj) { proj->GetFilesAsStringArray(tmpfiles); }
-        }
-
-        // iterate over the files and convert them to be relative path
-        // Also remove any .exe files (one of which managed to crash cscope),
-        // and files without an ext, which may be binaries and are unlikely to be .c or .h files in disguise; and .xpm
-        // and .png too
-        for(size_t i = 0; i < tmpfiles.size(); i++) {
-            wxFileName fn(tmpfiles.Item(i));
-            wxString ext = fn.GetExt();
-            if(ext == wxT("exe") || ext == wxT("") || ext == wxT("xpm") || ext == wxT("png")) { continue; }
-            fn.MakeRelativeTo(privateFolder);
-            files.push_back(fn);
-        }
-
-        // create temporary file and save the file there
-        wxFFile file(list_file.GetFullPath(), wxT("w+b"));
-        if(!file.IsOpened()) {
-            clDEBUG() << "Failed to open temporary file:" << list_file;
-            return wxEmptyString;
-        }
+    wxArrayString tmpfiles;
+    if(settings.GetScanScope() == SCOPE_ENTIRE_WORKSPACE) {
+        m_mgr->GetWorkspace()->GetWorkspaceFiles(tmpfiles);
+    } else {
+        // SCOPE_ACTIVE_PROJECT
+        ProjectPtr proj = m_mgr->GetWorkspace()->GetActiveProject();
+        if(proj) { proj->GetFilesAsStringArray(tmpfiles); }
+    }
 
-        // write the content of the files into the tempfile
-        wxString content;
-        for(size_t i = 0; i < files.size(); i++) {
-            wxFileName fn(files.at(i));
-            content << fn.GetFullPath(wxPATH_UNIX) << wxT("\n");
+    // Only C/C++ sources and headers are indexed. Decide by the extension only: this list can be big
+    wxArrayString files;
+    files.Alloc(tmpfiles.GetCount());
+    for(size_t i = 0; i < tmpfiles.GetCount(); i++) {
+        switch(FileExtManager::GetType(tmpfiles.Item(i))) {
+        case FileExtManager::TypeSourceC:
+        case FileExtManager::TypeSourceCpp:
+        case FileExtManager::TypeHeader:
+            files.Add(tmpfiles.Item(i));
+            break;
+        default:
+            break;
         }
-
-        file.Write(content);
-        file.Flush();
-        file.Close();
     }
-
-    return list_file.GetFullPath();
+    return files;
 }
 
-void Cscope::DoCscopeCommand(const wxString& command, const wxString& findWhat, const wxString& endMsg)
+wxString Cscope::GetDbFile() const
 {
-    // We haven't yet found a valid cscope exe, so look for one
-    wxString where;
-    if(!ExeLocator::Locate(GetCscopeExeName(), where)) {
-        wxString msg;
-        msg << _("I can't find 'cscope' anywhere. Please check if it's installed.") << wxT('\n')
-            << _("Or tell me where it can be found, from the menu: 'Plugins | CScope | Settings'");
-        wxMessageBox(msg, _("CScope not found"), wxOK | wxCENTER | wxICON_WARNING);
-        return;
-    }
+    wxFileName dbFile(clCxxWorkspaceST::Get()->GetPrivateFolder(), "cscope_index.db");
+    return dbFile.GetFullPath();
+}
 
+void Cscope::DoShowCscopeTab()
+{
     // set the focus to the cscope tab
     Notebook* book = m_mgr->GetOutputPaneNotebook();
 
@@ -396,14 +370,32 @@ void Cscope::DoCscopeCommand(const wxString& command, const wxString& findWhat,
             }
         }
     }
+}
+
+void Cscope::DoCscopeCommand(eCscopeQuery query, const wxString& findWhat, const wxString& endMsg)
+{
+    DoShowCscopeTab();
+    m_cscopeWin->Clear();
+
+    // get the rebuild option
+    CScopeConfData settings;
+    m_mgr->GetConfigTool()->ReadObject(wxT("CscopeSettings"), &settings);
+
+    // Any query that is still running is no longer wanted
+    ++m_queryId;
+    CScopeThreadST::Get()->SetLastQueryId(m_queryId);
 
-    // create the search thread and return
+    // create the search request and return
     CscopeRequest* req = new CscopeRequest();
     req->SetOwner(this);
-    req->SetCmd(command);
+    req->SetType(kCscopeRequestQuery);
+    req->SetQuery(query);
+    req->SetId(m_queryId);
+    req->SetDbFile(GetDbFile());
+    req->SetFiles(DoGetFileList());
+    req->SetUpdateIndex(settings.GetRebuildOption());
     req->SetEndMsg(endMsg);
     req->SetFindWhat(findWhat);
-    req->SetWorkingDir(clCxxWorkspaceST::Get()->GetPrivateFolder());
 
     CScopeThreadST::Get()->Add(req);
 }
@@ -418,15 +410,11 @@ void Cscope::OnFindGlobalDefinition(wxCommandEvent& e)
 {
     wxString word = GetSearchPattern();
     if(word.IsEmpty()) { return; }
-    m_cscopeWin->Clear();
-    wxString list_file = DoCreateListFile(false);
 
     // Do the actual search
-    wxString command;
     wxString endMsg;
-    command << GetCscopeExeName() << wxT(" -d -L -1 ") << word << wxT(" -i ") << list_file;
     endMsg << _("cscope results for: find global definition of '") << word << wxT("'");
-    DoCscopeCommand(command, word, endMsg);
+    DoCscopeCommand(kCscopeFindGlobalDefinition, word, endMsg);
 }
 
 void Cscope::OnFindFunctionsCalledByThisFunction(wxCommandEvent& e)
@@ -434,22 +422,10 @@ void Cscope::OnFindFunctionsCalledByThisFunction(wxCommandEvent& e)
     wxString word = GetSearchPattern();
     if(word.IsEmpty()) { return; }
 
-    m_cscopeWin->Clear();
-    wxString list_file = DoCreateListFile(false);
-
-    // get the rebuild option
-    wxString rebuildOption = wxT("");
-    CScopeConfData settings;
-
-    m_mgr->GetConfigTool()->ReadObject(wxT("CscopeSettings"), &settings);
-    if(!settings.GetRebuildOption()) { rebuildOption = wxT(" -d"); }
-
     // Do the actual search
-    wxString command;
     wxString endMsg;
-    command << GetCscopeExeName() << rebuildOption << wxT(" -L -2 ") << word << wxT(" -i ") << list_file;
     endMsg << _("cscope results for: functions called by '") << word << wxT("'");
-    DoCscopeCommand(command, word, endMsg);
+    DoCscopeCommand(kCscopeFunctionsCalledBy, word, endMsg);
 }
 
 void Cscope::OnFindFunctionsCallingThisFunction(wxCommandEvent& e)
@@ -457,22 +433,10 @@ void Cscope::OnFindFunctionsCallingThisFunction(wxCommandEvent& e)
     wxString word = GetSearchPattern();
     if(word.IsEmpty()) { return; }
 
-    m_cscopeWin->Clear();
-    wxString list_file = DoCreateListFile(false);
-
-    // get the rebuild option
-    wxString rebuildOption = wxT("");
-    CScopeConfData settings;
-
-    m_mgr->GetConfigTool()->ReadObject(wxT("CscopeSettings"), &settings);
-    if(!settings.GetRebuildOption()) { rebuildOption = wxT(" -d"); }
-
     // Do the actual search
-    wxString command;
     wxString endMsg;
-    command << GetCscopeExeName() << rebuildOption << wxT(" -L -3 ") << word << wxT(" -i ") << list_file;
     endMsg << _("cscope results for: functions calling '") << word << wxT("'");
-    DoCscopeCommand(command, word, endMsg);
+    DoCscopeCommand(kCscopeFunctionsCalling, word, endMsg);
 }
 
 void Cscope::OnFindFilesIncludingThisFname(wxCommandEvent& e)
@@ -482,35 +446,22 @@ void Cscope::OnFindFilesIncludingThisFname(wxCommandEvent& e)
         // If there's no selection, try for the caret word
         // That'll either be (rubbish, or) a filename
         // or it'll be the 'h'of filename.h
-        // Cscope can cope with just a filename
         word = m_mgr->GetActiveEditor()->GetWordAtCaret();
         if(word == wxT("h")) {
             long pos = m_mgr->GetActiveEditor()->GetCurrentPosition();
             long start = m_mgr->GetActiveEditor()->WordStartPos(pos - 2, true);
             wxString name = m_mgr->GetActiveEditor()->GetTextRange(start, pos - 2);
-            // Append the .h  Cscope would be happy with just foo,
-            // but would also return #include foobar.h which isn't what's been requested
+            // Append the .h, the index would also match foo against #include foobar.h
+            // which isn't what's been requested
             word = name + wxT(".h");
         }
         if(word.IsEmpty()) { return; }
     }
 
-    m_cscopeWin->Clear();
-    wxString list_file = DoCreateListFile(false);
-
-    // get the rebuild option
-    wxString rebuildOption = wxT("");
-    CScopeConfData settings;
-
-    m_mgr->GetConfigTool()->ReadObject(wxT("CscopeSettings"), &settings);
-    if(!settings.GetRebuildOption()) { rebuildOption = wxT(" -d"); }
-
     // Do the actual search
-    wxString command;
     wxString endMsg;
-    command << GetCscopeExeName() << rebuildOption << wxT(" -L -8 ") << word << wxT(" -i ") << list_file;
     endMsg << _("cscope results for: files that #include '") << word << wxT("'");
-    DoCscopeCommand(command, word, endMsg);
+    DoCscopeCommand(kCscopeFilesIncluding, word, endMsg);
 }
 
 void Cscope::OnCreateDB(wxCommandEvent& e)
@@ -518,31 +469,49 @@ void Cscope::OnCreateDB(wxCommandEvent& e)
     // sanity
     if(m_mgr->IsWorkspaceOpen() == false) { return; }
 
+    DoShowCscopeTab();
     m_cscopeWin->Clear();
-    wxString list_file = DoCreateListFile(true);
 
-    // get the reverted index option
-    wxString command;
-    wxString endMsg;
-    CScopeConfData settings;
+    // Rebuilding the index cancels the pending queries
+    ++m_queryId;
+    CScopeThreadST::Get()->SetLastQueryId(m_queryId);
 
-    command << GetCscopeExeName();
+    CscopeRequest* req = new CscopeRequest();
+    req->SetOwner(this);
+    req->SetType(kCscopeRequestCreateDB);
+    req->SetId(m_queryId);
+    req->SetDbFile(GetDbFile());
+    req->SetFiles(DoGetFileList());
+    req->SetEndMsg(_("Recreated CScope DB"));
+    CScopeThreadST::Get()->Add(req);
+}
 
-    m_mgr->GetConfigTool()->ReadObject(wxT("CscopeSettings"), &settings);
-    if(settings.GetBuildRevertedIndexOption()) {
-        command << wxT(" -q");
-        endMsg << _("Recreated inverted CScope DB");
-    } else {
-        command << wxT(" -b");
-        endMsg << _("Recreated CScope DB");
-    }
+void Cscope::OnFileSaved(clCommandEvent& e)
+{
+    e.Skip();
+    if(!m_mgr->IsWorkspaceOpen()) { return; }
 
-    // Do the actual create db
-    // since the process is always running from the workspace
-    // directory, there is no need to specify the full path of the list file
+    // Keep the index in sync with the file. Files that are not indexed are ignored by the thread
+    wxArrayString files;
+    files.Add(e.GetFileName());
 
-    command << wxT(" -L -i cscope_file.list");
-    DoCscopeCommand(command, wxEmptyString, endMsg);
+    CscopeRequest* req = new CscopeRequest();
+    req->SetOwner(this);
+    req->SetType(kCscopeRequestUpdateFiles);
+    req->SetDbFile(GetDbFile());
+    req->SetFiles(files);
+    CScopeThreadST::Get()->Add(req);
+}
+
+void Cscope::OnWorkspaceClosed(wxCommandEvent& e)
+{
+    e.Skip();
+    // Write the index of this workspace to the disk and release its memory
+    CscopeRequest* req = new CscopeRequest();
+    req->SetOwner(this);
+    req->SetType(kCscopeRequestSave);
+    req->SetUnloadIndex(true);
+    CScopeThreadST::Get()->Add(req);
 }
 
 void Cscope::OnDoSettings(wxCommandEvent& e)
@@ -560,17 +529,25 @@ void Cscope::OnDoSettings(wxCommandEvent& e)
     }
 }
 
-wxString Cscope::GetCscopeExeName()
+void Cscope::OnCScopeThreadEnded(wxCommandEvent& e)
 {
-    CScopeConfData settings;
-    m_mgr->GetConfigTool()->ReadObject(wxT("CscopeSettings"), &settings);
-    return settings.GetCscopeExe();
+    CScopeResultTable_t* result = (CScopeResultTable_t*)e.GetClientData();
+    if(e.GetInt() != m_queryId) {
+        // The results of an older query
+        CscopeTab::DeleteTable(result);
+        return;
+    }
+    if(result) { m_cscopeWin->AddResults(result); }
 }
 
-void Cscope::OnCScopeThreadEnded(wxCommandEvent& e)
+void Cscope::OnCScopeThreadResults(wxCommandEvent& e)
 {
     CScopeResultTable_t* result = (CScopeResultTable_t*)e.GetClientData();
-    m_cscopeWin->BuildTable(result);
+    if(e.GetInt() != m_queryId) {
+        CscopeTab::DeleteTable(result);
+        return;
+    }
+    m_cscopeWin->AddResults(result);
 }
 
 void Cscope::OnCScopeThreadUpdateStatus(wxCommandEvent& e)
@@ -624,22 +601,10 @@ wxString Cscope::GetSearchPattern() const
 
 void Cscope::DoFindSymbol(const wxString& word)
 {
-    m_cscopeWin->Clear();
-    wxString list_file = DoCreateListFile(false);
-
-    // get the rebuild option
-    wxString rebuildOption = wxT("");
-    CScopeConfData settings;
-
-    m_mgr->GetConfigTool()->ReadObject(wxT("CscopeSettings"), &settings);
-    if(!settings.GetRebuildOption()) { rebuildOption = wxT(" -d"); }
-
     // Do the actual search
-    wxString command;
     wxString endMsg;
-    command << GetCscopeExeName() << rebuildOption << wxT(" -L -0 ") << word << wxT(" -i ") << list_file;
     endMsg << wxT("cscope results for: find C symbol '") << word << wxT("'");
-    DoCscopeCommand(command, word, endMsg);
+    DoCscopeCommand(kCscopeFindSymbol, word, endMsg);
 }
 
 void Cscope::OnEditorContentMenu(clContextMenuEvent& event)
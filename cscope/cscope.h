@@ -29,6 +29,7 @@
 #include "map"
 #include "vector"
 #include "cscopeentrydata.h"
+#include "cscopeindex.h"
 #include "cl_command_event.h"
 #include "clTabTogglerHelper.h"
 
@@ -39,6 +40,7 @@ class Cscope : public IPlugin
     wxEvtHandler* m_topWindow;
     CscopeTab* m_cscopeWin;
     clTabTogglerHelper::Ptr_t m_tabHelper;
+    int m_queryId;
 
 public:
     Cscope(IManager* manager);
@@ -55,9 +57,10 @@ protected:
     // Helper
     //------------------------------------------
     wxMenu* CreateEditorPopMenu();
-    wxString GetCscopeExeName();
-    wxString DoCreateListFile(bool force);
-    void DoCscopeCommand(const wxString& command, const wxString& findWhat, const wxString& endMsg);
+    wxArrayString DoGetFileList();
+    wxString GetDbFile() const;
+    void DoCscopeCommand(eCscopeQuery query, const wxString& findWhat, const wxString& endMsg);
+    void DoShowCscopeTab();
     void DoFindSymbol(const wxString& word);
     wxString GetSearchPattern() const;
 
@@ -73,6 +76,9 @@ protected:
     void OnDoSettings(wxCommandEvent& e);
     void OnCScopeThreadEnded(wxCommandEvent& e);
     void OnCScopeThreadUpdateStatus(wxCommandEvent& e);
+    void OnCScopeThreadResults(wxCommandEvent& e);
+    void OnFileSaved(clCommandEvent& e);
+    void OnWorkspaceClosed(wxCommandEvent& e);
     void OnCscopeUI(wxUpdateUIEvent& e);
     void OnWorkspaceOpenUI(wxUpdateUIEvent& e);
     void OnEditorContentMenu(clContextMenuEvent& event);
@@ -25,100 +25,151 @@
 #include "cscope.h"
 #include "cscopedbbuilderthread.h"
 #include "cscopestatusmessage.h"
-#include "dirsaver.h"
 #include "file_logger.h"
-#include "procutils.h"
-#include "wx/filefn.h"
 
 int wxEVT_CSCOPE_THREAD_DONE = wxNewId();
 int wxEVT_CSCOPE_THREAD_UPDATE_STATUS = wxNewId();
+int wxEVT_CSCOPE_THREAD_RESULTS = wxNewId();
 
-CscopeDbBuilderThread::CscopeDbBuilderThread() {}
+/**
+ * @class CscopeQuerySink
+ * @brief sends the results of a query to its owner as they are found
+ */
+class CscopeQuerySink : public CscopeIndexSink
+{
+    CscopeDbBuilderThread* m_thread;
+    CscopeRequest* m_req;
+
+public:
+    CscopeQuerySink(CscopeDbBuilderThread* thread, CscopeRequest* req)
+        : m_thread(thread)
+        , m_req(req)
+    {
+    }
+
+    virtual bool AddResults(CScopeResultTable_t* table)
+    {
+        wxCommandEvent e(wxEVT_CSCOPE_THREAD_RESULTS);
+        e.SetClientData(table);
+        e.SetInt(m_req->GetId());
+        m_req->GetOwner()->AddPendingEvent(e);
+        return !m_thread->TestDestroy() && !m_thread->IsCancelled(m_req->GetId());
+    }
+};
+
+CscopeDbBuilderThread::CscopeDbBuilderThread()
+    : m_lastQueryId(0)
+{
+}
 
 CscopeDbBuilderThread::~CscopeDbBuilderThread() {}
 
+void CscopeDbBuilderThread::SetLastQueryId(int queryId)
+{
+    wxMutexLocker locker(m_lastQueryMutex);
+    m_lastQueryId = queryId;
+}
+
+bool CscopeDbBuilderThread::IsCancelled(int queryId)
+{
+    wxMutexLocker locker(m_lastQueryMutex);
+    return queryId != m_lastQueryId;
+}
+
+void CscopeDbBuilderThread::SaveIndex()
+{
+    if(!m_loadedDbFile.IsEmpty() && m_index.IsModified()) {
+        m_index.Save(m_loadedDbFile);
+    }
+}
+
 void CscopeDbBuilderThread::ProcessRequest(ThreadRequest* request)
 {
     CscopeRequest* req = (CscopeRequest*)request;
+    switch(req->GetType()) {
+    case kCscopeRequestCreateDB: {
+        SendStatusEvent(_("Indexing files..."), 10, req->GetFindWhat(), req->GetOwner());
+        m_index.Clear();
+        m_loadedDbFile = req->GetDbFile();
+        size_t count = m_index.Update(req->GetFiles());
+        SendStatusEvent(_("Saving the index..."), 90, wxEmptyString, req->GetOwner());
+        SaveIndex();
+        clDEBUG() << "CScope: indexed" << count << "files" << clEndl;
+        SendStatusEvent(req->GetEndMsg(), 100, wxEmptyString, req->GetOwner());
+
+        wxCommandEvent e(wxEVT_CSCOPE_THREAD_DONE);
+        e.SetClientData(NULL);
+        e.SetInt(req->GetId());
+        req->GetOwner()->AddPendingEvent(e);
+        break;
+    }
 
-    // change dir to the workspace directory
-    DirSaver ds;
+    case kCscopeRequestUpdateFiles:
+        // Only files that are already indexed, and only if this is the index of that workspace
+        if(m_loadedDbFile == req->GetDbFile()) {
+            for(size_t i = 0; i < req->GetFiles().GetCount(); ++i) {
+                m_index.UpdateFile(req->GetFiles().Item(i));
+            }
+        }
+        break;
 
-    wxSetWorkingDirectory(req->GetWorkingDir());
-    SendStatusEvent(_("Executing cscope..."), 10, req->GetFindWhat(), req->GetOwner());
+    case kCscopeRequestSave:
+        SaveIndex();
+        if(req->IsUnloadIndex()) {
+            m_index.Clear();
+            m_loadedDbFile.Clear();
+        }
+        break;
+
+    case kCscopeRequestQuery:
+    default:
+        DoQuery(req);
+        break;
+    }
+}
+
+void CscopeDbBuilderThread::DoLoadIndex(CscopeRequest* req)
+{
+    // Load the workspace index, or build it when there is none
+    bool loaded = (m_loadedDbFile == req->GetDbFile()) && !m_index.IsEmpty();
+    if(!loaded) {
+        SaveIndex();
+        m_loadedDbFile = req->GetDbFile();
+        SendStatusEvent(_("Loading the index..."), 10, req->GetFindWhat(), req->GetOwner());
+        m_index.Load(m_loadedDbFile);
+    }
+
+    // After loading it, catch up with what changed since it was saved
+    if(!loaded || req->IsUpdateIndex()) {
+        SendStatusEvent(_("Updating the index..."), 20, req->GetFindWhat(), req->GetOwner());
+        m_index.Update(req->GetFiles());
+        SaveIndex();
+    }
+}
 
-    // notify the database creation process as completed
-    wxArrayString output;
+void CscopeDbBuilderThread::DoQuery(CscopeRequest* req)
+{
+    if(IsCancelled(req->GetId())) {
+        return; // A newer query was made already
+    }
 
-    // set environment variables required by cscope
-    wxSetEnv(wxT("TMPDIR"), wxFileName::GetTempDir());
-    clDEBUG() << "CScope:" << req->GetCmd() << clEndl;
-    ProcUtils::SafeExecuteCommand(req->GetCmd(), output);
-    SendStatusEvent(_("Parsing results..."), 50, wxEmptyString, req->GetOwner());
-    clDEBUG1() << "CScope:\n" << output << clEndl;
-    CScopeResultTable_t* result = ParseResults(output);
-    SendStatusEvent(_("Done"), 100, wxEmptyString, req->GetOwner());
+    DoLoadIndex(req);
+
+    SendStatusEvent(_("Searching..."), 50, req->GetFindWhat(), req->GetOwner());
+    CscopeQuerySink sink(this, req);
+    size_t count = m_index.Query(req->GetQuery(), req->GetFindWhat(), &sink);
+    clDEBUG() << "CScope:" << count << "matches for" << req->GetFindWhat() << clEndl;
 
     // send status message
     SendStatusEvent(req->GetEndMsg(), 100, wxEmptyString, req->GetOwner());
 
-    // send the results
+    // notify that the query completed
     wxCommandEvent e(wxEVT_CSCOPE_THREAD_DONE);
-    e.SetClientData(result);
+    e.SetClientData(NULL);
+    e.SetInt(req->GetId());
     req->GetOwner()->AddPendingEvent(e);
 }
 
-CScopeResultTable_t* CscopeDbBuilderThread::ParseResults(const wxArrayString& output)
-{
-    CScopeResultTable_t* results = new CScopeResultTable_t();
-    for(size_t i = 0; i < output.GetCount(); i++) {
-        // parse each line
-        wxString line = output.Item(i);
-        CscopeEntryData data;
-
-        // first is the file name
-        line = line.Trim().Trim(false);
-        // skip errors
-        if(line.StartsWith(wxT("cscope:"))) { continue; }
-
-        wxString file = line.BeforeFirst(wxT(' '));
-        data.SetFile(file);
-        line = line.AfterFirst(wxT(' '));
-
-        // next is the scope
-        line = line.Trim().Trim(false);
-        wxString scope = line.BeforeFirst(wxT(' '));
-        line = line.AfterFirst(wxT(' '));
-        data.SetScope(scope);
-
-        // next is the line number
-        line = line.Trim().Trim(false);
-        long nn;
-        wxString line_number = line.BeforeFirst(wxT(' '));
-        line_number.ToLong(&nn);
-        data.SetLine(nn);
-        line = line.AfterFirst(wxT(' '));
-
-        // the rest is the pattern
-        wxString pattern = line;
-        data.SetPattern(pattern);
-
-        // insert the result
-        CScopeResultTable_t::const_iterator iter = results->find(data.GetFile());
-        std::vector<CscopeEntryData>* vec(NULL);
-        if(iter != results->end()) {
-            // this file already exist, append the result
-            vec = iter->second;
-        } else {
-            vec = new std::vector<CscopeEntryData>();
-            // add it to the map
-            (*results)[data.GetFile()] = vec;
-        }
-        vec->push_back(data);
-    }
-    return results;
-}
-
 void CscopeDbBuilderThread::SendStatusEvent(const wxString& msg, int percent, const wxString& findWhat,
                                             wxEvtHandler* owner)
 {
@@ -26,6 +26,7 @@
 #define __cscopedbbuilderthread__
 
 #include "cscopeentrydata.h"
+#include "cscopeindex.h"
 #include "singleton.h"
 #include "worker_thread.h"
 #include "wx/event.h"
@@ -37,9 +38,14 @@
 
 extern int wxEVT_CSCOPE_THREAD_DONE;
 extern int wxEVT_CSCOPE_THREAD_UPDATE_STATUS;
+extern int wxEVT_CSCOPE_THREAD_RESULTS;
 
-typedef std::vector<CscopeEntryData> CScopeEntryDataVec_t;
-typedef std::map<wxString, CScopeEntryDataVec_t*> CScopeResultTable_t;
+enum eCscopeRequest {
+    kCscopeRequestQuery = 0,   // answer a query from the index
+    kCscopeRequestCreateDB,    // rebuild the index from scratch
+    kCscopeRequestUpdateFiles, // re-index some files (e.g. after they were saved)
+    kCscopeRequestSave,        // write the index to the disk, and optionally unload it
+};
 
 /**
  * \class CscopeRequest
@@ -50,27 +56,47 @@ typedef std::map<wxString, CScopeEntryDataVec_t*> CScopeResultTable_t;
 class CscopeRequest : public ThreadRequest
 {
     wxEvtHandler* m_owner;
-    wxString m_cmd;
-    wxString m_workingDir;
-    wxString m_outfile;
+    eCscopeRequest m_type;
+    eCscopeQuery m_query;
+    int m_id;
+    wxString m_dbFile;
+    wxArrayString m_files;
+    bool m_updateIndex;
+    bool m_unloadIndex;
     wxString m_endMsg;
     wxString m_findWhat;
 
 public:
-    CscopeRequest(){};
+    CscopeRequest()
+        : m_owner(NULL)
+        , m_type(kCscopeRequestQuery)
+        , m_query(kCscopeFindSymbol)
+        , m_id(0)
+        , m_updateIndex(false)
+        , m_unloadIndex(false)
+    {
+    }
     ~CscopeRequest(){};
 
     // Setters
-    void SetCmd(const wxString& cmd) { this->m_cmd = cmd; }
-    void SetOutfile(const wxString& outfile) { this->m_outfile = outfile; }
     void SetOwner(wxEvtHandler* owner) { this->m_owner = owner; }
+    void SetType(eCscopeRequest type) { this->m_type = type; }
+    void SetQuery(eCscopeQuery query) { this->m_query = query; }
+    void SetId(int id) { this->m_id = id; }
+    void SetDbFile(const wxString& dbFile) { this->m_dbFile = dbFile; }
+    void SetFiles(const wxArrayString& files) { this->m_files = files; }
+    void SetUpdateIndex(bool updateIndex) { this->m_updateIndex = updateIndex; }
+    void SetUnloadIndex(bool unloadIndex) { this->m_unloadIndex = unloadIndex; }
 
-    void SetWorkingDir(const wxString& workingDir) { this->m_workingDir = workingDir; }
     // Getters
-    const wxString& GetCmd() const { return m_cmd; }
-    const wxString& GetOutfile() const { return m_outfile; }
     wxEvtHandler* GetOwner() { return m_owner; }
-    const wxString& GetWorkingDir() const { return m_workingDir; }
+    eCscopeRequest GetType() const { return m_type; }
+    eCscopeQuery GetQuery() const { return m_query; }
+    int GetId() const { return m_id; }
+    const wxString& GetDbFile() const { return m_dbFile; }
+    const wxArrayString& GetFiles() const { return m_files; }
+    bool IsUpdateIndex() const { return m_updateIndex; }
+    bool IsUnloadIndex() const { return m_unloadIndex; }
 
     void SetFindWhat(const wxString& findWhat) { this->m_findWhat = findWhat; }
     const wxString& GetFindWhat() const { return m_findWhat; }
@@ -81,10 +107,18 @@ public:
 class CscopeDbBuilderThread : public WorkerThread
 {
     friend class Singleton<CscopeDbBuilderThread>;
+    friend class CscopeQuerySink;
+
+    CscopeIndex m_index;
+    wxString m_loadedDbFile;
+    wxMutex m_lastQueryMutex;
+    int m_lastQueryId;
 
 protected:
     void ProcessRequest(ThreadRequest* req);
-    CScopeResultTable_t* ParseResults(const wxArrayString& output);
+    void DoQuery(CscopeRequest* req);
+    void DoLoadIndex(CscopeRequest* req);
+    bool IsCancelled(int queryId);
 
 protected:
     void SendStatusEvent(const wxString& msg, int percent, const wxString& findWhat, wxEvtHandler* owner);
@@ -92,6 +126,16 @@ protected:
 public:
     CscopeDbBuilderThread();
     ~CscopeDbBuilderThread();
+
+    /**
+     * @brief the newest query: the results of the older ones are no longer wanted
+     */
+    void SetLastQueryId(int queryId);
+
+    /**
+     * @brief write the index to the disk, if it was modified. Only call this when the thread is not running
+     */
+    void SaveIndex();
 };
 
 typedef Singleton<CscopeDbBuilderThread> CScopeThreadST;
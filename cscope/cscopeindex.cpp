@@ -0,0 +1,872 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2018 Eran Ifrah
+// file name            : cscopeindex.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+#include "cscopeindex.h"
+#include "CxxScannerTokens.h"
+#include "CxxTokenizer.h"
+#include "file_logger.h"
+#include "fileutils.h"
+#include <algorithm>
+#include <string.h>
+#include <unordered_set>
+#include <wx/ffile.h>
+#include <wx/tokenzr.h>
+
+#define CSCOPE_INDEX_MAGIC "CLCSCOPEIDX"
+#define CSCOPE_INDEX_VERSION 1
+
+// Files are indexed in parallel only when there are enough of them
+#define CSCOPE_MIN_FILES_PER_THREAD 64
+
+// The number of files whose results are sent together
+#define CSCOPE_RESULTS_BATCH 25
+
+#define CSCOPE_GLOBAL_SCOPE "<global>"
+
+namespace
+{
+bool ReadSourceFile(const wxString& path, wxString& content)
+{
+    if(!FileUtils::ReadFileContent(wxFileName(path), content)) {
+        return false;
+    }
+    if(content.IsEmpty() && FileUtils::GetFileSize(wxFileName(path))) {
+        // Not UTF-8
+        return FileUtils::ReadFileContent(wxFileName(path), content, wxConvISO8859_1);
+    }
+    return true;
+}
+
+//-----------------------------------------------------------
+// Serialization helpers
+//-----------------------------------------------------------
+void WriteU32(std::string& buffer, wxUint32 value)
+{
+    char bytes[4] = { (char)(value & 0xFF), (char)((value >> 8) & 0xFF), (char)((value >> 16) & 0xFF),
+                      (char)((value >> 24) & 0xFF) };
+    buffer.append(bytes, 4);
+}
+
+void WriteString(std::string& buffer, const std::string& str)
+{
+    WriteU32(buffer, str.length());
+    buffer.append(str);
+}
+
+struct IndexReader {
+    const std::string& m_buffer;
+    size_t m_pos;
+    bool m_ok;
+    IndexReader(const std::string& buffer, size_t pos)
+        : m_buffer(buffer)
+        , m_pos(pos)
+        , m_ok(true)
+    {
+    }
+
+    wxUint32 ReadU32()
+    {
+        if(!m_ok || (m_pos + 4) > m_buffer.length()) {
+            m_ok = false;
+            return 0;
+        }
+        const unsigned char* p = (const unsigned char*)m_buffer.data() + m_pos;
+        m_pos += 4;
+        return (wxUint32)p[0] | ((wxUint32)p[1] << 8) | ((wxUint32)p[2] << 16) | ((wxUint32)p[3] << 24);
+    }
+
+    std::string ReadString()
+    {
+        wxUint32 len = ReadU32();
+        if(!m_ok || (m_pos + len) > m_buffer.length()) {
+            m_ok = false;
+            return std::string();
+        }
+        std::string str = m_buffer.substr(m_pos, len);
+        m_pos += len;
+        return str;
+    }
+};
+
+//-----------------------------------------------------------
+// The tokenizer based parser
+//-----------------------------------------------------------
+enum eScopeKind { kScopeFunction, kScopeClass, kScopeOther };
+
+struct ParserScope {
+    eScopeKind m_kind;
+    wxUint32 m_name;
+    ParserScope(eScopeKind kind, wxUint32 name)
+        : m_kind(kind)
+        , m_name(name)
+    {
+    }
+};
+
+enum eDeclaratorState {
+    kDeclNone,      // nothing interesting
+    kDeclParams,    // reading the parameters of what may be a function definition: foo(...
+    kDeclAfter,     // after its ')': a '{' makes it a definition, a ';' a declaration
+    kDeclInitList,  // a constructor initialisation list
+};
+} // namespace
+
+/**
+ * @class CscopeIndexThread
+ * @brief indexes every 'step'th file of a list, starting with 'first'
+ */
+class CscopeIndexThread : public wxThread
+{
+    CscopeIndex* m_index;
+    const wxArrayString& m_files;
+    size_t m_first;
+    size_t m_step;
+    size_t m_count;
+
+public:
+    CscopeIndexThread(CscopeIndex* index, const wxArrayString& files, size_t first, size_t step)
+        : wxThread(wxTHREAD_JOINABLE)
+        , m_index(index)
+        , m_files(files)
+        , m_first(first)
+        , m_step(step)
+        , m_count(0)
+    {
+    }
+
+    virtual void* Entry()
+    {
+        for(size_t i = m_first; i < m_files.GetCount(); i += m_step) {
+            if(m_index->DoIndexFile(m_files.Item(i))) {
+                ++m_count;
+            }
+        }
+        return NULL;
+    }
+
+    size_t GetCount() const { return m_count; }
+};
+
+wxUint32 CscopeIndex::ParsedFile::GetNameId(const std::string& name)
+{
+    std::unordered_map<std::string, wxUint32>::iterator iter = m_nameIds.find(name);
+    if(iter != m_nameIds.end()) {
+        return iter->second;
+    }
+    wxUint32 id = m_names.size();
+    m_names.push_back(name);
+    m_nameIds.insert(std::make_pair(name, id));
+    return id;
+}
+
+CscopeIndex::CscopeIndex()
+    : m_modified(false)
+{
+}
+
+CscopeIndex::~CscopeIndex() {}
+
+void CscopeIndex::Parse(const wxString& content, ParsedFile& parsed, const std::string& symbol)
+{
+    CxxTokenizer tokenizer;
+    tokenizer.Reset(content);
+
+    std::vector<ParserScope> scopes;
+    int parenDepth = 0;
+    int prevType = 0;
+    wxUint32 prevIdent = NO_NAME;
+
+    eDeclaratorState declState = kDeclNone;
+    wxUint32 declName = NO_NAME;
+    wxUint32 declLine = 0;
+
+    bool expectClassName = false;
+    bool classNameLocked = false;
+    wxUint32 className = NO_NAME;
+    wxUint32 classLine = 0;
+
+    bool inTypedef = false;
+    wxUint32 typedefName = NO_NAME;
+    wxUint32 typedefLine = 0;
+
+    bool expectMacroName = false;
+
+    CxxLexerToken token;
+    while(tokenizer.NextToken(token)) {
+        int type = token.GetType();
+        wxUint32 line = token.GetLineNumber();
+
+        // The function we are in, if any
+        wxUint32 function = NO_NAME;
+        for(size_t i = scopes.size(); i > 0; --i) {
+            if(scopes[i - 1].m_kind == kScopeFunction) {
+                function = scopes[i - 1].m_name;
+                break;
+            }
+        }
+
+        if(type == T_PP_INCLUDE_FILENAME) {
+            // "foo/bar.h" or <foo/bar.h>: keyed by the file name
+            std::string filename = token.GetText();
+            if(filename.length() > 2) {
+                filename = filename.substr(1, filename.length() - 2);
+            }
+            size_t slash = filename.find_last_of("/\\");
+            if(slash != std::string::npos) {
+                filename = filename.substr(slash + 1);
+            }
+            Ref ref = { parsed.GetNameId(filename), line, function, kRefInclude };
+            parsed.m_refs.push_back(ref);
+            continue;
+        }
+
+        if(tokenizer.IsInPreProcessorSection() || type == T_PP_STATE_EXIT) {
+            // Only the macro names and the identifiers used by the pre-processor lines matter
+            if(type == T_PP_DEFINE) {
+                expectMacroName = true;
+
+            } else if(type == T_PP_IDENTIFIER) {
+                wxUint32 name = parsed.GetNameId(token.GetText());
+                if(expectMacroName) {
+                    Ref ref = { name, line, NO_NAME, kRefDefinition };
+                    parsed.m_refs.push_back(ref);
+                }
+                if(!symbol.empty() && symbol == token.GetText()) {
+                    Ref ref = { name, line, function, kRefSymbol };
+                    parsed.m_refs.push_back(ref);
+                }
+                expectMacroName = false;
+
+            } else {
+                expectMacroName = false;
+            }
+            continue;
+        }
+
+        switch(type) {
+        case T_IDENTIFIER: {
+            wxUint32 name = parsed.GetNameId(token.GetText());
+            if(!symbol.empty() && symbol == token.GetText()) {
+                Ref ref = { name, line, function, kRefSymbol };
+                parsed.m_refs.push_back(ref);
+            }
+            if(expectClassName && !classNameLocked && parenDepth == 0) {
+                // class WXDLLIMPEXP_CL Foo: the last identifier is the name
+                className = name;
+                classLine = line;
+            }
+            if(inTypedef && (parenDepth == 0 || (parenDepth == 1 && prevType == '*'))) {
+                typedefName = name;
+                typedefLine = line;
+            }
+            prevIdent = name;
+            break;
+        }
+
+        case T_CLASS:
+        case T_STRUCT:
+        case T_UNION:
+        case T_ENUM:
+            if(parenDepth == 0 && prevType != '<' && prevType != ',') {
+                expectClassName = true;
+                classNameLocked = false;
+                className = NO_NAME;
+            }
+            break;
+
+        case T_TYPEDEF:
+            inTypedef = true;
+            typedefName = NO_NAME;
+            break;
+
+        case '(':
+            ++parenDepth;
+            if(prevType == T_IDENTIFIER && prevIdent != NO_NAME) {
+                if(function != NO_NAME) {
+                    // A call made by the current function
+                    Ref ref = { prevIdent, line, function, kRefCall };
+                    parsed.m_refs.push_back(ref);
+
+                } else if(parenDepth == 1 && !expectClassName && (declState == kDeclNone || declState == kDeclAfter)) {
+                    // Outside of a function body: this may be the declarator of a function
+                    declState = kDeclParams;
+                    declName = prevIdent;
+                    declLine = line;
+                }
+            }
+            break;
+
+        case ')':
+            if(parenDepth > 0) {
+                --parenDepth;
+            }
+            if(declState == kDeclParams && parenDepth == 0) {
+                declState = kDeclAfter;
+            }
+            break;
+
+        case ':':
+            if(declState == kDeclAfter && parenDepth == 0) {
+                declState = kDeclInitList;
+            }
+            if(expectClassName && className != NO_NAME) {
+                // The base classes follow
+                classNameLocked = true;
+            }
+            break;
+
+        case '{':
+            if(declState == kDeclAfter || declState == kDeclInitList) {
+                Ref ref = { declName, declLine, NO_NAME, kRefDefinition };
+                parsed.m_refs.push_back(ref);
+                scopes.push_back(ParserScope(kScopeFunction, declName));
+
+            } else if(expectClassName) {
+                if(className != NO_NAME) {
+                    Ref ref = { className, classLine, NO_NAME, kRefDefinition };
+                    parsed.m_refs.push_back(ref);
+                }
+                scopes.push_back(ParserScope(kScopeClass, className));
+
+            } else {
+                scopes.push_back(ParserScope(kScopeOther, NO_NAME));
+            }
+            declState = kDeclNone;
+            expectClassName = false;
+            parenDepth = 0;
+            break;
+
+        case '}':
+            if(!scopes.empty()) {
+                scopes.pop_back();
+            }
+            declState = kDeclNone;
+            break;
+
+        case ';':
+            if(parenDepth == 0) {
+                if(inTypedef && typedefName != NO_NAME && function == NO_NAME) {
+                    Ref ref = { typedefName, typedefLine, NO_NAME, kRefDefinition };
+                    parsed.m_refs.push_back(ref);
+                }
+                inTypedef = false;
+                declState = kDeclNone;
+                expectClassName = false; // a forward declaration
+            }
+            break;
+
+        case '=':
+        case ',':
+            if(parenDepth == 0 && declState == kDeclAfter) {
+                // int x = foo(); or void foo() = delete;
+                declState = kDeclNone;
+            }
+            break;
+
+        default:
+            break;
+        }
+        prevType = type;
+    }
+}
+
+wxUint32 CscopeIndex::DoGetNameId(const std::string& name)
+{
+    std::unordered_map<std::string, wxUint32>::iterator iter = m_nameIds.find(name);
+    if(iter != m_nameIds.end()) {
+        return iter->second;
+    }
+    wxUint32 id = m_names.size();
+    m_names.push_back(name);
+    m_nameIds.insert(std::make_pair(name, id));
+    m_postings.push_back(std::vector<Posting>());
+    return id;
+}
+
+void CscopeIndex::DoAddPosting(wxUint32 fileId, wxUint32 index)
+{
+    FileData& data = m_files[fileId];
+    std::vector<Posting>& files = m_postings[data.m_names[index]];
+    Posting posting = { fileId, index };
+    data.m_slots.push_back(files.size());
+    files.push_back(posting);
+}
+
+void CscopeIndex::DoRemoveFile(wxUint32 fileId)
+{
+    // Every file knows where it is in the posting lists, so removing it does not search them: the last entry of
+    // each list is moved to the freed slot
+    FileData& data = m_files[fileId];
+    for(size_t i = 0; i < data.m_names.size(); ++i) {
+        std::vector<Posting>& files = m_postings[data.m_names[i]];
+        wxUint32 slot = data.m_slots[i];
+        Posting last = files.back();
+        files[slot] = last;
+        m_files[last.m_file].m_slots[last.m_index] = slot;
+        files.pop_back();
+    }
+    data.m_names.clear();
+    data.m_slots.clear();
+    data.m_refs.clear();
+    data.m_lastModified = 0;
+    m_modified = true;
+}
+
+void CscopeIndex::DoStoreFile(const wxString& path, time_t lastModified, const ParsedFile& parsed)
+{
+    wxUint32 fileId;
+    std::unordered_map<wxString, wxUint32>::iterator iter = m_fileIds.find(path);
+    if(iter == m_fileIds.end()) {
+        fileId = m_files.size();
+        m_files.push_back(FileData());
+        m_files.back().m_path = path;
+        m_fileIds.insert(std::make_pair(path, fileId));
+    } else {
+        fileId = iter->second;
+        DoRemoveFile(fileId);
+    }
+
+    // Map the file's names to the global ones
+    FileData& data = m_files[fileId];
+    std::vector<wxUint32> ids(parsed.m_names.size());
+    data.m_names.reserve(parsed.m_names.size());
+    data.m_slots.reserve(parsed.m_names.size());
+    for(size_t i = 0; i < parsed.m_names.size(); ++i) {
+        ids[i] = DoGetNameId(parsed.m_names[i]);
+        data.m_names.push_back(ids[i]);
+        DoAddPosting(fileId, i);
+    }
+
+    data.m_refs.reserve(parsed.m_refs.size());
+    for(size_t i = 0; i < parsed.m_refs.size(); ++i) {
+        Ref ref = parsed.m_refs[i];
+        ref.m_name = ids[ref.m_name];
+        ref.m_function = (ref.m_function == NO_NAME) ? NO_NAME : ids[ref.m_function];
+        data.m_refs.push_back(ref);
+    }
+    data.m_lastModified = lastModified;
+    m_modified = true;
+}
+
+bool CscopeIndex::DoIndexFile(const wxString& path)
+{
+    time_t lastModified = FileUtils::GetFileModificationTime(wxFileName(path));
+    {
+        wxMutexLocker locker(m_mutex);
+        std::unordered_map<wxString, wxUint32>::iterator iter = m_fileIds.find(path);
+        if(iter != m_fileIds.end() && m_files[iter->second].m_lastModified == lastModified) {
+            return false; // up to date
+        }
+    }
+
+    // Tokenize outside of the lock, this is where the time goes
+    wxString content;
+    if(!ReadSourceFile(path, content)) {
+        return false;
+    }
+    ParsedFile parsed;
+    Parse(content, parsed);
+
+    wxMutexLocker locker(m_mutex);
+    DoStoreFile(path, lastModified, parsed);
+    return true;
+}
+
+size_t CscopeIndex::Update(const wxArrayString& files)
+{
+    {
+        // Drop the files that are no longer part of the scan scope
+        wxMutexLocker locker(m_mutex);
+        std::unordered_set<wxString> listed;
+        for(size_t i = 0; i < files.GetCount(); ++i) {
+            listed.insert(files.Item(i));
+        }
+        std::vector<wxString> removed;
+        std::unordered_map<wxString, wxUint32>::iterator iter = m_fileIds.begin();
+        for(; iter != m_fileIds.end(); ++iter) {
+            if(listed.count(iter->first) == 0) {
+                removed.push_back(iter->first);
+            }
+        }
+        for(size_t i = 0; i < removed.size(); ++i) {
+            wxUint32 fileId = m_fileIds[removed[i]];
+            DoRemoveFile(fileId);
+            m_files[fileId].m_path.Clear();
+            m_fileIds.erase(removed[i]);
+        }
+    }
+
+    size_t threadCount = wxThread::GetCPUCount();
+    threadCount = std::min(threadCount, (files.GetCount() / CSCOPE_MIN_FILES_PER_THREAD) + 1);
+    if(threadCount <= 1) {
+        size_t count = 0;
+        for(size_t i = 0; i < files.GetCount(); ++i) {
+            if(DoIndexFile(files.Item(i))) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    std::vector<CscopeIndexThread*> threads;
+    for(size_t i = 0; i < threadCount; ++i) {
+        CscopeIndexThread* thread = new CscopeIndexThread(this, files, i, threadCount);
+        if(thread->Create() == wxTHREAD_NO_ERROR && thread->Run() == wxTHREAD_NO_ERROR) {
+            threads.push_back(thread);
+        } else {
+            // Could not start it, do its share here
+            thread->Entry();
+            threads.push_back(thread);
+        }
+    }
+
+    size_t count = 0;
+    for(size_t i = 0; i < threads.size(); ++i) {
+        if(threads[i]->IsRunning() || threads[i]->IsPaused()) {
+            threads[i]->Wait();
+        }
+        count += threads[i]->GetCount();
+        delete threads[i];
+    }
+    clDEBUG() << "CScope: indexed" << count << "files out of" << files.GetCount() << clEndl;
+    return count;
+}
+
+bool CscopeIndex::UpdateFile(const wxString& path)
+{
+    {
+        wxMutexLocker locker(m_mutex);
+        if(m_fileIds.count(path) == 0) {
+            return false;
+        }
+    }
+    return DoIndexFile(path);
+}
+
+size_t CscopeIndex::Query(eCscopeQuery query, const wxString& word, CscopeIndexSink* sink) const
+{
+    std::string name = word.mb_str(wxConvUTF8).data();
+    if(query == kCscopeFilesIncluding) {
+        // includes are keyed by the file name
+        size_t slash = name.find_last_of("/\\");
+        if(slash != std::string::npos) {
+            name = name.substr(slash + 1);
+        }
+    }
+
+    // Collect the matches while holding the lock, the source lines are read afterwards
+    typedef std::vector<std::pair<wxUint32, wxString> > Matches_t;
+    std::vector<std::pair<wxString, Matches_t> > results;
+    {
+        wxMutexLocker locker(m_mutex);
+        std::unordered_map<std::string, wxUint32>::const_iterator iter = m_nameIds.find(name);
+        if(iter == m_nameIds.end()) {
+            return 0;
+        }
+        wxUint32 nameId = iter->second;
+        const std::vector<Posting>& files = m_postings[nameId];
+        for(size_t i = 0; i < files.size(); ++i) {
+            const FileData& data = m_files[files[i].m_file];
+            Matches_t matches;
+            if(query == kCscopeFindSymbol) {
+                // Located below by tokenizing the file
+                results.push_back(std::make_pair(data.m_path, matches));
+                continue;
+            }
+
+            for(size_t n = 0; n < data.m_refs.size(); ++n) {
+                const Ref& ref = data.m_refs[n];
+                switch(query) {
+                case kCscopeFindGlobalDefinition:
+                    if(ref.m_kind == kRefDefinition && ref.m_name == nameId) {
+                        matches.push_back(std::make_pair(ref.m_line, word));
+                    }
+                    break;
+                case kCscopeFunctionsCalledBy:
+                    if(ref.m_kind == kRefCall && ref.m_function == nameId) {
+                        matches.push_back(
+                            std::make_pair(ref.m_line, wxString(m_names[ref.m_name].c_str(), wxConvUTF8)));
+                    }
+                    break;
+                case kCscopeFunctionsCalling:
+                    if(ref.m_kind == kRefCall && ref.m_name == nameId) {
+                        matches.push_back(
+                            std::make_pair(ref.m_line, wxString(m_names[ref.m_function].c_str(), wxConvUTF8)));
+                    }
+                    break;
+                case kCscopeFilesIncluding:
+                    if(ref.m_kind == kRefInclude && ref.m_name == nameId) {
+                        matches.push_back(std::make_pair(ref.m_line, wxString(CSCOPE_GLOBAL_SCOPE)));
+                    }
+                    break;
+                default:
+                    break;
+                }
+            }
+            if(!matches.empty()) {
+                results.push_back(std::make_pair(data.m_path, matches));
+            }
+        }
+    }
+
+    std::sort(results.begin(), results.end());
+    size_t count = 0;
+    CScopeResultTable_t* table = new CScopeResultTable_t();
+    for(size_t i = 0; i < results.size(); ++i) {
+        const wxString& path = results[i].first;
+        Matches_t& matches = results[i].second;
+        wxString content;
+        if(!ReadSourceFile(path, content)) {
+            continue;
+        }
+
+        if(query == kCscopeFindSymbol) {
+            ParsedFile parsed;
+            Parse(content, parsed, name);
+            for(size_t n = 0; n < parsed.m_refs.size(); ++n) {
+                const Ref& ref = parsed.m_refs[n];
+                if(ref.m_kind == kRefSymbol) {
+                    wxString scope = (ref.m_function == NO_NAME)
+                                         ? wxString(CSCOPE_GLOBAL_SCOPE)
+                                         : wxString(parsed.m_names[ref.m_function].c_str(), wxConvUTF8);
+                    matches.push_back(std::make_pair(ref.m_line, scope));
+                }
+            }
+        }
+
+        if(!matches.empty()) {
+            DoAddResults(path, matches, table, content, (query == kCscopeFilesIncluding) ? word : wxString());
+            count += matches.size();
+        }
+
+        if(table->size() >= CSCOPE_RESULTS_BATCH) {
+            bool cont = sink->AddResults(table);
+            table = new CScopeResultTable_t();
+            if(!cont) {
+                break;
+            }
+        }
+    }
+
+    if(table->empty()) {
+        delete table;
+    } else {
+        sink->AddResults(table);
+    }
+    return count;
+}
+
+void CscopeIndex::DoAddResults(const wxString& path, const std::vector<std::pair<wxUint32, wxString> >& matches,
+                               CScopeResultTable_t* table, const wxString& content, const wxString& filter) const
+{
+    wxArrayString lines = ::wxStringTokenize(content, "\n", wxTOKEN_RET_EMPTY_ALL);
+    CScopeEntryDataVec_t* vec = new CScopeEntryDataVec_t();
+    vec->reserve(matches.size());
+    for(size_t i = 0; i < matches.size(); ++i) {
+        wxUint32 line = matches[i].first;
+        wxString pattern = (line > 0 && line <= lines.GetCount()) ? lines.Item(line - 1) : wxString();
+        pattern.Trim().Trim(false);
+        if(!filter.IsEmpty() && !pattern.Contains(filter)) {
+            continue;
+        }
+
+        CscopeEntryData data;
+        data.SetFile(path);
+        data.SetLine(line);
+        data.SetScope(matches[i].second);
+        data.SetPattern(pattern);
+        vec->push_back(data);
+    }
+
+    if(vec->empty()) {
+        delete vec;
+        return;
+    }
+    (*table)[path] = vec;
+}
+
+void CscopeIndex::Clear()
+{
+    wxMutexLocker locker(m_mutex);
+    m_files.clear();
+    m_fileIds.clear();
+    m_names.clear();
+    m_nameIds.clear();
+    m_postings.clear();
+    m_modified = false;
+}
+
+bool CscopeIndex::IsEmpty() const
+{
+    wxMutexLocker locker(m_mutex);
+    return m_fileIds.empty();
+}
+
+bool CscopeIndex::IsModified() const
+{
+    wxMutexLocker locker(m_mutex);
+    return m_modified;
+}
+
+bool CscopeIndex::Save(const wxFileName& filename)
+{
+    std::string buffer;
+    {
+        wxMutexLocker locker(m_mutex);
+        buffer.append(CSCOPE_INDEX_MAGIC);
+        WriteU32(buffer, CSCOPE_INDEX_VERSION);
+
+        WriteU32(buffer, m_names.size());
+        for(size_t i = 0; i < m_names.size(); ++i) {
+            WriteString(buffer, m_names[i]);
+        }
+
+        // Only the live files, the slots of the removed ones are not kept
+        WriteU32(buffer, m_fileIds.size());
+        for(size_t i = 0; i < m_files.size(); ++i) {
+            const FileData& data = m_files[i];
+            if(data.m_path.IsEmpty()) {
+                continue;
+            }
+            WriteString(buffer, data.m_path.mb_str(wxConvUTF8).data());
+            WriteU32(buffer, (wxUint32)data.m_lastModified);
+            WriteU32(buffer, data.m_refs.size());
+            for(size_t n = 0; n < data.m_refs.size(); ++n) {
+                const Ref& ref = data.m_refs[n];
+                WriteU32(buffer, ref.m_name);
+                WriteU32(buffer, ref.m_line);
+                WriteU32(buffer, ref.m_function);
+                WriteU32(buffer, ref.m_kind);
+            }
+            WriteU32(buffer, data.m_names.size());
+            for(size_t n = 0; n < data.m_names.size(); ++n) {
+                WriteU32(buffer, data.m_names[n]);
+            }
+        }
+        m_modified = false;
+    }
+
+    // Write a temporary file and rename it, a crash while saving must not leave a truncated index behind
+    wxString tmpFile = filename.GetFullPath() + ".tmp";
+    bool ok = false;
+    {
+        wxFFile fp(tmpFile, "w+b");
+        if(fp.IsOpened()) {
+            ok = (fp.Write(buffer.data(), buffer.length()) == buffer.length());
+            ok = fp.Close() && ok;
+        }
+    }
+    if(!ok || !::wxRenameFile(tmpFile, filename.GetFullPath(), true)) {
+        clWARNING() << "CScope: could not write the index file:" << filename.GetFullPath() << clEndl;
+        clRemoveFile(tmpFile);
+        // Keep the index marked as modified so it is saved again later
+        wxMutexLocker locker(m_mutex);
+        m_modified = true;
+        return false;
+    }
+    return true;
+}
+
+bool CscopeIndex::Load(const wxFileName& filename)
+{
+    Clear();
+
+    wxFFile fp(filename.GetFullPath(), "rb");
+    if(!fp.IsOpened()) {
+        return false;
+    }
+    std::string buffer(fp.Length(), '\0');
+    if(buffer.empty() || fp.Read(&buffer[0], buffer.length()) != buffer.length()) {
+        return false;
+    }
+    fp.Close();
+
+    size_t magicLen = strlen(CSCOPE_INDEX_MAGIC);
+    if(buffer.compare(0, magicLen, CSCOPE_INDEX_MAGIC) != 0) {
+        return false;
+    }
+    IndexReader reader(buffer, magicLen);
+    if(reader.ReadU32() != CSCOPE_INDEX_VERSION) {
+        return false;
+    }
+
+    wxMutexLocker locker(m_mutex);
+    wxUint32 nameCount = reader.ReadU32();
+    for(wxUint32 i = 0; reader.m_ok && i < nameCount; ++i) {
+        DoGetNameId(reader.ReadString());
+    }
+
+    wxUint32 fileCount = reader.ReadU32();
+    for(wxUint32 i = 0; reader.m_ok && i < fileCount; ++i) {
+        FileData data;
+        data.m_path = wxString(reader.ReadString().c_str(), wxConvUTF8);
+        data.m_lastModified = reader.ReadU32();
+        wxUint32 refCount = reader.ReadU32();
+        for(wxUint32 n = 0; reader.m_ok && n < refCount; ++n) {
+            Ref ref;
+            ref.m_name = reader.ReadU32();
+            ref.m_line = reader.ReadU32();
+            ref.m_function = reader.ReadU32();
+            ref.m_kind = reader.ReadU32();
+            data.m_refs.push_back(ref);
+        }
+        wxUint32 count = reader.ReadU32();
+        for(wxUint32 n = 0; reader.m_ok && n < count; ++n) {
+            data.m_names.push_back(reader.ReadU32());
+        }
+
+        // Check the ids before trusting them
+        for(size_t n = 0; reader.m_ok && n < data.m_names.size(); ++n) {
+            reader.m_ok = data.m_names[n] < m_names.size();
+        }
+        for(size_t n = 0; reader.m_ok && n < data.m_refs.size(); ++n) {
+            reader.m_ok = data.m_refs[n].m_name < m_names.size() &&
+                          (data.m_refs[n].m_function == NO_NAME || data.m_refs[n].m_function < m_names.size());
+        }
+        if(!reader.m_ok) {
+            break;
+        }
+
+        wxUint32 fileId = m_files.size();
+        m_fileIds.insert(std::make_pair(data.m_path, fileId));
+        m_files.push_back(data);
+        m_files.back().m_slots.reserve(data.m_names.size());
+        for(size_t n = 0; n < data.m_names.size(); ++n) {
+            DoAddPosting(fileId, n);
+        }
+    }
+
+    if(!reader.m_ok) {
+        clWARNING() << "CScope: the index file is corrupted:" << filename.GetFullPath() << clEndl;
+        m_files.clear();
+        m_fileIds.clear();
+        m_names.clear();
+        m_nameIds.clear();
+        m_postings.clear();
+        return false;
+    }
+    m_modified = false;
+    clDEBUG() << "CScope: loaded the index of" << m_files.size() << "files" << clEndl;
+    return true;
+}
@@ -0,0 +1,174 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// copyright            : (C) 2018 Eran Ifrah
+// file name            : cscopeindex.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+#ifndef __cscopeindex__
+#define __cscopeindex__
+
+#include "cscopeentrydata.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <wx/arrstr.h>
+#include <wx/filename.h>
+#include <wx/string.h>
+#include <wx/thread.h>
+
+enum eCscopeQuery {
+    kCscopeFindSymbol = 0,       // all the references to a symbol (cscope -0)
+    kCscopeFindGlobalDefinition, // where a function, class, macro or typedef is defined (cscope -1)
+    kCscopeFunctionsCalledBy,    // the calls made by a function (cscope -2)
+    kCscopeFunctionsCalling,     // the functions calling a function (cscope -3)
+    kCscopeFilesIncluding,       // the files #including a file (cscope -8)
+};
+
+/**
+ * @class CscopeIndexSink
+ * @brief receives the results of a query, a few files at a time
+ */
+class CscopeIndexSink
+{
+public:
+    virtual ~CscopeIndexSink() {}
+    /**
+     * @brief a batch of results. The sink takes ownership of 'table'.
+     * @return false to cancel the query
+     */
+    virtual bool AddResults(CScopeResultTable_t* table) = 0;
+};
+
+/**
+ * @class CscopeIndex
+ * @brief an in-process cross reference database, built from the CxxTokenizer tokens.
+ * For every file it keeps the definitions, the calls (with the calling function) and the #includes, plus the set of
+ * identifiers it uses. The references to a symbol are located by tokenizing only the files that use it.
+ * The index is thread safe: files are indexed in parallel and can be updated while it is queried
+ */
+class CscopeIndex
+{
+    friend class CscopeIndexThread;
+
+public:
+    enum eRefKind {
+        kRefDefinition = 0,
+        kRefCall,
+        kRefInclude,
+        kRefSymbol, // only collected while answering kCscopeFindSymbol
+    };
+
+    struct Ref {
+        wxUint32 m_name;
+        wxUint32 m_line;
+        wxUint32 m_function; // the enclosing function, or NO_NAME
+        wxUint32 m_kind;
+    };
+
+    /**
+     * @brief an entry in the list of the files using a name
+     */
+    struct Posting {
+        wxUint32 m_file;
+        wxUint32 m_index; // the position of the name in the file's m_names
+    };
+
+    struct FileData {
+        wxString m_path;
+        time_t m_lastModified;
+        std::vector<Ref> m_refs;
+        std::vector<wxUint32> m_names; // every identifier used in the file, once
+        std::vector<wxUint32> m_slots; // where the file is in the posting list of each of m_names
+        FileData()
+            : m_lastModified(0)
+        {
+        }
+    };
+
+    /**
+     * @brief the result of tokenizing one file, with names local to it
+     */
+    struct ParsedFile {
+        std::vector<std::string> m_names;
+        std::unordered_map<std::string, wxUint32> m_nameIds;
+        std::vector<Ref> m_refs;
+        wxUint32 GetNameId(const std::string& name);
+    };
+
+    static const wxUint32 NO_NAME = (wxUint32)-1;
+
+protected:
+    mutable wxMutex m_mutex;
+    std::vector<FileData> m_files;
+    std::unordered_map<wxString, wxUint32> m_fileIds;
+    std::vector<std::string> m_names;
+    std::unordered_map<std::string, wxUint32> m_nameIds;
+    std::vector<std::vector<Posting> > m_postings; // name id -> the files using it
+    bool m_modified;
+
+protected:
+    wxUint32 DoGetNameId(const std::string& name);
+    void DoAddPosting(wxUint32 fileId, wxUint32 index);
+    void DoRemoveFile(wxUint32 fileId);
+    void DoStoreFile(const wxString& path, time_t lastModified, const ParsedFile& parsed);
+    bool DoIndexFile(const wxString& path);
+    void DoAddResults(const wxString& path, const std::vector<std::pair<wxUint32, wxString> >& matches,
+                      CScopeResultTable_t* table, const wxString& content, const wxString& filter) const;
+
+public:
+    CscopeIndex();
+    virtual ~CscopeIndex();
+
+    /**
+     * @brief tokenize 'content' into 'parsed'. When 'symbol' is not empty, every use of it is collected as well
+     */
+    static void Parse(const wxString& content, ParsedFile& parsed, const std::string& symbol = "");
+
+    /**
+     * @brief make the index match 'files': index the new and the modified ones (in parallel) and drop those that are
+     * no longer in the list
+     * @return the number of files (re)indexed
+     */
+    size_t Update(const wxArrayString& files);
+
+    /**
+     * @brief re-index a single file, if it is part of the index
+     */
+    bool UpdateFile(const wxString& path);
+
+    /**
+     * @brief answer a query. The results are passed to 'sink' as they are found
+     * @return the number of matches
+     */
+    size_t Query(eCscopeQuery query, const wxString& word, CscopeIndexSink* sink) const;
+
+    void Clear();
+    bool IsEmpty() const;
+    bool IsModified() const;
+
+    /**
+     * @brief persist the index, so the next session starts from it instead of tokenizing everything again
+     */
+    bool Save(const wxFileName& filename);
+    bool Load(const wxFileName& filename);
+};
+
+#endif // __cscopeindex__
@@ -43,7 +43,6 @@
 
 CscopeTab::CscopeTab(wxWindow* parent, IManager* mgr)
     : CscopeTabBase(parent)
-    , m_table(NULL)
     , m_mgr(mgr)
 {
     m_styler.Reset(new clFindResultsStyler(m_stc));
@@ -75,27 +74,27 @@ CscopeTab::~CscopeTab()
 
 void CscopeTab::Clear()
 {
-    FreeTable();
     m_stc->SetEditable(true);
     m_stc->ClearAll();
     m_stc->SetEditable(false);
     m_matchesInStc.clear();
+    m_insertedItems.clear();
+    m_styler->SetStyles(m_stc);
 }
 
 void CscopeTab::BuildTable(CScopeResultTable_t* table)
 {
     CHECK_PTR_RET(table);
-    // Free the old table
-    FreeTable();
+    Clear();
+    AddResults(table);
+}
 
-    m_table = table;
-    ClearText();
-    m_matchesInStc.clear();
-    m_styler->SetStyles(m_stc);
+void CscopeTab::AddResults(CScopeResultTable_t* table)
+{
+    CHECK_PTR_RET(table);
 
-    wxStringSet_t insertedItems;
-    CScopeResultTable_t::iterator iter = m_table->begin();
-    for(; iter != m_table->end(); ++iter) {
+    CScopeResultTable_t::iterator iter = table->begin();
+    for(; iter != table->end(); ++iter) {
         wxString file = iter->first;
 
         // Add line for the file
@@ -109,27 +108,27 @@ void CscopeTab::BuildTable(CScopeResultTable_t* table)
             wxString display_string;
             display_string << _("Line: ") << entry.GetLine() << wxT(", ") << entry.GetScope() << wxT(", ")
                            << entry.GetPattern();
-            if(insertedItems.count(display_string) == 0) {
-                insertedItems.insert(display_string);
+            if(m_insertedItems.count(display_string) == 0) {
+                m_insertedItems.insert(display_string);
                 int lineno = m_stc->GetLineCount() - 1; // STC line number *before* we add the result
                 AddMatch(entry.GetLine(), entry.GetPattern());
                 m_matchesInStc.insert(std::make_pair(lineno, entry));
             }
         }
     }
-    FreeTable();
+    DeleteTable(table);
 }
 
-void CscopeTab::FreeTable()
+void CscopeTab::DeleteTable(CScopeResultTable_t* table)
 {
-    if(m_table) {
-        CScopeResultTable_t::iterator iter = m_table->begin();
-        for(; iter != m_table->end(); iter++) {
+    if(table) {
+        CScopeResultTable_t::iterator iter = table->begin();
+        for(; iter != table->end(); iter++) {
             // delete the vector
             delete iter->second;
         }
-        m_table->clear();
-        wxDELETE(m_table);
+        table->clear();
+        wxDELETE(table);
     }
 }
 
@@ -57,7 +57,6 @@ public:
 
 class CscopeTab : public CscopeTabBase
 {
-    CScopeResultTable_t* m_table;
     IManager* m_mgr;
     wxString m_findWhat;
     StringManager m_stringManager;
@@ -65,12 +64,12 @@ class CscopeTab : public CscopeTabBase
     BitmapLoader::BitmapMap_t m_bitmaps;
     clFindResultsStyler::Ptr_t m_styler;
     std::map<int, CscopeEntryData> m_matchesInStc;
+    wxStringSet_t m_insertedItems;
     
 protected:
     wxBitmap GetBitmap(const wxString& filename) const;
 
 protected:
-    void FreeTable();
     void OnClearResults(wxCommandEvent& e);
     void OnClearResultsUI(wxUpdateUIEvent& e);
     void OnChangeSearchScope(wxCommandEvent& e);
@@ -89,6 +88,16 @@ public:
     virtual ~CscopeTab();
 
     void BuildTable(CScopeResultTable_t* table);
+
+    /**
+     * @brief append a batch of results to the view. The table is deleted
+     */
+    void AddResults(CScopeResultTable_t* table);
+
+    /**
+     * @brief delete a result table and its content
+     */
+    static void DeleteTable(CScopeResultTable_t* table);
     void Clear();
     void SetMessage(const wxString& msg, int percent);
 
@@ -0,0 +1,230 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2018 Eran Ifrah
+// File name            : GitBlameCache.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "GitBlameCache.h"
+#include "cl_standard_paths.h"
+#include "file_logger.h"
+#include "fileutils.h"
+#include <algorithm>
+#include <functional>
+#include <wx/dir.h>
+#include <wx/filename.h>
+#include <wx/tokenzr.h>
+
+// Number of blames kept in memory
+#define GIT_BLAME_CACHE_MEMORY_ENTRIES 16
+
+// Limits of the on-disk cache. The least recently used files are removed first
+#define GIT_BLAME_CACHE_DISK_ENTRIES 500
+#define GIT_BLAME_CACHE_DISK_SIZE (64 * 1024 * 1024)
+
+//------------------------------------------------------------------------
+// GitIncrementalBlameParser
+//------------------------------------------------------------------------
+
+GitIncrementalBlameParser::GitIncrementalBlameParser()
+    : m_inGroup(false)
+{
+}
+
+GitIncrementalBlameParser::~GitIncrementalBlameParser() {}
+
+void GitIncrementalBlameParser::Clear()
+{
+    m_commits.clear();
+    m_partialLine.Clear();
+    m_current = Group();
+    m_inGroup = false;
+}
+
+void GitIncrementalBlameParser::Feed(const wxString& output, Group::Vec_t& groups)
+{
+    m_partialLine << output;
+    size_t start = 0;
+    size_t where = m_partialLine.find('\n');
+    while(where != wxString::npos) {
+        wxString line = m_partialLine.Mid(start, where - start);
+        if(line.EndsWith("\r")) { line.RemoveLast(); }
+        ParseLine(line, groups);
+        start = where + 1;
+        where = m_partialLine.find('\n', start);
+    }
+    m_partialLine.Remove(0, start);
+}
+
+void GitIncrementalBlameParser::ParseLine(const wxString& line, Group::Vec_t& groups)
+{
+    if(!m_inGroup) {
+        // <sha> <original-line> <final-line> <number-of-lines>
+        wxArrayString parts = ::wxStringTokenize(line, " ", wxTOKEN_STRTOK);
+        if(parts.GetCount() != 4 || parts.Item(0).length() != 40) { return; }
+
+        m_current = Group();
+        m_current.m_sha = parts.Item(0);
+        if(!parts.Item(2).ToLong(&m_current.m_finalLine) || !parts.Item(3).ToLong(&m_current.m_numLines)) { return; }
+        m_inGroup = true;
+        return;
+    }
+
+    wxString value;
+    if(line.StartsWith("author ", &value)) {
+        m_commits[m_current.m_sha].m_author = value;
+
+    } else if(line.StartsWith("author-time ", &value)) {
+        value.ToLong(&m_commits[m_current.m_sha].m_time);
+
+    } else if(line.StartsWith("filename ")) {
+        // end of the group
+        const CommitInfo& info = m_commits[m_current.m_sha];
+        m_current.m_author = info.m_author;
+        m_current.m_time = info.m_time;
+        groups.push_back(m_current);
+        m_inGroup = false;
+    }
+}
+
+//------------------------------------------------------------------------
+// GitBlameCache
+//------------------------------------------------------------------------
+
+GitBlameCache::GitBlameCache()
+    : m_maxEntries(GIT_BLAME_CACHE_MEMORY_ENTRIES)
+{
+    wxFileName folder(clStandardPaths::Get().GetUserDataDir(), "");
+    folder.AppendDir("git");
+    folder.AppendDir("blame");
+    folder.Mkdir(wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+    m_folder = folder.GetPath();
+}
+
+GitBlameCache::~GitBlameCache() {}
+
+wxString GitBlameCache::GetCacheFile(const wxString& key) const
+{
+    size_t hash = std::hash<std::wstring>()(key.ToStdWstring());
+    return wxFileName(m_folder, wxString::Format("%llx.blame", (unsigned long long)hash)).GetFullPath();
+}
+
+bool GitBlameCache::DoReadLine(const wxString& data, size_t& start, wxString& line) const
+{
+    size_t where = data.find('\n', start);
+    if(where == wxString::npos) { return false; }
+    line = data.Mid(start, where - start);
+    start = where + 1;
+    return true;
+}
+
+void GitBlameCache::DoInsert(const wxString& key, const Entry& entry)
+{
+    if(m_entries.count(key) == 0) {
+        m_lru.push_front(key);
+        if(m_lru.size() > m_maxEntries) {
+            m_entries.erase(m_lru.back());
+            m_lru.pop_back();
+        }
+    }
+    m_entries[key] = entry;
+}
+
+bool GitBlameCache::Get(const wxString& key, Entry& entry)
+{
+    std::map<wxString, Entry>::const_iterator iter = m_entries.find(key);
+    if(iter != m_entries.end()) {
+        entry = iter->second;
+        m_lru.remove(key);
+        m_lru.push_front(key);
+        return true;
+    }
+
+    // Try the disk: key, number of lines, the margins and then the content
+    wxString data;
+    wxFileName cacheFile(GetCacheFile(key));
+    if(!FileUtils::ReadFileContent(cacheFile, data)) { return false; }
+
+    size_t start = 0;
+    wxString header;
+    if(!DoReadLine(data, start, header) || header != key) { return false; } // hash collision
+
+    wxString countStr;
+    long count = 0;
+    if(!DoReadLine(data, start, countStr) || !countStr.ToLong(&count) || count < 0) { return false; }
+
+    Entry cached;
+    for(long i = 0; i < count; ++i) {
+        wxString margin;
+        if(!DoReadLine(data, start, margin)) { return false; }
+        cached.m_margins.Add(margin);
+    }
+    cached.m_content = data.Mid(start);
+
+    // The modification time is the last use time of the file
+    cacheFile.Touch();
+    DoInsert(key, cached);
+    entry = cached;
+    return true;
+}
+
+void GitBlameCache::Put(const wxString& key, const Entry& entry)
+{
+    DoInsert(key, entry);
+
+    wxString data;
+    data << key << "\n" << entry.m_margins.GetCount() << "\n";
+    for(size_t i = 0; i < entry.m_margins.GetCount(); ++i) {
+        data << entry.m_margins.Item(i) << "\n";
+    }
+    data << entry.m_content;
+    if(!FileUtils::WriteFileContent(GetCacheFile(key), data)) {
+        clDEBUG() << "Git blame: failed to write cache file for" << key << clEndl;
+    }
+    DoTrimDiskCache();
+}
+
+void GitBlameCache::DoTrimDiskCache()
+{
+    wxArrayString files;
+    wxDir::GetAllFiles(m_folder, &files, "*.blame", wxDIR_FILES);
+
+    // <last use time, size, path>
+    std::vector<std::pair<time_t, std::pair<size_t, wxString> > > entries;
+    size_t totalSize = 0;
+    for(size_t i = 0; i < files.GetCount(); ++i) {
+        size_t size = FileUtils::GetFileSize(files.Item(i));
+        totalSize += size;
+        entries.push_back(
+            std::make_pair(FileUtils::GetFileModificationTime(files.Item(i)), std::make_pair(size, files.Item(i))));
+    }
+    if(entries.size() <= GIT_BLAME_CACHE_DISK_ENTRIES && totalSize <= GIT_BLAME_CACHE_DISK_SIZE) { return; }
+
+    // Oldest first
+    std::sort(entries.begin(), entries.end());
+    size_t count = entries.size();
+    for(size_t i = 0; i < entries.size(); ++i) {
+        if(count <= GIT_BLAME_CACHE_DISK_ENTRIES && totalSize <= GIT_BLAME_CACHE_DISK_SIZE) { break; }
+        clRemoveFile(entries[i].second.second);
+        totalSize -= entries[i].second.first;
+        --count;
+    }
+}
@@ -0,0 +1,120 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2018 Eran Ifrah
+// File name            : GitBlameCache.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GITBLAMECACHE_H
+#define GITBLAMECACHE_H
+
+#include <list>
+#include <map>
+#include <vector>
+#include <wx/arrstr.h>
+#include <wx/string.h>
+
+/**
+ * @class GitIncrementalBlameParser
+ * @brief parses the output of 'git blame --incremental' as it is streamed. A line group is reported as soon as its
+ * 'filename' terminator is seen. The commit headers are sent only once per commit, so they are remembered here
+ */
+class GitIncrementalBlameParser
+{
+public:
+    struct Group {
+        wxString m_sha;
+        wxString m_author;
+        long m_time;
+        long m_finalLine; // 1 based
+        long m_numLines;
+        Group()
+            : m_time(0)
+            , m_finalLine(0)
+            , m_numLines(0)
+        {
+        }
+        typedef std::vector<Group> Vec_t;
+    };
+
+protected:
+    struct CommitInfo {
+        wxString m_author;
+        long m_time;
+        CommitInfo()
+            : m_time(0)
+        {
+        }
+    };
+
+    std::map<wxString, CommitInfo> m_commits;
+    wxString m_partialLine;
+    Group m_current;
+    bool m_inGroup;
+
+protected:
+    void ParseLine(const wxString& line, Group::Vec_t& groups);
+
+public:
+    GitIncrementalBlameParser();
+    virtual ~GitIncrementalBlameParser();
+
+    void Clear();
+    /**
+     * @brief process the next chunk of output. Completed groups are appended to 'groups'
+     */
+    void Feed(const wxString& output, Group::Vec_t& groups);
+};
+
+/**
+ * @class GitBlameCache
+ * @brief blame results per (repository, commit, arguments, file). Only blames of a given commit are cached, they never
+ * change. Recently used entries are kept in memory, the on-disk cache is capped in entries and size
+ */
+class GitBlameCache
+{
+public:
+    struct Entry {
+        wxString m_content;      // the file content at that commit
+        wxArrayString m_margins; // the blame margin text, one per line
+    };
+
+protected:
+    std::map<wxString, Entry> m_entries;
+    std::list<wxString> m_lru;
+    size_t m_maxEntries;
+    wxString m_folder;
+
+protected:
+    wxString GetCacheFile(const wxString& key) const;
+    void DoInsert(const wxString& key, const Entry& entry);
+    bool DoReadLine(const wxString& data, size_t& start, wxString& line) const;
+    void DoTrimDiskCache();
+
+public:
+    GitBlameCache();
+    virtual ~GitBlameCache();
+
+    bool Get(const wxString& key, Entry& entry);
+    void Put(const wxString& key, const Entry& entry);
+};
+
+#endif // GITBLAMECACHE_H
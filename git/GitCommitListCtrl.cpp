@@ -0,0 +1,40 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2018 Eran Ifrah
+// File name            : GitCommitListCtrl.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "GitCommitListCtrl.h"
+
+GitCommitListCtrl::GitCommitListCtrl(wxWindow* parent, wxWindowID id, const wxPoint& pos, const wxSize& size,
+                                     long style)
+    : wxDataViewCtrl(parent, id, pos, size, style)
+{
+}
+
+GitCommitListCtrl::~GitCommitListCtrl() {}
+
+wxDataViewColumn* GitCommitListCtrl::AppendTextColumn(const wxString& label, wxDataViewCellMode mode, int width,
+                                                      wxAlignment align, int flags)
+{
+    return wxDataViewCtrl::AppendTextColumn(label, GetColumnCount(), mode, width, align, flags);
+}
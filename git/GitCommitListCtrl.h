@@ -0,0 +1,51 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2018 Eran Ifrah
+// File name            : GitCommitListCtrl.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GITCOMMITLISTCTRL_H
+#define GITCOMMITLISTCTRL_H
+
+#include <wx/dataview.h>
+
+/**
+ * @class GitCommitListCtrl
+ * @brief the commit list of the log dialog. A plain wxDataViewCtrl, so it can show the virtual commits model, that
+ * also offers the wxDataViewListCtrl way of adding columns used by the generated dialog code
+ */
+class GitCommitListCtrl : public wxDataViewCtrl
+{
+public:
+    GitCommitListCtrl(wxWindow* parent, wxWindowID id = wxID_ANY, const wxPoint& pos = wxDefaultPosition,
+                      const wxSize& size = wxDefaultSize, long style = 0);
+    virtual ~GitCommitListCtrl();
+
+    using wxDataViewCtrl::AppendTextColumn;
+    /**
+     * @brief append a text column showing the next model column
+     */
+    wxDataViewColumn* AppendTextColumn(const wxString& label, wxDataViewCellMode mode, int width, wxAlignment align,
+                                       int flags);
+};
+
+#endif // GITCOMMITLISTCTRL_H
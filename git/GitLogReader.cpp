@@ -0,0 +1,161 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2018 Eran Ifrah
+// File name            : GitLogReader.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "GitLogReader.h"
+#include "asyncprocess.h"
+#include "file_logger.h"
+#include "processreaderthread.h"
+#include <wx/tokenzr.h>
+
+wxDEFINE_EVENT(wxEVT_GIT_LOG_COMMITS, clCommandEvent);
+wxDEFINE_EVENT(wxEVT_GIT_LOG_PAGE_DONE, clCommandEvent);
+
+// The fields are separated with the ASCII 'unit separator': unlike '@' it never appears in a subject line
+#define GIT_LOG_FIELD_SEPARATOR wxT('\x1f')
+
+GitLogReader::GitLogReader(wxEvtHandler* owner, const wxString& gitPath, const wxString& workingDir)
+    : m_owner(owner)
+    , m_gitPath(gitPath)
+    , m_workingDir(workingDir)
+    , m_process(NULL)
+    , m_pageCount(0)
+{
+    Bind(wxEVT_ASYNC_PROCESS_OUTPUT, &GitLogReader::OnProcessOutput, this);
+    Bind(wxEVT_ASYNC_PROCESS_TERMINATED, &GitLogReader::OnProcessTerminated, this);
+}
+
+GitLogReader::~GitLogReader()
+{
+    Unbind(wxEVT_ASYNC_PROCESS_OUTPUT, &GitLogReader::OnProcessOutput, this);
+    Unbind(wxEVT_ASYNC_PROCESS_TERMINATED, &GitLogReader::OnProcessTerminated, this);
+    wxDELETE(m_process);
+}
+
+bool GitLogReader::Start(const wxString& args, size_t skip, size_t count)
+{
+    Stop();
+
+    // Resuming from the last listed commit would follow its first parent only, and would be merged with any
+    // revision passed in 'args': --skip keeps the exact order and content of a single 'git log' run
+    wxString command;
+    command << m_gitPath << " --no-pager log --pretty=\"format:%h%x1f%an%x1f%ci%x1f%s\" -n " << count << " ";
+    if(skip) {
+        command << "--skip=" << skip << " ";
+    }
+    command << args;
+    clDEBUG() << "Git log:" << command << clEndl;
+
+    m_partialLine.Clear();
+    m_pageCount = 0;
+    m_process = ::CreateAsyncProcess(this, command, IProcessCreateDefault, m_workingDir);
+    if(!m_process) {
+        clWARNING() << "Git log: failed to execute:" << command << clEndl;
+        return false;
+    }
+    return true;
+}
+
+void GitLogReader::Stop()
+{
+    if(m_process) {
+        // Don't leave the process running (and reporting to us) in the background
+        m_process->Detach();
+        m_process->Terminate();
+        wxDELETE(m_process);
+    }
+    m_partialLine.Clear();
+}
+
+void GitLogReader::OnProcessOutput(clProcessEvent& event)
+{
+    if(event.GetProcess() != m_process) {
+        return; // a stopped page
+    }
+
+    // Only complete lines are sent, the remainder waits for the next chunk
+    wxString output = m_partialLine + event.GetOutput();
+    int where = output.Find('\n', true);
+    if(where == wxNOT_FOUND) {
+        m_partialLine.swap(output);
+        return;
+    }
+    m_partialLine = output.Mid(where + 1);
+    output.Truncate(where);
+    DoSendLines(output);
+}
+
+void GitLogReader::OnProcessTerminated(clProcessEvent& event)
+{
+    IProcess* process = event.GetProcess();
+    event.SetProcess(NULL);
+    if(process != m_process) {
+        wxDELETE(process);
+        return;
+    }
+    wxDELETE(m_process);
+
+    // "format:" does not terminate the last line
+    wxString lastLine;
+    lastLine.swap(m_partialLine);
+    DoSendLines(lastLine);
+
+    clCommandEvent evt(wxEVT_GIT_LOG_PAGE_DONE);
+    evt.SetInt(m_pageCount);
+    m_owner->ProcessEvent(evt);
+}
+
+void GitLogReader::DoSendLines(const wxString& output)
+{
+    wxArrayString lines;
+    wxArrayString tokens = ::wxStringTokenize(output, "\r\n", wxTOKEN_STRTOK);
+    for(size_t i = 0; i < tokens.GetCount(); ++i) {
+        // Skip anything that is not a commit line, e.g. an error message
+        if(tokens.Item(i).Find(GIT_LOG_FIELD_SEPARATOR) != wxNOT_FOUND) {
+            lines.Add(tokens.Item(i));
+        }
+    }
+    if(lines.IsEmpty()) {
+        return;
+    }
+
+    m_pageCount += lines.GetCount();
+    clCommandEvent evt(wxEVT_GIT_LOG_COMMITS);
+    evt.SetStrings(lines);
+    m_owner->ProcessEvent(evt);
+}
+
+bool GitLogReader::ParseLine(const wxString& line, wxString& hash, wxString& author, wxString& date,
+                             wxString& subject)
+{
+    wxArrayString fields = ::wxStringTokenize(line, wxString(GIT_LOG_FIELD_SEPARATOR), wxTOKEN_RET_EMPTY_ALL);
+    if(fields.GetCount() < 4) {
+        return false;
+    }
+    hash = fields.Item(0);
+    author = fields.Item(1);
+    date = fields.Item(2);
+    subject = fields.Item(3);
+    return true;
+}
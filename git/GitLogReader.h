@@ -0,0 +1,84 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2018 Eran Ifrah
+// File name            : GitLogReader.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GITLOGREADER_H
+#define GITLOGREADER_H
+
+#include "cl_command_event.h"
+#include <wx/event.h>
+#include <wx/string.h>
+
+class IProcess;
+class clProcessEvent;
+
+// A page of commits was read. GetStrings() holds the new commits, one log line each
+wxDECLARE_EVENT(wxEVT_GIT_LOG_COMMITS, clCommandEvent);
+// The page is complete. GetInt() holds the number of commits read for it
+wxDECLARE_EVENT(wxEVT_GIT_LOG_PAGE_DONE, clCommandEvent);
+
+/**
+ * @class GitLogReader
+ * @brief runs 'git log' one page at a time and streams the commits to its owner as git outputs them.
+ * The events are delivered synchronously, so nothing from a stopped page reaches the owner
+ */
+class GitLogReader : public wxEvtHandler
+{
+    wxEvtHandler* m_owner;
+    wxString m_gitPath;
+    wxString m_workingDir;
+    IProcess* m_process;
+    wxString m_partialLine;
+    size_t m_pageCount;
+
+protected:
+    void OnProcessOutput(clProcessEvent& event);
+    void OnProcessTerminated(clProcessEvent& event);
+    void DoSendLines(const wxString& output);
+
+public:
+    GitLogReader(wxEvtHandler* owner, const wxString& gitPath, const wxString& workingDir);
+    virtual ~GitLogReader();
+
+    /**
+     * @brief start reading 'count' commits, after skipping the first 'skip' ones. 'args' are passed as-is to
+     * git log (--grep, -S, --author, revisions...). A running page is stopped first
+     */
+    bool Start(const wxString& args, size_t skip, size_t count);
+
+    /**
+     * @brief stop and kill the running page, if any
+     */
+    void Stop();
+
+    bool IsRunning() const { return m_process != NULL; }
+    void SetWorkingDir(const wxString& workingDir) { this->m_workingDir = workingDir; }
+
+    /**
+     * @brief split a log line into its fields
+     */
+    static bool ParseLine(const wxString& line, wxString& hash, wxString& author, wxString& date, wxString& subject);
+};
+
+#endif // GITLOGREADER_H
@@ -0,0 +1,589 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2018 Eran Ifrah
+// File name            : GitStatusJob.cpp
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#include "GitStatusJob.h"
+#include "file_logger.h"
+#include <algorithm>
+#include <string.h>
+#include <string>
+#include <wx/ffile.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+
+wxDEFINE_EVENT(wxEVT_GIT_STATUS_DONE, clCommandEvent);
+
+// Below this number of files, a single thread checks the working tree
+#define GIT_STATUS_MIN_FILES_PER_THREAD 512
+
+namespace
+{
+inline wxUint32 ReadUint32(const unsigned char* p)
+{
+    return ((wxUint32)p[0] << 24) | ((wxUint32)p[1] << 16) | ((wxUint32)p[2] << 8) | (wxUint32)p[3];
+}
+
+inline wxUint16 ReadUint16(const unsigned char* p) { return (wxUint16)((p[0] << 8) | p[1]); }
+
+// Index v4 path prefix length, see git's varint.c
+bool ReadVarint(const unsigned char*& p, const unsigned char* end, size_t& value)
+{
+    if(p >= end) { return false; }
+    unsigned char c = *p++;
+    value = c & 127;
+    while(c & 128) {
+        if(p >= end) { return false; }
+        c = *p++;
+        value = ((value + 1) << 7) | (c & 127);
+    }
+    return true;
+}
+
+/**
+ * @brief minimal SHA-1, used to compare a racily clean file with its blob id
+ */
+class SHA1
+{
+    wxUint32 m_state[5];
+    unsigned char m_buffer[64];
+    wxUint64 m_length;
+    size_t m_used;
+
+    static inline wxUint32 Rol(wxUint32 value, int bits) { return (value << bits) | (value >> (32 - bits)); }
+
+    void Transform(const unsigned char* block)
+    {
+        wxUint32 w[80];
+        for(int i = 0; i < 16; ++i) {
+            w[i] = ReadUint32(block + (i * 4));
+        }
+        for(int i = 16; i < 80; ++i) {
+            w[i] = Rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        wxUint32 a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3], e = m_state[4];
+        for(int i = 0; i < 80; ++i) {
+            wxUint32 f, k;
+            if(i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if(i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if(i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            wxUint32 temp = Rol(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = Rol(b, 30);
+            b = a;
+            a = temp;
+        }
+        m_state[0] += a;
+        m_state[1] += b;
+        m_state[2] += c;
+        m_state[3] += d;
+        m_state[4] += e;
+    }
+
+public:
+    SHA1()
+        : m_length(0)
+        , m_used(0)
+    {
+        m_state[0] = 0x67452301;
+        m_state[1] = 0xEFCDAB89;
+        m_state[2] = 0x98BADCFE;
+        m_state[3] = 0x10325476;
+        m_state[4] = 0xC3D2E1F0;
+    }
+
+    void Update(const void* data, size_t len)
+    {
+        const unsigned char* p = (const unsigned char*)data;
+        m_length += len;
+        while(len) {
+            size_t count = std::min(len, sizeof(m_buffer) - m_used);
+            memcpy(m_buffer + m_used, p, count);
+            m_used += count;
+            p += count;
+            len -= count;
+            if(m_used == sizeof(m_buffer)) {
+                Transform(m_buffer);
+                m_used = 0;
+            }
+        }
+    }
+
+    void Final(unsigned char digest[20])
+    {
+        wxUint64 bits = m_length * 8;
+        unsigned char pad = 0x80;
+        Update(&pad, 1);
+        pad = 0;
+        while(m_used != 56) {
+            Update(&pad, 1);
+        }
+        unsigned char length[8];
+        for(int i = 0; i < 8; ++i) {
+            length[i] = (unsigned char)(bits >> (56 - (i * 8)));
+        }
+        Update(length, 8);
+        for(int i = 0; i < 20; ++i) {
+            digest[i] = (unsigned char)(m_state[i / 4] >> (24 - ((i % 4) * 8)));
+        }
+    }
+};
+
+/**
+ * @brief return true if the file content hashes to the blob id recorded in the index.
+ * Note that clean filters (e.g. core.autocrlf) are not applied, such files are reported as modified
+ */
+bool IsSameContent(const GitIndex::Entry& entry)
+{
+    wxFFile fp(entry.m_fullpath, "rb");
+    if(!fp.IsOpened()) { return false; }
+
+    SHA1 sha;
+    std::string header = "blob " + std::to_string((unsigned long long)entry.m_size);
+    sha.Update(header.c_str(), header.length() + 1); // include the terminating null
+
+    char buffer[64 * 1024];
+    size_t total = 0;
+    while(!fp.Eof()) {
+        size_t count = fp.Read(buffer, sizeof(buffer));
+        if(count == 0) { break; }
+        sha.Update(buffer, count);
+        total += count;
+    }
+    if(total != entry.m_size) { return false; }
+
+    unsigned char digest[20];
+    sha.Final(digest);
+    return memcmp(digest, entry.m_sha1, 20) == 0;
+}
+
+/**
+ * @brief check a slice of the index entries against the working tree
+ */
+class GitStatThread : public wxThread
+{
+    GitIndex::Vec_t& m_entries;
+    const std::vector<size_t>& m_indexes;
+    size_t m_from;
+    size_t m_to;
+    time_t m_indexMtime;
+
+public:
+    GitStatThread(GitIndex::Vec_t& entries, const std::vector<size_t>& indexes, size_t from, size_t to,
+                  time_t indexMtime)
+        : wxThread(wxTHREAD_JOINABLE)
+        , m_entries(entries)
+        , m_indexes(indexes)
+        , m_from(from)
+        , m_to(to)
+        , m_indexMtime(indexMtime)
+    {
+    }
+    virtual ~GitStatThread() {}
+
+    virtual void* Entry()
+    {
+        for(size_t i = m_from; i < m_to; ++i) {
+            GitIndex::Entry& entry = m_entries[m_indexes[i]];
+            entry.m_modified = GitIndex::IsEntryModified(entry, m_indexMtime);
+        }
+        return NULL;
+    }
+};
+}
+
+//------------------------------------------------------------------------
+// GitIndex
+//------------------------------------------------------------------------
+
+GitIndex::GitIndex()
+    : m_indexMtime(0)
+    , m_indexSize(0)
+    , m_loaded(false)
+{
+}
+
+GitIndex::~GitIndex() {}
+
+void GitIndex::SetRepositoryDirectory(const wxString& repoDir)
+{
+    wxMutexLocker locker(m_mutex);
+    if(m_loaded && m_repoDir == repoDir) {
+        // Same repository, keep the cache
+        return;
+    }
+    m_repoDir = repoDir;
+    m_indexFile.Clear();
+    m_indexMtime = 0;
+    m_indexSize = 0;
+    m_entries.clear();
+    m_pathToEntry.clear();
+    m_modified.clear();
+    m_loaded = false;
+}
+
+wxString GitIndex::DoGetIndexFile() const
+{
+    wxFileName dotgit(m_repoDir, ".git");
+    if(wxFileName::DirExists(dotgit.GetFullPath())) { return wxFileName(dotgit.GetFullPath(), "index").GetFullPath(); }
+
+    // A work tree or a submodule: ".git" is a file pointing to the real git folder
+    wxFFile fp(dotgit.GetFullPath(), "rb");
+    wxString content;
+    if(!fp.IsOpened() || !fp.ReadAll(&content)) { return ""; }
+    content.Trim().Trim(false);
+    if(!content.StartsWith("gitdir:", &content)) { return ""; }
+    content.Trim(false);
+
+    wxFileName gitdir(content, "");
+    if(!gitdir.IsAbsolute()) { gitdir.MakeAbsolute(m_repoDir); }
+    return wxFileName(gitdir.GetPath(), "index").GetFullPath();
+}
+
+bool GitIndex::DoParse(const wxString& indexFile, Vec_t& entries) const
+{
+    wxFFile fp(indexFile, "rb");
+    if(!fp.IsOpened()) { return false; }
+
+    std::vector<unsigned char> data(fp.Length());
+    if(data.size() < 12 || fp.Read(data.data(), data.size()) != data.size()) { return false; }
+
+    const unsigned char* p = data.data();
+    const unsigned char* end = p + data.size() - 20; // trailing checksum
+    if(memcmp(p, "DIRC", 4) != 0) { return false; }
+
+    wxUint32 version = ReadUint32(p + 4);
+    wxUint32 count = ReadUint32(p + 8);
+    if(version < 2 || version > 4) {
+        clWARNING() << "Git: unsupported index version " << (int)version << clEndl;
+        return false;
+    }
+    p += 12;
+
+    wxString prefix = m_repoDir;
+    if(!prefix.EndsWith(wxFileName::GetPathSeparator())) { prefix << wxFileName::GetPathSeparator(); }
+
+    entries.clear();
+    entries.reserve(count);
+    std::string path;
+    for(wxUint32 i = 0; i < count; ++i) {
+        const unsigned char* entryStart = p;
+        if(p + 62 > end) { return false; }
+
+        Entry entry;
+        entry.m_mtimeSec = ReadUint32(p + 8);
+        entry.m_mtimeNsec = ReadUint32(p + 12);
+        entry.m_ino = ReadUint32(p + 20);
+        entry.m_mode = ReadUint32(p + 24);
+        entry.m_size = ReadUint32(p + 36);
+        memcpy(entry.m_sha1, p + 40, 20);
+        wxUint16 flags = ReadUint16(p + 60);
+        p += 62;
+
+        wxUint16 extendedFlags = 0;
+        if(flags & 0x4000) {
+            if(version < 3 || p + 2 > end) { return false; }
+            extendedFlags = ReadUint16(p);
+            p += 2;
+        }
+
+        // The path
+        if(version == 4) {
+            size_t strip = 0;
+            if(!ReadVarint(p, end, strip) || strip > path.length()) { return false; }
+            path.erase(path.length() - strip);
+        } else {
+            path.clear();
+        }
+        const unsigned char* nul = (const unsigned char*)memchr(p, 0, end - p);
+        if(!nul) { return false; }
+        path.append((const char*)p, nul - p);
+        p = nul + 1;
+
+        // Entries are padded to a multiple of 8 bytes, except in version 4
+        if(version != 4) {
+            size_t len = (nul - entryStart) + 1;
+            p = entryStart + ((len + 7) & ~(size_t)7);
+        }
+
+        wxUint32 type = entry.m_mode & 0170000;
+        if(type == 0040000) {
+            // sparse directory entry
+            continue;
+        }
+
+        entry.m_fullpath = prefix + wxString::FromUTF8(path.c_str());
+#ifdef __WXMSW__
+        entry.m_fullpath.Replace("/", "\\");
+#endif
+        entry.m_conflict = ((flags >> 12) & 0x3) != 0;
+        entry.m_skip = (flags & 0x8000) || (extendedFlags & 0x4000) || type == 0160000 || type == 0120000;
+        entry.m_checked = false;
+        entry.m_lastMtime = 0;
+        entry.m_lastSize = 0;
+        entry.m_lastNsec = 0;
+        entry.m_modified = false;
+        entries.push_back(entry);
+    }
+
+    // A split index keeps its entries in a shared index file, let git handle it
+    while(p + 8 <= end) {
+        if(memcmp(p, "link", 4) == 0) {
+            clDEBUG() << "Git: split index is not supported by the index reader" << clEndl;
+            return false;
+        }
+        p += 8 + ReadUint32(p + 4);
+    }
+    return true;
+}
+
+bool GitIndex::DoLoad(GitStatusResult* result, bool& reloaded)
+{
+    reloaded = false;
+    if(m_indexFile.IsEmpty()) { m_indexFile = DoGetIndexFile(); }
+    if(m_indexFile.IsEmpty()) { return false; }
+
+    wxStructStat st;
+    if(wxStat(m_indexFile, &st) != 0) { return false; }
+    if(m_loaded && st.st_mtime == m_indexMtime && st.st_size == m_indexSize) { return true; }
+
+    Vec_t entries;
+    if(!DoParse(m_indexFile, entries)) { return false; }
+
+    // Keep the working tree results of the entries that did not change
+    std::unordered_map<wxString, size_t> pathToEntry;
+    pathToEntry.reserve(entries.size());
+    for(size_t i = 0; i < entries.size(); ++i) {
+        Entry& entry = entries[i];
+        if(pathToEntry.count(entry.m_fullpath)) {
+            // unmerged paths appear once per stage
+            entries[pathToEntry[entry.m_fullpath]].m_conflict = true;
+            entry.m_skip = true;
+            continue;
+        }
+        pathToEntry.insert(std::make_pair(entry.m_fullpath, i));
+
+        std::unordered_map<wxString, size_t>::const_iterator iter = m_pathToEntry.find(entry.m_fullpath);
+        if(iter == m_pathToEntry.end()) {
+            result->m_trackedAdded.insert(entry.m_fullpath);
+        } else {
+            const Entry& old = m_entries[iter->second];
+            if(old.m_checked && old.m_mtimeSec == entry.m_mtimeSec && old.m_mtimeNsec == entry.m_mtimeNsec &&
+               old.m_size == entry.m_size && memcmp(old.m_sha1, entry.m_sha1, 20) == 0) {
+                entry.m_checked = true;
+                entry.m_lastMtime = old.m_lastMtime;
+                entry.m_lastSize = old.m_lastSize;
+                entry.m_lastNsec = old.m_lastNsec;
+                entry.m_modified = old.m_modified;
+            }
+        }
+    }
+    for(std::unordered_map<wxString, size_t>::const_iterator iter = m_pathToEntry.begin(); iter != m_pathToEntry.end();
+        ++iter) {
+        if(pathToEntry.count(iter->first) == 0) { result->m_trackedRemoved.insert(iter->first); }
+    }
+
+    m_entries.swap(entries);
+    m_pathToEntry.swap(pathToEntry);
+    m_indexMtime = st.st_mtime;
+    m_indexSize = st.st_size;
+    m_loaded = true;
+    reloaded = true;
+    return true;
+}
+
+bool GitIndex::IsEntryModified(Entry& entry, time_t indexMtime)
+{
+    if(entry.m_skip) { return false; }
+    if(entry.m_conflict) { return true; }
+
+    wxStructStat st;
+    if(wxStat(entry.m_fullpath, &st) != 0) {
+        // deleted
+        entry.m_checked = false;
+        return true;
+    }
+
+    long nsec = 0;
+#ifdef __linux__
+    nsec = st.st_mtim.tv_nsec;
+#endif
+
+    // Same stat data as last time: same answer
+    if(entry.m_checked && entry.m_lastMtime == (wxInt64)st.st_mtime && entry.m_lastSize == (wxInt64)st.st_size &&
+       entry.m_lastNsec == nsec) {
+        return entry.m_modified;
+    }
+
+    bool modified = false;
+    if((wxUint32)st.st_size != entry.m_size) {
+        modified = true;
+#ifndef __WXMSW__
+    } else if((st.st_mode & S_IXUSR) != (entry.m_mode & S_IXUSR)) {
+        modified = true;
+#endif
+    } else {
+        bool statChanged = (wxUint32)st.st_mtime != entry.m_mtimeSec;
+#ifdef __linux__
+        statChanged = statChanged || (entry.m_mtimeNsec && (wxUint32)nsec != entry.m_mtimeNsec);
+#endif
+        // A file written in the same second as the index is "racily clean": its stat data can not be trusted
+        bool racy = (time_t)entry.m_mtimeSec >= indexMtime;
+        if(statChanged || racy) { modified = !IsSameContent(entry); }
+    }
+
+    entry.m_checked = true;
+    entry.m_lastMtime = st.st_mtime;
+    entry.m_lastSize = st.st_size;
+    entry.m_lastNsec = nsec;
+    return modified;
+}
+
+void GitIndex::DoCheckEntries(const std::vector<size_t>& indexes)
+{
+    size_t threadCount = std::max(1, wxThread::GetCPUCount());
+    threadCount = std::min(threadCount, (indexes.size() / GIT_STATUS_MIN_FILES_PER_THREAD) + 1);
+
+    // Split the work between the threads, the calling thread takes the first slice
+    std::vector<GitStatThread*> threads;
+    size_t sliceSize = (indexes.size() / threadCount) + 1;
+    for(size_t i = 1; i < threadCount; ++i) {
+        size_t from = i * sliceSize;
+        size_t to = std::min(indexes.size(), from + sliceSize);
+        if(from >= to) { break; }
+
+        GitStatThread* thread = new GitStatThread(m_entries, indexes, from, to, m_indexMtime);
+        if(thread->Create() != wxTHREAD_NO_ERROR || thread->Run() != wxTHREAD_NO_ERROR) {
+            // Could not start the thread, do it here
+            thread->Entry();
+            delete thread;
+            continue;
+        }
+        threads.push_back(thread);
+    }
+
+    for(size_t i = 0; i < std::min(sliceSize, indexes.size()); ++i) {
+        Entry& entry = m_entries[indexes[i]];
+        entry.m_modified = IsEntryModified(entry, m_indexMtime);
+    }
+
+    for(size_t i = 0; i < threads.size(); ++i) {
+        threads[i]->Wait();
+        delete threads[i];
+    }
+}
+
+void GitIndex::Refresh(const wxArrayString& files, GitStatusResult* result)
+{
+    wxMutexLocker locker(m_mutex);
+
+    bool reloaded = false;
+    if(!DoLoad(result, reloaded)) {
+        result->m_ok = false;
+        return;
+    }
+    result->m_ok = true;
+
+    std::vector<size_t> indexes;
+    bool fullRefresh = files.IsEmpty() || reloaded;
+    if(fullRefresh) {
+        indexes.reserve(m_entries.size());
+        for(size_t i = 0; i < m_entries.size(); ++i) {
+            indexes.push_back(i);
+        }
+    } else {
+        for(size_t i = 0; i < files.GetCount(); ++i) {
+            std::unordered_map<wxString, size_t>::const_iterator iter = m_pathToEntry.find(files.Item(i));
+            if(iter != m_pathToEntry.end()) { indexes.push_back(iter->second); }
+        }
+    }
+
+    DoCheckEntries(indexes);
+
+    if(fullRefresh) {
+        wxStringSet_t modified;
+        for(size_t i = 0; i < m_entries.size(); ++i) {
+            const Entry& entry = m_entries[i];
+            if(!entry.m_modified) { continue; }
+            modified.insert(entry.m_fullpath);
+            if(m_modified.count(entry.m_fullpath) == 0) { result->m_modifiedAdded.insert(entry.m_fullpath); }
+        }
+        for(wxStringSet_t::const_iterator iter = m_modified.begin(); iter != m_modified.end(); ++iter) {
+            if(modified.count(*iter) == 0) { result->m_modifiedRemoved.insert(*iter); }
+        }
+        m_modified.swap(modified);
+
+    } else {
+        for(size_t i = 0; i < indexes.size(); ++i) {
+            const Entry& entry = m_entries[indexes[i]];
+            bool wasModified = m_modified.count(entry.m_fullpath) != 0;
+            if(entry.m_modified && !wasModified) {
+                m_modified.insert(entry.m_fullpath);
+                result->m_modifiedAdded.insert(entry.m_fullpath);
+            } else if(!entry.m_modified && wasModified) {
+                m_modified.erase(entry.m_fullpath);
+                result->m_modifiedRemoved.insert(entry.m_fullpath);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+// GitStatusJob
+//------------------------------------------------------------------------
+
+GitStatusJob::GitStatusJob(wxEvtHandler* parent, GitIndex* index, const wxArrayString& files)
+    : Job(parent)
+    , m_index(index)
+    , m_files(files)
+{
+}
+
+GitStatusJob::~GitStatusJob() {}
+
+void GitStatusJob::Process(wxThread* thread)
+{
+    wxUnusedVar(thread);
+    GitStatusResult* result = new GitStatusResult();
+    m_index->Refresh(m_files, result);
+
+    if(m_parent) {
+        clCommandEvent event(wxEVT_GIT_STATUS_DONE);
+        event.SetClientObject(result);
+        m_parent->AddPendingEvent(event);
+    } else {
+        delete result;
+    }
+}
@@ -0,0 +1,154 @@
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+//
+// Copyright            : (C) 2018 Eran Ifrah
+// File name            : GitStatusJob.h
+//
+// -------------------------------------------------------------------------
+// A
+//              _____           _      _     _ _
+//             /  __ \         | |    | |   (_) |
+//             | /  \/ ___   __| | ___| |    _| |_ ___
+//             | |    / _ \ / _  |/ _ \ |   | | __/ _ )
+//             | \__/\ (_) | (_| |  __/ |___| | ||  __/
+//              \____/\___/ \__,_|\___\_____/_|\__\___|
+//
+//                                                  F i l e
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef GITSTATUSJOB_H
+#define GITSTATUSJOB_H
+
+#include "cl_command_event.h"
+#include "job.h"
+#include "macros.h"
+#include <unordered_map>
+#include <vector>
+#include <wx/arrstr.h>
+#include <wx/thread.h>
+
+// Sent to the job's parent when a status refresh completes.
+// clCommandEvent::GetClientObject() holds a GitStatusResult
+wxDECLARE_EVENT(wxEVT_GIT_STATUS_DONE, clCommandEvent);
+
+/**
+ * @class GitStatusResult
+ * @brief the changes found by a status refresh, relative to the previous refresh
+ */
+class GitStatusResult : public wxClientData
+{
+public:
+    bool m_ok;                        // false if the index could not be read. Use 'git ls-files' instead
+    wxStringSet_t m_trackedAdded;     // files that became tracked
+    wxStringSet_t m_trackedRemoved;   // files that are no longer tracked
+    wxStringSet_t m_modifiedAdded;    // files that became modified
+    wxStringSet_t m_modifiedRemoved;  // files that are no longer modified
+
+    GitStatusResult()
+        : m_ok(false)
+    {
+    }
+    virtual ~GitStatusResult() {}
+    bool IsEmpty() const
+    {
+        return m_trackedAdded.empty() && m_trackedRemoved.empty() && m_modifiedAdded.empty() &&
+               m_modifiedRemoved.empty();
+    }
+};
+
+/**
+ * @class GitIndex
+ * @brief an in-process replacement for 'git ls-files' and 'git ls-files -m'. Reads .git/index directly and compares
+ * the stat data recorded there against the working tree. The index is re-read only when it changes on disk, and the
+ * per-file results are kept between calls so unchanged files are never hashed twice
+ */
+class GitIndex
+{
+public:
+    struct Entry {
+        wxString m_fullpath;
+        wxUint32 m_mtimeSec;
+        wxUint32 m_mtimeNsec;
+        wxUint32 m_ino;
+        wxUint32 m_mode;
+        wxUint32 m_size;
+        unsigned char m_sha1[20];
+        bool m_skip;     // assume-unchanged, skip-worktree and gitlink entries are never reported as modified
+        bool m_conflict; // unmerged entry
+
+        // The stat data seen during the last check, and what it was resolved to
+        bool m_checked;
+        wxInt64 m_lastMtime;
+        wxInt64 m_lastSize;
+        long m_lastNsec;
+        bool m_modified;
+    };
+    typedef std::vector<Entry> Vec_t;
+
+protected:
+    wxString m_repoDir;
+    wxString m_indexFile;
+    time_t m_indexMtime;
+    wxFileOffset m_indexSize;
+    Vec_t m_entries;
+    std::unordered_map<wxString, size_t> m_pathToEntry;
+    wxStringSet_t m_modified;
+    bool m_loaded;
+    wxMutex m_mutex;
+
+protected:
+    bool DoLoad(GitStatusResult* result, bool& reloaded);
+    bool DoParse(const wxString& indexFile, Vec_t& entries) const;
+    void DoCheckEntries(const std::vector<size_t>& indexes);
+    wxString DoGetIndexFile() const;
+
+public:
+    GitIndex();
+    virtual ~GitIndex();
+
+    /**
+     * @brief set the repository folder. Clears all the cached data if the folder changed
+     */
+    void SetRepositoryDirectory(const wxString& repoDir);
+
+    /**
+     * @brief refresh the status of 'files' (absolute paths) or of all the tracked files if 'files' is empty.
+     * Thread safe, called from the status job
+     */
+    void Refresh(const wxArrayString& files, GitStatusResult* result);
+
+    /**
+     * @brief check a single index entry against the working tree
+     */
+    static bool IsEntryModified(Entry& entry, time_t indexMtime);
+};
+
+/**
+ * @class GitStatusJob
+ * @brief runs GitIndex::Refresh in the background and reports the deltas to its parent
+ */
+class GitStatusJob : public Job
+{
+    GitIndex* m_index;
+    wxArrayString m_files;
+
+public:
+    /**
+     * @param parent receives the wxEVT_GIT_STATUS_DONE event
+     * @param index the plugin's index cache
+     * @param files the files to check (absolute paths). An empty list means: all the tracked files
+     */
+    GitStatusJob(wxEvtHandler* parent, GitIndex* index, const wxArrayString& files);
+    virtual ~GitStatusJob();
+
+    virtual void Process(wxThread* thread);
+};
+
+#endif // GITSTATUSJOB_H
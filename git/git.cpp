@@ -60,6 +60,7 @@
 #include "gitBlameDlg.h"
 #include "gitCloneDlg.h"
 #include "icons/icon_git.xpm"
+#include "jobqueue.h"
 #include "overlaytool.h"
 #include "project.h"
 #include <wx/ffile.h>
@@ -131,6 +132,12 @@ GitPlugin::GitPlugin(IManager* manager)
     , m_commitListDlg(NULL)
     , m_commandProcessor(NULL)
     , m_gitBlameDlg(NULL)
+    , m_statusQueue(NULL)
+    , m_nativeStatus(true)
+    , m_statusJobRunning(false)
+    , m_statusRefreshPending(false)
+    , m_statusRepaintPending(false)
+    , m_statusJobRepaint(false)
 {
     m_longName = _("GIT plugin");
     m_shortName = wxT("Git");
@@ -138,6 +145,7 @@ GitPlugin::GitPlugin(IManager* manager)
 
     Bind(wxEVT_ASYNC_PROCESS_OUTPUT, &GitPlugin::OnProcessOutput, this);
     Bind(wxEVT_ASYNC_PROCESS_TERMINATED, &GitPlugin::OnProcessTerminated, this);
+    Bind(wxEVT_GIT_STATUS_DONE, &GitPlugin::OnGitStatusDone, this);
 
     EventNotifier::Get()->Connect(wxEVT_INIT_DONE, wxCommandEventHandler(GitPlugin::OnInitDone), NULL, this);
     EventNotifier::Get()->Connect(wxEVT_WORKSPACE_LOADED, wxCommandEventHandler(GitPlugin::OnWorkspaceLoaded), NULL,
@@ -145,6 +153,8 @@ GitPlugin::GitPlugin(IManager* manager)
     EventNotifier::Get()->Connect(wxEVT_WORKSPACE_CLOSED, wxCommandEventHandler(GitPlugin::OnWorkspaceClosed), NULL,
                                   this);
     EventNotifier::Get()->Connect(wxEVT_FILE_SAVED, clCommandEventHandler(GitPlugin::OnFileSaved), NULL, this);
+    EventNotifier::Get()->Bind(wxEVT_FILES_MODIFIED_REPLACE_IN_FILES, &GitPlugin::OnFilesModifiedReplaceInFiles, this);
+    EventNotifier::Get()->Bind(wxEVT_FILE_SYSTEM_UPDATED, &GitPlugin::OnFileSystemUpdated, this);
     EventNotifier::Get()->Connect(wxEVT_PROJ_FILE_ADDED, clCommandEventHandler(GitPlugin::OnFilesAddedToProject), NULL,
                                   this);
     EventNotifier::Get()->Connect(wxEVT_PROJ_FILE_REMOVED, clCommandEventHandler(GitPlugin::OnFilesRemovedFromProject),
@@ -420,6 +430,8 @@ void GitPlugin::UnPlug()
     /*SYSTEM*/
     EventNotifier::Get()->Disconnect(wxEVT_INIT_DONE, wxCommandEventHandler(GitPlugin::OnInitDone), NULL, this);
     EventNotifier::Get()->Disconnect(wxEVT_FILE_SAVED, clCommandEventHandler(GitPlugin::OnFileSaved), NULL, this);
+    EventNotifier::Get()->Unbind(wxEVT_FILES_MODIFIED_REPLACE_IN_FILES, &GitPlugin::OnFilesModifiedReplaceInFiles, this);
+    EventNotifier::Get()->Unbind(wxEVT_FILE_SYSTEM_UPDATED, &GitPlugin::OnFileSystemUpdated, this);
     EventNotifier::Get()->Disconnect(wxEVT_WORKSPACE_LOADED, wxCommandEventHandler(GitPlugin::OnWorkspaceLoaded), NULL,
                                      this);
     EventNotifier::Get()->Disconnect(wxEVT_PROJ_FILE_ADDED, clCommandEventHandler(GitPlugin::OnFilesAddedToProject),
@@ -447,6 +459,11 @@ void GitPlugin::UnPlug()
     wxTheApp->Bind(wxEVT_MENU, &GitPlugin::OnFolderStashPop, this, XRCID("git_stash_pop_folder"));
     Unbind(wxEVT_ASYNC_PROCESS_OUTPUT, &GitPlugin::OnProcessOutput, this);
     Unbind(wxEVT_ASYNC_PROCESS_TERMINATED, &GitPlugin::OnProcessTerminated, this);
+    Unbind(wxEVT_GIT_STATUS_DONE, &GitPlugin::OnGitStatusDone, this);
+    if(m_statusQueue) {
+        m_statusQueue->Stop();
+        wxDELETE(m_statusQueue);
+    }
     m_tabToggler.reset(NULL);
 }
 
@@ -510,6 +527,7 @@ void GitPlugin::DoSetRepoPath(const wxString& repoPath, bool promptUser)
         }
 
         m_repositoryDirectory = dir;
+        m_gitIndex.SetRepositoryDirectory(m_repositoryDirectory);
         data.SetProjectLastRepoPath(workspaceName, projectName, m_repositoryDirectory);
         conf.WriteItem(&data);
         conf.Save();
@@ -748,9 +766,12 @@ void GitPlugin::OnCommit(wxCommandEvent& e)
 void GitPlugin::OnCommitList(wxCommandEvent& e)
 {
     wxUnusedVar(e);
-    gitAction ga(gitCommitList, wxT(""));
-    m_gitActionQueue.push_back(ga);
-    ProcessGitActionQueue();
+    if(m_repositoryDirectory.IsEmpty()) return;
+
+    // The dialog reads the history itself, a page at a time
+    if(!m_commitListDlg) { m_commitListDlg = new GitCommitListDlg(m_topWindow, m_repositoryDirectory, this); }
+    m_commitListDlg->Show();
+    m_commitListDlg->ReloadCommits();
 }
 
 /*******************************************************************************/
@@ -898,9 +919,13 @@ wxString GitPlugin::GetEditorRelativeFilepath() const // Called by OnGitBlame or
 /*******************************************************************************/
 void GitPlugin::DoGitBlame(const wxString& args) // Called by OnGitBlame or the git blame dialog
 {
-    gitAction ga(gitBlame, args);
-    m_gitActionQueue.push_back(ga);
-    ProcessGitActionQueue();
+    if(m_repositoryDirectory.IsEmpty()) return;
+
+    // The dialog runs the blame itself, streaming the result as it arrives
+    if(!m_gitBlameDlg) { m_gitBlameDlg = new GitBlameDlg(m_topWindow, this); }
+    m_gitBlameDlg->Show();
+    m_gitBlameDlg->SetFocus();
+    m_gitBlameDlg->StartBlame(args);
 }
 /*******************************************************************************/
 void GitPlugin::OnGitBlameRevList(const wxString& arg, const wxString& filepath,
@@ -983,12 +1008,143 @@ void GitPlugin::OnFileSaved(clCommandEvent& e)
         DoSetTreeItemImage(m_mgr->GetTree(TreeFileView), it->second, OverlayTool::Bmp_Modified);
     }
 
-    gitAction ga(gitListModified, wxT(""));
-    m_gitActionQueue.push_back(ga);
-    ProcessGitActionQueue();
+    // Only the saved file needs to be compared against the index
+    wxArrayString files;
+    files.Add(e.GetFileName());
+    if(!DoRefreshStatus(files)) {
+        gitAction ga(gitListModified, wxT(""));
+        m_gitActionQueue.push_back(ga);
+        ProcessGitActionQueue();
+    }
     RefreshFileListView();
 }
 
+/*******************************************************************************/
+void GitPlugin::OnFilesModifiedReplaceInFiles(clFileSystemEvent& e)
+{
+    e.Skip();
+    if(!IsGitEnabled() || e.GetStrings().IsEmpty()) return;
+    if(!DoRefreshStatus(e.GetStrings())) {
+        gitAction ga(gitListModified, wxT(""));
+        m_gitActionQueue.push_back(ga);
+        ProcessGitActionQueue();
+    }
+}
+
+/*******************************************************************************/
+void GitPlugin::OnFileSystemUpdated(clFileSystemEvent& e)
+{
+    e.Skip();
+    if(!IsGitEnabled()) return;
+    // The index is re-read only if it was changed on disk
+    DoRefreshStatus(wxArrayString());
+}
+
+/*******************************************************************************/
+bool GitPlugin::DoRefreshStatus(const wxArrayString& files, bool repaintAll)
+{
+    if(!m_nativeStatus || m_repositoryDirectory.IsEmpty()) return false;
+
+    if(repaintAll) { m_statusRepaintPending = true; }
+    if(m_statusJobRunning) {
+        // Coalesce the requests received while a refresh is in progress
+        if(files.IsEmpty()) {
+            m_statusRefreshPending = true;
+        } else {
+            for(size_t i = 0; i < files.GetCount(); ++i) {
+                m_statusPendingFiles.Add(files.Item(i));
+            }
+        }
+        return true;
+    }
+
+    if(!m_statusQueue) {
+        m_statusQueue = new JobQueue();
+        m_statusQueue->Start(1);
+    }
+    m_statusJobRunning = true;
+    m_statusJobRepaint = m_statusRepaintPending;
+    m_statusRepaintPending = false;
+    m_statusQueue->PushJob(new GitStatusJob(this, &m_gitIndex, files));
+    return true;
+}
+
+/*******************************************************************************/
+void GitPlugin::OnGitStatusDone(clCommandEvent& e)
+{
+    m_statusJobRunning = false;
+    bool repaintAll = m_statusJobRepaint;
+    m_statusJobRepaint = false;
+
+    GitStatusResult* result = dynamic_cast<GitStatusResult*>(e.GetClientObject());
+    if(result && IsGitEnabled()) {
+        if(result->m_ok) {
+            DoApplyStatus(*result);
+            // A full listing was requested (e.g. the tree was rebuilt): the deltas are not enough
+            if(repaintAll) { DoRepaintStatus(); }
+
+        } else {
+            // Could not read the index (e.g. split index or unknown version), let git do the work from now on
+            GIT_MESSAGE1(wxT("Could not read the git index, using 'git ls-files' instead"));
+            m_nativeStatus = false;
+            m_statusRefreshPending = false;
+            m_statusRepaintPending = false;
+            m_statusPendingFiles.Clear();
+            m_gitActionQueue.push_back(gitAction(gitListAll, wxT("")));
+            m_gitActionQueue.push_back(gitAction(gitListModified, wxT("")));
+            ProcessGitActionQueue();
+            return;
+        }
+    }
+
+    // Serve the requests received while the job was running
+    if(m_statusRefreshPending || m_statusRepaintPending) {
+        m_statusRefreshPending = false;
+        m_statusPendingFiles.Clear();
+        DoRefreshStatus(wxArrayString());
+
+    } else if(!m_statusPendingFiles.IsEmpty()) {
+        wxArrayString files;
+        files.swap(m_statusPendingFiles);
+        DoRefreshStatus(files);
+    }
+}
+
+/*******************************************************************************/
+void GitPlugin::DoApplyStatus(const GitStatusResult& result)
+{
+    if(result.IsEmpty()) return;
+
+    wxStringSet_t::const_iterator iter;
+    for(iter = result.m_trackedRemoved.begin(); iter != result.m_trackedRemoved.end(); ++iter) {
+        m_trackedFiles.erase(*iter);
+    }
+    m_trackedFiles.insert(result.m_trackedAdded.begin(), result.m_trackedAdded.end());
+
+    // Files which are no longer modified go back to the 'tracked' image
+    wxStringSet_t toOK = result.m_trackedAdded;
+    for(iter = result.m_modifiedRemoved.begin(); iter != result.m_modifiedRemoved.end(); ++iter) {
+        m_modifiedFiles.erase(*iter);
+        if(m_trackedFiles.count(*iter)) { toOK.insert(*iter); }
+    }
+    m_modifiedFiles.insert(result.m_modifiedAdded.begin(), result.m_modifiedAdded.end());
+
+    // Only the items that changed are updated
+    wxTreeCtrl* tree = m_mgr->GetTree(TreeFileView);
+    if(!toOK.empty()) { ColourFileTree(tree, toOK, OverlayTool::Bmp_OK); }
+    if(!result.m_modifiedAdded.empty()) { ColourFileTree(tree, result.m_modifiedAdded, OverlayTool::Bmp_Modified); }
+}
+
+/*******************************************************************************/
+void GitPlugin::DoRepaintStatus()
+{
+    wxTreeCtrl* tree = m_mgr->GetTree(TreeFileView);
+    m_mgr->SetStatusMessage(_("Colouring tracked git files..."), 0);
+    ColourFileTree(tree, m_trackedFiles, OverlayTool::Bmp_OK);
+    ColourFileTree(tree, m_modifiedFiles, OverlayTool::Bmp_Modified);
+    m_mgr->SetStatusMessage("", 0);
+}
+
 /*******************************************************************************/
 void GitPlugin::OnFilesAddedToProject(clCommandEvent& e)
 {
@@ -1045,6 +1201,16 @@ void GitPlugin::ProcessGitActionQueue()
 
     if(m_process) { return; }
 
+    if((ga.action == gitListAll && !m_bActionRequiresTreUpdate) || ga.action == gitListModified) {
+        // Answered in-process from the git index, no need to spawn git. A full listing repaints the entire
+        // tree, not only the files whose status changed since the last refresh
+        if(DoRefreshStatus(wxArrayString(), true)) {
+            m_gitActionQueue.pop_front();
+            ProcessGitActionQueue();
+            return;
+        }
+    }
+
     wxString command = m_pathGITExecutable;
 
     // Wrap the executable with quotes if needed
@@ -1226,20 +1392,6 @@ void GitPlugin::ProcessGitActionQueue()
         GIT_MESSAGE(wxT("%s. Repo path: %s"), command.c_str(), m_repositoryDirectory.c_str());
         break;
 
-    case gitCommitList:
-        GIT_MESSAGE(wxT("Listing commits..."));
-        ShowProgress(wxT("Fetching commit list"));
-        // hash @ author-name @ date @ subject
-        command << wxT(" --no-pager log --pretty=\"%h@%an@%ci@%s\" -n 100 ") << ga.arguments;
-        GIT_MESSAGE(wxT("%s. Repo path: %s"), command.c_str(), m_repositoryDirectory.c_str());
-        break;
-
-    case gitBlame:
-        GIT_MESSAGE("Git blame...");
-        command << " --no-pager blame --line-porcelain " << ga.arguments;
-        GIT_MESSAGE("Git blame: %s", command);
-        break;
-
     case gitRevlist:
         command << " --no-pager rev-list " << ga.arguments;
         GIT_MESSAGE("Git rev-list: %s", command);
@@ -1559,12 +1711,6 @@ void GitPlugin::OnProcessTerminated(clProcessEvent& event)
             AddDefaultActions();
         }
 
-    } else if(ga.action == gitBlame) {
-        if(!m_gitBlameDlg) { m_gitBlameDlg = new GitBlameDlg(m_topWindow, this); }
-        m_gitBlameDlg->SetBlame(m_commandOutput, ga.arguments);
-        m_gitBlameDlg->Show();
-        m_gitBlameDlg->SetFocus();
-
     } else if(ga.action == gitRevlist) {
         if(m_gitBlameDlg) { m_gitBlameDlg->OnRevListOutput(m_commandOutput, ga.arguments); }
 
@@ -1644,15 +1790,6 @@ void GitPlugin::OnProcessTerminated(clProcessEvent& event)
         // Reload files if needed
         EventNotifier::Get()->PostReloadExternallyModifiedEvent(true);
 
-    } else if(ga.action == gitCommitList) {
-        if(m_commitListDlg) {
-            m_commitListDlg->SetCommitList(m_commandOutput);
-        } else {
-            m_commitListDlg = new GitCommitListDlg(m_topWindow, m_repositoryDirectory, this);
-            m_commitListDlg->SetCommitList(m_commandOutput);
-        }
-        m_commitListDlg->Show();
-
     } else if(ga.action == gitRevertCommit) {
         AddDefaultActions();
     }
@@ -1690,8 +1827,8 @@ void GitPlugin::OnProcessOutput(clProcessEvent& event)
     tmpOutput.Trim().Trim(false);
     tmpOutput.MakeLower();
 
-    if(ga.action != gitDiffRepoCommit && ga.action != gitDiffFile && ga.action != gitCommitList &&
-       ga.action != gitDiffRepoShow && ga.action != gitBlame && ga.action != gitRevlist)
+    if(ga.action != gitDiffRepoCommit && ga.action != gitDiffFile &&
+       ga.action != gitDiffRepoShow && ga.action != gitRevlist)
 
     {
         if(tmpOutput.Contains("username for")) {
@@ -1779,6 +1916,7 @@ void GitPlugin::InitDefaults()
 
     if(!repoPath.IsEmpty() && wxFileName::DirExists(repoPath + wxFileName::GetPathSeparator() + wxT(".git"))) {
         m_repositoryDirectory = repoPath;
+        m_gitIndex.SetRepositoryDirectory(m_repositoryDirectory);
 
     } else {
         DoCleanup();
@@ -1936,6 +2074,11 @@ void GitPlugin::DoCleanup()
     m_remoteBranchList.Clear();
     m_trackedFiles.clear();
     m_modifiedFiles.clear();
+    m_gitIndex.SetRepositoryDirectory("");
+    m_nativeStatus = true;
+    m_statusRefreshPending = false;
+    m_statusRepaintPending = false;
+    m_statusPendingFiles.Clear();
     m_addedFiles = false;
     m_progressMessage.Clear();
     m_commandOutput.Clear();
@@ -2575,15 +2718,6 @@ void GitPlugin::WorkspaceClosed()
     m_workspaceFilename.Clear();
 }
 
-void GitPlugin::FetchNextCommits(int skip, const wxString& args)
-{
-    wxString skipCommits;
-    skipCommits << " --skip=" << skip;
-    gitAction ga(gitCommitList, args + skipCommits);
-    m_gitActionQueue.push_back(ga);
-    ProcessGitActionQueue();
-}
-
 void GitPlugin::OnFileGitBlame(wxCommandEvent& event)
 {
     // Sanity
@@ -50,9 +50,11 @@
 #include "gitui.h"
 #include <vector>
 #include "clTabTogglerHelper.h"
+#include "GitStatusJob.h"
 
 class clCommandProcessor;
 class GitBlameDlg;
+class JobQueue;
 
 class gitAction
 {
@@ -124,8 +126,6 @@ class GitPlugin : public IPlugin
         gitBranchListRemote,
         gitBranchSwitch,
         gitBranchSwitchRemote,
-        gitCommitList,
-        gitBlame,
         gitRevlist,
         gitRebase,
         gitGarbageCollection,
@@ -171,6 +171,14 @@ class GitPlugin : public IPlugin
     clCommandProcessor* m_commandProcessor;
     clTabTogglerHelper::Ptr_t m_tabToggler;
     GitBlameDlg* m_gitBlameDlg;
+    GitIndex m_gitIndex;
+    JobQueue* m_statusQueue;
+    bool m_nativeStatus;
+    bool m_statusJobRunning;
+    bool m_statusRefreshPending;
+    bool m_statusRepaintPending; // the next status job repaints the whole tree
+    bool m_statusJobRepaint;     // the running status job repaints the whole tree
+    wxArrayString m_statusPendingFiles;
 
 private:
     void DoCreateTreeImages();
@@ -207,6 +215,9 @@ private:
     void DoShowDiffsForFiles(const wxArrayString& files, bool useFileAsBase = false);
     void DoSetRepoPath(const wxString& repoPath = "", bool promptUser = true);
     void DoRecoverFromGitCommandError();
+    bool DoRefreshStatus(const wxArrayString& files, bool repaintAll = false);
+    void DoApplyStatus(const GitStatusResult& result);
+    void DoRepaintStatus();
 
     DECLARE_EVENT_TABLE()
 
@@ -219,6 +230,9 @@ private:
     void OnFolderMenu(clContextMenuEvent& event);
 
     void OnFileSaved(clCommandEvent& e);
+    void OnFilesModifiedReplaceInFiles(clFileSystemEvent& e);
+    void OnFileSystemUpdated(clFileSystemEvent& e);
+    void OnGitStatusDone(clCommandEvent& e);
     void OnFilesAddedToProject(clCommandEvent& e);
     void OnFilesRemovedFromProject(clCommandEvent& e);
     void OnWorkspaceLoaded(wxCommandEvent& e);
@@ -282,13 +296,6 @@ public:
      */
     bool IsGitEnabled() const;
     
-    /**
-     * @brief fetch the next 100 commits (skip 'skip' first commits)
-     * and show them in the commit list dialog
-     * @param skip number of first commits to skip
-     */
-    void FetchNextCommits(int skip, const wxString& args);
-
     GitConsole* GetConsole() { return m_console; }
     const wxString& GetRepositoryDirectory() const { return m_repositoryDirectory; }
     IProcess* GetProcess() { return m_process; }
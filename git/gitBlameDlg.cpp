@@ -10,6 +10,8 @@
 #include "processreaderthread.h"
 #include <wx/dcmemory.h>
 #include <wx/bitmap.h>
+#include "fileutils.h"
+#include <vector>
 
 #define TEXT_MARGIN_ID 0
 #define LINENUMBER_MARGIN_ID 1
@@ -17,79 +19,30 @@
 #define AUTHOR_WIDTH 15
 #define HASH_WIDTH 8
 
-size_t FindAuthorLine(wxArrayString& blameArr, size_t n, wxString* author) // Helper function
-{
-    for(; n < blameArr.GetCount(); ++n) {
-        if(blameArr.Item(n).StartsWith("author ", author)) {
-            break;
-        }
-    }
-    return n; // which will now index either the next 'author ' field, or the end of the array
-}
-
 // The text margin needs to be 24 chars wide for the date & hash, the max author-width, plus 2 spaces between
 static int marginwidth = DATE_WIDTH + AUTHOR_WIDTH + HASH_WIDTH + 2;
 
-// Helper function. 'n' indexes any previous 'author ' field + 1
-wxArrayString ParseBlame(wxStyledTextCtrl* stc, wxArrayString& blameArr, size_t& n)
+// Helper function: the margin text of a blamed line
+wxString FormatMargin(const wxString& sha, const wxString& authorName, long datetime)
 {
-    // For a format supposedly designed for easy parsing, porcelain is decidedly unhelpful
-    // Each line's entry usually has 13 fields but may have 12 (or less?)
-    // Most fields start with a descriptive string e.g. 'author', 'filename', but the hash and the code-line don't.
-    // 'author ' should normally be present, so search for that and then guess
-    wxArrayString arr;
-    wxString hash, author, dtstring, date;
-    n = FindAuthorLine(blameArr, n, &author);
-    if(n == blameArr.GetCount()) {
-        return arr; // Either something went wrong or we've reached the end
-    }
-
-    // OK, we've found the author field. The hash should be the previous field
-    hash = blameArr.Item(n - 1);
-    wxCHECK_MSG(hash.Len() > 39, arr,
-        "What should have been the 'commit-hash' field is too short"); // Something went seriously wrong, or the output
-                                                                       // is very strange. Skip.
-    hash = ' ' + hash.Left(8);
-
-    for(size_t c = n + 1; c < blameArr.GetCount(); ++c) {
-        if(blameArr.Item(c).StartsWith("author-time ", &dtstring)) {
-            break;
-        }
-        if(blameArr.Item(c).StartsWith("author ")) {
-            break; // Abort as we've overrun into the next blame line!
+    wxString date;
+    if(datetime) {
+        wxDateTime dt((time_t)datetime);
+        if(dt.IsValid()) {
+            date = dt.Format("%d-%m-%Y ");
         }
     }
-    if(!dtstring.empty()) { // Don't abort the whole item just because there's no date
-        long datetime;
-        if(dtstring.ToLong(&datetime)) {
-            wxDateTime dt((time_t)datetime);
-            if(dt.IsValid()) {
-                date = dt.Format("%d-%m-%Y ");
-            }
-        }
-    }
-
-    // To find the code-line, the safest way is to find the _next_ 'author ' and work backwards
-    size_t cl = FindAuthorLine(blameArr, n + 1, NULL);
-    if(cl == blameArr.GetCount()) {
-        --cl; // This must be the last item, so the code-line should be at the end
-    } else {
-        cl -= 2; // -1 for the next item's author field, -1 for its hash,
-    }
 
-    // Now create the margin line, carefully: the central 'author' field is truncated/padded to fill the available space
+    // The central 'author' field is truncated/padded to fill the available space
     // All this would be much easier if scintilla allowed writing text to 3 'text' margins, but afaict it doesn't
+    wxString author = authorName;
     author.Truncate(AUTHOR_WIDTH);
     author.Pad(AUTHOR_WIDTH - author.Len(), ' ');
 
     wxString margin;
-    margin << date << author << hash;
-
-    wxASSERT(margin.Len() <= marginwidth);
-    arr.Add(margin);
-    arr.Add(blameArr.Item(cl)); // code-line
-
-    return arr;
+    margin << date << author << ' ' << sha.Left(HASH_WIDTH);
+    wxASSERT(margin.Len() <= (size_t)marginwidth);
+    return margin;
 }
 
 void StoreExtraArgs(wxComboBox* m_comboExtraArgs, const wxString extraArgs) // Helper function
@@ -112,6 +65,11 @@ GitBlameDlg::GitBlameDlg(wxWindow* parent, GitPlugin* plugin)
     , m_sashPositionMain(0)
     , m_sashPositionV(0)
     , m_sashPositionH(0)
+    , m_process(NULL)
+    , m_blameProcess(NULL)
+    , m_contentProcess(NULL)
+    , m_diffProcess(NULL)
+    , m_blameLineCount(0)
 {
     WindowAttrManager::Load(this);
     m_editEventsHandler.Reset(new clEditEventsHandler(m_stcBlame));
@@ -154,6 +112,10 @@ GitBlameDlg::GitBlameDlg(wxWindow* parent, GitPlugin* plugin)
 GitBlameDlg::~GitBlameDlg()
 {
     m_editEventsHandler.Reset(NULL);
+    Unbind(wxEVT_ASYNC_PROCESS_OUTPUT, &GitBlameDlg::OnProcessOutput, this);
+    Unbind(wxEVT_ASYNC_PROCESS_TERMINATED, &GitBlameDlg::OnProcessTerminated, this);
+    DoCancelBlame();
+    wxDELETE(m_process);
     
     clConfig conf("git.conf");
     GitEntry data;
@@ -177,6 +139,12 @@ GitBlameDlg::~GitBlameDlg()
 
 void GitBlameDlg::OnCloseDialog(wxCommandEvent& event)
 {
+    DoCancelBlame();
+    m_blameKey.Clear();
+    m_margins.Clear();
+    m_prevCommit.Clear();
+    m_prevMargins.Clear();
+    m_stcBlame->SetReadOnly(false);
     m_stcBlame->ClearAll();
     m_choiceHistory->Clear();
     m_comboExtraArgs->Clear();
@@ -187,18 +155,97 @@ void GitBlameDlg::OnCloseDialog(wxCommandEvent& event)
     Hide();
 }
 
-void GitBlameDlg::SetBlame(const wxString& blame, const wxString& args)
+void GitBlameDlg::StartBlame(const wxString& args)
 {
+    // Remember the current blame, stepping to its parent commit reuses it
+    if(!m_blameCommit.empty() && IsBlameComplete()) {
+        m_prevCommit = m_blameCommit;
+        m_prevExtraArgs = m_blameExtraArgs;
+        m_prevFile = m_blameFile;
+        m_prevMargins = m_margins;
+    }
+    DoCancelBlame();
+
+    // args is either "<file>" or "<commit> [extra-args] -- <file>"
     wxString filename = args;
-    size_t where = args.Find(" -- ");
+    m_blameCommit.Clear();
+    m_blameExtraArgs.Clear();
+    int where = args.Find(" -- ");
     if(where != wxNOT_FOUND) {
         filename = args.Mid(where + 4);
+        wxString rest = args.Left(where);
+        rest.Trim().Trim(false);
+        m_blameCommit = rest.BeforeFirst(' ');
+        m_blameExtraArgs = rest.AfterFirst(' ');
+        m_blameExtraArgs.Trim().Trim(false);
     }
     filename.Trim().Trim(false);
+    m_blameFile = filename;
 
     clDEBUG() << "GitBlame is called for file:" << filename << clEndl;
-    clDEBUG1() << "GitBlame 'blame':\n" << blame << clEndl;
+    DoPrepareEditor(filename);
+
+    // Only the blame of a given commit can be cached: the working copy changes
+    m_blameKey.Clear();
+    if(!m_blameCommit.empty()) {
+        m_blameKey << m_plugin->GetRepositoryDirectory() << "|" << m_blameCommit << "|" << m_blameExtraArgs << "|"
+                   << m_blameFile;
+        GitBlameCache::Entry entry;
+        if(m_blameCache.Get(m_blameKey, entry)) {
+            clDEBUG() << "GitBlame: using cached blame for" << m_blameKey << clEndl;
+            DoShowContent(entry.m_content);
+            for(size_t i = 0; i < entry.m_margins.GetCount(); ++i) {
+                DoSetMarginText(i, entry.m_margins.Item(i));
+            }
+            DoBlameCompleted();
+            return;
+        }
+    }
+
+    if(m_blameCommit.empty()) {
+        // The working copy: the content is on the disk
+        wxString content;
+        // m_blameFile is relative to the repository root and may contain folders
+        wxFileName fn(m_blameFile);
+        fn.MakeAbsolute(m_plugin->GetRepositoryDirectory());
+        FileUtils::ReadFileContent(fn, content);
+        DoShowContent(content);
+        DoStartBlameProcess("");
+
+    } else {
+        // Fetch the file content at that commit first, the blame fills the margins while streaming in
+        wxString path = m_blameFile;
+        path.Replace("\\", "/");
+        wxString command = wxString::Format("%s --no-pager show %s:\"%s\"", m_gitPath, m_blameCommit, path);
+        m_contentOutput.Clear();
+        m_contentProcess =
+            ::CreateAsyncProcess(this, command, IProcessCreateDefault, m_plugin->GetRepositoryDirectory());
+        if(!m_contentProcess) {
+            clWARNING() << "GitBlame: failed to execute:" << command << clEndl;
+        }
+    }
+}
+
+void GitBlameDlg::DoKillProcess(IProcess*& process)
+{
+    if(process) {
+        // Stop the notifications first, we don't want the events of a cancelled process
+        process->Detach();
+        process->Terminate();
+        wxDELETE(process);
+    }
+}
+
+void GitBlameDlg::DoCancelBlame()
+{
+    DoKillProcess(m_blameProcess);
+    DoKillProcess(m_contentProcess);
+    DoKillProcess(m_diffProcess);
+    m_blameParser.Clear();
+}
 
+void GitBlameDlg::DoPrepareEditor(const wxString& filename)
+{
     // Set blame editor style and fonts
     LexerConf::Ptr_t lexer = ColoursAndFontsManager::Get().GetLexerForFile(wxFileName(filename).GetFullName());
     if(!lexer) {
@@ -224,41 +271,167 @@ void GitBlameDlg::SetBlame(const wxString& blame, const wxString& args)
     m_stcBlame->SetMarginWidth(TEXT_MARGIN_ID, marginwidth * charWidth);
     m_stcBlame->SetMarginSensitive(TEXT_MARGIN_ID, true);
 
-    wxArrayString lines = wxStringTokenize(blame, "\n");
-    const size_t count = lines.GetCount();
-    wxString blameCommit;
-    if(args.Contains(" -- ")) {
-        // This must be a subsequent SetBlame call after a dclick. We can get the commit from args
-        blameCommit = args.Left(8);
+    // In case we're re-entering, ensure we're r/w. For a wxSTC 'readonly' also means can't append text programatically
+    m_stcBlame->SetReadOnly(false);
+    m_stcBlame->ClearAll();
+    m_stcBlame->SetReadOnly(true);
+    m_margins.Clear();
+    m_blameLineCount = 0;
+}
+
+void GitBlameDlg::DoShowContent(const wxString& content)
+{
+    m_stcBlame->SetReadOnly(false);
+    m_stcBlame->SetText(content);
+    m_stcBlame->SetReadOnly(true);
+
+    // git does not blame the empty line after the last EOL
+    m_blameLineCount = m_stcBlame->GetLineCount();
+    if(m_blameLineCount && (content.IsEmpty() || content.Last() == '\n')) {
+        --m_blameLineCount;
     }
+    m_margins.Clear();
+    m_margins.Add(wxEmptyString, m_blameLineCount);
 
-    size_t numlen =
-        wxString::Format("%i", (int)count).length(); // How many digits must we allow room for in the number margin?
+    size_t numlen = wxString::Format("%i", (int)m_blameLineCount)
+                        .length(); // How many digits must we allow room for in the number margin?
     int m_stcBlame_PixelWidth = 4 + numlen * m_stcBlame->TextWidth(wxSTC_STYLE_LINENUMBER, "9");
     m_stcBlame->SetMarginType(LINENUMBER_MARGIN_ID, wxSTC_MARGIN_NUMBER);
     m_stcBlame->SetMarginWidth(LINENUMBER_MARGIN_ID, m_stcBlame_PixelWidth);
+}
 
-    // In case we're re-entering, ensure we're r/w. For a wxSTC 'readonly' also means can't append text programatically
-    m_stcBlame->SetReadOnly(false);
-    m_stcBlame->ClearAll();
+void GitBlameDlg::DoSetMarginText(size_t line, const wxString& text)
+{
+    if(line >= m_margins.GetCount()) {
+        return;
+    }
+    m_margins.Item(line) = text;
+    m_stcBlame->MarginSetText(line, text);
+}
+
+bool GitBlameDlg::IsBlameComplete() const
+{
+    if(m_blameProcess || m_contentProcess || m_diffProcess) {
+        return false;
+    }
+    for(size_t i = 0; i < m_margins.GetCount(); ++i) {
+        if(m_margins.Item(i).IsEmpty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void GitBlameDlg::DoStartBlameProcess(const wxString& ranges)
+{
+    m_blameParser.Clear();
+
+    wxString command;
+    command << m_gitPath << " --no-pager blame --incremental " << ranges;
+    if(!m_blameCommit.empty()) {
+        command << " " << m_blameCommit;
+    }
+    if(!m_blameExtraArgs.empty()) {
+        command << " " << m_blameExtraArgs;
+    }
+    command << " -- \"" << m_blameFile << "\"";
+    clDEBUG() << "GitBlame:" << command << clEndl;
+
+    m_blameProcess = ::CreateAsyncProcess(this, command, IProcessCreateDefault, m_plugin->GetRepositoryDirectory());
+    if(!m_blameProcess) {
+        clWARNING() << "GitBlame: failed to execute:" << command << clEndl;
+    }
+}
+
+void GitBlameDlg::DoApplyParentBlame(const wxString& diff)
+{
+    // 'diff' is "git diff -U0 <commit> <child-commit>". The lines outside of its hunks are unchanged in the child, so
+    // they have the same blame there. Only the lines that the child commit modified need to be blamed again
+    std::vector<size_t> childLine(m_blameLineCount + 1, 0); // our line number -> child line number, 0 = unknown
+    size_t line = 1, child = 1;
+    wxArrayString lines = ::wxStringTokenize(diff, "\n", wxTOKEN_STRTOK);
+    for(size_t i = 0; i < lines.GetCount(); ++i) {
+        // @@ -start[,count] +start[,count] @@
+        wxString hunk;
+        if(!lines.Item(i).StartsWith("@@ -", &hunk)) {
+            continue;
+        }
+        wxString ours = hunk.BeforeFirst(' ');
+        wxString theirs = hunk.AfterFirst('+').BeforeFirst(' ');
+        long start = 0, count = 1, childStart = 0, childCount = 1;
+        if(!ours.BeforeFirst(',').ToLong(&start) || !theirs.BeforeFirst(',').ToLong(&childStart)) {
+            continue;
+        }
+        if(ours.Contains(",")) {
+            ours.AfterFirst(',').ToLong(&count);
+        }
+        if(theirs.Contains(",")) {
+            theirs.AfterFirst(',').ToLong(&childCount);
+        }
+
+        // A zero count means "after line 'start'"
+        size_t unchangedEnd = (count == 0) ? start : start - 1;
+        while(line <= unchangedEnd && line <= m_blameLineCount) {
+            childLine[line++] = child++;
+        }
+        line = (count == 0) ? start + 1 : start + count;
+        child = (childCount == 0) ? childStart + 1 : childStart + childCount;
+    }
+    while(line <= m_blameLineCount) {
+        childLine[line++] = child++;
+    }
+
+    // Reuse the child's blame and collect the line ranges that must be blamed
+    wxString ranges;
+    size_t rangeCount = 0;
+    long rangeStart = -1;
+    wxString childHash = m_prevCommit.Left(HASH_WIDTH);
+    for(size_t i = 1; i <= m_blameLineCount + 1; ++i) {
+        bool known = false;
+        if(i <= m_blameLineCount && childLine[i] && childLine[i] <= m_prevMargins.GetCount()) {
+            const wxString& margin = m_prevMargins.Item(childLine[i] - 1);
+            if(!margin.IsEmpty() && !margin.EndsWith(childHash)) {
+                DoSetMarginText(i - 1, margin);
+                known = true;
+            }
+        }
 
-    for(size_t n = 0, line = 0; n < count; ++n) {
-        wxArrayString item = ParseBlame(m_stcBlame, lines, n);
-        if(!item.GetCount()) {
-            continue; // The entry must be corrupt, or we overran
+        if(!known && i <= m_blameLineCount) {
+            if(rangeStart == -1) {
+                rangeStart = i;
+            }
+        } else if(rangeStart != -1) {
+            ranges << " -L " << rangeStart << "," << (i - 1);
+            ++rangeCount;
+            rangeStart = -1;
         }
+    }
 
-        // We must append each code-line before doing MarginSetText(), which seems to fail if the line doesn't yet exist
-        m_stcBlame->AppendText(item.Item(1) + '\n');
-        m_stcBlame->MarginSetText(line++, item.Item(0));
+    if(rangeCount == 0) {
+        DoBlameCompleted();
+    } else if(rangeCount > 100) {
+        // Too fragmented, blame the whole file
+        DoStartBlameProcess("");
+    } else {
+        DoStartBlameProcess(ranges);
     }
+}
 
-    m_stcBlame->SetReadOnly(true); // Now we can safely set it to r/o
+void GitBlameDlg::DoBlameCompleted()
+{
+    if(!m_blameKey.empty() && IsBlameComplete()) {
+        GitBlameCache::Entry entry;
+        if(!m_blameCache.Get(m_blameKey, entry)) {
+            entry.m_content = m_stcBlame->GetText();
+            entry.m_margins = m_margins;
+            m_blameCache.Put(m_blameKey, entry);
+        }
+    }
 
     m_commitStore.LoadChoice(m_choiceHistory);
-    if(!blameCommit.empty()) {
+    if(!m_blameCommit.empty()) {
         for(size_t n = 0; n < m_choiceHistory->GetCount(); ++n) {
-            if(m_choiceHistory->GetString(n).Left(8) == blameCommit.Left(8)) {
+            if(m_choiceHistory->GetString(n).Left(8) == m_blameCommit.Left(8)) {
                 m_choiceHistory->SetSelection(n);
             }
         }
@@ -271,8 +444,8 @@ void GitBlameDlg::SetBlame(const wxString& blame, const wxString& args)
         }
     }
     
-    if (!blameCommit.Left(8).empty()) {
-        UpdateLogControls(blameCommit.Left(8));
+    if(!m_blameCommit.Left(8).empty()) {
+        UpdateLogControls(m_blameCommit.Left(8));
     }
 }
 
@@ -442,8 +615,48 @@ void GitBlameDlg::OnChangeFile(wxCommandEvent& event)
 
 void GitBlameDlg::OnProcessTerminated(clProcessEvent& event)
 {
-    wxUnusedVar(event);
+    IProcess* process = event.GetProcess();
+    if(process == m_blameProcess) {
+        wxDELETE(m_blameProcess);
+        event.SetProcess(NULL);
+        DoBlameCompleted();
+        return;
+
+    } else if(process == m_contentProcess) {
+        wxDELETE(m_contentProcess);
+        event.SetProcess(NULL);
+        DoShowContent(m_contentOutput);
+        m_contentOutput.Clear();
+
+        // Stepping from a commit to its parent: reuse what we know
+        bool isParent = !m_prevCommit.empty() && m_prevFile == m_blameFile && m_prevExtraArgs.empty() &&
+                        m_blameExtraArgs.empty() && m_commitStore.GetCommitParent(m_prevCommit.Left(8)) == m_blameCommit.Left(8);
+        if(isParent) {
+            wxString command = wxString::Format("%s --no-pager diff --no-color -U0 %s %s -- \"%s\"", m_gitPath,
+                                                m_blameCommit, m_prevCommit, m_blameFile);
+            m_diffOutput.Clear();
+            m_diffProcess =
+                ::CreateAsyncProcess(this, command, IProcessCreateDefault, m_plugin->GetRepositoryDirectory());
+        }
+        if(!m_diffProcess) {
+            DoStartBlameProcess("");
+        }
+        return;
+
+    } else if(process == m_diffProcess) {
+        wxDELETE(m_diffProcess);
+        event.SetProcess(NULL);
+        DoApplyParentBlame(m_diffOutput);
+        m_diffOutput.Clear();
+        return;
+
+    } else if(process != m_process) {
+        // Not ours
+        return;
+    }
+
     wxDELETE(m_process);
+    event.SetProcess(NULL);
 
     m_stcCommitMessage->SetEditable(true);
     m_stcDiff->SetEditable(true);
@@ -494,7 +707,31 @@ void GitBlameDlg::OnProcessTerminated(clProcessEvent& event)
     m_stcCommitMessage->SetEditable(false);
 }
 
-void GitBlameDlg::OnProcessOutput(clProcessEvent& event) { m_commandOutput.Append(event.GetOutput()); }
+void GitBlameDlg::OnProcessOutput(clProcessEvent& event)
+{
+    IProcess* process = event.GetProcess();
+    if(process == m_blameProcess) {
+        // Fill the margins as the blame streams in
+        GitIncrementalBlameParser::Group::Vec_t groups;
+        m_blameParser.Feed(event.GetOutput(), groups);
+        for(size_t i = 0; i < groups.size(); ++i) {
+            const GitIncrementalBlameParser::Group& group = groups[i];
+            wxString margin = FormatMargin(group.m_sha, group.m_author, group.m_time);
+            for(long n = 0; n < group.m_numLines; ++n) {
+                DoSetMarginText(group.m_finalLine - 1 + n, margin);
+            }
+        }
+
+    } else if(process == m_contentProcess) {
+        m_contentOutput << event.GetOutput();
+
+    } else if(process == m_diffProcess) {
+        m_diffOutput << event.GetOutput();
+
+    } else if(process == m_process) {
+        m_commandOutput.Append(event.GetOutput());
+    }
+}
 
 void GitBlameDlg::UpdateLogControls(const wxString& commit)
 {
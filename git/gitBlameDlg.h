@@ -4,6 +4,7 @@
 #include "clEditorEditEventsHandler.h"
 #include "cl_command_event.h"
 #include "macros.h"
+#include "GitBlameCache.h"
 #include <wx/stc/stc.h>
 #include <wx/arrstr.h>
 #include <wx/choice.h>
@@ -82,7 +83,10 @@ public:
     GitBlameDlg(wxWindow* parent, GitPlugin* plugin);
     virtual ~GitBlameDlg();
 
-    void SetBlame(const wxString& blame, const wxString& args);
+    /**
+     * @brief blame a file. 'args' is either the file path or "<commit> [extra-args] -- <file path>"
+     */
+    void StartBlame(const wxString& args);
     void OnRevListOutput(const wxString& output, const wxString& Arguments);
 
 protected:
@@ -100,6 +104,16 @@ protected:
     void ClearLogControls();
     void UpdateLogControls(const wxString& commit);
 
+    void DoCancelBlame();
+    void DoPrepareEditor(const wxString& filename);
+    void DoShowContent(const wxString& content);
+    void DoSetMarginText(size_t line, const wxString& text);
+    void DoStartBlameProcess(const wxString& ranges);
+    void DoKillProcess(IProcess*& process);
+    void DoApplyParentBlame(const wxString& diff);
+    void DoBlameCompleted();
+    bool IsBlameComplete() const;
+
     void OnProcessTerminated(clProcessEvent& event);
     void OnProcessOutput(clProcessEvent& event);
     void OnChangeFile(wxCommandEvent& event);
@@ -118,6 +132,27 @@ protected:
     wxString m_commandOutput;
     IProcess* m_process;
     wxString m_gitPath;
+
+    // The blame being displayed
+    GitIncrementalBlameParser m_blameParser;
+    GitBlameCache m_blameCache;
+    IProcess* m_blameProcess;
+    IProcess* m_contentProcess;
+    IProcess* m_diffProcess;
+    wxString m_contentOutput;
+    wxString m_diffOutput;
+    wxString m_blameCommit; // empty for the working copy
+    wxString m_blameExtraArgs;
+    wxString m_blameFile;
+    wxString m_blameKey; // cache key, empty if the blame can not be cached
+    wxArrayString m_margins;
+    size_t m_blameLineCount;
+
+    // The previous blame, reused when stepping to its parent commit
+    wxString m_prevCommit;
+    wxString m_prevExtraArgs;
+    wxString m_prevFile;
+    wxArrayString m_prevMargins;
 };
 
 class GitBlameSettingsDlg : public GitBlameSettingsDlgBase
@@ -42,14 +42,83 @@
 static int ID_COPY_COMMIT_HASH = wxNewId();
 static int ID_REVERT_COMMIT = wxNewId();
 
+// The number of commits read at a time, and how close to the last one the view may get before reading the next page
+#define GIT_LOG_PAGE_SIZE 500
+#define GIT_LOG_PREFETCH_ROWS 100
+
+GitCommitListModel::GitCommitListModel(GitCommitListDlg* dlg)
+    : wxDataViewVirtualListModel(0)
+    , m_dlg(dlg)
+{
+}
+
+GitCommitListModel::~GitCommitListModel() {}
+
+void GitCommitListModel::Clear()
+{
+    m_commits.clear();
+    Reset(0);
+}
+
+void GitCommitListModel::Append(const wxArrayString& lines)
+{
+    for(size_t i = 0; i < lines.GetCount(); ++i) {
+        m_commits.push_back(std::string(lines.Item(i).mb_str(wxConvUTF8).data()));
+        RowAppended();
+    }
+}
+
+wxString GitCommitListModel::GetCommitHash(unsigned int row) const
+{
+    if(row >= m_commits.size()) {
+        return wxEmptyString;
+    }
+    const std::string& line = m_commits[row];
+    return wxString(line.substr(0, line.find('\x1f')).c_str(), wxConvUTF8);
+}
+
+void GitCommitListModel::GetValueByRow(wxVariant& variant, unsigned int row, unsigned int col) const
+{
+    if(row >= m_commits.size()) {
+        return;
+    }
+
+    // Only the rows being displayed get here: get the next page before the user scrolls to the end
+    if((row + GIT_LOG_PREFETCH_ROWS) >= m_commits.size()) {
+        m_dlg->RequestMoreCommits();
+    }
+
+    wxString hash, author, date, subject;
+    GitLogReader::ParseLine(wxString(m_commits[row].c_str(), wxConvUTF8), hash, author, date, subject);
+    switch(col) {
+    case 0:
+        variant = hash;
+        break;
+    case 1:
+        variant = author;
+        break;
+    case 2:
+        variant = date;
+        break;
+    default:
+        variant = subject;
+        break;
+    }
+}
+
 GitCommitListDlg::GitCommitListDlg(wxWindow* parent, const wxString& workingDir, GitPlugin* git)
     : GitCommitListDlgBase(parent)
     , m_git(git)
     , m_workingDir(workingDir)
-    , m_skip(0)
+    , m_process(NULL)
+    , m_logReader(NULL)
+    , m_historyComplete(false)
+    , m_fetchRequested(false)
 {
     Bind(wxEVT_ASYNC_PROCESS_OUTPUT, &GitCommitListDlg::OnProcessOutput, this);
     Bind(wxEVT_ASYNC_PROCESS_TERMINATED, &GitCommitListDlg::OnProcessTerminated, this);
+    Bind(wxEVT_GIT_LOG_COMMITS, &GitCommitListDlg::OnLogCommits, this);
+    Bind(wxEVT_GIT_LOG_PAGE_DONE, &GitCommitListDlg::OnLogPageDone, this);
 
     LexerConf::Ptr_t lex = EditorConfigST::Get()->GetLexer("diff");
     if(lex) {
@@ -68,6 +137,15 @@ GitCommitListDlg::GitCommitListDlg(wxWindow* parent, const wxString& workingDir,
     if(m_gitPath.IsEmpty()) {
         m_gitPath = "git";
     }
+    m_logReader = new GitLogReader(this, m_gitPath, m_workingDir);
+
+    // The list shows a virtual model: the history is read a page at a time as the user scrolls, so the
+    // Previous/Next paging buttons are not needed
+    m_model.reset(new GitCommitListModel(this));
+    m_dvListCtrlCommitList->AssociateModel(m_model.get());
+    m_buttonPrevious->Hide();
+    m_buttonNext->Hide();
+
     SetName("GitCommitListDlg");
     WindowAttrManager::Load(this);
 
@@ -84,15 +162,69 @@ GitCommitListDlg::GitCommitListDlg(wxWindow* parent, const wxString& workingDir,
 }
 
 /*******************************************************************************/
-GitCommitListDlg::~GitCommitListDlg() { m_git->m_commitListDlg = NULL; }
+GitCommitListDlg::~GitCommitListDlg()
+{
+    Unbind(wxEVT_ASYNC_PROCESS_OUTPUT, &GitCommitListDlg::OnProcessOutput, this);
+    Unbind(wxEVT_ASYNC_PROCESS_TERMINATED, &GitCommitListDlg::OnProcessTerminated, this);
+    Unbind(wxEVT_GIT_LOG_COMMITS, &GitCommitListDlg::OnLogCommits, this);
+    Unbind(wxEVT_GIT_LOG_PAGE_DONE, &GitCommitListDlg::OnLogPageDone, this);
+    wxDELETE(m_logReader);
+    wxDELETE(m_process);
+    m_git->m_commitListDlg = NULL;
+}
+
+/*******************************************************************************/
+void GitCommitListDlg::ReloadCommits()
+{
+    m_Filter = GetFilterString();
+    DoStartListing();
+}
+
+/*******************************************************************************/
+void GitCommitListDlg::DoStartListing()
+{
+    // Stops any page (or search) still running
+    m_logReader->Stop();
+    ClearAll();
+    m_historyComplete = false;
+    m_fetchRequested = false;
+    m_logReader->Start(m_Filter, 0, GIT_LOG_PAGE_SIZE);
+}
+
+/*******************************************************************************/
+void GitCommitListDlg::RequestMoreCommits()
+{
+    // Called while the list is painting: defer the actual work
+    if(m_historyComplete || m_fetchRequested || m_logReader->IsRunning()) {
+        return;
+    }
+    m_fetchRequested = true;
+    CallAfter(&GitCommitListDlg::DoFetchMore);
+}
+
+/*******************************************************************************/
+void GitCommitListDlg::DoFetchMore()
+{
+    m_fetchRequested = false;
+    if(m_historyComplete || m_logReader->IsRunning()) {
+        return;
+    }
+    if(m_model->GetCount() == 0) {
+        return;
+    }
+    m_logReader->Start(m_Filter, m_model->GetCount(), GIT_LOG_PAGE_SIZE);
+}
+
+/*******************************************************************************/
+void GitCommitListDlg::OnLogCommits(clCommandEvent& event) { m_model->Append(event.GetStrings()); }
 
 /*******************************************************************************/
-void GitCommitListDlg::SetCommitList(const wxString& commits)
+void GitCommitListDlg::OnLogPageDone(clCommandEvent& event)
 {
-    m_commitList = commits;
-    m_history.insert(std::make_pair(m_skip, m_commitList));
-    // Load all commits, un-filtered
-    DoLoadCommits("");
+    if(event.GetInt() < GIT_LOG_PAGE_SIZE) {
+        // A short page: this is the end of the history
+        m_historyComplete = true;
+    }
 }
 
 /*******************************************************************************/
@@ -108,7 +240,13 @@ void GitCommitListDlg::OnChangeFile(wxCommandEvent& e)
 /*******************************************************************************/
 void GitCommitListDlg::OnProcessTerminated(clProcessEvent& event)
 {
-    wxUnusedVar(event);
+    IProcess* process = event.GetProcess();
+    event.SetProcess(NULL);
+    if(process != m_process) {
+        // The output of a commit that is no longer selected
+        wxDELETE(process);
+        return;
+    }
     wxDELETE(m_process);
 
     ClearAll(false);
@@ -156,17 +294,41 @@ void GitCommitListDlg::OnProcessTerminated(clProcessEvent& event)
     m_stcCommitMessage->SetEditable(false);
 }
 /*******************************************************************************/
-void GitCommitListDlg::OnProcessOutput(clProcessEvent& event) { m_commandOutput.Append(event.GetOutput()); }
+void GitCommitListDlg::OnProcessOutput(clProcessEvent& event)
+{
+    if(event.GetProcess() == m_process) {
+        m_commandOutput.Append(event.GetOutput());
+    }
+}
+
+wxString GitCommitListDlg::GetSelectedCommit() const
+{
+    wxDataViewItem sel = m_dvListCtrlCommitList->GetSelection();
+    if(!sel.IsOk()) {
+        return wxEmptyString;
+    }
+    return m_model->GetCommitHash(m_model->GetRow(sel));
+}
 
 void GitCommitListDlg::OnSelectionChanged(wxDataViewEvent& event)
 {
-    wxVariant v;
     if(!event.GetItem().IsOk()) {
         return;
     }
 
-    m_dvListCtrlCommitList->GetValue(v, m_dvListCtrlCommitList->ItemToRow(event.GetItem()), 0);
-    wxString commitID = v.GetString();
+    wxString commitID = m_model->GetCommitHash(m_model->GetRow(event.GetItem()));
+    if(commitID.IsEmpty()) {
+        return;
+    }
+
+    // Only the last selected commit is shown
+    if(m_process) {
+        m_process->Detach();
+        m_process->Terminate();
+        wxDELETE(m_process);
+    }
+    m_commandOutput.Clear();
+
     wxString command = wxString::Format(wxT("%s --no-pager show --first-parent %s"), m_gitPath.c_str(), commitID.c_str());
     m_process = CreateAsyncProcess(this, command, IProcessCreateDefault, m_workingDir);
 }
@@ -181,24 +343,20 @@ void GitCommitListDlg::OnContextMenu(wxDataViewEvent& event)
 
 void GitCommitListDlg::OnCopyCommitHashToClipboard(wxCommandEvent& e)
 {
-    wxDataViewItem sel = m_dvListCtrlCommitList->GetSelection();
-    CHECK_ITEM_RET(sel);
-
-    wxVariant v;
-    m_dvListCtrlCommitList->GetValue(v, m_dvListCtrlCommitList->ItemToRow(sel), 0);
-    wxString commitID = v.GetString();
+    wxString commitID = GetSelectedCommit();
+    if(commitID.IsEmpty()) {
+        return;
+    }
 
     ::CopyToClipboard(commitID);
 }
 
 void GitCommitListDlg::OnRevertCommit(wxCommandEvent& e)
 {
-    wxDataViewItem sel = m_dvListCtrlCommitList->GetSelection();
-    CHECK_ITEM_RET(sel);
-
-    wxVariant v;
-    m_dvListCtrlCommitList->GetValue(v, m_dvListCtrlCommitList->ItemToRow(sel), 0);
-    wxString commitID = v.GetString();
+    wxString commitID = GetSelectedCommit();
+    if(commitID.IsEmpty()) {
+        return;
+    }
 
     if(::wxMessageBox(_("Are you sure you want to revert commit #") + commitID,
                       "CodeLite",
@@ -217,26 +375,6 @@ void GitCommitListDlg::OnClose(wxCloseEvent& event)
 
 void GitCommitListDlg::OnOK(wxCommandEvent& event) { Destroy(); }
 
-void GitCommitListDlg::DoLoadCommits(const wxString& filter)
-{
-    ClearAll();
-
-    // hash @ subject @ author-name @ date
-    wxArrayString gitList = wxStringTokenize(m_commitList, wxT("\n"), wxTOKEN_STRTOK);
-    wxArrayString filters = wxStringTokenize(filter, " ");
-    for(unsigned i = 0; i < gitList.GetCount(); ++i) {
-        wxArrayString gitCommit = ::wxStringTokenize(gitList[i], "@");
-        if(gitCommit.GetCount() >= 4) {
-            wxVector<wxVariant> cols;
-            cols.push_back(gitCommit.Item(0));
-            cols.push_back(gitCommit.Item(1));
-            cols.push_back(gitCommit.Item(2));
-            cols.push_back(gitCommit.Item(3));
-            m_dvListCtrlCommitList->AppendItem(cols);
-        }
-    }
-}
-
 void GitCommitListDlg::ClearAll(bool includingCommitlist /*=true*/)
 {
     m_stcCommitMessage->SetEditable(true);
@@ -244,7 +382,7 @@ void GitCommitListDlg::ClearAll(bool includingCommitlist /*=true*/)
     m_stcCommitMessage->ClearAll();
     m_fileListBox->Clear();
     if(includingCommitlist) {
-        m_dvListCtrlCommitList->DeleteAllItems();
+        m_model->Clear();
     }
     m_diffMap.clear();
     m_stcDiff->ClearAll();
@@ -259,21 +397,10 @@ void GitCommitListDlg::OnSearchCommitList(wxCommandEvent& event)
         return; // No change
     }
 
+    // git searches the whole history in the background, the matches are shown as they are found. A new search
+    // cancels the running one
     m_Filter = filter;
-
-    if(m_Filter.empty()) {
-        wxCommandEvent e; // A search-filter has been removed, so reload
-        m_git->OnCommitList(e);
-        return;
-    }
-
-    ClearAll();
-
-    m_skip = 0;
-    m_history.clear();
-    m_commitList.clear();
-
-    m_git->FetchNextCommits(m_skip, m_Filter);
+    DoStartListing();
 }
 
 wxString GitCommitListDlg::GetFilterString() const
@@ -307,26 +434,6 @@ wxString GitCommitListDlg::GetFilterString() const
     return args;
 }
 
-void GitCommitListDlg::OnNext(wxCommandEvent& event)
-{
-    m_skip += 100;
-    // Check the cache first
-    if(m_history.count(m_skip)) {
-        SetCommitList(m_history.find(m_skip)->second);
-    } else {
-        m_git->FetchNextCommits(m_skip, m_Filter);
-    }
-}
-
-void GitCommitListDlg::OnPrevious(wxCommandEvent& event)
-{
-    int skip = m_skip - 100;
-    if(m_history.count(skip)) {
-        m_skip -= 100;
-        SetCommitList(m_history.find(m_skip)->second);
-    }
-}
-
 void GitCommitListDlg::OnExtraArgsTextEnter(wxCommandEvent& event)
 {
     // Add any text to the combobox, uniqued
@@ -341,10 +448,3 @@ void GitCommitListDlg::OnExtraArgsTextEnter(wxCommandEvent& event)
 
     OnSearchCommitList(event);
 }
-
-void GitCommitListDlg::OnPreviousUI(wxUpdateUIEvent& event) { event.Enable(m_skip >= 100); }
-
-void GitCommitListDlg::OnNextUpdateUI(wxUpdateUIEvent& event)
-{
-    event.Enable(m_dvListCtrlCommitList->GetItemCount() >= 100);
-}
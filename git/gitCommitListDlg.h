@@ -34,12 +34,43 @@
 #define __gitCommitListDlg__
 
 #include <map>
+#include <string>
+#include <vector>
 #include "gitui.h"
 #include "macros.h"
 #include "cl_command_event.h"
+#include "GitLogReader.h"
+#include <wx/dataview.h>
 
 class IProcess;
 class GitPlugin;
+class GitCommitListDlg;
+
+/**
+ * @class GitCommitListModel
+ * @brief a virtual list of the commits read so far. Only the visible rows are ever converted for display, and
+ * asking for a row close to the end requests the next page of history
+ */
+class GitCommitListModel : public wxDataViewVirtualListModel
+{
+    GitCommitListDlg* m_dlg;
+    std::vector<std::string> m_commits; // the raw log lines, UTF-8 to keep long histories small
+
+public:
+    GitCommitListModel(GitCommitListDlg* dlg);
+    virtual ~GitCommitListModel();
+
+    void Clear();
+    void Append(const wxArrayString& lines);
+    size_t GetCount() const { return m_commits.size(); }
+    wxString GetCommitHash(unsigned int row) const;
+
+    virtual unsigned int GetColumnCount() const { return 4; }
+    virtual wxString GetColumnType(unsigned int col) const { return "string"; }
+    virtual void GetValueByRow(wxVariant& variant, unsigned int row, unsigned int col) const;
+    virtual bool SetValueByRow(const wxVariant& variant, unsigned int row, unsigned int col) { return false; }
+};
+
 class GitCommitListDlg : public GitCommitListDlgBase
 {
     GitPlugin* m_git;
@@ -48,27 +79,34 @@ class GitCommitListDlg : public GitCommitListDlgBase
     wxString m_commandOutput;
     IProcess* m_process;
     wxString m_gitPath;
-    wxString m_commitList;
     wxString m_Filter;
-    int m_skip;
-    std::map<int, wxString> m_history;
+    wxObjectDataPtr<GitCommitListModel> m_model;
+    GitLogReader* m_logReader;
+    bool m_historyComplete;
+    bool m_fetchRequested;
 
 protected:
-    virtual void OnNextUpdateUI(wxUpdateUIEvent& event);
     virtual void OnExtraArgsTextEnter(wxCommandEvent& event);
-    virtual void OnNext(wxCommandEvent& event);
-    virtual void OnPrevious(wxCommandEvent& event);
-    virtual void OnPreviousUI(wxUpdateUIEvent& event);
     virtual void OnSearchCommitList(wxCommandEvent& event);
-    void DoLoadCommits(const wxString& filter);
-	void ClearAll(bool includingCommitlist = true);
+    void DoStartListing();
+    void DoFetchMore();
+    void ClearAll(bool includingCommitlist = true);
     wxString GetFilterString() const;
+    wxString GetSelectedCommit() const;
 
 public:
     GitCommitListDlg(wxWindow* parent, const wxString& workingDir, GitPlugin* git);
     ~GitCommitListDlg();
 
-    void SetCommitList(const wxString& commits);
+    /**
+     * @brief (re)load the history from the top, using the current search filter
+     */
+    void ReloadCommits();
+
+    /**
+     * @brief called by the model when the view gets close to the last commit read
+     */
+    void RequestMoreCommits();
 
 private:
     void OnChangeFile(wxCommandEvent& e);
@@ -76,6 +114,8 @@ private:
     // Event handlers
     void OnProcessTerminated(clProcessEvent& event);
     void OnProcessOutput(clProcessEvent& event);
+    void OnLogCommits(clCommandEvent& event);
+    void OnLogPageDone(clCommandEvent& event);
 
 protected:
     virtual void OnOK(wxCommandEvent& event);
@@ -34,6 +34,7 @@
 #include <wx/combobox.h>
 #include <wx/arrstr.h>
 #include <wx/dataview.h>
+#include "GitCommitListCtrl.h"
 #include <wx/listbox.h>
 #include "gitCommitEditor.h"
 #include <wx/radiobox.h>
@@ -181,7 +182,7 @@ protected:
     wxCheckBox* m_checkBoxIgnoreCase;
     wxStaticText* m_staticText414;
     wxComboBox* m_comboExtraArgs;
-    wxDataViewListCtrl* m_dvListCtrlCommitList;
+    GitCommitListCtrl* m_dvListCtrlCommitList;
     wxPanel* m_splitterPage182;
     wxSplitterWindow* m_splitter186;
     wxPanel* m_splitterPage190;
@@ -215,7 +216,7 @@ public:
     wxCheckBox* GetCheckBoxIgnoreCase() { return m_checkBoxIgnoreCase; }
     wxStaticText* GetStaticText414() { return m_staticText414; }
     wxComboBox* GetComboExtraArgs() { return m_comboExtraArgs; }
-    wxDataViewListCtrl* GetDvListCtrlCommitList() { return m_dvListCtrlCommitList; }
+    GitCommitListCtrl* GetDvListCtrlCommitList() { return m_dvListCtrlCommitList; }
     wxPanel* GetSplitterPage178() { return m_splitterPage178; }
     wxStaticText* GetStaticText210() { return m_staticText210; }
     wxListBox* GetFileListBox() { return m_fileListBox; }